@@ -0,0 +1,32 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+// Cycles taken by crc8(), crc16_ccitt() and crc32() over a 512-byte buffer, for the
+// CRC_IMPLEMENTATION the program is built with. These are the figures of the table in crc.h.
+
+#include "benchmark.h"
+
+#define BUFFER_LENGTH 512
+
+static uint8_t buffer[BUFFER_LENGTH];
+
+// Keeps the results alive so that the computations are not optimized away
+volatile uint32_t bench_sink;
+
+int main()
+{
+  for (uint32_t i = 0; i < BUFFER_LENGTH; i++)
+    buffer[i] = (uint8_t)(i * 37 + 11);
+  uint32_t overhead = bench_overhead();
+  uint32_t c8, c16, c32;
+  BENCH_CYCLES(c8, bench_sink = crc8(CRC8_INIT, buffer, BUFFER_LENGTH));
+  BENCH_CYCLES(c16, bench_sink = crc16_ccitt(CRC16_CCITT_INIT, buffer, BUFFER_LENGTH));
+  BENCH_CYCLES(c32, bench_sink = crc32(CRC32_INIT, buffer, BUFFER_LENGTH));
+  uart_printf(BENCH_UART, "crc (implementation %u): %u bytes, crc8 %u, crc16 %u, crc32 %u cycles\n",
+              CRC_IMPLEMENTATION, BUFFER_LENGTH, c8 - overhead, c16 - overhead, c32 - overhead);
+  return 0;
+}
@@ -0,0 +1,59 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+// Cycles per toggle of the GPIO toggle functions, with and without a GpioShadow, compared with a
+// read-modify-write of OUT and with the CLR then SET sequence, which switches pins going low one
+// store before pins going high.
+
+#include "benchmark.h"
+
+#define TOGGLES 256
+
+// Toggle by a read-modify-write of OUT, not protected from interrupt handlers
+static inline void toggle_group_rmw(GpioController *gpio, const uint32_t bit_mask)
+{
+  INV_FLAG(gpio->OUT, bit_mask);
+}
+
+// Toggle with two stores: the pins going low switch before the pins going high
+static inline void toggle_group_clear_set(GpioController *gpio, const uint32_t bit_mask)
+{
+  uint32_t high = gpio->OUT & bit_mask;
+  gpio->CLR = high;
+  gpio->SET = bit_mask ^ high;
+}
+
+// Cycles of TOGGLES runs of `statement`, less those of an empty loop
+#define BENCH_TOGGLES(name, statement)                                                             \
+  do                                                                                               \
+  {                                                                                                \
+    uint32_t cycles;                                                                               \
+    BENCH_CYCLES(cycles, for (uint32_t i = 0; i < TOGGLES; i++) {                                  \
+      statement;                                                                                   \
+      __asm__ volatile("" ::: "memory");                                                           \
+    });                                                                                            \
+    cycles -= empty;                                                                               \
+    uart_printf(BENCH_UART, "%-26s %u.%02u\n", name, cycles / TOGGLES,                             \
+                (cycles % TOGGLES) * 100 / TOGGLES);                                               \
+  } while (0)
+
+int main()
+{
+  GpioShadow shadow;
+  gpio_set_output_group(BENCH_GPIO, 0xff);
+  gpio_shadow_init(&shadow, BENCH_GPIO);
+  uint32_t empty;
+  BENCH_CYCLES(empty, for (uint32_t i = 0; i < TOGGLES; i++) __asm__ volatile("" ::: "memory"));
+  uart_printf(BENCH_UART, "gpio: cycles per toggle\n");
+  BENCH_TOGGLES("gpio_toggle", gpio_toggle(BENCH_GPIO, 3));
+  BENCH_TOGGLES("gpio_shadow_toggle", gpio_shadow_toggle(&shadow, 3));
+  BENCH_TOGGLES("OUT read-modify-write", toggle_group_rmw(BENCH_GPIO, 0x0f));
+  BENCH_TOGGLES("CLR then SET", toggle_group_clear_set(BENCH_GPIO, 0x0f));
+  BENCH_TOGGLES("gpio_toggle_group", gpio_toggle_group(BENCH_GPIO, 0x0f));
+  BENCH_TOGGLES("gpio_shadow_toggle_group", gpio_shadow_toggle_group(&shadow, 0x0f));
+  return 0;
+}
@@ -0,0 +1,55 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+// Cycles taken to log a record with two arguments through a UART TX buffer (LOG_TOKEN_BUFFERED),
+// to queue it for later framing (LOG_TOKEN_DEFERRED) and to frame it from the queue
+// (log_queue_flush). These are the figures given in log.h.
+
+#include "benchmark.h"
+
+#define RUNS 16
+
+static uint8_t tx_storage[1024];
+static UartTxBuffer txb;
+static uint32_t log_storage[64];
+static LogQueue logq;
+
+// Flushed records are written to this model of a UART rather than to the device, to keep them off
+// the output of the benchmark
+static UartController sink = {.READY = 1};
+
+// Runs of the benchmarks keep small and large arguments apart
+static uint32_t small_values[RUNS];
+static int32_t signed_values[RUNS];
+
+int main()
+{
+  for (uint32_t i = 0; i < RUNS; i++)
+  {
+    small_values[i] = i * 5;
+    signed_values[i] = -(int32_t)(i * 1000);
+  }
+  uint32_t overhead = bench_overhead();
+  uint32_t buffered = 0, deferred = 0, flushed = 0;
+  for (uint32_t i = 0; i < RUNS; i++)
+  {
+    uint32_t cycles;
+    uart_tx_buffer_init(&txb, BENCH_UART, tx_storage, sizeof(tx_storage), UART_OVERFLOW_DROP);
+    BENCH_CYCLES(cycles,
+                 LOG_TOKEN_BUFFERED(&txb, "adc[%u] = %d\n", small_values[i], signed_values[i]));
+    buffered += cycles - overhead;
+    log_queue_init(&logq, log_storage, NUMBER_OF(log_storage));
+    BENCH_CYCLES(cycles,
+                 LOG_TOKEN_DEFERRED(&logq, "adc[%u] = %d\n", small_values[i], signed_values[i]));
+    deferred += cycles - overhead;
+    BENCH_CYCLES(cycles, log_queue_flush(&logq, &sink));
+    flushed += cycles - overhead;
+  }
+  uart_printf(BENCH_UART, "log: 2 arguments, buffered %u, deferred %u, flush %u cycles\n",
+              buffered / RUNS, deferred / RUNS, flushed / RUNS);
+  return 0;
+}
@@ -0,0 +1,154 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+// Cycles taken by the context switches of rtos.h. These are the figures given in rtos.h.
+//
+// Two threads of the same priority first pass the turn to each other through two semaphores, then
+// by yielding, so every switch goes through `ecall`. The yields read CSR_MCYCLE as soon as `ecall`
+// returns in the resumed thread, to measure the whole switch including `mret`. Finally a sleeping
+// thread is woken up by the Machine Timer Interrupt while the other thread spins: it preempts the
+// spinning thread, which resumes once it sleeps again.
+
+#include "benchmark.h"
+
+#define ROUNDS 1000U
+#define WAKEUPS 100U
+
+// Minimum, maximum and sum of a series of cycle counts
+typedef struct
+{
+  uint32_t min;
+  uint32_t max;
+  uint32_t sum;
+  uint32_t count;
+} Series;
+
+static Timebase tb;
+static Rtos rtos;
+static RtosThread ping, pong, sleeper;
+static uint32_t ping_stack[256], pong_stack[256], sleeper_stack[256];
+static RtosSemaphore to_ping, to_pong, parked;
+static Series ecall_kernel, ecall_mret, preempted_kernel, mti_kernel;
+static volatile bool sleeper_done;
+
+static void series_add(Series *series, uint32_t cycles)
+{
+  if (series->count == 0 || cycles < series->min)
+    series->min = cycles;
+  if (cycles > series->max)
+    series->max = cycles;
+  series->sum += cycles;
+  series->count++;
+}
+
+static void series_print(const char *name, const Series *series)
+{
+  uart_printf(BENCH_UART, "%-30s %u min, %u mean, %u max (%u switches)\n", name, series->min,
+              series->sum / series->count, series->max, series->count);
+}
+
+// rtos_yield() between two threads of the same priority. Return the cycles from the trap entry
+// to the first instruction after `ecall` in the resumed thread.
+static uint32_t yield_timed()
+{
+  uint32_t mstatus = csr_global_disable_irq_save();
+  RtosThread *previous = rtos.current;
+  rtos_ready_remove(&rtos, previous);
+  rtos_ready_insert(&rtos, previous);
+  RtosThread *next = rtos_highest_ready(&rtos);
+  rtos.current = next;
+  rtos.switches++;
+  uint32_t end;
+  // rtos_switch_context() followed by a read of CSR_MCYCLE
+  __asm__ volatile("mv a0, %1\n"
+                   "mv a1, %2\n"
+                   "ecall\n"
+                   "csrr %0, mcycle\n"
+                   : "=r"(end)
+                   : "r"(&previous->sp), "r"(next->sp)
+                   : "ra", "t0", "t1", "t2", "t3", "t4", "t5", "t6", "a0", "a1", "a2", "a3", "a4",
+                     "a5", "a6", "a7", "memory");
+  csr_global_restore_irq(mstatus);
+  return end - rtos.trap_cycle;
+}
+
+static void run_sleeper(void *arg)
+{
+  (void)arg;
+  for (uint32_t i = 0; i < WAKEUPS; i++)
+  {
+    rtos_sleep(us_to_ticks(&tb, 100));
+    series_add(&mti_kernel, rtos.switch_cycles);
+  }
+  sleeper_done = true;
+}
+
+static void run_pong(void *arg)
+{
+  (void)arg;
+  for (uint32_t i = 0; i < ROUNDS; i++)
+  {
+    rtos_semaphore_wait(&to_pong);
+    series_add(&ecall_kernel, rtos.switch_cycles);
+    rtos_semaphore_post(&to_ping);
+  }
+  for (uint32_t i = 0; i < ROUNDS; i++)
+    series_add(&ecall_mret, yield_timed());
+  rtos_semaphore_wait(&parked);
+}
+
+static void run_ping(void *arg)
+{
+  (void)arg;
+  for (uint32_t i = 0; i < ROUNDS; i++)
+  {
+    rtos_semaphore_post(&to_pong);
+    rtos_semaphore_wait(&to_ping);
+    series_add(&ecall_kernel, rtos.switch_cycles);
+  }
+  for (uint32_t i = 0; i < ROUNDS; i++)
+    series_add(&ecall_mret, yield_timed());
+  uint32_t max_ecall = rtos.max_switch_cycles;
+
+  // Spin while the sleeping thread preempts this one. When it sleeps again, the switch back here is
+  // the last one.
+  rtos_thread_create(&rtos, &sleeper, run_sleeper, NULL, sleeper_stack, sizeof(sleeper_stack), 0);
+  volatile uint32_t *switches = &rtos.switches;
+  volatile uint32_t *switch_cycles = &rtos.switch_cycles;
+  uint32_t seen = *switches;
+  while (!sleeper_done)
+  {
+    if (*switches != seen)
+    {
+      seen = *switches;
+      series_add(&preempted_kernel, *switch_cycles);
+    }
+  }
+
+  uart_printf(BENCH_UART, "rtos: context switch cycles\n");
+  series_print("ecall, kernel", &ecall_kernel);
+  series_print("ecall, through mret", &ecall_mret);
+  series_print("ecall to a preempted thread", &preempted_kernel);
+  series_print("MTI, kernel", &mti_kernel);
+  uart_printf(BENCH_UART, "max_switch_cycles %u with ecall only, %u in total\n", max_ecall,
+              rtos.max_switch_cycles);
+  // End the program (see start.S)
+  __asm__ volatile("li a0, 0\n"
+                   "1: j 1b\n");
+}
+
+int main()
+{
+  timebase_init(&tb, BENCH_MTIMER, 50000000);
+  rtos_init(&rtos, &tb);
+  rtos_semaphore_init(&to_ping, 0);
+  rtos_semaphore_init(&to_pong, 0);
+  rtos_semaphore_init(&parked, 0);
+  rtos_thread_create(&rtos, &ping, run_ping, NULL, ping_stack, sizeof(ping_stack), 1);
+  rtos_thread_create(&rtos, &pong, run_pong, NULL, pong_stack, sizeof(pong_stack), 1);
+  rtos_start(&rtos);
+}
@@ -0,0 +1,42 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+/* Common definitions of the cycle benchmarks. They are built for RISC-V Steel with
+ * benchmarks/CMakeLists.txt and run either on the hardware or on tools/steel_sim.c, which models
+ * the peripherals at the addresses below. Results are printed on the UART. */
+
+#ifndef __LIBSTEEL_BENCHMARK__
+#define __LIBSTEEL_BENCHMARK__
+
+#include "libsteel.h"
+
+#define BENCH_UART ((UartController *)0x80000000)
+#define BENCH_MTIMER ((MTimerController *)0x80010000)
+#define BENCH_GPIO ((GpioController *)0x80020000)
+#define BENCH_SPI ((SpiController *)0x80030000)
+
+// Number of cycles taken by `statement`, read from CSR_MCYCLE. The two reads cost a few cycles of
+// their own, reported by bench_overhead() so it can be subtracted
+#define BENCH_CYCLES(result, statement)                                                            \
+  do                                                                                               \
+  {                                                                                                \
+    uint32_t bench_start, bench_end;                                                               \
+    CSR_READ(CSR_MCYCLE, bench_start);                                                             \
+    statement;                                                                                     \
+    CSR_READ(CSR_MCYCLE, bench_end);                                                               \
+    (result) = bench_end - bench_start;                                                            \
+  } while (0)
+
+// Cycles counted by BENCH_CYCLES() around an empty statement
+static inline uint32_t bench_overhead()
+{
+  uint32_t cycles;
+  BENCH_CYCLES(cycles, __asm__ volatile("" ::: "memory"));
+  return cycles;
+}
+
+#endif // __LIBSTEEL_BENCHMARK__
@@ -0,0 +1,28 @@
+# -----------------------------------------------------------------------------
+# Copyright (c) 2020-2024 RISC-V Steel contributors
+#
+# This work is licensed under the MIT License, see LICENSE file for details.
+# SPDX-License-Identifier: MIT
+# -----------------------------------------------------------------------------
+
+# Toolchain file for cross-compiling the benchmarks for RISC-V Steel (RV32I, no M extension):
+#
+#   cmake -S . -B build-riscv -DCMAKE_TOOLCHAIN_FILE=benchmarks/riscv32-unknown-elf.cmake
+#
+# The compiler defaults to riscv32-unknown-elf-gcc and can be changed with -DCMAKE_C_COMPILER.
+
+set(CMAKE_SYSTEM_NAME Generic)
+set(CMAKE_SYSTEM_PROCESSOR riscv32)
+
+if(NOT CMAKE_C_COMPILER)
+  set(CMAKE_C_COMPILER riscv32-unknown-elf-gcc)
+endif()
+
+set(CMAKE_ASM_COMPILER ${CMAKE_C_COMPILER})
+
+# The test programs of CMake cannot run without the startup code of benchmarks/start.S
+set(CMAKE_TRY_COMPILE_TARGET_TYPE STATIC_LIBRARY)
+
+set(CMAKE_C_FLAGS_INIT "-march=rv32i_zicsr -mabi=ilp32 -ffreestanding")
+set(CMAKE_ASM_FLAGS_INIT "-march=rv32i_zicsr -mabi=ilp32")
+set(CMAKE_EXE_LINKER_FLAGS_INIT "-nostartfiles")
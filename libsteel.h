@@ -8,10 +8,26 @@
 #ifndef __RVSTEEL_LIBSTEEL__
 #define __RVSTEEL_LIBSTEEL__
 
+#include "libsteel/cobs.h"
+#include "libsteel/crc.h"
 #include "libsteel/csr.h"
+#include "libsteel/delay.h"
+#include "libsteel/format.h"
 #include "libsteel/gpio.h"
+#include "libsteel/gpio_debounce.h"
+#include "libsteel/gpio_edge.h"
+#include "libsteel/i2c.h"
+#include "libsteel/log.h"
 #include "libsteel/mtimer.h"
+#include "libsteel/rtos.h"
+#include "libsteel/scheduler.h"
+#include "libsteel/sdcard.h"
+#include "libsteel/sleep.h"
 #include "libsteel/spi.h"
+#include "libsteel/spi_async.h"
+#include "libsteel/spi_flash.h"
+#include "libsteel/timebase.h"
+#include "libsteel/timer_wheel.h"
 #include "libsteel/uart.h"
 
 #endif // __RVSTEEL_LIBSTEEL__
@@ -0,0 +1,327 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_COBS__
+#define __LIBSTEEL_COBS__
+
+#include "crc.h"
+#include "globals.h"
+#include "uart.h"
+
+/* Packet framing over the UART with Consistent Overhead Byte Stuffing (COBS). Each frame carries
+ * the payload followed by its CRC-16/CCITT-FALSE (most significant byte first), COBS-encoded so
+ * that it contains no zero bytes, and is terminated by a single 0x00 delimiter.
+ *
+ * Both directions work incrementally. The encoder writes to the UART as the payload is provided,
+ * either directly or through a UartTxBuffer, holding back at most one COBS block (254 bytes). The
+ * decoder is fed one byte at a time and checks the CRC on the fly, so a received frame is never
+ * scanned twice. */
+
+// Maximum number of data bytes in a COBS block
+#define COBS_BLOCK_SIZE 254U
+
+// Number of CRC bytes appended to the payload of each frame
+#define COBS_CRC_SIZE 2U
+
+// Struct holding the state of a COBS frame encoder
+typedef struct
+{
+  // Pointer to the UartController the frame is sent to, used when `txb` is NULL
+  UartController *uart;
+  // Pointer to the UartTxBuffer the frame is written to, or NULL to write to `uart` directly
+  UartTxBuffer *txb;
+  // CRC of the payload written so far
+  uint16_t crc;
+  // Number of bytes held in `block`
+  uint32_t length;
+  // Data bytes of the current COBS block, sent once its code byte is known
+  uint8_t block[COBS_BLOCK_SIZE];
+} CobsEncoder;
+
+// Enumeration with the results of feeding a byte to a COBS frame decoder
+enum CobsStatus
+{
+  // The frame is not complete yet
+  COBS_IN_PROGRESS = 0,
+  // A complete frame with a valid CRC was received
+  COBS_FRAME_READY = 1,
+  // The frame did not fit in the buffer of the decoder and was discarded
+  COBS_ERROR_OVERFLOW = 2,
+  // The frame ended in the middle of a COBS block or was too short to hold a CRC
+  COBS_ERROR_FRAMING = 3,
+  // The CRC of the frame did not match
+  COBS_ERROR_CRC = 4
+};
+
+// Struct holding the state of a COBS frame decoder
+typedef struct
+{
+  // Buffer where the decoded frame is stored, provided by the user
+  uint8_t *buf;
+  // Size of the buffer in bytes
+  uint32_t size;
+  // Number of decoded bytes in the buffer, CRC included
+  uint32_t length;
+  // Running CRC of the decoded bytes. It equals zero after a valid CRC trailer.
+  uint16_t crc;
+  // Code byte of the current COBS block, or 0 before the first block of a frame
+  uint8_t code;
+  // Number of data bytes still expected in the current COBS block
+  uint8_t remaining;
+  // True if the current frame overflowed the buffer and must be discarded
+  bool overflow;
+  // Number of frames discarded because of an error
+  uint32_t errors;
+} CobsDecoder;
+
+/**
+ * @brief Send the COBS block held by the encoder, preceded by its code byte.
+ *
+ * @param enc Pointer to the CobsEncoder
+ */
+static inline void cobs_encoder_flush_block(CobsEncoder *enc)
+{
+  if (enc->txb != NULL)
+  {
+    uart_tx_buffer_put(enc->txb, enc->length + 1);
+    uart_tx_buffer_write(enc->txb, enc->block, enc->length);
+  }
+  else
+  {
+    uart_write(enc->uart, enc->length + 1);
+    uart_write_buffer(enc->uart, enc->block, enc->length);
+  }
+  enc->length = 0;
+}
+
+/**
+ * @brief Encode one byte of the frame. The CRC is not updated.
+ *
+ * @param enc Pointer to the CobsEncoder
+ * @param data The byte to encode
+ */
+static inline void cobs_encoder_put(CobsEncoder *enc, uint8_t data)
+{
+  // A full block is only sent once the next byte arrives, so that a frame ending with a full
+  // block is not followed by a redundant empty one
+  if (enc->length == COBS_BLOCK_SIZE)
+    cobs_encoder_flush_block(enc);
+  if (data == 0)
+  {
+    cobs_encoder_flush_block(enc);
+    return;
+  }
+  enc->block[enc->length++] = data;
+}
+
+/**
+ * @brief Start a new frame.
+ *
+ * @param enc Pointer to the CobsEncoder
+ * @param uart Pointer to the UartController the frame is sent to
+ */
+static inline void cobs_encoder_begin(CobsEncoder *enc, UartController *uart)
+{
+  enc->uart = uart;
+  enc->txb = NULL;
+  enc->crc = CRC16_CCITT_INIT;
+  enc->length = 0;
+}
+
+/**
+ * @brief Start a new frame written to a UART TX ring buffer instead of the UART device. The frame
+ * is then sent by `uart_tx_buffer_service`, and bytes that do not fit are handled according to the
+ * overflow policy of the buffer. A frame missing bytes is rejected by the CRC check of the
+ * receiver.
+ *
+ * @param enc Pointer to the CobsEncoder
+ * @param txb Pointer to the UartTxBuffer the frame is written to
+ */
+static inline void cobs_encoder_begin_buffered(CobsEncoder *enc, UartTxBuffer *txb)
+{
+  cobs_encoder_begin(enc, txb->uart);
+  enc->txb = txb;
+}
+
+/**
+ * @brief Append `length` bytes to the payload of the current frame. Can be called any number of
+ * times between `cobs_encoder_begin` and `cobs_encoder_end`.
+ *
+ * @param enc Pointer to the CobsEncoder
+ * @param data Pointer to the payload bytes
+ * @param length Number of payload bytes
+ */
+static inline void cobs_encoder_write(CobsEncoder *enc, const uint8_t *data, size_t length)
+{
+  for (size_t i = 0; i < length; i++)
+  {
+    enc->crc = crc16_ccitt_update(enc->crc, data[i]);
+    cobs_encoder_put(enc, data[i]);
+  }
+}
+
+/**
+ * @brief Append the CRC to the current frame, send the last COBS block and the frame delimiter.
+ *
+ * @param enc Pointer to the CobsEncoder
+ */
+static inline void cobs_encoder_end(CobsEncoder *enc)
+{
+  uint16_t crc = enc->crc;
+  cobs_encoder_put(enc, crc >> 8);
+  cobs_encoder_put(enc, crc & 0xff);
+  cobs_encoder_flush_block(enc);
+  if (enc->txb != NULL)
+    uart_tx_buffer_put(enc->txb, 0);
+  else
+    uart_write(enc->uart, 0);
+}
+
+/**
+ * @brief Send a complete frame over the UART device.
+ *
+ * @param uart Pointer to the UartController
+ * @param data Pointer to the payload
+ * @param length Number of payload bytes
+ */
+static inline void cobs_send_frame(UartController *uart, const uint8_t *data, size_t length)
+{
+  CobsEncoder enc;
+  cobs_encoder_begin(&enc, uart);
+  cobs_encoder_write(&enc, data, length);
+  cobs_encoder_end(&enc);
+}
+
+/**
+ * @brief Write a complete frame to a UART TX ring buffer.
+ *
+ * @param txb Pointer to the UartTxBuffer
+ * @param data Pointer to the payload
+ * @param length Number of payload bytes
+ */
+static inline void cobs_send_frame_buffered(UartTxBuffer *txb, const uint8_t *data, size_t length)
+{
+  CobsEncoder enc;
+  cobs_encoder_begin_buffered(&enc, txb);
+  cobs_encoder_write(&enc, data, length);
+  cobs_encoder_end(&enc);
+}
+
+/**
+ * @brief Reset the decoder to wait for the start of a new frame.
+ *
+ * @param dec Pointer to the CobsDecoder
+ */
+static inline void cobs_decoder_reset(CobsDecoder *dec)
+{
+  dec->length = 0;
+  dec->crc = CRC16_CCITT_INIT;
+  dec->code = 0;
+  dec->remaining = 0;
+  dec->overflow = false;
+}
+
+/**
+ * @brief Initialize a COBS frame decoder. Frames longer than `size` bytes (CRC included) are
+ * discarded.
+ *
+ * @param dec Pointer to the CobsDecoder
+ * @param buf Buffer where decoded frames are stored
+ * @param size Size of the buffer in bytes
+ */
+static inline void cobs_decoder_init(CobsDecoder *dec, uint8_t *buf, uint32_t size)
+{
+  dec->buf = buf;
+  dec->size = size;
+  dec->errors = 0;
+  cobs_decoder_reset(dec);
+}
+
+/**
+ * @brief Store one decoded byte of the current frame.
+ *
+ * @param dec Pointer to the CobsDecoder
+ * @param data The decoded byte
+ */
+static inline void cobs_decoder_store(CobsDecoder *dec, uint8_t data)
+{
+  if (dec->length == dec->size)
+  {
+    dec->overflow = true;
+    return;
+  }
+  dec->buf[dec->length++] = data;
+  dec->crc = crc16_ccitt_update(dec->crc, data);
+}
+
+/**
+ * @brief Feed one received byte to the decoder. When `COBS_FRAME_READY` is returned, the payload
+ * is available in the buffer of the decoder and its length is given by
+ * `cobs_decoder_payload_length`. It remains valid until the next byte is fed.
+ *
+ * Example usage:
+ * ```
+ * uint8_t byte;
+ * while (uart_rx_buffer_get(&rxb, &byte))
+ *   if (cobs_decoder_feed(&dec, byte) == COBS_FRAME_READY)
+ *     handle_packet(dec.buf, cobs_decoder_payload_length(&dec));
+ * ```
+ *
+ * @param dec Pointer to the CobsDecoder
+ * @param data The received byte
+ * @return enum CobsStatus
+ */
+static inline enum CobsStatus cobs_decoder_feed(CobsDecoder *dec, uint8_t data)
+{
+  if (data == 0)
+  {
+    // Delimiters between frames (e.g. sent to resynchronize the receiver) are ignored
+    if (dec->code == 0)
+      return COBS_IN_PROGRESS;
+    enum CobsStatus status = COBS_FRAME_READY;
+    if (dec->overflow)
+      status = COBS_ERROR_OVERFLOW;
+    else if (dec->remaining != 0 || dec->length < COBS_CRC_SIZE)
+      status = COBS_ERROR_FRAMING;
+    else if (dec->crc != 0)
+      status = COBS_ERROR_CRC;
+    uint32_t length = dec->length;
+    cobs_decoder_reset(dec);
+    if (status == COBS_FRAME_READY)
+      dec->length = length;
+    else
+      dec->errors++;
+    return status;
+  }
+  if (dec->remaining == 0)
+  {
+    // A new block starts. The previous block ended with an implied zero unless it was full.
+    if (dec->code == 0)
+      dec->length = 0;
+    else if (dec->code <= COBS_BLOCK_SIZE)
+      cobs_decoder_store(dec, 0);
+    dec->code = data;
+    dec->remaining = data - 1;
+    return COBS_IN_PROGRESS;
+  }
+  cobs_decoder_store(dec, data);
+  dec->remaining--;
+  return COBS_IN_PROGRESS;
+}
+
+/**
+ * @brief Return the number of payload bytes of the frame just decoded.
+ *
+ * @param dec Pointer to the CobsDecoder
+ * @return uint32_t
+ */
+static inline uint32_t cobs_decoder_payload_length(CobsDecoder *dec)
+{
+  return dec->length - COBS_CRC_SIZE;
+}
+
+#endif // __LIBSTEEL_COBS__
@@ -0,0 +1,225 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_CRC__
+#define __LIBSTEEL_CRC__
+
+#include "globals.h"
+
+/* CRC-8, CRC-16 and CRC-32 computation using only RV32I instructions (no multiply or divide).
+ *
+ * Three implementations trade code size for speed and are selected at compile time by defining
+ * CRC_IMPLEMENTATION before including this file (or with -DCRC_IMPLEMENTATION=...):
+ *
+ *   - CRC_IMPL_BITWISE: no tables, 8 shift/xor steps per byte. Smallest and slowest.
+ *   - CRC_IMPL_NIBBLE:  16-entry tables, 2 lookups per byte. The default.
+ *   - CRC_IMPL_SLICE4:  4 x 256-entry tables (1 KB for CRC-8, 2 KB for CRC-16, 4 KB for CRC-32),
+ *                       4 lookups per 4 bytes. Fastest for buffers.
+ *
+ * Cycles per byte over a 512-byte buffer, from benchmarks/bench_crc.c (CSR_MCYCLE around `crc8`,
+ * `crc16_ccitt` and `crc32`) built with clang 14 -O2 for rv32i and run on tools/steel_sim.c, which
+ * counts 1 cycle per instruction, plus 1 per load and 2 per taken branch or jump:
+ *
+ *                       CRC-8   CRC-16   CRC-32
+ *   CRC_IMPL_BITWISE     51.5     52.4     43.6
+ *   CRC_IMPL_NIBBLE      22.0     27.0     22.0
+ *   CRC_IMPL_SLICE4       7.5      9.3     11.3
+ *
+ * All functions take the CRC computed so far so that data can be processed in pieces. */
+
+#define CRC_IMPL_BITWISE 0
+#define CRC_IMPL_NIBBLE 1
+#define CRC_IMPL_SLICE4 2
+
+#ifndef CRC_IMPLEMENTATION
+#define CRC_IMPLEMENTATION CRC_IMPL_NIBBLE
+#endif
+
+#include "crc_tables.h"
+
+// Initial value of a CRC-7/MMC computation (polynomial 0x09), used by SD card commands
+#define CRC7_INIT 0x00U
+
+// Initial value of a CRC-8/SMBUS computation (polynomial 0x07, not reflected)
+#define CRC8_INIT 0x00U
+
+// Initial value of a CRC-16/CCITT-FALSE computation (polynomial 0x1021, not reflected)
+#define CRC16_CCITT_INIT 0xFFFFU
+
+// Initial value of a CRC-16/XMODEM computation, used by SD cards. Same polynomial as CRC-16/CCITT.
+#define CRC16_XMODEM_INIT 0x0000U
+
+// Initial value of a CRC-32 (IEEE 802.3) computation (polynomial 0x04C11DB7, reflected)
+#define CRC32_INIT 0xFFFFFFFFU
+
+/**
+ * @brief Update a CRC-7/MMC (polynomial 0x09), as used by SD card commands, with one byte of data.
+ * Start with `CRC7_INIT`. The CRC is kept in the 7 most significant bits of the value, so the last
+ * byte of an SD command is `crc | 1`. Always bitwise: it only covers a few bytes per command.
+ *
+ * @param crc The CRC computed so far, in the 7 most significant bits
+ * @param data The next byte of data
+ * @return uint8_t
+ */
+static inline uint8_t crc7_update(uint8_t crc, uint8_t data)
+{
+  crc ^= data;
+  for (uint32_t i = 0; i < 8; i++)
+    crc = (crc & 0x80) ? (crc << 1) ^ (0x09 << 1) : crc << 1;
+  return crc;
+}
+
+/**
+ * @brief Update a CRC-8/SMBUS with one byte of data. Start with `CRC8_INIT`.
+ *
+ * @param crc The CRC computed so far
+ * @param data The next byte of data
+ * @return uint8_t
+ */
+static inline uint8_t crc8_update(uint8_t crc, uint8_t data)
+{
+  crc ^= data;
+#if CRC_IMPLEMENTATION == CRC_IMPL_BITWISE
+  for (uint32_t i = 0; i < 8; i++)
+    crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  return crc;
+#elif CRC_IMPLEMENTATION == CRC_IMPL_NIBBLE
+  crc = (crc << 4) ^ crc8_nibble_table[crc >> 4];
+  return (crc << 4) ^ crc8_nibble_table[crc >> 4];
+#else
+  return crc8_slice4_table[0][crc];
+#endif
+}
+
+/**
+ * @brief Compute the CRC-8/SMBUS of `length` bytes, starting from `crc`.
+ *
+ * @param crc The CRC computed so far, or `CRC8_INIT`
+ * @param data Pointer to the data
+ * @param length Number of bytes
+ * @return uint8_t
+ */
+static inline uint8_t crc8(uint8_t crc, const uint8_t *data, size_t length)
+{
+  const uint8_t *end = data + length;
+#if CRC_IMPLEMENTATION == CRC_IMPL_SLICE4
+  for (; end - data >= 4; data += 4)
+    crc = crc8_slice4_table[3][crc ^ data[0]] ^ crc8_slice4_table[2][data[1]] ^
+          crc8_slice4_table[1][data[2]] ^ crc8_slice4_table[0][data[3]];
+#endif
+  while (data != end)
+    crc = crc8_update(crc, *data++);
+  return crc;
+}
+
+/**
+ * @brief Update a CRC-16/CCITT-FALSE (or CRC-16/XMODEM) with one byte of data. Start with
+ * `CRC16_CCITT_INIT` (or `CRC16_XMODEM_INIT`). Appending the final CRC to the data, most
+ * significant byte first, makes the CRC of the whole sequence equal to zero.
+ *
+ * @param crc The CRC computed so far
+ * @param data The next byte of data
+ * @return uint16_t
+ */
+static inline uint16_t crc16_ccitt_update(uint16_t crc, uint8_t data)
+{
+#if CRC_IMPLEMENTATION == CRC_IMPL_BITWISE
+  crc ^= (uint16_t)data << 8;
+  for (uint32_t i = 0; i < 8; i++)
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  return crc;
+#elif CRC_IMPLEMENTATION == CRC_IMPL_NIBBLE
+  crc = (crc << 4) ^ crc16_ccitt_nibble_table[(crc >> 12) ^ (data >> 4)];
+  return (crc << 4) ^ crc16_ccitt_nibble_table[(crc >> 12) ^ (data & 0xf)];
+#else
+  return (crc << 8) ^ crc16_ccitt_slice4_table[0][(crc >> 8) ^ data];
+#endif
+}
+
+/**
+ * @brief Compute the CRC-16/CCITT-FALSE (or CRC-16/XMODEM) of `length` bytes, starting from `crc`.
+ *
+ * @param crc The CRC computed so far, `CRC16_CCITT_INIT` or `CRC16_XMODEM_INIT`
+ * @param data Pointer to the data
+ * @param length Number of bytes
+ * @return uint16_t
+ */
+static inline uint16_t crc16_ccitt(uint16_t crc, const uint8_t *data, size_t length)
+{
+  const uint8_t *end = data + length;
+#if CRC_IMPLEMENTATION == CRC_IMPL_SLICE4
+  for (; end - data >= 4; data += 4)
+    crc = crc16_ccitt_slice4_table[3][(crc >> 8) ^ data[0]] ^
+          crc16_ccitt_slice4_table[2][(crc & 0xff) ^ data[1]] ^
+          crc16_ccitt_slice4_table[1][data[2]] ^ crc16_ccitt_slice4_table[0][data[3]];
+#endif
+  while (data != end)
+    crc = crc16_ccitt_update(crc, *data++);
+  return crc;
+}
+
+/**
+ * @brief Update a CRC-32 with one byte of data. Start with `CRC32_INIT` and pass the result to
+ * `crc32_final` once all data was processed.
+ *
+ * @param crc The CRC computed so far
+ * @param data The next byte of data
+ * @return uint32_t
+ */
+static inline uint32_t crc32_update(uint32_t crc, uint8_t data)
+{
+  crc ^= data;
+#if CRC_IMPLEMENTATION == CRC_IMPL_BITWISE
+  for (uint32_t i = 0; i < 8; i++)
+    crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320U : crc >> 1;
+  return crc;
+#elif CRC_IMPLEMENTATION == CRC_IMPL_NIBBLE
+  crc = (crc >> 4) ^ crc32_nibble_table[crc & 0xf];
+  return (crc >> 4) ^ crc32_nibble_table[crc & 0xf];
+#else
+  return (crc >> 8) ^ crc32_slice4_table[0][crc & 0xff];
+#endif
+}
+
+/**
+ * @brief Compute the CRC-32 of `length` bytes, starting from `crc`. The value returned must be
+ * passed to `crc32_final` once all data was processed.
+ *
+ * @param crc The CRC computed so far, or `CRC32_INIT`
+ * @param data Pointer to the data
+ * @param length Number of bytes
+ * @return uint32_t
+ */
+static inline uint32_t crc32(uint32_t crc, const uint8_t *data, size_t length)
+{
+  const uint8_t *end = data + length;
+#if CRC_IMPLEMENTATION == CRC_IMPL_SLICE4
+  // Bytes are combined one by one since RV32I does not allow misaligned word loads
+  for (; end - data >= 4; data += 4)
+  {
+    crc ^= data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+    crc = crc32_slice4_table[3][crc & 0xff] ^ crc32_slice4_table[2][(crc >> 8) & 0xff] ^
+          crc32_slice4_table[1][(crc >> 16) & 0xff] ^ crc32_slice4_table[0][crc >> 24];
+  }
+#endif
+  while (data != end)
+    crc = crc32_update(crc, *data++);
+  return crc;
+}
+
+/**
+ * @brief Return the final value of a CRC-32 computation (the CRC with all bits inverted).
+ *
+ * @param crc The CRC computed by `crc32` or `crc32_update`
+ * @return uint32_t
+ */
+static inline uint32_t crc32_final(uint32_t crc)
+{
+  return ~crc;
+}
+
+#endif // __LIBSTEEL_CRC__
@@ -0,0 +1,409 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_CRC_TABLES__
+#define __LIBSTEEL_CRC_TABLES__
+
+#include "globals.h"
+
+/* Lookup tables used by libsteel/crc.h. Only the tables of the implementation selected with
+ * CRC_IMPLEMENTATION are compiled in.
+ *
+ * Nibble tables hold the CRC of each 4-bit value (16 entries). Slice-by-4 tables hold, in row k,
+ * the CRC of each byte value followed by k zero bytes (4 x 256 entries). */
+
+#if CRC_IMPLEMENTATION == CRC_IMPL_NIBBLE
+
+static const uint8_t crc8_nibble_table[16] = {
+  0x00U, 0x07U, 0x0eU, 0x09U, 0x1cU, 0x1bU, 0x12U, 0x15U,
+  0x38U, 0x3fU, 0x36U, 0x31U, 0x24U, 0x23U, 0x2aU, 0x2dU};
+
+static const uint16_t crc16_ccitt_nibble_table[16] = {
+  0x0000U, 0x1021U, 0x2042U, 0x3063U, 0x4084U, 0x50a5U, 0x60c6U, 0x70e7U,
+  0x8108U, 0x9129U, 0xa14aU, 0xb16bU, 0xc18cU, 0xd1adU, 0xe1ceU, 0xf1efU};
+
+static const uint32_t crc32_nibble_table[16] = {
+  0x00000000U, 0x1db71064U, 0x3b6e20c8U, 0x26d930acU,
+  0x76dc4190U, 0x6b6b51f4U, 0x4db26158U, 0x5005713cU,
+  0xedb88320U, 0xf00f9344U, 0xd6d6a3e8U, 0xcb61b38cU,
+  0x9b64c2b0U, 0x86d3d2d4U, 0xa00ae278U, 0xbdbdf21cU};
+
+#elif CRC_IMPLEMENTATION == CRC_IMPL_SLICE4
+
+static const uint8_t crc8_slice4_table[4][256] = {
+  {
+    0x00U, 0x07U, 0x0eU, 0x09U, 0x1cU, 0x1bU, 0x12U, 0x15U, 0x38U, 0x3fU, 0x36U, 0x31U,
+    0x24U, 0x23U, 0x2aU, 0x2dU, 0x70U, 0x77U, 0x7eU, 0x79U, 0x6cU, 0x6bU, 0x62U, 0x65U,
+    0x48U, 0x4fU, 0x46U, 0x41U, 0x54U, 0x53U, 0x5aU, 0x5dU, 0xe0U, 0xe7U, 0xeeU, 0xe9U,
+    0xfcU, 0xfbU, 0xf2U, 0xf5U, 0xd8U, 0xdfU, 0xd6U, 0xd1U, 0xc4U, 0xc3U, 0xcaU, 0xcdU,
+    0x90U, 0x97U, 0x9eU, 0x99U, 0x8cU, 0x8bU, 0x82U, 0x85U, 0xa8U, 0xafU, 0xa6U, 0xa1U,
+    0xb4U, 0xb3U, 0xbaU, 0xbdU, 0xc7U, 0xc0U, 0xc9U, 0xceU, 0xdbU, 0xdcU, 0xd5U, 0xd2U,
+    0xffU, 0xf8U, 0xf1U, 0xf6U, 0xe3U, 0xe4U, 0xedU, 0xeaU, 0xb7U, 0xb0U, 0xb9U, 0xbeU,
+    0xabU, 0xacU, 0xa5U, 0xa2U, 0x8fU, 0x88U, 0x81U, 0x86U, 0x93U, 0x94U, 0x9dU, 0x9aU,
+    0x27U, 0x20U, 0x29U, 0x2eU, 0x3bU, 0x3cU, 0x35U, 0x32U, 0x1fU, 0x18U, 0x11U, 0x16U,
+    0x03U, 0x04U, 0x0dU, 0x0aU, 0x57U, 0x50U, 0x59U, 0x5eU, 0x4bU, 0x4cU, 0x45U, 0x42U,
+    0x6fU, 0x68U, 0x61U, 0x66U, 0x73U, 0x74U, 0x7dU, 0x7aU, 0x89U, 0x8eU, 0x87U, 0x80U,
+    0x95U, 0x92U, 0x9bU, 0x9cU, 0xb1U, 0xb6U, 0xbfU, 0xb8U, 0xadU, 0xaaU, 0xa3U, 0xa4U,
+    0xf9U, 0xfeU, 0xf7U, 0xf0U, 0xe5U, 0xe2U, 0xebU, 0xecU, 0xc1U, 0xc6U, 0xcfU, 0xc8U,
+    0xddU, 0xdaU, 0xd3U, 0xd4U, 0x69U, 0x6eU, 0x67U, 0x60U, 0x75U, 0x72U, 0x7bU, 0x7cU,
+    0x51U, 0x56U, 0x5fU, 0x58U, 0x4dU, 0x4aU, 0x43U, 0x44U, 0x19U, 0x1eU, 0x17U, 0x10U,
+    0x05U, 0x02U, 0x0bU, 0x0cU, 0x21U, 0x26U, 0x2fU, 0x28U, 0x3dU, 0x3aU, 0x33U, 0x34U,
+    0x4eU, 0x49U, 0x40U, 0x47U, 0x52U, 0x55U, 0x5cU, 0x5bU, 0x76U, 0x71U, 0x78U, 0x7fU,
+    0x6aU, 0x6dU, 0x64U, 0x63U, 0x3eU, 0x39U, 0x30U, 0x37U, 0x22U, 0x25U, 0x2cU, 0x2bU,
+    0x06U, 0x01U, 0x08U, 0x0fU, 0x1aU, 0x1dU, 0x14U, 0x13U, 0xaeU, 0xa9U, 0xa0U, 0xa7U,
+    0xb2U, 0xb5U, 0xbcU, 0xbbU, 0x96U, 0x91U, 0x98U, 0x9fU, 0x8aU, 0x8dU, 0x84U, 0x83U,
+    0xdeU, 0xd9U, 0xd0U, 0xd7U, 0xc2U, 0xc5U, 0xccU, 0xcbU, 0xe6U, 0xe1U, 0xe8U, 0xefU,
+    0xfaU, 0xfdU, 0xf4U, 0xf3U
+  },
+  {
+    0x00U, 0x15U, 0x2aU, 0x3fU, 0x54U, 0x41U, 0x7eU, 0x6bU, 0xa8U, 0xbdU, 0x82U, 0x97U,
+    0xfcU, 0xe9U, 0xd6U, 0xc3U, 0x57U, 0x42U, 0x7dU, 0x68U, 0x03U, 0x16U, 0x29U, 0x3cU,
+    0xffU, 0xeaU, 0xd5U, 0xc0U, 0xabU, 0xbeU, 0x81U, 0x94U, 0xaeU, 0xbbU, 0x84U, 0x91U,
+    0xfaU, 0xefU, 0xd0U, 0xc5U, 0x06U, 0x13U, 0x2cU, 0x39U, 0x52U, 0x47U, 0x78U, 0x6dU,
+    0xf9U, 0xecU, 0xd3U, 0xc6U, 0xadU, 0xb8U, 0x87U, 0x92U, 0x51U, 0x44U, 0x7bU, 0x6eU,
+    0x05U, 0x10U, 0x2fU, 0x3aU, 0x5bU, 0x4eU, 0x71U, 0x64U, 0x0fU, 0x1aU, 0x25U, 0x30U,
+    0xf3U, 0xe6U, 0xd9U, 0xccU, 0xa7U, 0xb2U, 0x8dU, 0x98U, 0x0cU, 0x19U, 0x26U, 0x33U,
+    0x58U, 0x4dU, 0x72U, 0x67U, 0xa4U, 0xb1U, 0x8eU, 0x9bU, 0xf0U, 0xe5U, 0xdaU, 0xcfU,
+    0xf5U, 0xe0U, 0xdfU, 0xcaU, 0xa1U, 0xb4U, 0x8bU, 0x9eU, 0x5dU, 0x48U, 0x77U, 0x62U,
+    0x09U, 0x1cU, 0x23U, 0x36U, 0xa2U, 0xb7U, 0x88U, 0x9dU, 0xf6U, 0xe3U, 0xdcU, 0xc9U,
+    0x0aU, 0x1fU, 0x20U, 0x35U, 0x5eU, 0x4bU, 0x74U, 0x61U, 0xb6U, 0xa3U, 0x9cU, 0x89U,
+    0xe2U, 0xf7U, 0xc8U, 0xddU, 0x1eU, 0x0bU, 0x34U, 0x21U, 0x4aU, 0x5fU, 0x60U, 0x75U,
+    0xe1U, 0xf4U, 0xcbU, 0xdeU, 0xb5U, 0xa0U, 0x9fU, 0x8aU, 0x49U, 0x5cU, 0x63U, 0x76U,
+    0x1dU, 0x08U, 0x37U, 0x22U, 0x18U, 0x0dU, 0x32U, 0x27U, 0x4cU, 0x59U, 0x66U, 0x73U,
+    0xb0U, 0xa5U, 0x9aU, 0x8fU, 0xe4U, 0xf1U, 0xceU, 0xdbU, 0x4fU, 0x5aU, 0x65U, 0x70U,
+    0x1bU, 0x0eU, 0x31U, 0x24U, 0xe7U, 0xf2U, 0xcdU, 0xd8U, 0xb3U, 0xa6U, 0x99U, 0x8cU,
+    0xedU, 0xf8U, 0xc7U, 0xd2U, 0xb9U, 0xacU, 0x93U, 0x86U, 0x45U, 0x50U, 0x6fU, 0x7aU,
+    0x11U, 0x04U, 0x3bU, 0x2eU, 0xbaU, 0xafU, 0x90U, 0x85U, 0xeeU, 0xfbU, 0xc4U, 0xd1U,
+    0x12U, 0x07U, 0x38U, 0x2dU, 0x46U, 0x53U, 0x6cU, 0x79U, 0x43U, 0x56U, 0x69U, 0x7cU,
+    0x17U, 0x02U, 0x3dU, 0x28U, 0xebU, 0xfeU, 0xc1U, 0xd4U, 0xbfU, 0xaaU, 0x95U, 0x80U,
+    0x14U, 0x01U, 0x3eU, 0x2bU, 0x40U, 0x55U, 0x6aU, 0x7fU, 0xbcU, 0xa9U, 0x96U, 0x83U,
+    0xe8U, 0xfdU, 0xc2U, 0xd7U
+  },
+  {
+    0x00U, 0x6bU, 0xd6U, 0xbdU, 0xabU, 0xc0U, 0x7dU, 0x16U, 0x51U, 0x3aU, 0x87U, 0xecU,
+    0xfaU, 0x91U, 0x2cU, 0x47U, 0xa2U, 0xc9U, 0x74U, 0x1fU, 0x09U, 0x62U, 0xdfU, 0xb4U,
+    0xf3U, 0x98U, 0x25U, 0x4eU, 0x58U, 0x33U, 0x8eU, 0xe5U, 0x43U, 0x28U, 0x95U, 0xfeU,
+    0xe8U, 0x83U, 0x3eU, 0x55U, 0x12U, 0x79U, 0xc4U, 0xafU, 0xb9U, 0xd2U, 0x6fU, 0x04U,
+    0xe1U, 0x8aU, 0x37U, 0x5cU, 0x4aU, 0x21U, 0x9cU, 0xf7U, 0xb0U, 0xdbU, 0x66U, 0x0dU,
+    0x1bU, 0x70U, 0xcdU, 0xa6U, 0x86U, 0xedU, 0x50U, 0x3bU, 0x2dU, 0x46U, 0xfbU, 0x90U,
+    0xd7U, 0xbcU, 0x01U, 0x6aU, 0x7cU, 0x17U, 0xaaU, 0xc1U, 0x24U, 0x4fU, 0xf2U, 0x99U,
+    0x8fU, 0xe4U, 0x59U, 0x32U, 0x75U, 0x1eU, 0xa3U, 0xc8U, 0xdeU, 0xb5U, 0x08U, 0x63U,
+    0xc5U, 0xaeU, 0x13U, 0x78U, 0x6eU, 0x05U, 0xb8U, 0xd3U, 0x94U, 0xffU, 0x42U, 0x29U,
+    0x3fU, 0x54U, 0xe9U, 0x82U, 0x67U, 0x0cU, 0xb1U, 0xdaU, 0xccU, 0xa7U, 0x1aU, 0x71U,
+    0x36U, 0x5dU, 0xe0U, 0x8bU, 0x9dU, 0xf6U, 0x4bU, 0x20U, 0x0bU, 0x60U, 0xddU, 0xb6U,
+    0xa0U, 0xcbU, 0x76U, 0x1dU, 0x5aU, 0x31U, 0x8cU, 0xe7U, 0xf1U, 0x9aU, 0x27U, 0x4cU,
+    0xa9U, 0xc2U, 0x7fU, 0x14U, 0x02U, 0x69U, 0xd4U, 0xbfU, 0xf8U, 0x93U, 0x2eU, 0x45U,
+    0x53U, 0x38U, 0x85U, 0xeeU, 0x48U, 0x23U, 0x9eU, 0xf5U, 0xe3U, 0x88U, 0x35U, 0x5eU,
+    0x19U, 0x72U, 0xcfU, 0xa4U, 0xb2U, 0xd9U, 0x64U, 0x0fU, 0xeaU, 0x81U, 0x3cU, 0x57U,
+    0x41U, 0x2aU, 0x97U, 0xfcU, 0xbbU, 0xd0U, 0x6dU, 0x06U, 0x10U, 0x7bU, 0xc6U, 0xadU,
+    0x8dU, 0xe6U, 0x5bU, 0x30U, 0x26U, 0x4dU, 0xf0U, 0x9bU, 0xdcU, 0xb7U, 0x0aU, 0x61U,
+    0x77U, 0x1cU, 0xa1U, 0xcaU, 0x2fU, 0x44U, 0xf9U, 0x92U, 0x84U, 0xefU, 0x52U, 0x39U,
+    0x7eU, 0x15U, 0xa8U, 0xc3U, 0xd5U, 0xbeU, 0x03U, 0x68U, 0xceU, 0xa5U, 0x18U, 0x73U,
+    0x65U, 0x0eU, 0xb3U, 0xd8U, 0x9fU, 0xf4U, 0x49U, 0x22U, 0x34U, 0x5fU, 0xe2U, 0x89U,
+    0x6cU, 0x07U, 0xbaU, 0xd1U, 0xc7U, 0xacU, 0x11U, 0x7aU, 0x3dU, 0x56U, 0xebU, 0x80U,
+    0x96U, 0xfdU, 0x40U, 0x2bU
+  },
+  {
+    0x00U, 0x16U, 0x2cU, 0x3aU, 0x58U, 0x4eU, 0x74U, 0x62U, 0xb0U, 0xa6U, 0x9cU, 0x8aU,
+    0xe8U, 0xfeU, 0xc4U, 0xd2U, 0x67U, 0x71U, 0x4bU, 0x5dU, 0x3fU, 0x29U, 0x13U, 0x05U,
+    0xd7U, 0xc1U, 0xfbU, 0xedU, 0x8fU, 0x99U, 0xa3U, 0xb5U, 0xceU, 0xd8U, 0xe2U, 0xf4U,
+    0x96U, 0x80U, 0xbaU, 0xacU, 0x7eU, 0x68U, 0x52U, 0x44U, 0x26U, 0x30U, 0x0aU, 0x1cU,
+    0xa9U, 0xbfU, 0x85U, 0x93U, 0xf1U, 0xe7U, 0xddU, 0xcbU, 0x19U, 0x0fU, 0x35U, 0x23U,
+    0x41U, 0x57U, 0x6dU, 0x7bU, 0x9bU, 0x8dU, 0xb7U, 0xa1U, 0xc3U, 0xd5U, 0xefU, 0xf9U,
+    0x2bU, 0x3dU, 0x07U, 0x11U, 0x73U, 0x65U, 0x5fU, 0x49U, 0xfcU, 0xeaU, 0xd0U, 0xc6U,
+    0xa4U, 0xb2U, 0x88U, 0x9eU, 0x4cU, 0x5aU, 0x60U, 0x76U, 0x14U, 0x02U, 0x38U, 0x2eU,
+    0x55U, 0x43U, 0x79U, 0x6fU, 0x0dU, 0x1bU, 0x21U, 0x37U, 0xe5U, 0xf3U, 0xc9U, 0xdfU,
+    0xbdU, 0xabU, 0x91U, 0x87U, 0x32U, 0x24U, 0x1eU, 0x08U, 0x6aU, 0x7cU, 0x46U, 0x50U,
+    0x82U, 0x94U, 0xaeU, 0xb8U, 0xdaU, 0xccU, 0xf6U, 0xe0U, 0x31U, 0x27U, 0x1dU, 0x0bU,
+    0x69U, 0x7fU, 0x45U, 0x53U, 0x81U, 0x97U, 0xadU, 0xbbU, 0xd9U, 0xcfU, 0xf5U, 0xe3U,
+    0x56U, 0x40U, 0x7aU, 0x6cU, 0x0eU, 0x18U, 0x22U, 0x34U, 0xe6U, 0xf0U, 0xcaU, 0xdcU,
+    0xbeU, 0xa8U, 0x92U, 0x84U, 0xffU, 0xe9U, 0xd3U, 0xc5U, 0xa7U, 0xb1U, 0x8bU, 0x9dU,
+    0x4fU, 0x59U, 0x63U, 0x75U, 0x17U, 0x01U, 0x3bU, 0x2dU, 0x98U, 0x8eU, 0xb4U, 0xa2U,
+    0xc0U, 0xd6U, 0xecU, 0xfaU, 0x28U, 0x3eU, 0x04U, 0x12U, 0x70U, 0x66U, 0x5cU, 0x4aU,
+    0xaaU, 0xbcU, 0x86U, 0x90U, 0xf2U, 0xe4U, 0xdeU, 0xc8U, 0x1aU, 0x0cU, 0x36U, 0x20U,
+    0x42U, 0x54U, 0x6eU, 0x78U, 0xcdU, 0xdbU, 0xe1U, 0xf7U, 0x95U, 0x83U, 0xb9U, 0xafU,
+    0x7dU, 0x6bU, 0x51U, 0x47U, 0x25U, 0x33U, 0x09U, 0x1fU, 0x64U, 0x72U, 0x48U, 0x5eU,
+    0x3cU, 0x2aU, 0x10U, 0x06U, 0xd4U, 0xc2U, 0xf8U, 0xeeU, 0x8cU, 0x9aU, 0xa0U, 0xb6U,
+    0x03U, 0x15U, 0x2fU, 0x39U, 0x5bU, 0x4dU, 0x77U, 0x61U, 0xb3U, 0xa5U, 0x9fU, 0x89U,
+    0xebU, 0xfdU, 0xc7U, 0xd1U
+  }};
+
+static const uint16_t crc16_ccitt_slice4_table[4][256] = {
+  {
+    0x0000U, 0x1021U, 0x2042U, 0x3063U, 0x4084U, 0x50a5U, 0x60c6U, 0x70e7U, 0x8108U, 0x9129U,
+    0xa14aU, 0xb16bU, 0xc18cU, 0xd1adU, 0xe1ceU, 0xf1efU, 0x1231U, 0x0210U, 0x3273U, 0x2252U,
+    0x52b5U, 0x4294U, 0x72f7U, 0x62d6U, 0x9339U, 0x8318U, 0xb37bU, 0xa35aU, 0xd3bdU, 0xc39cU,
+    0xf3ffU, 0xe3deU, 0x2462U, 0x3443U, 0x0420U, 0x1401U, 0x64e6U, 0x74c7U, 0x44a4U, 0x5485U,
+    0xa56aU, 0xb54bU, 0x8528U, 0x9509U, 0xe5eeU, 0xf5cfU, 0xc5acU, 0xd58dU, 0x3653U, 0x2672U,
+    0x1611U, 0x0630U, 0x76d7U, 0x66f6U, 0x5695U, 0x46b4U, 0xb75bU, 0xa77aU, 0x9719U, 0x8738U,
+    0xf7dfU, 0xe7feU, 0xd79dU, 0xc7bcU, 0x48c4U, 0x58e5U, 0x6886U, 0x78a7U, 0x0840U, 0x1861U,
+    0x2802U, 0x3823U, 0xc9ccU, 0xd9edU, 0xe98eU, 0xf9afU, 0x8948U, 0x9969U, 0xa90aU, 0xb92bU,
+    0x5af5U, 0x4ad4U, 0x7ab7U, 0x6a96U, 0x1a71U, 0x0a50U, 0x3a33U, 0x2a12U, 0xdbfdU, 0xcbdcU,
+    0xfbbfU, 0xeb9eU, 0x9b79U, 0x8b58U, 0xbb3bU, 0xab1aU, 0x6ca6U, 0x7c87U, 0x4ce4U, 0x5cc5U,
+    0x2c22U, 0x3c03U, 0x0c60U, 0x1c41U, 0xedaeU, 0xfd8fU, 0xcdecU, 0xddcdU, 0xad2aU, 0xbd0bU,
+    0x8d68U, 0x9d49U, 0x7e97U, 0x6eb6U, 0x5ed5U, 0x4ef4U, 0x3e13U, 0x2e32U, 0x1e51U, 0x0e70U,
+    0xff9fU, 0xefbeU, 0xdfddU, 0xcffcU, 0xbf1bU, 0xaf3aU, 0x9f59U, 0x8f78U, 0x9188U, 0x81a9U,
+    0xb1caU, 0xa1ebU, 0xd10cU, 0xc12dU, 0xf14eU, 0xe16fU, 0x1080U, 0x00a1U, 0x30c2U, 0x20e3U,
+    0x5004U, 0x4025U, 0x7046U, 0x6067U, 0x83b9U, 0x9398U, 0xa3fbU, 0xb3daU, 0xc33dU, 0xd31cU,
+    0xe37fU, 0xf35eU, 0x02b1U, 0x1290U, 0x22f3U, 0x32d2U, 0x4235U, 0x5214U, 0x6277U, 0x7256U,
+    0xb5eaU, 0xa5cbU, 0x95a8U, 0x8589U, 0xf56eU, 0xe54fU, 0xd52cU, 0xc50dU, 0x34e2U, 0x24c3U,
+    0x14a0U, 0x0481U, 0x7466U, 0x6447U, 0x5424U, 0x4405U, 0xa7dbU, 0xb7faU, 0x8799U, 0x97b8U,
+    0xe75fU, 0xf77eU, 0xc71dU, 0xd73cU, 0x26d3U, 0x36f2U, 0x0691U, 0x16b0U, 0x6657U, 0x7676U,
+    0x4615U, 0x5634U, 0xd94cU, 0xc96dU, 0xf90eU, 0xe92fU, 0x99c8U, 0x89e9U, 0xb98aU, 0xa9abU,
+    0x5844U, 0x4865U, 0x7806U, 0x6827U, 0x18c0U, 0x08e1U, 0x3882U, 0x28a3U, 0xcb7dU, 0xdb5cU,
+    0xeb3fU, 0xfb1eU, 0x8bf9U, 0x9bd8U, 0xabbbU, 0xbb9aU, 0x4a75U, 0x5a54U, 0x6a37U, 0x7a16U,
+    0x0af1U, 0x1ad0U, 0x2ab3U, 0x3a92U, 0xfd2eU, 0xed0fU, 0xdd6cU, 0xcd4dU, 0xbdaaU, 0xad8bU,
+    0x9de8U, 0x8dc9U, 0x7c26U, 0x6c07U, 0x5c64U, 0x4c45U, 0x3ca2U, 0x2c83U, 0x1ce0U, 0x0cc1U,
+    0xef1fU, 0xff3eU, 0xcf5dU, 0xdf7cU, 0xaf9bU, 0xbfbaU, 0x8fd9U, 0x9ff8U, 0x6e17U, 0x7e36U,
+    0x4e55U, 0x5e74U, 0x2e93U, 0x3eb2U, 0x0ed1U, 0x1ef0U
+  },
+  {
+    0x0000U, 0x3331U, 0x6662U, 0x5553U, 0xccc4U, 0xfff5U, 0xaaa6U, 0x9997U, 0x89a9U, 0xba98U,
+    0xefcbU, 0xdcfaU, 0x456dU, 0x765cU, 0x230fU, 0x103eU, 0x0373U, 0x3042U, 0x6511U, 0x5620U,
+    0xcfb7U, 0xfc86U, 0xa9d5U, 0x9ae4U, 0x8adaU, 0xb9ebU, 0xecb8U, 0xdf89U, 0x461eU, 0x752fU,
+    0x207cU, 0x134dU, 0x06e6U, 0x35d7U, 0x6084U, 0x53b5U, 0xca22U, 0xf913U, 0xac40U, 0x9f71U,
+    0x8f4fU, 0xbc7eU, 0xe92dU, 0xda1cU, 0x438bU, 0x70baU, 0x25e9U, 0x16d8U, 0x0595U, 0x36a4U,
+    0x63f7U, 0x50c6U, 0xc951U, 0xfa60U, 0xaf33U, 0x9c02U, 0x8c3cU, 0xbf0dU, 0xea5eU, 0xd96fU,
+    0x40f8U, 0x73c9U, 0x269aU, 0x15abU, 0x0dccU, 0x3efdU, 0x6baeU, 0x589fU, 0xc108U, 0xf239U,
+    0xa76aU, 0x945bU, 0x8465U, 0xb754U, 0xe207U, 0xd136U, 0x48a1U, 0x7b90U, 0x2ec3U, 0x1df2U,
+    0x0ebfU, 0x3d8eU, 0x68ddU, 0x5becU, 0xc27bU, 0xf14aU, 0xa419U, 0x9728U, 0x8716U, 0xb427U,
+    0xe174U, 0xd245U, 0x4bd2U, 0x78e3U, 0x2db0U, 0x1e81U, 0x0b2aU, 0x381bU, 0x6d48U, 0x5e79U,
+    0xc7eeU, 0xf4dfU, 0xa18cU, 0x92bdU, 0x8283U, 0xb1b2U, 0xe4e1U, 0xd7d0U, 0x4e47U, 0x7d76U,
+    0x2825U, 0x1b14U, 0x0859U, 0x3b68U, 0x6e3bU, 0x5d0aU, 0xc49dU, 0xf7acU, 0xa2ffU, 0x91ceU,
+    0x81f0U, 0xb2c1U, 0xe792U, 0xd4a3U, 0x4d34U, 0x7e05U, 0x2b56U, 0x1867U, 0x1b98U, 0x28a9U,
+    0x7dfaU, 0x4ecbU, 0xd75cU, 0xe46dU, 0xb13eU, 0x820fU, 0x9231U, 0xa100U, 0xf453U, 0xc762U,
+    0x5ef5U, 0x6dc4U, 0x3897U, 0x0ba6U, 0x18ebU, 0x2bdaU, 0x7e89U, 0x4db8U, 0xd42fU, 0xe71eU,
+    0xb24dU, 0x817cU, 0x9142U, 0xa273U, 0xf720U, 0xc411U, 0x5d86U, 0x6eb7U, 0x3be4U, 0x08d5U,
+    0x1d7eU, 0x2e4fU, 0x7b1cU, 0x482dU, 0xd1baU, 0xe28bU, 0xb7d8U, 0x84e9U, 0x94d7U, 0xa7e6U,
+    0xf2b5U, 0xc184U, 0x5813U, 0x6b22U, 0x3e71U, 0x0d40U, 0x1e0dU, 0x2d3cU, 0x786fU, 0x4b5eU,
+    0xd2c9U, 0xe1f8U, 0xb4abU, 0x879aU, 0x97a4U, 0xa495U, 0xf1c6U, 0xc2f7U, 0x5b60U, 0x6851U,
+    0x3d02U, 0x0e33U, 0x1654U, 0x2565U, 0x7036U, 0x4307U, 0xda90U, 0xe9a1U, 0xbcf2U, 0x8fc3U,
+    0x9ffdU, 0xacccU, 0xf99fU, 0xcaaeU, 0x5339U, 0x6008U, 0x355bU, 0x066aU, 0x1527U, 0x2616U,
+    0x7345U, 0x4074U, 0xd9e3U, 0xead2U, 0xbf81U, 0x8cb0U, 0x9c8eU, 0xafbfU, 0xfaecU, 0xc9ddU,
+    0x504aU, 0x637bU, 0x3628U, 0x0519U, 0x10b2U, 0x2383U, 0x76d0U, 0x45e1U, 0xdc76U, 0xef47U,
+    0xba14U, 0x8925U, 0x991bU, 0xaa2aU, 0xff79U, 0xcc48U, 0x55dfU, 0x66eeU, 0x33bdU, 0x008cU,
+    0x13c1U, 0x20f0U, 0x75a3U, 0x4692U, 0xdf05U, 0xec34U, 0xb967U, 0x8a56U, 0x9a68U, 0xa959U,
+    0xfc0aU, 0xcf3bU, 0x56acU, 0x659dU, 0x30ceU, 0x03ffU
+  },
+  {
+    0x0000U, 0x3730U, 0x6e60U, 0x5950U, 0xdcc0U, 0xebf0U, 0xb2a0U, 0x8590U, 0xa9a1U, 0x9e91U,
+    0xc7c1U, 0xf0f1U, 0x7561U, 0x4251U, 0x1b01U, 0x2c31U, 0x4363U, 0x7453U, 0x2d03U, 0x1a33U,
+    0x9fa3U, 0xa893U, 0xf1c3U, 0xc6f3U, 0xeac2U, 0xddf2U, 0x84a2U, 0xb392U, 0x3602U, 0x0132U,
+    0x5862U, 0x6f52U, 0x86c6U, 0xb1f6U, 0xe8a6U, 0xdf96U, 0x5a06U, 0x6d36U, 0x3466U, 0x0356U,
+    0x2f67U, 0x1857U, 0x4107U, 0x7637U, 0xf3a7U, 0xc497U, 0x9dc7U, 0xaaf7U, 0xc5a5U, 0xf295U,
+    0xabc5U, 0x9cf5U, 0x1965U, 0x2e55U, 0x7705U, 0x4035U, 0x6c04U, 0x5b34U, 0x0264U, 0x3554U,
+    0xb0c4U, 0x87f4U, 0xdea4U, 0xe994U, 0x1dadU, 0x2a9dU, 0x73cdU, 0x44fdU, 0xc16dU, 0xf65dU,
+    0xaf0dU, 0x983dU, 0xb40cU, 0x833cU, 0xda6cU, 0xed5cU, 0x68ccU, 0x5ffcU, 0x06acU, 0x319cU,
+    0x5eceU, 0x69feU, 0x30aeU, 0x079eU, 0x820eU, 0xb53eU, 0xec6eU, 0xdb5eU, 0xf76fU, 0xc05fU,
+    0x990fU, 0xae3fU, 0x2bafU, 0x1c9fU, 0x45cfU, 0x72ffU, 0x9b6bU, 0xac5bU, 0xf50bU, 0xc23bU,
+    0x47abU, 0x709bU, 0x29cbU, 0x1efbU, 0x32caU, 0x05faU, 0x5caaU, 0x6b9aU, 0xee0aU, 0xd93aU,
+    0x806aU, 0xb75aU, 0xd808U, 0xef38U, 0xb668U, 0x8158U, 0x04c8U, 0x33f8U, 0x6aa8U, 0x5d98U,
+    0x71a9U, 0x4699U, 0x1fc9U, 0x28f9U, 0xad69U, 0x9a59U, 0xc309U, 0xf439U, 0x3b5aU, 0x0c6aU,
+    0x553aU, 0x620aU, 0xe79aU, 0xd0aaU, 0x89faU, 0xbecaU, 0x92fbU, 0xa5cbU, 0xfc9bU, 0xcbabU,
+    0x4e3bU, 0x790bU, 0x205bU, 0x176bU, 0x7839U, 0x4f09U, 0x1659U, 0x2169U, 0xa4f9U, 0x93c9U,
+    0xca99U, 0xfda9U, 0xd198U, 0xe6a8U, 0xbff8U, 0x88c8U, 0x0d58U, 0x3a68U, 0x6338U, 0x5408U,
+    0xbd9cU, 0x8aacU, 0xd3fcU, 0xe4ccU, 0x615cU, 0x566cU, 0x0f3cU, 0x380cU, 0x143dU, 0x230dU,
+    0x7a5dU, 0x4d6dU, 0xc8fdU, 0xffcdU, 0xa69dU, 0x91adU, 0xfeffU, 0xc9cfU, 0x909fU, 0xa7afU,
+    0x223fU, 0x150fU, 0x4c5fU, 0x7b6fU, 0x575eU, 0x606eU, 0x393eU, 0x0e0eU, 0x8b9eU, 0xbcaeU,
+    0xe5feU, 0xd2ceU, 0x26f7U, 0x11c7U, 0x4897U, 0x7fa7U, 0xfa37U, 0xcd07U, 0x9457U, 0xa367U,
+    0x8f56U, 0xb866U, 0xe136U, 0xd606U, 0x5396U, 0x64a6U, 0x3df6U, 0x0ac6U, 0x6594U, 0x52a4U,
+    0x0bf4U, 0x3cc4U, 0xb954U, 0x8e64U, 0xd734U, 0xe004U, 0xcc35U, 0xfb05U, 0xa255U, 0x9565U,
+    0x10f5U, 0x27c5U, 0x7e95U, 0x49a5U, 0xa031U, 0x9701U, 0xce51U, 0xf961U, 0x7cf1U, 0x4bc1U,
+    0x1291U, 0x25a1U, 0x0990U, 0x3ea0U, 0x67f0U, 0x50c0U, 0xd550U, 0xe260U, 0xbb30U, 0x8c00U,
+    0xe352U, 0xd462U, 0x8d32U, 0xba02U, 0x3f92U, 0x08a2U, 0x51f2U, 0x66c2U, 0x4af3U, 0x7dc3U,
+    0x2493U, 0x13a3U, 0x9633U, 0xa103U, 0xf853U, 0xcf63U
+  },
+  {
+    0x0000U, 0x76b4U, 0xed68U, 0x9bdcU, 0xcaf1U, 0xbc45U, 0x2799U, 0x512dU, 0x85c3U, 0xf377U,
+    0x68abU, 0x1e1fU, 0x4f32U, 0x3986U, 0xa25aU, 0xd4eeU, 0x1ba7U, 0x6d13U, 0xf6cfU, 0x807bU,
+    0xd156U, 0xa7e2U, 0x3c3eU, 0x4a8aU, 0x9e64U, 0xe8d0U, 0x730cU, 0x05b8U, 0x5495U, 0x2221U,
+    0xb9fdU, 0xcf49U, 0x374eU, 0x41faU, 0xda26U, 0xac92U, 0xfdbfU, 0x8b0bU, 0x10d7U, 0x6663U,
+    0xb28dU, 0xc439U, 0x5fe5U, 0x2951U, 0x787cU, 0x0ec8U, 0x9514U, 0xe3a0U, 0x2ce9U, 0x5a5dU,
+    0xc181U, 0xb735U, 0xe618U, 0x90acU, 0x0b70U, 0x7dc4U, 0xa92aU, 0xdf9eU, 0x4442U, 0x32f6U,
+    0x63dbU, 0x156fU, 0x8eb3U, 0xf807U, 0x6e9cU, 0x1828U, 0x83f4U, 0xf540U, 0xa46dU, 0xd2d9U,
+    0x4905U, 0x3fb1U, 0xeb5fU, 0x9debU, 0x0637U, 0x7083U, 0x21aeU, 0x571aU, 0xccc6U, 0xba72U,
+    0x753bU, 0x038fU, 0x9853U, 0xeee7U, 0xbfcaU, 0xc97eU, 0x52a2U, 0x2416U, 0xf0f8U, 0x864cU,
+    0x1d90U, 0x6b24U, 0x3a09U, 0x4cbdU, 0xd761U, 0xa1d5U, 0x59d2U, 0x2f66U, 0xb4baU, 0xc20eU,
+    0x9323U, 0xe597U, 0x7e4bU, 0x08ffU, 0xdc11U, 0xaaa5U, 0x3179U, 0x47cdU, 0x16e0U, 0x6054U,
+    0xfb88U, 0x8d3cU, 0x4275U, 0x34c1U, 0xaf1dU, 0xd9a9U, 0x8884U, 0xfe30U, 0x65ecU, 0x1358U,
+    0xc7b6U, 0xb102U, 0x2adeU, 0x5c6aU, 0x0d47U, 0x7bf3U, 0xe02fU, 0x969bU, 0xdd38U, 0xab8cU,
+    0x3050U, 0x46e4U, 0x17c9U, 0x617dU, 0xfaa1U, 0x8c15U, 0x58fbU, 0x2e4fU, 0xb593U, 0xc327U,
+    0x920aU, 0xe4beU, 0x7f62U, 0x09d6U, 0xc69fU, 0xb02bU, 0x2bf7U, 0x5d43U, 0x0c6eU, 0x7adaU,
+    0xe106U, 0x97b2U, 0x435cU, 0x35e8U, 0xae34U, 0xd880U, 0x89adU, 0xff19U, 0x64c5U, 0x1271U,
+    0xea76U, 0x9cc2U, 0x071eU, 0x71aaU, 0x2087U, 0x5633U, 0xcdefU, 0xbb5bU, 0x6fb5U, 0x1901U,
+    0x82ddU, 0xf469U, 0xa544U, 0xd3f0U, 0x482cU, 0x3e98U, 0xf1d1U, 0x8765U, 0x1cb9U, 0x6a0dU,
+    0x3b20U, 0x4d94U, 0xd648U, 0xa0fcU, 0x7412U, 0x02a6U, 0x997aU, 0xefceU, 0xbee3U, 0xc857U,
+    0x538bU, 0x253fU, 0xb3a4U, 0xc510U, 0x5eccU, 0x2878U, 0x7955U, 0x0fe1U, 0x943dU, 0xe289U,
+    0x3667U, 0x40d3U, 0xdb0fU, 0xadbbU, 0xfc96U, 0x8a22U, 0x11feU, 0x674aU, 0xa803U, 0xdeb7U,
+    0x456bU, 0x33dfU, 0x62f2U, 0x1446U, 0x8f9aU, 0xf92eU, 0x2dc0U, 0x5b74U, 0xc0a8U, 0xb61cU,
+    0xe731U, 0x9185U, 0x0a59U, 0x7cedU, 0x84eaU, 0xf25eU, 0x6982U, 0x1f36U, 0x4e1bU, 0x38afU,
+    0xa373U, 0xd5c7U, 0x0129U, 0x779dU, 0xec41U, 0x9af5U, 0xcbd8U, 0xbd6cU, 0x26b0U, 0x5004U,
+    0x9f4dU, 0xe9f9U, 0x7225U, 0x0491U, 0x55bcU, 0x2308U, 0xb8d4U, 0xce60U, 0x1a8eU, 0x6c3aU,
+    0xf7e6U, 0x8152U, 0xd07fU, 0xa6cbU, 0x3d17U, 0x4ba3U
+  }};
+
+static const uint32_t crc32_slice4_table[4][256] = {
+  {
+    0x00000000U, 0x77073096U, 0xee0e612cU, 0x990951baU, 0x076dc419U, 0x706af48fU, 0xe963a535U,
+    0x9e6495a3U, 0x0edb8832U, 0x79dcb8a4U, 0xe0d5e91eU, 0x97d2d988U, 0x09b64c2bU, 0x7eb17cbdU,
+    0xe7b82d07U, 0x90bf1d91U, 0x1db71064U, 0x6ab020f2U, 0xf3b97148U, 0x84be41deU, 0x1adad47dU,
+    0x6ddde4ebU, 0xf4d4b551U, 0x83d385c7U, 0x136c9856U, 0x646ba8c0U, 0xfd62f97aU, 0x8a65c9ecU,
+    0x14015c4fU, 0x63066cd9U, 0xfa0f3d63U, 0x8d080df5U, 0x3b6e20c8U, 0x4c69105eU, 0xd56041e4U,
+    0xa2677172U, 0x3c03e4d1U, 0x4b04d447U, 0xd20d85fdU, 0xa50ab56bU, 0x35b5a8faU, 0x42b2986cU,
+    0xdbbbc9d6U, 0xacbcf940U, 0x32d86ce3U, 0x45df5c75U, 0xdcd60dcfU, 0xabd13d59U, 0x26d930acU,
+    0x51de003aU, 0xc8d75180U, 0xbfd06116U, 0x21b4f4b5U, 0x56b3c423U, 0xcfba9599U, 0xb8bda50fU,
+    0x2802b89eU, 0x5f058808U, 0xc60cd9b2U, 0xb10be924U, 0x2f6f7c87U, 0x58684c11U, 0xc1611dabU,
+    0xb6662d3dU, 0x76dc4190U, 0x01db7106U, 0x98d220bcU, 0xefd5102aU, 0x71b18589U, 0x06b6b51fU,
+    0x9fbfe4a5U, 0xe8b8d433U, 0x7807c9a2U, 0x0f00f934U, 0x9609a88eU, 0xe10e9818U, 0x7f6a0dbbU,
+    0x086d3d2dU, 0x91646c97U, 0xe6635c01U, 0x6b6b51f4U, 0x1c6c6162U, 0x856530d8U, 0xf262004eU,
+    0x6c0695edU, 0x1b01a57bU, 0x8208f4c1U, 0xf50fc457U, 0x65b0d9c6U, 0x12b7e950U, 0x8bbeb8eaU,
+    0xfcb9887cU, 0x62dd1ddfU, 0x15da2d49U, 0x8cd37cf3U, 0xfbd44c65U, 0x4db26158U, 0x3ab551ceU,
+    0xa3bc0074U, 0xd4bb30e2U, 0x4adfa541U, 0x3dd895d7U, 0xa4d1c46dU, 0xd3d6f4fbU, 0x4369e96aU,
+    0x346ed9fcU, 0xad678846U, 0xda60b8d0U, 0x44042d73U, 0x33031de5U, 0xaa0a4c5fU, 0xdd0d7cc9U,
+    0x5005713cU, 0x270241aaU, 0xbe0b1010U, 0xc90c2086U, 0x5768b525U, 0x206f85b3U, 0xb966d409U,
+    0xce61e49fU, 0x5edef90eU, 0x29d9c998U, 0xb0d09822U, 0xc7d7a8b4U, 0x59b33d17U, 0x2eb40d81U,
+    0xb7bd5c3bU, 0xc0ba6cadU, 0xedb88320U, 0x9abfb3b6U, 0x03b6e20cU, 0x74b1d29aU, 0xead54739U,
+    0x9dd277afU, 0x04db2615U, 0x73dc1683U, 0xe3630b12U, 0x94643b84U, 0x0d6d6a3eU, 0x7a6a5aa8U,
+    0xe40ecf0bU, 0x9309ff9dU, 0x0a00ae27U, 0x7d079eb1U, 0xf00f9344U, 0x8708a3d2U, 0x1e01f268U,
+    0x6906c2feU, 0xf762575dU, 0x806567cbU, 0x196c3671U, 0x6e6b06e7U, 0xfed41b76U, 0x89d32be0U,
+    0x10da7a5aU, 0x67dd4accU, 0xf9b9df6fU, 0x8ebeeff9U, 0x17b7be43U, 0x60b08ed5U, 0xd6d6a3e8U,
+    0xa1d1937eU, 0x38d8c2c4U, 0x4fdff252U, 0xd1bb67f1U, 0xa6bc5767U, 0x3fb506ddU, 0x48b2364bU,
+    0xd80d2bdaU, 0xaf0a1b4cU, 0x36034af6U, 0x41047a60U, 0xdf60efc3U, 0xa867df55U, 0x316e8eefU,
+    0x4669be79U, 0xcb61b38cU, 0xbc66831aU, 0x256fd2a0U, 0x5268e236U, 0xcc0c7795U, 0xbb0b4703U,
+    0x220216b9U, 0x5505262fU, 0xc5ba3bbeU, 0xb2bd0b28U, 0x2bb45a92U, 0x5cb36a04U, 0xc2d7ffa7U,
+    0xb5d0cf31U, 0x2cd99e8bU, 0x5bdeae1dU, 0x9b64c2b0U, 0xec63f226U, 0x756aa39cU, 0x026d930aU,
+    0x9c0906a9U, 0xeb0e363fU, 0x72076785U, 0x05005713U, 0x95bf4a82U, 0xe2b87a14U, 0x7bb12baeU,
+    0x0cb61b38U, 0x92d28e9bU, 0xe5d5be0dU, 0x7cdcefb7U, 0x0bdbdf21U, 0x86d3d2d4U, 0xf1d4e242U,
+    0x68ddb3f8U, 0x1fda836eU, 0x81be16cdU, 0xf6b9265bU, 0x6fb077e1U, 0x18b74777U, 0x88085ae6U,
+    0xff0f6a70U, 0x66063bcaU, 0x11010b5cU, 0x8f659effU, 0xf862ae69U, 0x616bffd3U, 0x166ccf45U,
+    0xa00ae278U, 0xd70dd2eeU, 0x4e048354U, 0x3903b3c2U, 0xa7672661U, 0xd06016f7U, 0x4969474dU,
+    0x3e6e77dbU, 0xaed16a4aU, 0xd9d65adcU, 0x40df0b66U, 0x37d83bf0U, 0xa9bcae53U, 0xdebb9ec5U,
+    0x47b2cf7fU, 0x30b5ffe9U, 0xbdbdf21cU, 0xcabac28aU, 0x53b39330U, 0x24b4a3a6U, 0xbad03605U,
+    0xcdd70693U, 0x54de5729U, 0x23d967bfU, 0xb3667a2eU, 0xc4614ab8U, 0x5d681b02U, 0x2a6f2b94U,
+    0xb40bbe37U, 0xc30c8ea1U, 0x5a05df1bU, 0x2d02ef8dU
+  },
+  {
+    0x00000000U, 0x191b3141U, 0x32366282U, 0x2b2d53c3U, 0x646cc504U, 0x7d77f445U, 0x565aa786U,
+    0x4f4196c7U, 0xc8d98a08U, 0xd1c2bb49U, 0xfaefe88aU, 0xe3f4d9cbU, 0xacb54f0cU, 0xb5ae7e4dU,
+    0x9e832d8eU, 0x87981ccfU, 0x4ac21251U, 0x53d92310U, 0x78f470d3U, 0x61ef4192U, 0x2eaed755U,
+    0x37b5e614U, 0x1c98b5d7U, 0x05838496U, 0x821b9859U, 0x9b00a918U, 0xb02dfadbU, 0xa936cb9aU,
+    0xe6775d5dU, 0xff6c6c1cU, 0xd4413fdfU, 0xcd5a0e9eU, 0x958424a2U, 0x8c9f15e3U, 0xa7b24620U,
+    0xbea97761U, 0xf1e8e1a6U, 0xe8f3d0e7U, 0xc3de8324U, 0xdac5b265U, 0x5d5daeaaU, 0x44469febU,
+    0x6f6bcc28U, 0x7670fd69U, 0x39316baeU, 0x202a5aefU, 0x0b07092cU, 0x121c386dU, 0xdf4636f3U,
+    0xc65d07b2U, 0xed705471U, 0xf46b6530U, 0xbb2af3f7U, 0xa231c2b6U, 0x891c9175U, 0x9007a034U,
+    0x179fbcfbU, 0x0e848dbaU, 0x25a9de79U, 0x3cb2ef38U, 0x73f379ffU, 0x6ae848beU, 0x41c51b7dU,
+    0x58de2a3cU, 0xf0794f05U, 0xe9627e44U, 0xc24f2d87U, 0xdb541cc6U, 0x94158a01U, 0x8d0ebb40U,
+    0xa623e883U, 0xbf38d9c2U, 0x38a0c50dU, 0x21bbf44cU, 0x0a96a78fU, 0x138d96ceU, 0x5ccc0009U,
+    0x45d73148U, 0x6efa628bU, 0x77e153caU, 0xbabb5d54U, 0xa3a06c15U, 0x888d3fd6U, 0x91960e97U,
+    0xded79850U, 0xc7cca911U, 0xece1fad2U, 0xf5facb93U, 0x7262d75cU, 0x6b79e61dU, 0x4054b5deU,
+    0x594f849fU, 0x160e1258U, 0x0f152319U, 0x243870daU, 0x3d23419bU, 0x65fd6ba7U, 0x7ce65ae6U,
+    0x57cb0925U, 0x4ed03864U, 0x0191aea3U, 0x188a9fe2U, 0x33a7cc21U, 0x2abcfd60U, 0xad24e1afU,
+    0xb43fd0eeU, 0x9f12832dU, 0x8609b26cU, 0xc94824abU, 0xd05315eaU, 0xfb7e4629U, 0xe2657768U,
+    0x2f3f79f6U, 0x362448b7U, 0x1d091b74U, 0x04122a35U, 0x4b53bcf2U, 0x52488db3U, 0x7965de70U,
+    0x607eef31U, 0xe7e6f3feU, 0xfefdc2bfU, 0xd5d0917cU, 0xcccba03dU, 0x838a36faU, 0x9a9107bbU,
+    0xb1bc5478U, 0xa8a76539U, 0x3b83984bU, 0x2298a90aU, 0x09b5fac9U, 0x10aecb88U, 0x5fef5d4fU,
+    0x46f46c0eU, 0x6dd93fcdU, 0x74c20e8cU, 0xf35a1243U, 0xea412302U, 0xc16c70c1U, 0xd8774180U,
+    0x9736d747U, 0x8e2de606U, 0xa500b5c5U, 0xbc1b8484U, 0x71418a1aU, 0x685abb5bU, 0x4377e898U,
+    0x5a6cd9d9U, 0x152d4f1eU, 0x0c367e5fU, 0x271b2d9cU, 0x3e001cddU, 0xb9980012U, 0xa0833153U,
+    0x8bae6290U, 0x92b553d1U, 0xddf4c516U, 0xc4eff457U, 0xefc2a794U, 0xf6d996d5U, 0xae07bce9U,
+    0xb71c8da8U, 0x9c31de6bU, 0x852aef2aU, 0xca6b79edU, 0xd37048acU, 0xf85d1b6fU, 0xe1462a2eU,
+    0x66de36e1U, 0x7fc507a0U, 0x54e85463U, 0x4df36522U, 0x02b2f3e5U, 0x1ba9c2a4U, 0x30849167U,
+    0x299fa026U, 0xe4c5aeb8U, 0xfdde9ff9U, 0xd6f3cc3aU, 0xcfe8fd7bU, 0x80a96bbcU, 0x99b25afdU,
+    0xb29f093eU, 0xab84387fU, 0x2c1c24b0U, 0x350715f1U, 0x1e2a4632U, 0x07317773U, 0x4870e1b4U,
+    0x516bd0f5U, 0x7a468336U, 0x635db277U, 0xcbfad74eU, 0xd2e1e60fU, 0xf9ccb5ccU, 0xe0d7848dU,
+    0xaf96124aU, 0xb68d230bU, 0x9da070c8U, 0x84bb4189U, 0x03235d46U, 0x1a386c07U, 0x31153fc4U,
+    0x280e0e85U, 0x674f9842U, 0x7e54a903U, 0x5579fac0U, 0x4c62cb81U, 0x8138c51fU, 0x9823f45eU,
+    0xb30ea79dU, 0xaa1596dcU, 0xe554001bU, 0xfc4f315aU, 0xd7626299U, 0xce7953d8U, 0x49e14f17U,
+    0x50fa7e56U, 0x7bd72d95U, 0x62cc1cd4U, 0x2d8d8a13U, 0x3496bb52U, 0x1fbbe891U, 0x06a0d9d0U,
+    0x5e7ef3ecU, 0x4765c2adU, 0x6c48916eU, 0x7553a02fU, 0x3a1236e8U, 0x230907a9U, 0x0824546aU,
+    0x113f652bU, 0x96a779e4U, 0x8fbc48a5U, 0xa4911b66U, 0xbd8a2a27U, 0xf2cbbce0U, 0xebd08da1U,
+    0xc0fdde62U, 0xd9e6ef23U, 0x14bce1bdU, 0x0da7d0fcU, 0x268a833fU, 0x3f91b27eU, 0x70d024b9U,
+    0x69cb15f8U, 0x42e6463bU, 0x5bfd777aU, 0xdc656bb5U, 0xc57e5af4U, 0xee530937U, 0xf7483876U,
+    0xb809aeb1U, 0xa1129ff0U, 0x8a3fcc33U, 0x9324fd72U
+  },
+  {
+    0x00000000U, 0x01c26a37U, 0x0384d46eU, 0x0246be59U, 0x0709a8dcU, 0x06cbc2ebU, 0x048d7cb2U,
+    0x054f1685U, 0x0e1351b8U, 0x0fd13b8fU, 0x0d9785d6U, 0x0c55efe1U, 0x091af964U, 0x08d89353U,
+    0x0a9e2d0aU, 0x0b5c473dU, 0x1c26a370U, 0x1de4c947U, 0x1fa2771eU, 0x1e601d29U, 0x1b2f0bacU,
+    0x1aed619bU, 0x18abdfc2U, 0x1969b5f5U, 0x1235f2c8U, 0x13f798ffU, 0x11b126a6U, 0x10734c91U,
+    0x153c5a14U, 0x14fe3023U, 0x16b88e7aU, 0x177ae44dU, 0x384d46e0U, 0x398f2cd7U, 0x3bc9928eU,
+    0x3a0bf8b9U, 0x3f44ee3cU, 0x3e86840bU, 0x3cc03a52U, 0x3d025065U, 0x365e1758U, 0x379c7d6fU,
+    0x35dac336U, 0x3418a901U, 0x3157bf84U, 0x3095d5b3U, 0x32d36beaU, 0x331101ddU, 0x246be590U,
+    0x25a98fa7U, 0x27ef31feU, 0x262d5bc9U, 0x23624d4cU, 0x22a0277bU, 0x20e69922U, 0x2124f315U,
+    0x2a78b428U, 0x2bbade1fU, 0x29fc6046U, 0x283e0a71U, 0x2d711cf4U, 0x2cb376c3U, 0x2ef5c89aU,
+    0x2f37a2adU, 0x709a8dc0U, 0x7158e7f7U, 0x731e59aeU, 0x72dc3399U, 0x7793251cU, 0x76514f2bU,
+    0x7417f172U, 0x75d59b45U, 0x7e89dc78U, 0x7f4bb64fU, 0x7d0d0816U, 0x7ccf6221U, 0x798074a4U,
+    0x78421e93U, 0x7a04a0caU, 0x7bc6cafdU, 0x6cbc2eb0U, 0x6d7e4487U, 0x6f38fadeU, 0x6efa90e9U,
+    0x6bb5866cU, 0x6a77ec5bU, 0x68315202U, 0x69f33835U, 0x62af7f08U, 0x636d153fU, 0x612bab66U,
+    0x60e9c151U, 0x65a6d7d4U, 0x6464bde3U, 0x662203baU, 0x67e0698dU, 0x48d7cb20U, 0x4915a117U,
+    0x4b531f4eU, 0x4a917579U, 0x4fde63fcU, 0x4e1c09cbU, 0x4c5ab792U, 0x4d98dda5U, 0x46c49a98U,
+    0x4706f0afU, 0x45404ef6U, 0x448224c1U, 0x41cd3244U, 0x400f5873U, 0x4249e62aU, 0x438b8c1dU,
+    0x54f16850U, 0x55330267U, 0x5775bc3eU, 0x56b7d609U, 0x53f8c08cU, 0x523aaabbU, 0x507c14e2U,
+    0x51be7ed5U, 0x5ae239e8U, 0x5b2053dfU, 0x5966ed86U, 0x58a487b1U, 0x5deb9134U, 0x5c29fb03U,
+    0x5e6f455aU, 0x5fad2f6dU, 0xe1351b80U, 0xe0f771b7U, 0xe2b1cfeeU, 0xe373a5d9U, 0xe63cb35cU,
+    0xe7fed96bU, 0xe5b86732U, 0xe47a0d05U, 0xef264a38U, 0xeee4200fU, 0xeca29e56U, 0xed60f461U,
+    0xe82fe2e4U, 0xe9ed88d3U, 0xebab368aU, 0xea695cbdU, 0xfd13b8f0U, 0xfcd1d2c7U, 0xfe976c9eU,
+    0xff5506a9U, 0xfa1a102cU, 0xfbd87a1bU, 0xf99ec442U, 0xf85cae75U, 0xf300e948U, 0xf2c2837fU,
+    0xf0843d26U, 0xf1465711U, 0xf4094194U, 0xf5cb2ba3U, 0xf78d95faU, 0xf64fffcdU, 0xd9785d60U,
+    0xd8ba3757U, 0xdafc890eU, 0xdb3ee339U, 0xde71f5bcU, 0xdfb39f8bU, 0xddf521d2U, 0xdc374be5U,
+    0xd76b0cd8U, 0xd6a966efU, 0xd4efd8b6U, 0xd52db281U, 0xd062a404U, 0xd1a0ce33U, 0xd3e6706aU,
+    0xd2241a5dU, 0xc55efe10U, 0xc49c9427U, 0xc6da2a7eU, 0xc7184049U, 0xc25756ccU, 0xc3953cfbU,
+    0xc1d382a2U, 0xc011e895U, 0xcb4dafa8U, 0xca8fc59fU, 0xc8c97bc6U, 0xc90b11f1U, 0xcc440774U,
+    0xcd866d43U, 0xcfc0d31aU, 0xce02b92dU, 0x91af9640U, 0x906dfc77U, 0x922b422eU, 0x93e92819U,
+    0x96a63e9cU, 0x976454abU, 0x9522eaf2U, 0x94e080c5U, 0x9fbcc7f8U, 0x9e7eadcfU, 0x9c381396U,
+    0x9dfa79a1U, 0x98b56f24U, 0x99770513U, 0x9b31bb4aU, 0x9af3d17dU, 0x8d893530U, 0x8c4b5f07U,
+    0x8e0de15eU, 0x8fcf8b69U, 0x8a809decU, 0x8b42f7dbU, 0x89044982U, 0x88c623b5U, 0x839a6488U,
+    0x82580ebfU, 0x801eb0e6U, 0x81dcdad1U, 0x8493cc54U, 0x8551a663U, 0x8717183aU, 0x86d5720dU,
+    0xa9e2d0a0U, 0xa820ba97U, 0xaa6604ceU, 0xaba46ef9U, 0xaeeb787cU, 0xaf29124bU, 0xad6fac12U,
+    0xacadc625U, 0xa7f18118U, 0xa633eb2fU, 0xa4755576U, 0xa5b73f41U, 0xa0f829c4U, 0xa13a43f3U,
+    0xa37cfdaaU, 0xa2be979dU, 0xb5c473d0U, 0xb40619e7U, 0xb640a7beU, 0xb782cd89U, 0xb2cddb0cU,
+    0xb30fb13bU, 0xb1490f62U, 0xb08b6555U, 0xbbd72268U, 0xba15485fU, 0xb853f606U, 0xb9919c31U,
+    0xbcde8ab4U, 0xbd1ce083U, 0xbf5a5edaU, 0xbe9834edU
+  },
+  {
+    0x00000000U, 0xb8bc6765U, 0xaa09c88bU, 0x12b5afeeU, 0x8f629757U, 0x37def032U, 0x256b5fdcU,
+    0x9dd738b9U, 0xc5b428efU, 0x7d084f8aU, 0x6fbde064U, 0xd7018701U, 0x4ad6bfb8U, 0xf26ad8ddU,
+    0xe0df7733U, 0x58631056U, 0x5019579fU, 0xe8a530faU, 0xfa109f14U, 0x42acf871U, 0xdf7bc0c8U,
+    0x67c7a7adU, 0x75720843U, 0xcdce6f26U, 0x95ad7f70U, 0x2d111815U, 0x3fa4b7fbU, 0x8718d09eU,
+    0x1acfe827U, 0xa2738f42U, 0xb0c620acU, 0x087a47c9U, 0xa032af3eU, 0x188ec85bU, 0x0a3b67b5U,
+    0xb28700d0U, 0x2f503869U, 0x97ec5f0cU, 0x8559f0e2U, 0x3de59787U, 0x658687d1U, 0xdd3ae0b4U,
+    0xcf8f4f5aU, 0x7733283fU, 0xeae41086U, 0x525877e3U, 0x40edd80dU, 0xf851bf68U, 0xf02bf8a1U,
+    0x48979fc4U, 0x5a22302aU, 0xe29e574fU, 0x7f496ff6U, 0xc7f50893U, 0xd540a77dU, 0x6dfcc018U,
+    0x359fd04eU, 0x8d23b72bU, 0x9f9618c5U, 0x272a7fa0U, 0xbafd4719U, 0x0241207cU, 0x10f48f92U,
+    0xa848e8f7U, 0x9b14583dU, 0x23a83f58U, 0x311d90b6U, 0x89a1f7d3U, 0x1476cf6aU, 0xaccaa80fU,
+    0xbe7f07e1U, 0x06c36084U, 0x5ea070d2U, 0xe61c17b7U, 0xf4a9b859U, 0x4c15df3cU, 0xd1c2e785U,
+    0x697e80e0U, 0x7bcb2f0eU, 0xc377486bU, 0xcb0d0fa2U, 0x73b168c7U, 0x6104c729U, 0xd9b8a04cU,
+    0x446f98f5U, 0xfcd3ff90U, 0xee66507eU, 0x56da371bU, 0x0eb9274dU, 0xb6054028U, 0xa4b0efc6U,
+    0x1c0c88a3U, 0x81dbb01aU, 0x3967d77fU, 0x2bd27891U, 0x936e1ff4U, 0x3b26f703U, 0x839a9066U,
+    0x912f3f88U, 0x299358edU, 0xb4446054U, 0x0cf80731U, 0x1e4da8dfU, 0xa6f1cfbaU, 0xfe92dfecU,
+    0x462eb889U, 0x549b1767U, 0xec277002U, 0x71f048bbU, 0xc94c2fdeU, 0xdbf98030U, 0x6345e755U,
+    0x6b3fa09cU, 0xd383c7f9U, 0xc1366817U, 0x798a0f72U, 0xe45d37cbU, 0x5ce150aeU, 0x4e54ff40U,
+    0xf6e89825U, 0xae8b8873U, 0x1637ef16U, 0x048240f8U, 0xbc3e279dU, 0x21e91f24U, 0x99557841U,
+    0x8be0d7afU, 0x335cb0caU, 0xed59b63bU, 0x55e5d15eU, 0x47507eb0U, 0xffec19d5U, 0x623b216cU,
+    0xda874609U, 0xc832e9e7U, 0x708e8e82U, 0x28ed9ed4U, 0x9051f9b1U, 0x82e4565fU, 0x3a58313aU,
+    0xa78f0983U, 0x1f336ee6U, 0x0d86c108U, 0xb53aa66dU, 0xbd40e1a4U, 0x05fc86c1U, 0x1749292fU,
+    0xaff54e4aU, 0x322276f3U, 0x8a9e1196U, 0x982bbe78U, 0x2097d91dU, 0x78f4c94bU, 0xc048ae2eU,
+    0xd2fd01c0U, 0x6a4166a5U, 0xf7965e1cU, 0x4f2a3979U, 0x5d9f9697U, 0xe523f1f2U, 0x4d6b1905U,
+    0xf5d77e60U, 0xe762d18eU, 0x5fdeb6ebU, 0xc2098e52U, 0x7ab5e937U, 0x680046d9U, 0xd0bc21bcU,
+    0x88df31eaU, 0x3063568fU, 0x22d6f961U, 0x9a6a9e04U, 0x07bda6bdU, 0xbf01c1d8U, 0xadb46e36U,
+    0x15080953U, 0x1d724e9aU, 0xa5ce29ffU, 0xb77b8611U, 0x0fc7e174U, 0x9210d9cdU, 0x2aacbea8U,
+    0x38191146U, 0x80a57623U, 0xd8c66675U, 0x607a0110U, 0x72cfaefeU, 0xca73c99bU, 0x57a4f122U,
+    0xef189647U, 0xfdad39a9U, 0x45115eccU, 0x764dee06U, 0xcef18963U, 0xdc44268dU, 0x64f841e8U,
+    0xf92f7951U, 0x41931e34U, 0x5326b1daU, 0xeb9ad6bfU, 0xb3f9c6e9U, 0x0b45a18cU, 0x19f00e62U,
+    0xa14c6907U, 0x3c9b51beU, 0x842736dbU, 0x96929935U, 0x2e2efe50U, 0x2654b999U, 0x9ee8defcU,
+    0x8c5d7112U, 0x34e11677U, 0xa9362eceU, 0x118a49abU, 0x033fe645U, 0xbb838120U, 0xe3e09176U,
+    0x5b5cf613U, 0x49e959fdU, 0xf1553e98U, 0x6c820621U, 0xd43e6144U, 0xc68bceaaU, 0x7e37a9cfU,
+    0xd67f4138U, 0x6ec3265dU, 0x7c7689b3U, 0xc4caeed6U, 0x591dd66fU, 0xe1a1b10aU, 0xf3141ee4U,
+    0x4ba87981U, 0x13cb69d7U, 0xab770eb2U, 0xb9c2a15cU, 0x017ec639U, 0x9ca9fe80U, 0x241599e5U,
+    0x36a0360bU, 0x8e1c516eU, 0x866616a7U, 0x3eda71c2U, 0x2c6fde2cU, 0x94d3b949U, 0x090481f0U,
+    0xb1b8e695U, 0xa30d497bU, 0x1bb12e1eU, 0x43d23e48U, 0xfb6e592dU, 0xe9dbf6c3U, 0x516791a6U,
+    0xccb0a91fU, 0x740cce7aU, 0x66b96194U, 0xde0506f1U
+  }};
+
+#endif
+
+#endif // __LIBSTEEL_CRC_TABLES__
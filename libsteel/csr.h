@@ -362,7 +362,7 @@
  *
  */
 #define CSR_READ(csr_address, uint32_var)                                                          \
-  asm volatile("csrr %0, %1" : "=r"(uint32_var) : "I"(csr_address))
+  asm volatile("csrr %0, %1" : "=r"(uint32_var) : "i"(csr_address))
 
 /**
  * @brief Write a value to a Control and Status Register.
@@ -379,7 +379,7 @@
  *
  */
 #define CSR_WRITE(csr_address, uint32_value)                                                       \
-  asm volatile("csrw %0, %1" : : "I"(csr_address), "r"(uint32_value))
+  asm volatile("csrw %0, %1" : : "i"(csr_address), "r"(uint32_value))
 
 /**
  * @brief Atomic read/write a value to a Control and Status Register.
@@ -398,7 +398,7 @@
  *
  */
 #define CSR_READ_WRITE(csr_address, uint32_var, uint32_value)                                      \
-  asm volatile("csrrw %0, %1, %2" : "=r"(uint32_var) : "I"(csr_address), "r"(uint32_value))
+  asm volatile("csrrw %0, %1, %2" : "=r"(uint32_var) : "i"(csr_address), "r"(uint32_value))
 
 /**
  * @brief Set specific bits in a Control and Status Register based on the bit mask provided.
@@ -415,7 +415,7 @@
  *
  */
 #define CSR_SET(csr_address, bit_mask)                                                             \
-  asm volatile("csrrs zero, %0, %1" : : "I"(csr_address), "r"(bit_mask))
+  asm volatile("csrrs zero, %0, %1" : : "i"(csr_address), "r"(bit_mask))
 
 /**
  * @brief Clear specific bits in a Control and Status Register based on the bit mask provided.
@@ -432,7 +432,7 @@
  *
  */
 #define CSR_CLEAR(csr_address, bit_mask)                                                           \
-  asm volatile("csrrc zero, %0, %1" : : "I"(csr_address), "r"(bit_mask))
+  asm volatile("csrrc zero, %0, %1" : : "i"(csr_address), "r"(bit_mask))
 
 /**
  * @brief Atomic read/set bits in a Control and Status Register. The bits are set based on the bit
@@ -452,7 +452,7 @@
  *
  */
 #define CSR_READ_SET(csr_address, uint32_var, bit_mask)                                            \
-  asm volatile("csrrs %0, %1, %2" : "=r"(uint32_var) : "I"(csr_address), "r"(bit_mask))
+  asm volatile("csrrs %0, %1, %2" : "=r"(uint32_var) : "i"(csr_address), "r"(bit_mask))
 
 /**
  * @brief Atomic read/clear bits in a Control and Status Register. The bits are cleared based on the
@@ -472,7 +472,7 @@
  *
  */
 #define CSR_READ_CLEAR(csr_address, uint32_var, bit_mask)                                          \
-  asm volatile("csrrc %0, %1, %2" : "=r"(uint32_var) : "I"(csr_address), "r"(bit_mask))
+  asm volatile("csrrc %0, %1, %2" : "=r"(uint32_var) : "i"(csr_address), "r"(bit_mask))
 
 /**
  * @brief Globally enable interrupt requests by setting the global Machine Interrupt Enable (MIE)
@@ -509,6 +509,47 @@ static inline void csr_global_disable_irq()
   CSR_CLEAR(CSR_MSTATUS, MSTATUS_MIE_MASK);
 }
 
+/**
+ * @brief Globally disable all interrupt requests and return the previous value of the Machine
+ * Status (MSTATUS) CSR. Use it with `csr_global_restore_irq` to protect short critical sections
+ * shared with interrupt handlers:
+ *
+ * ```
+ * uint32_t mstatus = csr_global_disable_irq_save();
+ * // ... critical section ...
+ * csr_global_restore_irq(mstatus);
+ * ```
+ *
+ * @return uint32_t
+ */
+static inline uint32_t csr_global_disable_irq_save()
+{
+  uint32_t mstatus;
+  CSR_READ_CLEAR(CSR_MSTATUS, mstatus, MSTATUS_MIE_MASK);
+  return mstatus;
+}
+
+/**
+ * @brief Restore the global Machine Interrupt Enable (MIE) bit to the state saved by
+ * `csr_global_disable_irq_save`.
+ *
+ * @param mstatus The value returned by `csr_global_disable_irq_save`
+ */
+static inline void csr_global_restore_irq(uint32_t mstatus)
+{
+  CSR_SET(CSR_MSTATUS, mstatus & MSTATUS_MIE_MASK);
+}
+
+/**
+ * @brief Stop the core until an interrupt enabled in MIE becomes pending. The interrupt does not
+ * need to be globally enabled to wake the core up.
+ *
+ */
+static inline void wait_for_interrupt()
+{
+  asm volatile("wfi");
+}
+
 /**
  * @brief Enable vectored mode for interrupt requests.
  *
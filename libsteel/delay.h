@@ -0,0 +1,144 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_DELAY__
+#define __LIBSTEEL_DELAY__
+
+#include "csr.h"
+#include "globals.h"
+#include "mtimer.h"
+
+/* Busy-wait delays measured on a hardware counter instead of instruction counts, so they do not
+ * depend on compiler flags.
+ *
+ * The counter is selected at compile time:
+ * - CSR_MCYCLE, by default;
+ * - CSR_CYCLE, if LIBSTEEL_DELAY_USE_CYCLE is defined (for code running in U-mode);
+ * - the lowest word of MTIME, if LIBSTEEL_DELAY_MTIMER is defined as an expression evaluating to a
+ *   pointer to the MTimerController, e.g.
+ *   `#define LIBSTEEL_DELAY_MTIMER ((MTimerController *)0x80030000)`.
+ *   MTIME is incremented at every clock cycle as well, but must be enabled.
+ *
+ * LIBSTEEL_CLOCK_HZ is the frequency of the system clock. It defaults to 50 MHz and must be
+ * defined before including libsteel headers if the clock is different. Since it is a constant,
+ * delay_us and delay_ms with a constant argument fold into a single cycle count at compile time.
+ *
+ * Bounds: a delay is never shorter than requested (rounded to whole cycles). It is longer by at
+ * most one iteration of the polling loop plus the call overhead, about 10 cycles with CSR_MCYCLE
+ * and a few more with MTIME (one bus read per iteration), plus the time spent in interrupt
+ * handlers. The 32-bit counter wraps around every 2^32 cycles; differences are computed modulo
+ * 2^32, and delays longer than 2^31 cycles are split into steps measured from the same start, so
+ * they do not drift.
+ *
+ * Example usage:
+ * ```
+ * #define LIBSTEEL_CLOCK_HZ 25000000
+ * #include "libsteel.h"
+ *
+ * gpio_set(gpio, 0);
+ * delay_us(10); // 250 cycles, computed at compile time
+ * gpio_clear(gpio, 0);
+ * ```
+ */
+
+#ifndef LIBSTEEL_CLOCK_HZ
+// Frequency of the system clock in Hz
+#define LIBSTEEL_CLOCK_HZ 50000000U
+#endif
+
+// Whole part of the number of cycles per microsecond
+#define DELAY_CYCLES_PER_US ((uint32_t)(LIBSTEEL_CLOCK_HZ / 1000000U))
+
+// Fractional part of the number of cycles per microsecond, in units of 2^-32, rounded up
+#define DELAY_CYCLES_PER_US_FRAC                                                                   \
+  ((uint32_t)((((uint64_t)(LIBSTEEL_CLOCK_HZ % 1000000U) << 32) + 999999U) / 1000000U))
+
+// Whole part of the number of cycles per millisecond
+#define DELAY_CYCLES_PER_MS ((uint32_t)(LIBSTEEL_CLOCK_HZ / 1000U))
+
+// Fractional part of the number of cycles per millisecond, in units of 2^-32, rounded up
+#define DELAY_CYCLES_PER_MS_FRAC                                                                   \
+  ((uint32_t)((((uint64_t)(LIBSTEEL_CLOCK_HZ % 1000U) << 32) + 999U) / 1000U))
+
+/**
+ * @brief Return the current value of the counter used for delays (lowest 32 bits).
+ *
+ * @return uint32_t
+ */
+static inline uint32_t delay_counter()
+{
+  uint32_t count;
+#if defined(LIBSTEEL_DELAY_MTIMER)
+  count = (LIBSTEEL_DELAY_MTIMER)->MTIMEL;
+#elif defined(LIBSTEEL_DELAY_USE_CYCLE)
+  CSR_READ(CSR_CYCLE, count);
+#else
+  CSR_READ(CSR_MCYCLE, count);
+#endif
+  return count;
+}
+
+/**
+ * @brief Wait until `cycles` cycles have elapsed since the counter read `start`.
+ *
+ * @param start Value of `delay_counter()` at the start of the delay
+ * @param cycles Number of cycles
+ */
+static inline void delay_cycles_since(uint32_t start, uint64_t cycles)
+{
+  while (cycles > 0x80000000U)
+  {
+    while (delay_counter() - start < 0x80000000U)
+      ;
+    start += 0x80000000U;
+    cycles -= 0x80000000U;
+  }
+  while (delay_counter() - start < (uint32_t)cycles)
+    ;
+}
+
+/**
+ * @brief Wait for `cycles` clock cycles.
+ *
+ * @param cycles Number of cycles
+ */
+static inline void delay_cycles(uint32_t cycles)
+{
+  uint32_t start = delay_counter();
+  while (delay_counter() - start < cycles)
+    ;
+}
+
+/**
+ * @brief Wait for `us` microseconds.
+ *
+ * @param us Number of microseconds
+ */
+static inline void delay_us(uint32_t us)
+{
+  uint32_t start = delay_counter();
+  uint64_t cycles = (uint64_t)us * DELAY_CYCLES_PER_US;
+  if (DELAY_CYCLES_PER_US_FRAC != 0)
+    cycles += ((uint64_t)us * DELAY_CYCLES_PER_US_FRAC + 0xFFFFFFFFU) >> 32;
+  delay_cycles_since(start, cycles);
+}
+
+/**
+ * @brief Wait for `ms` milliseconds.
+ *
+ * @param ms Number of milliseconds
+ */
+static inline void delay_ms(uint32_t ms)
+{
+  uint32_t start = delay_counter();
+  uint64_t cycles = (uint64_t)ms * DELAY_CYCLES_PER_MS;
+  if (DELAY_CYCLES_PER_MS_FRAC != 0)
+    cycles += ((uint64_t)ms * DELAY_CYCLES_PER_MS_FRAC + 0xFFFFFFFFU) >> 32;
+  delay_cycles_since(start, cycles);
+}
+
+#endif // __LIBSTEEL_DELAY__
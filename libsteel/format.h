@@ -0,0 +1,447 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_FORMAT__
+#define __LIBSTEEL_FORMAT__
+
+#include <stdarg.h>
+
+#include "globals.h"
+#include "uart.h"
+
+/* Minimal formatted output for RISC-V Steel. It allocates no memory, does not depend on newlib and
+ * uses only RV32I instructions: decimal digits are found by subtracting powers of ten, so neither
+ * hardware nor software division is needed.
+ *
+ * Supported conversions: %d, %i, %u, %x, %X, %c, %s and %%. A minimum field width can be given,
+ * optionally preceded by the `0` (pad with zeros) or `-` (left-justify) flags. Example: "%08x".
+ * The integer conversions accept the length modifiers `hh`, `h`, `l`, `ll` and `z`, so the
+ * <inttypes.h> macros (PRIu32 is "lu" on RV32) can be used. 64-bit arguments are converted with the
+ * same subtraction method, which is slower but only taken when the value does not fit 32 bits.
+ *
+ * All printf-like functions are checked by the compiler against their arguments (-Wformat). */
+
+// Type of the function called by `format_vprint` to output each formatted character
+typedef void (*FormatPutChar)(void *context, char c);
+
+// Powers of ten used to convert binary numbers to decimal digits without division
+static const uint32_t format_pow10[] = {1000000000U, 100000000U, 10000000U, 1000000U, 100000U,
+                                        10000U,      1000U,      100U,      10U};
+
+/**
+ * @brief Write the decimal digits of `value` to `buf`, without a terminating null character, and
+ * return the number of digits written. `buf` must have room for 10 characters.
+ *
+ * @param buf Destination of the decimal digits
+ * @param value The number to convert
+ * @return uint32_t
+ */
+static inline uint32_t format_uint32_dec(char *buf, uint32_t value)
+{
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < NUMBER_OF(format_pow10); i++)
+  {
+    uint32_t pow10 = format_pow10[i];
+    char digit = '0';
+    while (value >= pow10)
+    {
+      value -= pow10;
+      digit++;
+    }
+    if (digit != '0' || n != 0)
+      buf[n++] = digit;
+  }
+  buf[n++] = '0' + value;
+  return n;
+}
+
+// Powers of ten used to convert 64-bit numbers to decimal digits without division
+static const uint64_t format_pow10_64[] = {
+    10000000000000000000ULL, 1000000000000000000ULL, 100000000000000000ULL,
+    10000000000000000ULL,    1000000000000000ULL,    100000000000000ULL,
+    10000000000000ULL,       1000000000000ULL,       100000000000ULL,
+    10000000000ULL,          1000000000ULL,          100000000ULL,
+    10000000ULL,             1000000ULL,             100000ULL,
+    10000ULL,                1000ULL,                100ULL,
+    10ULL};
+
+/**
+ * @brief Write the decimal digits of a 64-bit `value` to `buf`, without a terminating null
+ * character, and return the number of digits written. `buf` must have room for 20 characters.
+ *
+ * @param buf Destination of the decimal digits
+ * @param value The number to convert
+ * @return uint32_t
+ */
+static inline uint32_t format_uint64_dec(char *buf, uint64_t value)
+{
+  if ((value >> 32) == 0)
+    return format_uint32_dec(buf, (uint32_t)value);
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < NUMBER_OF(format_pow10_64); i++)
+  {
+    uint64_t pow10 = format_pow10_64[i];
+    char digit = '0';
+    while (value >= pow10)
+    {
+      value -= pow10;
+      digit++;
+    }
+    if (digit != '0' || n != 0)
+      buf[n++] = digit;
+  }
+  buf[n++] = '0' + (uint32_t)value;
+  return n;
+}
+
+/**
+ * @brief Write the hexadecimal digits of `value` to `buf`, without a terminating null character,
+ * and return the number of digits written. `buf` must have room for 8 characters.
+ *
+ * @param buf Destination of the hexadecimal digits
+ * @param value The number to convert
+ * @param uppercase Use `A-F` instead of `a-f`
+ * @return uint32_t
+ */
+static inline uint32_t format_uint32_hex(char *buf, uint32_t value, bool uppercase)
+{
+  const char *hex_digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+  int32_t shift = 28;
+  while (shift > 0 && (value >> shift) == 0)
+    shift -= 4;
+  uint32_t n = 0;
+  for (; shift >= 0; shift -= 4)
+    buf[n++] = hex_digits[(value >> shift) & 0xf];
+  return n;
+}
+
+/**
+ * @brief Write the hexadecimal digits of a 64-bit `value` to `buf`, without a terminating null
+ * character, and return the number of digits written. `buf` must have room for 16 characters.
+ *
+ * @param buf Destination of the hexadecimal digits
+ * @param value The number to convert
+ * @param uppercase Use `A-F` instead of `a-f`
+ * @return uint32_t
+ */
+static inline uint32_t format_uint64_hex(char *buf, uint64_t value, bool uppercase)
+{
+  uint32_t high = (uint32_t)(value >> 32);
+  if (high == 0)
+    return format_uint32_hex(buf, (uint32_t)value, uppercase);
+  const char *hex_digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+  uint32_t n = format_uint32_hex(buf, high, uppercase);
+  // The low word keeps its leading zeros
+  uint32_t low = (uint32_t)value;
+  for (int32_t shift = 28; shift >= 0; shift -= 4)
+    buf[n++] = hex_digits[(low >> shift) & 0xf];
+  return n;
+}
+
+// Length modifiers accepted by the integer conversions
+enum FormatLength
+{
+  FORMAT_LENGTH_INT = 0,
+  // hh
+  FORMAT_LENGTH_CHAR = 1,
+  // h
+  FORMAT_LENGTH_SHORT = 2,
+  // l
+  FORMAT_LENGTH_LONG = 3,
+  // ll
+  FORMAT_LENGTH_LONG_LONG = 4,
+  // z
+  FORMAT_LENGTH_SIZE = 5
+};
+
+/**
+ * @brief Fetch the next argument of a signed integer conversion (%d, %i).
+ *
+ * @param args The arguments being formatted
+ * @param length The length modifier of the conversion
+ * @return int64_t
+ */
+static inline int64_t format_arg_signed(va_list *args, enum FormatLength length)
+{
+  switch (length)
+  {
+  case FORMAT_LENGTH_CHAR:
+    return (signed char)va_arg(*args, int);
+  case FORMAT_LENGTH_SHORT:
+    return (short)va_arg(*args, int);
+  case FORMAT_LENGTH_LONG:
+    return va_arg(*args, long);
+  case FORMAT_LENGTH_LONG_LONG:
+    return va_arg(*args, long long);
+  case FORMAT_LENGTH_SIZE:
+    return va_arg(*args, ptrdiff_t);
+  default:
+    return va_arg(*args, int);
+  }
+}
+
+/**
+ * @brief Fetch the next argument of an unsigned integer conversion (%u, %x, %X).
+ *
+ * @param args The arguments being formatted
+ * @param length The length modifier of the conversion
+ * @return uint64_t
+ */
+static inline uint64_t format_arg_unsigned(va_list *args, enum FormatLength length)
+{
+  switch (length)
+  {
+  case FORMAT_LENGTH_CHAR:
+    return (unsigned char)va_arg(*args, unsigned int);
+  case FORMAT_LENGTH_SHORT:
+    return (unsigned short)va_arg(*args, unsigned int);
+  case FORMAT_LENGTH_LONG:
+    return va_arg(*args, unsigned long);
+  case FORMAT_LENGTH_LONG_LONG:
+    return va_arg(*args, unsigned long long);
+  case FORMAT_LENGTH_SIZE:
+    return va_arg(*args, size_t);
+  default:
+    return va_arg(*args, unsigned int);
+  }
+}
+
+/**
+ * @brief Format a string as described at the top of this file, passing each output character to
+ * `put`. Return the number of characters output.
+ *
+ * @param put Function called to output each character
+ * @param context Opaque pointer handed to `put`
+ * @param fmt The format string
+ * @param args The arguments to be formatted
+ * @return uint32_t
+ */
+static inline uint32_t format_vprint(FormatPutChar put, void *context, const char *fmt,
+                                     va_list args)
+{
+  uint32_t count = 0;
+  char digits[20];
+  // Work on a copy, as a va_list parameter cannot portably be passed on by address
+  va_list ap;
+  va_copy(ap, args);
+  for (; *fmt != '\0'; fmt++)
+  {
+    if (*fmt != '%')
+    {
+      put(context, *fmt);
+      count++;
+      continue;
+    }
+    fmt++;
+    bool left = false;
+    char pad = ' ';
+    for (;; fmt++)
+    {
+      if (*fmt == '-')
+        left = true;
+      else if (*fmt == '0')
+        pad = '0';
+      else
+        break;
+    }
+    uint32_t width = 0;
+    while (*fmt >= '0' && *fmt <= '9')
+    {
+      width = (width << 3) + (width << 1) + (*fmt - '0');
+      fmt++;
+    }
+    enum FormatLength length = FORMAT_LENGTH_INT;
+    if (*fmt == 'h')
+    {
+      fmt++;
+      length = FORMAT_LENGTH_SHORT;
+      if (*fmt == 'h')
+      {
+        fmt++;
+        length = FORMAT_LENGTH_CHAR;
+      }
+    }
+    else if (*fmt == 'l')
+    {
+      fmt++;
+      length = FORMAT_LENGTH_LONG;
+      if (*fmt == 'l')
+      {
+        fmt++;
+        length = FORMAT_LENGTH_LONG_LONG;
+      }
+    }
+    else if (*fmt == 'z')
+    {
+      fmt++;
+      length = FORMAT_LENGTH_SIZE;
+    }
+    const char *str = digits;
+    uint32_t len = 0;
+    char sign = 0;
+    switch (*fmt)
+    {
+    case 'd':
+    case 'i':
+    {
+      int64_t value = format_arg_signed(&ap, length);
+      uint64_t magnitude = value;
+      if (value < 0)
+      {
+        sign = '-';
+        magnitude = -magnitude;
+      }
+      len = format_uint64_dec(digits, magnitude);
+      break;
+    }
+    case 'u':
+      len = format_uint64_dec(digits, format_arg_unsigned(&ap, length));
+      break;
+    case 'x':
+    case 'X':
+      len = format_uint64_hex(digits, format_arg_unsigned(&ap, length), *fmt == 'X');
+      break;
+    case 'c':
+      digits[0] = (char)va_arg(ap, int);
+      len = 1;
+      break;
+    case 's':
+      str = va_arg(ap, const char *);
+      if (str == NULL)
+        str = "(null)";
+      while (str[len] != '\0')
+        len++;
+      break;
+    case '\0':
+      // A lone '%' at the end of the format string is ignored
+      va_end(ap);
+      return count;
+    default:
+      // Unsupported conversions are printed as-is
+      digits[0] = '%';
+      digits[1] = *fmt;
+      len = *fmt == '%' ? 1 : 2;
+      str = *fmt == '%' ? digits + 1 : digits;
+      break;
+    }
+    uint32_t total = len + (sign != 0);
+    uint32_t fill = width > total ? width - total : 0;
+    if (left)
+      pad = ' ';
+    if (sign != 0 && pad == '0')
+      put(context, sign);
+    if (!left)
+      for (uint32_t i = 0; i < fill; i++)
+        put(context, pad);
+    if (sign != 0 && pad != '0')
+      put(context, sign);
+    for (uint32_t i = 0; i < len; i++)
+      put(context, str[i]);
+    if (left)
+      for (uint32_t i = 0; i < fill; i++)
+        put(context, ' ');
+    count += total + fill;
+  }
+  va_end(ap);
+  return count;
+}
+
+// Output function used by `uart_printf`
+static inline void format_put_uart(void *context, char c)
+{
+  uart_write((UartController *)context, c);
+}
+
+// Output function used by `uart_tx_buffer_printf`
+static inline void format_put_uart_tx_buffer(void *context, char c)
+{
+  uart_tx_buffer_put((UartTxBuffer *)context, c);
+}
+
+// State of the output function used by `format_snprintf`
+typedef struct
+{
+  char *buf;
+  uint32_t size;
+  uint32_t pos;
+} FormatStringOutput;
+
+// Output function used by `format_snprintf`
+static inline void format_put_string(void *context, char c)
+{
+  FormatStringOutput *out = (FormatStringOutput *)context;
+  if (out->pos + 1 < out->size)
+    out->buf[out->pos++] = c;
+}
+
+/**
+ * @brief Send a formatted string over the UART device. Return the number of characters sent.
+ *
+ * Example usage:
+ * ```
+ * uart_printf(uart, "adc[%u] = %6d (0x%04x)\n", channel, value, raw);
+ * ```
+ *
+ * @param uart Pointer to the UartController
+ * @param fmt The format string
+ * @param ... The arguments to be formatted
+ * @return uint32_t
+ */
+__FORMAT_PRINTF(2, 3)
+static inline uint32_t uart_printf(UartController *uart, const char *fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  uint32_t count = format_vprint(format_put_uart, uart, fmt, args);
+  va_end(args);
+  return count;
+}
+
+/**
+ * @brief Write a formatted string to a UART TX buffer and return without waiting for it to be
+ * sent. Return the number of characters formatted.
+ *
+ * @param txb Pointer to the UartTxBuffer
+ * @param fmt The format string
+ * @param ... The arguments to be formatted
+ * @return uint32_t
+ */
+__FORMAT_PRINTF(2, 3)
+static inline uint32_t uart_tx_buffer_printf(UartTxBuffer *txb, const char *fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  uint32_t count = format_vprint(format_put_uart_tx_buffer, txb, fmt, args);
+  va_end(args);
+  return count;
+}
+
+/**
+ * @brief Write a formatted string to `buf`, truncating it to `size - 1` characters and always
+ * adding a terminating null character (if `size > 0`). Return the length the string would have
+ * without truncation.
+ *
+ * @param buf Destination of the formatted string
+ * @param size Size of `buf` in bytes
+ * @param fmt The format string
+ * @param ... The arguments to be formatted
+ * @return uint32_t
+ */
+__FORMAT_PRINTF(3, 4)
+static inline uint32_t format_snprintf(char *buf, uint32_t size, const char *fmt, ...)
+{
+  FormatStringOutput out = {buf, size, 0};
+  va_list args;
+  va_start(args, fmt);
+  uint32_t count = format_vprint(format_put_string, &out, fmt, args);
+  va_end(args);
+  if (size > 0)
+    buf[out.pos] = '\0';
+  return count;
+}
+
+#endif // __LIBSTEEL_FORMAT__
@@ -9,6 +9,7 @@
 #define __LIBSTEEL_GLOBALS__
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifndef __ASM
@@ -67,6 +68,20 @@
 #define __PACKED_UNION union __attribute__((packed, aligned(1)))
 #endif
 
+#ifndef __FORMAT_PRINTF
+#define __FORMAT_PRINTF(format_index, first_arg_index)                                             \
+  __attribute__((format(printf, format_index, first_arg_index)))
+#endif
+
+// Compile-time assertion, usable from both C and C++
+#ifndef __STATIC_ASSERT
+#ifdef __cplusplus
+#define __STATIC_ASSERT(condition, message) static_assert(condition, message)
+#else
+#define __STATIC_ASSERT(condition, message) _Static_assert(condition, message)
+#endif
+#endif
+
 #ifndef __IRQ_M
 #define __IRQ_M(vector) __attribute__((interrupt("machine"))) void vector(void)
 #endif
@@ -103,4 +118,38 @@
 
 #define NUMBER_OF(a) (sizeof a / sizeof a[0])
 
+/**
+ * @brief Count the trailing zero bits of a non-zero 32-bit value, i.e. return the index of its
+ * lowest set bit. Uses a 5-step binary search with shifts and masks only, since RV32I has neither
+ * a count instruction (Zbb) nor a multiplier for de Bruijn methods. The result is undefined for 0.
+ *
+ * @param x A non-zero value
+ * @return uint32_t
+ */
+__STATIC_FORCEINLINE uint32_t ctz32(uint32_t x)
+{
+  uint32_t n = 0;
+  if ((x & 0xffff) == 0)
+  {
+    n += 16;
+    x >>= 16;
+  }
+  if ((x & 0xff) == 0)
+  {
+    n += 8;
+    x >>= 8;
+  }
+  if ((x & 0xf) == 0)
+  {
+    n += 4;
+    x >>= 4;
+  }
+  if ((x & 0x3) == 0)
+  {
+    n += 2;
+    x >>= 2;
+  }
+  return n + ((x & 1) ^ 1);
+}
+
 #endif // __LIBSTEEL_GLOBALS__
@@ -8,6 +8,7 @@
 #ifndef __LIBSTEEL_GPIO__
 #define __LIBSTEEL_GPIO__
 
+#include "csr.h"
 #include "globals.h"
 
 // Struct providing access to RISC-V Steel GPIO Controller registers
@@ -114,12 +115,21 @@ static inline void gpio_clear(GpioController *gpio, const uint32_t pin_id)
  * @brief Toggle the value of a GPIO pin. An attempt to toggle a pin configured as input is
  * gracefully ignored (no errors are given).
  *
+ * The pin is toggled with a single store to the SET or CLR register instead of writing back the
+ * whole OUT register, so pins driven by interrupt handlers in the meantime are never overwritten.
+ * The controller has no toggle register, so register OUT is still read to know the current value:
+ * use `gpio_shadow_toggle` to toggle without any bus read.
+ *
  * @param gpio Pointer to the GpioController
  * @param pin_id The ID of the GPIO pin to toggle. Note that IDs start at 0.
  */
 static inline void gpio_toggle(GpioController *gpio, const uint32_t pin_id)
 {
-  INV_BIT(gpio->OUT, pin_id);
+  uint32_t bit = 0x1U << pin_id;
+  if (gpio->OUT & bit)
+    gpio->CLR = bit;
+  else
+    gpio->SET = bit;
 }
 
 /**
@@ -234,10 +244,218 @@ static inline void gpio_clear_group(GpioController *gpio, const uint32_t bit_mas
  * @param bit_mask A bit mask indicating which GPIO pins must have their values toggled.
  * Example: 0b00010000 toggles gpio[4] from 0->1 or 1->0, depending on its current value. All
  * remaining pins keep their current values.
+ *
+ * All pins change with a single store to register OUT, so they switch on the same clock edge.
+ * The controller has no toggle register, so OUT is still read and written back, with interrupts
+ * masked in between so that pins driven by interrupt handlers are never overwritten. Only
+ * `gpio_shadow_toggle_group` toggles with a single store and no register read.
  */
 static inline void gpio_toggle_group(GpioController *gpio, const uint32_t bit_mask)
 {
-  INV_FLAG(gpio->OUT, bit_mask);
+  uint32_t mstatus = csr_global_disable_irq_save();
+  gpio->OUT = gpio->OUT ^ bit_mask;
+  csr_global_restore_irq(mstatus);
+}
+
+// Struct holding a GPIO Controller handle that mirrors registers OE and OUT in RAM
+typedef struct
+{
+  // Pointer to the GpioController
+  GpioController *gpio;
+  // Copy of register OE (Output Enable)
+  uint32_t oe;
+  // Copy of register OUT (Output)
+  uint32_t out;
+} GpioShadow;
+
+/* With a GpioShadow, changing the direction of pins and toggling them are single stores (no bus
+ * read), and `gpio_shadow_get_output` returns the driven values without any bus access. The shadow
+ * is only correct if every change to OE and OUT goes through it: call `gpio_shadow_sync` after
+ * changing them otherwise. A GpioShadow must not be used from two contexts (e.g. the main loop and
+ * an interrupt handler) at the same time. */
+
+/**
+ * @brief Reload the copies of registers OE and OUT held by a GpioShadow from the controller.
+ *
+ * @param shadow Pointer to the GpioShadow
+ */
+static inline void gpio_shadow_sync(GpioShadow *shadow)
+{
+  shadow->oe = shadow->gpio->OE;
+  shadow->out = shadow->gpio->OUT;
+}
+
+/**
+ * @brief Initialize a GpioShadow for a GPIO Controller, reading the current OE and OUT values.
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @param gpio Pointer to the GpioController
+ */
+static inline void gpio_shadow_init(GpioShadow *shadow, GpioController *gpio)
+{
+  shadow->gpio = gpio;
+  gpio_shadow_sync(shadow);
+}
+
+/**
+ * @brief Set a group of GPIO pins to work as outputs with a single store to register OE.
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @param bit_mask A bit mask indicating which GPIO pins to set as outputs
+ */
+static inline void gpio_shadow_set_output_group(GpioShadow *shadow, const uint32_t bit_mask)
+{
+  shadow->oe |= bit_mask;
+  shadow->gpio->OE = shadow->oe;
+}
+
+/**
+ * @brief Set a group of GPIO pins to work as inputs with a single store to register OE.
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @param bit_mask A bit mask indicating which GPIO pins to set as inputs
+ */
+static inline void gpio_shadow_set_input_group(GpioShadow *shadow, const uint32_t bit_mask)
+{
+  shadow->oe &= ~bit_mask;
+  shadow->gpio->OE = shadow->oe;
+}
+
+/**
+ * @brief Set a GPIO pin to work as an output with a single store to register OE.
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @param pin_id The ID of the GPIO pin to set as an output. Note that IDs start at 0.
+ */
+static inline void gpio_shadow_set_output(GpioShadow *shadow, const uint32_t pin_id)
+{
+  gpio_shadow_set_output_group(shadow, 0x1U << pin_id);
+}
+
+/**
+ * @brief Set a GPIO pin to work as an input with a single store to register OE.
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @param pin_id The ID of the GPIO pin to set as an input. Note that IDs start at 0.
+ */
+static inline void gpio_shadow_set_input(GpioShadow *shadow, const uint32_t pin_id)
+{
+  gpio_shadow_set_input_group(shadow, 0x1U << pin_id);
+}
+
+/**
+ * @brief Set a group of GPIO pins to logic 1 through register SET. As with `gpio_set_group`, pins
+ * set as inputs are not affected.
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @param bit_mask A bit mask indicating which GPIO pins must be set to logic 1
+ */
+static inline void gpio_shadow_set_group(GpioShadow *shadow, const uint32_t bit_mask)
+{
+  shadow->gpio->SET = bit_mask;
+  shadow->out |= bit_mask & shadow->oe;
+}
+
+/**
+ * @brief Set a group of GPIO pins to logic 0 through register CLR. As with `gpio_clear_group`,
+ * pins set as inputs are not affected.
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @param bit_mask A bit mask indicating which GPIO pins must be set to logic 0
+ */
+static inline void gpio_shadow_clear_group(GpioShadow *shadow, const uint32_t bit_mask)
+{
+  shadow->gpio->CLR = bit_mask;
+  shadow->out &= ~(bit_mask & shadow->oe);
+}
+
+/**
+ * @brief Set the value of a GPIO pin to logic 1.
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @param pin_id The ID of the GPIO pin to set. Note that IDs start at 0.
+ */
+static inline void gpio_shadow_set(GpioShadow *shadow, const uint32_t pin_id)
+{
+  gpio_shadow_set_group(shadow, 0x1U << pin_id);
+}
+
+/**
+ * @brief Set the value of a GPIO pin to logic 0.
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @param pin_id The ID of the GPIO pin to clear. Note that IDs start at 0.
+ */
+static inline void gpio_shadow_clear(GpioShadow *shadow, const uint32_t pin_id)
+{
+  gpio_shadow_clear_group(shadow, 0x1U << pin_id);
+}
+
+/**
+ * @brief Toggle the value of a GPIO pin with a single store to register SET or CLR. No register
+ * is read.
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @param pin_id The ID of the GPIO pin to toggle. Note that IDs start at 0.
+ */
+static inline void gpio_shadow_toggle(GpioShadow *shadow, const uint32_t pin_id)
+{
+  uint32_t bit = 0x1U << pin_id;
+  if (shadow->out & bit)
+    gpio_shadow_clear_group(shadow, bit);
+  else
+    gpio_shadow_set_group(shadow, bit);
+}
+
+/**
+ * @brief Toggle the value of a group of GPIO pins with a single store to register OUT, so that all
+ * of them switch on the same clock edge. No register is read. Pins set as inputs are not affected,
+ * but output pins driven without the shadow (e.g. by an interrupt handler) are overwritten.
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @param bit_mask A bit mask indicating which GPIO pins must have their values toggled
+ */
+static inline void gpio_shadow_toggle_group(GpioShadow *shadow, const uint32_t bit_mask)
+{
+  shadow->out ^= bit_mask & shadow->oe;
+  shadow->gpio->OUT = shadow->out;
+}
+
+/**
+ * @brief Set the logic values of all output pins at once with a single store to register OUT. As
+ * with `gpio_write_group`, pins set as inputs are not affected.
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @param value_mask A bit mask with the logic values for the GPIO pins
+ */
+static inline void gpio_shadow_write_group(GpioShadow *shadow, const uint32_t value_mask)
+{
+  shadow->gpio->OUT = value_mask;
+  shadow->out = (shadow->out & ~shadow->oe) | (value_mask & shadow->oe);
+}
+
+/**
+ * @brief Return a bit vector with the values driven on the output pins, taken from the shadow
+ * copy of register OUT (no bus access).
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @return uint32_t
+ */
+static inline uint32_t gpio_shadow_get_output(GpioShadow *shadow)
+{
+  return shadow->out & shadow->oe;
+}
+
+/**
+ * @brief Return a bit vector with the pins set as outputs, taken from the shadow copy of register
+ * OE (no bus access).
+ *
+ * @param shadow Pointer to the GpioShadow
+ * @return uint32_t
+ */
+static inline uint32_t gpio_shadow_get_output_enable(GpioShadow *shadow)
+{
+  return shadow->oe;
 }
 
 #endif // __LIBSTEEL_GPIO__
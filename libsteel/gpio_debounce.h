@@ -0,0 +1,149 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_GPIO_DEBOUNCE__
+#define __LIBSTEEL_GPIO_DEBOUNCE__
+
+#include "csr.h"
+#include "globals.h"
+#include "gpio.h"
+
+/* Debouncing of all 32 GPIO inputs in parallel. Each pin has a 2-bit counter, stored bit-sliced
+ * across two words (`cnt0` holds bit 0 of all 32 counters, `cnt1` bit 1), so one sample of all
+ * pins costs a handful of logical operations and no branch or loop. A pin changes its debounced
+ * state once it is read with the new value in 4 consecutive samples; any sample agreeing with the
+ * current state resets its counter.
+ *
+ * Take one sample per tick of a periodic timer, e.g. every 5 ms from the MTimer interrupt:
+ *
+ * ```
+ * static GpioDebouncer buttons;
+ *
+ * __IRQ_M(mtimer_irq_handler)
+ * {
+ *   mtimer_set_compare(mtimer, mtimer_get_counter(mtimer) + DEBOUNCE_TICKS);
+ *   gpio_debounce_sample(&buttons, gpio);
+ * }
+ *
+ * // In the main loop:
+ * uint32_t pressed = gpio_debounce_take_rising(&buttons);
+ * ```
+ */
+
+// Struct holding the state of the debouncer of the 32 GPIO inputs
+typedef struct
+{
+  // Debounced state of all pins
+  uint32_t state;
+  // Bit 0 of the counters of all pins
+  uint32_t cnt0;
+  // Bit 1 of the counters of all pins
+  uint32_t cnt1;
+  // Pins whose debounced state changed from 0 to 1 since the last call to
+  // `gpio_debounce_take_rising`
+  volatile uint32_t rising;
+  // Pins whose debounced state changed from 1 to 0 since the last call to
+  // `gpio_debounce_take_falling`
+  volatile uint32_t falling;
+} GpioDebouncer;
+
+/**
+ * @brief Initialize a debouncer with the debounced state of all pins set to `initial_state`
+ * (usually the value returned by `gpio_read_all`).
+ *
+ * @param deb Pointer to the GpioDebouncer
+ * @param initial_state Initial debounced state of all pins
+ */
+static inline void gpio_debounce_init(GpioDebouncer *deb, const uint32_t initial_state)
+{
+  deb->state = initial_state;
+  deb->cnt0 = 0;
+  deb->cnt1 = 0;
+  deb->rising = 0;
+  deb->falling = 0;
+}
+
+/**
+ * @brief Feed a sample of all pins to the debouncer and return a mask of the pins whose debounced
+ * state changed with it. Rising and falling edges are also accumulated for
+ * `gpio_debounce_take_rising` and `gpio_debounce_take_falling`.
+ *
+ * @param deb Pointer to the GpioDebouncer
+ * @param sample The value of all pins, as returned by `gpio_read_all`
+ * @return uint32_t
+ */
+static inline uint32_t gpio_debounce_update(GpioDebouncer *deb, const uint32_t sample)
+{
+  // Pins that differ from their debounced state count up; the others have their counter cleared
+  uint32_t delta = sample ^ deb->state;
+  deb->cnt1 = (deb->cnt1 ^ deb->cnt0) & delta;
+  deb->cnt0 = ~deb->cnt0 & delta;
+  // The counter of a pin wraps to zero on its 4th consecutive differing sample
+  uint32_t changed = delta & ~(deb->cnt0 | deb->cnt1);
+  deb->state ^= changed;
+  deb->rising |= changed & deb->state;
+  deb->falling |= changed & ~deb->state;
+  return changed;
+}
+
+/**
+ * @brief Read all GPIO pins once and feed them to the debouncer. Return a mask of the pins whose
+ * debounced state changed.
+ *
+ * @param deb Pointer to the GpioDebouncer
+ * @param gpio Pointer to the GpioController
+ * @return uint32_t
+ */
+static inline uint32_t gpio_debounce_sample(GpioDebouncer *deb, GpioController *gpio)
+{
+  return gpio_debounce_update(deb, gpio_read_all(gpio));
+}
+
+/**
+ * @brief Return the debounced state of all pins.
+ *
+ * @param deb Pointer to the GpioDebouncer
+ * @return uint32_t
+ */
+static inline uint32_t gpio_debounce_state(GpioDebouncer *deb)
+{
+  return deb->state;
+}
+
+/**
+ * @brief Return the pins that had a debounced rising edge since the last call, and clear them. Safe
+ * to call while the debouncer is fed from an interrupt handler.
+ *
+ * @param deb Pointer to the GpioDebouncer
+ * @return uint32_t
+ */
+static inline uint32_t gpio_debounce_take_rising(GpioDebouncer *deb)
+{
+  uint32_t mstatus = csr_global_disable_irq_save();
+  uint32_t rising = deb->rising;
+  deb->rising = 0;
+  csr_global_restore_irq(mstatus);
+  return rising;
+}
+
+/**
+ * @brief Return the pins that had a debounced falling edge since the last call, and clear them.
+ * Safe to call while the debouncer is fed from an interrupt handler.
+ *
+ * @param deb Pointer to the GpioDebouncer
+ * @return uint32_t
+ */
+static inline uint32_t gpio_debounce_take_falling(GpioDebouncer *deb)
+{
+  uint32_t mstatus = csr_global_disable_irq_save();
+  uint32_t falling = deb->falling;
+  deb->falling = 0;
+  csr_global_restore_irq(mstatus);
+  return falling;
+}
+
+#endif // __LIBSTEEL_GPIO_DEBOUNCE__
@@ -0,0 +1,131 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_GPIO_EDGE__
+#define __LIBSTEEL_GPIO_EDGE__
+
+#include "globals.h"
+#include "gpio.h"
+
+/* Pin-change detection for GPIO inputs. The GPIO Controller has no per-pin interrupts, so a
+ * GpioEdgeScanner keeps the previous value of register IN and compares it with a new one on each
+ * scan, obtaining the rising and falling edges of all 32 pins with a single `gpio_read_all`. Scans
+ * never wait and can be done from a fast interrupt or a timer interrupt handler.
+ *
+ * Example usage:
+ * ```
+ * static GpioEdgeScanner scanner;
+ *
+ * static void on_edge(uint32_t pin_id, bool rising, void *context)
+ * {
+ *   // ...
+ * }
+ *
+ * __IRQ_M(mtimer_irq_handler)
+ * {
+ *   GpioEdges edges = gpio_edge_scan(&scanner, gpio);
+ *   gpio_edge_dispatch(edges, on_edge, NULL);
+ * }
+ * ```
+ */
+
+// Struct holding the previous value of the IN register of a GPIO Controller
+typedef struct
+{
+  // Value of register IN at the last scan
+  uint32_t previous;
+  // Pins whose edges are reported. Edges on other pins are ignored.
+  uint32_t mask;
+} GpioEdgeScanner;
+
+// Struct with the edges found by a scan
+typedef struct
+{
+  // Pins that changed from 0 to 1
+  uint32_t rising;
+  // Pins that changed from 1 to 0
+  uint32_t falling;
+} GpioEdges;
+
+// Type of the function called by `gpio_edge_dispatch` for each edge
+typedef void (*GpioEdgeCallback)(uint32_t pin_id, bool rising, void *context);
+
+/**
+ * @brief Initialize a scanner, taking the current value of register IN as reference.
+ *
+ * @param scanner Pointer to the GpioEdgeScanner
+ * @param gpio Pointer to the GpioController
+ * @param mask A bit mask indicating which GPIO pins have their edges reported
+ */
+static inline void gpio_edge_init(GpioEdgeScanner *scanner, GpioController *gpio,
+                                  const uint32_t mask)
+{
+  scanner->previous = gpio_read_all(gpio);
+  scanner->mask = mask;
+}
+
+/**
+ * @brief Compare a new value of register IN with the previous one and return the edges found.
+ *
+ * @param scanner Pointer to the GpioEdgeScanner
+ * @param current The new value of register IN
+ * @return GpioEdges
+ */
+static inline GpioEdges gpio_edge_update(GpioEdgeScanner *scanner, const uint32_t current)
+{
+  uint32_t changed = (current ^ scanner->previous) & scanner->mask;
+  scanner->previous = current;
+  GpioEdges edges = {changed & current, changed & ~current};
+  return edges;
+}
+
+/**
+ * @brief Read register IN once and return the edges found since the previous scan.
+ *
+ * @param scanner Pointer to the GpioEdgeScanner
+ * @param gpio Pointer to the GpioController
+ * @return GpioEdges
+ */
+static inline GpioEdges gpio_edge_scan(GpioEdgeScanner *scanner, GpioController *gpio)
+{
+  return gpio_edge_update(scanner, gpio_read_all(gpio));
+}
+
+/**
+ * @brief Call `callback` once for each pin set in `mask`, from the lowest pin ID to the highest.
+ * Only the set bits are visited: each step finds the lowest one with `ctz32` and clears it.
+ *
+ * @param mask A bit mask of pins
+ * @param rising Value handed to the callback
+ * @param callback The function to call
+ * @param context Opaque pointer handed to the callback
+ */
+static inline void gpio_edge_dispatch_mask(uint32_t mask, bool rising, GpioEdgeCallback callback,
+                                           void *context)
+{
+  while (mask != 0)
+  {
+    callback(ctz32(mask), rising, context);
+    mask &= mask - 1;
+  }
+}
+
+/**
+ * @brief Call `callback` once for each edge found by a scan: first the rising edges, then the
+ * falling edges.
+ *
+ * @param edges The edges found by `gpio_edge_scan`
+ * @param callback The function to call
+ * @param context Opaque pointer handed to the callback
+ */
+static inline void gpio_edge_dispatch(GpioEdges edges, GpioEdgeCallback callback, void *context)
+{
+  gpio_edge_dispatch_mask(edges.rising, true, callback, context);
+  gpio_edge_dispatch_mask(edges.falling, false, callback, context);
+}
+
+#endif // __LIBSTEEL_GPIO_EDGE__
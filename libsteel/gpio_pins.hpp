@@ -0,0 +1,132 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_GPIO_PINS__
+#define __LIBSTEEL_GPIO_PINS__
+
+#include "gpio.h"
+
+/* C++ layer to drive several GPIO pins at once. Assigning a value to a Pin or a PinSet yields a
+ * PinWrite (a pair of SET/CLR masks); PinWrites are combined with the comma operator, the rightmost
+ * assignment winning when a pin appears twice. All of it is constexpr, so with constant values the
+ * masks are computed by the compiler and `gpio_apply` is reduced to at most one store to register
+ * SET and one store to register CLR, with no per-pin code left.
+ *
+ * Example usage:
+ * ```
+ * constexpr libsteel::Pin led{0}, cs{1}, dc{2};
+ * libsteel::gpio_apply(gpio, (led = HIGH, cs = LOW, dc = HIGH)); // SET = 0b101, CLR = 0b010
+ *
+ * constexpr libsteel::PinSet bus = libsteel::Pin{4} | libsteel::Pin{5} | libsteel::Pin{6};
+ * libsteel::gpio_apply(gpio, (bus = LOW, cs = HIGH));
+ * ```
+ *
+ * Requires C++11 or later. */
+
+namespace libsteel
+{
+  // Pair of masks with the pins to be set to logic 1 and to logic 0
+  struct PinWrite
+  {
+    // Pins to be set to logic 1 (written to register SET)
+    uint32_t set_mask;
+    // Pins to be set to logic 0 (written to register CLR)
+    uint32_t clr_mask;
+  };
+
+  // Combine two PinWrites. For pins present in both, the value given by `b` wins.
+  constexpr PinWrite operator,(PinWrite a, PinWrite b)
+  {
+    return PinWrite{(a.set_mask & ~b.clr_mask) | b.set_mask,
+                    (a.clr_mask & ~b.set_mask) | b.clr_mask};
+  }
+
+  // A group of GPIO pins, identified by a bit mask
+  struct PinSet
+  {
+    // Bit mask of the pins in the group
+    uint32_t mask;
+
+    // Drive all pins of the group to `value`
+    constexpr PinWrite operator=(GpioLogicValue value) const
+    {
+      return value == HIGH ? PinWrite{mask, 0} : PinWrite{0, mask};
+    }
+
+    // Drive all pins of the group to `value` (true means HIGH)
+    constexpr PinWrite operator=(bool value) const
+    {
+      return value ? PinWrite{mask, 0} : PinWrite{0, mask};
+    }
+  };
+
+  // A single GPIO pin, identified by its ID (IDs start at 0)
+  struct Pin
+  {
+    // The ID of the GPIO pin
+    uint32_t id;
+
+    // Bit mask of the pin
+    constexpr uint32_t mask() const
+    {
+      return 0x1U << id;
+    }
+
+    // Drive the pin to `value`
+    constexpr PinWrite operator=(GpioLogicValue value) const
+    {
+      return PinSet{mask()} = value;
+    }
+
+    // Drive the pin to `value` (true means HIGH)
+    constexpr PinWrite operator=(bool value) const
+    {
+      return PinSet{mask()} = value;
+    }
+
+    // Conversion to a group holding only this pin
+    constexpr operator PinSet() const
+    {
+      return PinSet{mask()};
+    }
+  };
+
+  // Group of pins holding the pins of both operands
+  constexpr PinSet operator|(PinSet a, PinSet b)
+  {
+    return PinSet{a.mask | b.mask};
+  }
+
+  /**
+   * @brief Apply a PinWrite to a GPIO Controller with at most one store to register SET and one
+   * store to register CLR. As with `gpio_set_group` and `gpio_clear_group`, pins set as inputs are
+   * not affected.
+   *
+   * @param gpio Pointer to the GpioController
+   * @param write The pins to set and clear, usually an expression like `(a = HIGH, b = LOW)`
+   */
+  __attribute__((always_inline)) inline void gpio_apply(GpioController *gpio, PinWrite write)
+  {
+    if (write.set_mask != 0)
+      gpio->SET = write.set_mask;
+    if (write.clr_mask != 0)
+      gpio->CLR = write.clr_mask;
+  }
+
+  /**
+   * @brief Set a group of pins to work as outputs.
+   *
+   * @param gpio Pointer to the GpioController
+   * @param pins The group of pins
+   */
+  inline void gpio_set_output(GpioController *gpio, PinSet pins)
+  {
+    gpio_set_output_group(gpio, pins.mask);
+  }
+}
+
+#endif // __LIBSTEEL_GPIO_PINS__
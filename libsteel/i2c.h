@@ -0,0 +1,453 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_I2C__
+#define __LIBSTEEL_I2C__
+
+#include "csr.h"
+#include "globals.h"
+#include "gpio.h"
+
+/* Bit-banged I2C master on two GPIO pins. The lines are driven open-drain style: the output value
+ * of both pins is kept at 0 and a line is pulled low by setting its pin as an output, or released
+ * (pulled up by the external resistor) by setting it as an input. External pull-up resistors are
+ * required.
+ *
+ * Timing is taken from CSR_MCYCLE: every edge is scheduled relative to the previous one, so the
+ * time spent in the driver code itself does not slow the bus down. A wait that ends late (e.g.
+ * after an interrupt) becomes the reference for the next edge, so no later phase is shortened to
+ * catch up. The SCL low phase takes 53% of the period, which meets the minimum low and high times
+ * of Standard, Fast and Fast-mode Plus. Slaves stretching the clock are waited for, up to a
+ * timeout after which the transaction is aborted and returns I2C_TIMEOUT.
+ *
+ * Example usage (read 6 bytes from register 0x3B of a sensor at address 0x68):
+ * ```
+ * I2cMaster i2c;
+ * i2c_init(&i2c, gpio, 4, 5, 50000000, I2C_FAST_MODE);
+ * uint8_t data[6];
+ * i2c_read_registers(&i2c, 0x68, 0x3B, data, sizeof(data));
+ * ```
+ */
+
+// Enumeration with the I2C bus speeds, in Hz
+enum I2cSpeed
+{
+  // Standard mode, 100 kHz
+  I2C_STANDARD_MODE = 100000,
+  // Fast mode, 400 kHz
+  I2C_FAST_MODE = 400000,
+  // Fast-mode Plus, 1 MHz
+  I2C_FAST_MODE_PLUS = 1000000
+};
+
+// Enumeration with the results of I2C transactions
+enum I2cStatus
+{
+  // The transaction completed successfully
+  I2C_OK = 0,
+  // The slave did not acknowledge its address or a data byte
+  I2C_NACK = 1,
+  // A slave stretched the clock for longer than the timeout
+  I2C_TIMEOUT = 2
+};
+
+// Struct holding the state of a bit-banged I2C master
+typedef struct
+{
+  // Pointer to the GpioController
+  GpioController *gpio;
+  // ID of the GPIO pin used as SCL
+  uint32_t scl;
+  // ID of the GPIO pin used as SDA
+  uint32_t sda;
+  // Duration of the SCL low phase in cycles
+  uint32_t t_low;
+  // Duration of the SCL high phase in cycles
+  uint32_t t_high;
+  // Maximum time a slave may stretch the clock, in cycles
+  uint32_t stretch_timeout;
+  // Value of CSR_MCYCLE at the last edge, used to schedule the next one
+  uint32_t t_edge;
+  // True if a slave stretched the clock for too long during the current transaction, which is
+  // then aborted: no more bits are clocked
+  bool timeout;
+} I2cMaster;
+
+/**
+ * @brief Return the current value of CSR_MCYCLE (lowest 32 bits).
+ *
+ * @return uint32_t
+ */
+static inline uint32_t i2c_cycles()
+{
+  uint32_t cycles;
+  CSR_READ(CSR_MCYCLE, cycles);
+  return cycles;
+}
+
+/**
+ * @brief Wait until `duration` cycles have elapsed since the last edge, and make the instant the
+ * wait ends the reference for the next edge (`t_edge = max(now, t_edge + duration)`). If the
+ * driver was delayed, e.g. by an interrupt, the next phase therefore still lasts its full duration
+ * instead of being shortened to catch up.
+ *
+ * @param i2c Pointer to the I2cMaster
+ * @param duration Number of cycles
+ */
+static inline void i2c_wait(I2cMaster *i2c, uint32_t duration)
+{
+  uint32_t now;
+  do
+    now = i2c_cycles();
+  while (now - i2c->t_edge < duration);
+  i2c->t_edge = now;
+}
+
+// Pull SCL low
+static inline void i2c_scl_low(I2cMaster *i2c)
+{
+  gpio_set_output(i2c->gpio, i2c->scl);
+}
+
+// Pull SDA low
+static inline void i2c_sda_low(I2cMaster *i2c)
+{
+  gpio_set_output(i2c->gpio, i2c->sda);
+}
+
+// Release SDA
+static inline void i2c_sda_release(I2cMaster *i2c)
+{
+  gpio_set_input(i2c->gpio, i2c->sda);
+}
+
+/**
+ * @brief Release SCL and wait until it is actually high, which a slave can delay by stretching the
+ * clock. If it was delayed, the timing reference is moved to the moment SCL went high. If it is
+ * still low after the stretch timeout, `timeout` is set and the transaction is aborted.
+ *
+ * @param i2c Pointer to the I2cMaster
+ */
+static inline void i2c_scl_release(I2cMaster *i2c)
+{
+  gpio_set_input(i2c->gpio, i2c->scl);
+  if (gpio_read(i2c->gpio, i2c->scl))
+    return;
+  uint32_t start = i2c_cycles();
+  while (!gpio_read(i2c->gpio, i2c->scl))
+  {
+    if (i2c_cycles() - start >= i2c->stretch_timeout)
+    {
+      i2c->timeout = true;
+      break;
+    }
+  }
+  i2c->t_edge = i2c_cycles();
+}
+
+/**
+ * @brief Initialize a bit-banged I2C master and release both lines.
+ *
+ * @param i2c Pointer to the I2cMaster
+ * @param gpio Pointer to the GpioController
+ * @param scl ID of the GPIO pin used as SCL
+ * @param sda ID of the GPIO pin used as SDA
+ * @param clock_hz Frequency of the system clock in Hz
+ * @param speed The bus speed
+ */
+static inline void i2c_init(I2cMaster *i2c, GpioController *gpio, const uint32_t scl,
+                            const uint32_t sda, uint32_t clock_hz, enum I2cSpeed speed)
+{
+  i2c->gpio = gpio;
+  i2c->scl = scl;
+  i2c->sda = sda;
+  uint32_t period = clock_hz / speed;
+  // 17/32 = 53% of the period, computed with shifts since RV32I has no multiplier
+  i2c->t_low = ((period << 4) + period) >> 5;
+  i2c->t_high = period - i2c->t_low;
+  i2c->stretch_timeout = clock_hz / 100;
+  i2c->timeout = false;
+  // Latch 0 in the output register of both pins (writes are ignored while a pin is an input), then
+  // release them. Pins already latched at 0 are not glitched.
+  uint32_t mask = (0x1U << scl) | (0x1U << sda);
+  uint32_t latched_high = gpio->OUT & mask;
+  if (latched_high != 0)
+  {
+    gpio_set_output_group(gpio, latched_high);
+    gpio_clear_group(gpio, latched_high);
+  }
+  gpio_set_input_group(gpio, mask);
+  i2c->t_edge = i2c_cycles();
+}
+
+/**
+ * @brief Generate a START condition. The bus must be idle (both lines high).
+ *
+ * @param i2c Pointer to the I2cMaster
+ */
+static inline void i2c_start(I2cMaster *i2c)
+{
+  i2c->timeout = false;
+  i2c->t_edge = i2c_cycles();
+  i2c_sda_low(i2c);
+  i2c_wait(i2c, i2c->t_high);
+  i2c_scl_low(i2c);
+}
+
+/**
+ * @brief Generate a repeated START condition in the middle of a transaction.
+ *
+ * @param i2c Pointer to the I2cMaster
+ */
+static inline void i2c_repeated_start(I2cMaster *i2c)
+{
+  if (i2c->timeout)
+    return;
+  i2c_sda_release(i2c);
+  i2c_wait(i2c, i2c->t_low);
+  i2c_scl_release(i2c);
+  i2c_wait(i2c, i2c->t_high);
+  i2c_sda_low(i2c);
+  i2c_wait(i2c, i2c->t_high);
+  i2c_scl_low(i2c);
+}
+
+/**
+ * @brief Generate a STOP condition, leaving the bus idle.
+ *
+ * @param i2c Pointer to the I2cMaster
+ */
+static inline void i2c_stop(I2cMaster *i2c)
+{
+  i2c_sda_low(i2c);
+  i2c_wait(i2c, i2c->t_low);
+  i2c_scl_release(i2c);
+  i2c_wait(i2c, i2c->t_high);
+  i2c_sda_release(i2c);
+  i2c_wait(i2c, i2c->t_high);
+}
+
+/**
+ * @brief Clock one bit out on SDA and return the value read back on SDA while SCL is high. Writing
+ * a 1 releases SDA, so this also reads a bit sent by the slave. Once the transaction has been
+ * aborted by a stretch timeout, nothing is clocked and 1 (a NACK) is returned.
+ *
+ * @param i2c Pointer to the I2cMaster
+ * @param bit The bit to send (0 or 1)
+ * @return uint32_t
+ */
+static inline uint32_t i2c_bit(I2cMaster *i2c, uint32_t bit)
+{
+  if (i2c->timeout)
+    return 1;
+  if (bit)
+    i2c_sda_release(i2c);
+  else
+    i2c_sda_low(i2c);
+  i2c_wait(i2c, i2c->t_low);
+  i2c_scl_release(i2c);
+  if (i2c->timeout)
+    return 1;
+  i2c_wait(i2c, i2c->t_high);
+  uint32_t value = gpio_read(i2c->gpio, i2c->sda);
+  i2c_scl_low(i2c);
+  return value;
+}
+
+/**
+ * @brief Send a byte, most significant bit first, and return true if the slave acknowledged it.
+ *
+ * @param i2c Pointer to the I2cMaster
+ * @param data The byte to send
+ * @return true
+ * @return false
+ */
+static inline bool i2c_write_byte(I2cMaster *i2c, uint8_t data)
+{
+  for (uint32_t i = 0; i < 8; i++)
+  {
+    i2c_bit(i2c, data >> 7);
+    data <<= 1;
+  }
+  return i2c_bit(i2c, 1) == 0;
+}
+
+/**
+ * @brief Receive a byte, most significant bit first, and acknowledge it if `ack` is true. The last
+ * byte of a read must not be acknowledged.
+ *
+ * @param i2c Pointer to the I2cMaster
+ * @param ack Whether the byte is acknowledged
+ * @return uint8_t
+ */
+static inline uint8_t i2c_read_byte(I2cMaster *i2c, bool ack)
+{
+  uint8_t data = 0;
+  for (uint32_t i = 0; i < 8; i++)
+    data = (data << 1) | i2c_bit(i2c, 1);
+  i2c_bit(i2c, ack ? 0 : 1);
+  return data;
+}
+
+/**
+ * @brief Return the status of a transaction in which a byte was not acknowledged: I2C_TIMEOUT if
+ * it was aborted by a stretch timeout, I2C_NACK otherwise.
+ *
+ * @param i2c Pointer to the I2cMaster
+ * @return enum I2cStatus
+ */
+static inline enum I2cStatus i2c_nack_status(I2cMaster *i2c)
+{
+  return i2c->timeout ? I2C_TIMEOUT : I2C_NACK;
+}
+
+/**
+ * @brief Send the bytes of a write after a START (or repeated START) and the slave address.
+ * Return I2C_NACK as soon as a byte is not acknowledged, or I2C_TIMEOUT if the transaction was
+ * aborted.
+ *
+ * @param i2c Pointer to the I2cMaster
+ * @param address The 7-bit slave address
+ * @param data Pointer to the bytes to send
+ * @param length Number of bytes to send
+ * @return enum I2cStatus
+ */
+static inline enum I2cStatus i2c_write_bytes(I2cMaster *i2c, uint8_t address, const uint8_t *data,
+                                             size_t length)
+{
+  if (!i2c_write_byte(i2c, address << 1))
+    return i2c_nack_status(i2c);
+  for (size_t i = 0; i < length; i++)
+    if (!i2c_write_byte(i2c, data[i]))
+      return i2c_nack_status(i2c);
+  return I2C_OK;
+}
+
+/**
+ * @brief Receive the bytes of a read after a START (or repeated START) and the slave address.
+ *
+ * With `length` 0 the slave is addressed for a write instead: after acknowledging a read address,
+ * a slave drives the first data bit on SDA, which would prevent the STOP condition. This still
+ * tells whether the slave is present.
+ *
+ * @param i2c Pointer to the I2cMaster
+ * @param address The 7-bit slave address
+ * @param data Where the bytes received are stored
+ * @param length Number of bytes to receive
+ * @return enum I2cStatus
+ */
+static inline enum I2cStatus i2c_read_bytes(I2cMaster *i2c, uint8_t address, uint8_t *data,
+                                            size_t length)
+{
+  if (length == 0)
+    return i2c_write_bytes(i2c, address, NULL, 0);
+  if (!i2c_write_byte(i2c, (address << 1) | 1))
+    return i2c_nack_status(i2c);
+  for (size_t i = 0; i < length; i++)
+    data[i] = i2c_read_byte(i2c, i + 1 < length);
+  return i2c->timeout ? I2C_TIMEOUT : I2C_OK;
+}
+
+/**
+ * @brief End a transaction with a STOP condition and return its final status. An aborted
+ * transaction cannot be ended with a STOP, since the slave holds SCL low: both lines are released
+ * and I2C_TIMEOUT is returned.
+ *
+ * @param i2c Pointer to the I2cMaster
+ * @param status The status of the transaction so far
+ * @return enum I2cStatus
+ */
+static inline enum I2cStatus i2c_finish(I2cMaster *i2c, enum I2cStatus status)
+{
+  if (i2c->timeout)
+  {
+    i2c_sda_release(i2c);
+    return I2C_TIMEOUT;
+  }
+  i2c_stop(i2c);
+  return i2c->timeout ? I2C_TIMEOUT : status;
+}
+
+/**
+ * @brief Write `length` bytes to a slave in a single transaction.
+ *
+ * @param i2c Pointer to the I2cMaster
+ * @param address The 7-bit slave address
+ * @param data Pointer to the bytes to send
+ * @param length Number of bytes to send
+ * @return enum I2cStatus
+ */
+static inline enum I2cStatus i2c_write(I2cMaster *i2c, uint8_t address, const uint8_t *data,
+                                       size_t length)
+{
+  i2c_start(i2c);
+  return i2c_finish(i2c, i2c_write_bytes(i2c, address, data, length));
+}
+
+/**
+ * @brief Read `length` bytes from a slave in a single transaction.
+ *
+ * @param i2c Pointer to the I2cMaster
+ * @param address The 7-bit slave address
+ * @param data Where the bytes received are stored
+ * @param length Number of bytes to receive
+ * @return enum I2cStatus
+ */
+static inline enum I2cStatus i2c_read(I2cMaster *i2c, uint8_t address, uint8_t *data,
+                                      size_t length)
+{
+  i2c_start(i2c);
+  return i2c_finish(i2c, i2c_read_bytes(i2c, address, data, length));
+}
+
+/**
+ * @brief Read `length` consecutive registers of a slave starting at register `reg`, in a single
+ * transaction: the register address is written, then a repeated START begins a burst read.
+ *
+ * @param i2c Pointer to the I2cMaster
+ * @param address The 7-bit slave address
+ * @param reg Address of the first register
+ * @param data Where the register values are stored
+ * @param length Number of registers to read
+ * @return enum I2cStatus
+ */
+static inline enum I2cStatus i2c_read_registers(I2cMaster *i2c, uint8_t address, uint8_t reg,
+                                                uint8_t *data, size_t length)
+{
+  i2c_start(i2c);
+  enum I2cStatus status = i2c_write_bytes(i2c, address, &reg, 1);
+  if (status == I2C_OK)
+  {
+    i2c_repeated_start(i2c);
+    status = i2c_read_bytes(i2c, address, data, length);
+  }
+  return i2c_finish(i2c, status);
+}
+
+/**
+ * @brief Write `length` consecutive registers of a slave starting at register `reg`, in a single
+ * transaction.
+ *
+ * @param i2c Pointer to the I2cMaster
+ * @param address The 7-bit slave address
+ * @param reg Address of the first register
+ * @param data Pointer to the register values
+ * @param length Number of registers to write
+ * @return enum I2cStatus
+ */
+static inline enum I2cStatus i2c_write_registers(I2cMaster *i2c, uint8_t address, uint8_t reg,
+                                                 const uint8_t *data, size_t length)
+{
+  i2c_start(i2c);
+  enum I2cStatus status = i2c_write_bytes(i2c, address, &reg, 1);
+  for (size_t i = 0; status == I2C_OK && i < length; i++)
+    if (!i2c_write_byte(i2c, data[i]))
+      status = i2c_nack_status(i2c);
+  return i2c_finish(i2c, status);
+}
+
+#endif // __LIBSTEEL_I2C__
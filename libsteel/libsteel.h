@@ -8,10 +8,26 @@
 #ifndef __RVSTEEL_LIBSTEEL__
 #define __RVSTEEL_LIBSTEEL__
 
+#include "cobs.h"
+#include "crc.h"
 #include "csr.h"
+#include "delay.h"
+#include "format.h"
 #include "gpio.h"
+#include "gpio_debounce.h"
+#include "gpio_edge.h"
+#include "i2c.h"
+#include "log.h"
 #include "mtimer.h"
+#include "rtos.h"
+#include "scheduler.h"
+#include "sdcard.h"
+#include "sleep.h"
 #include "spi.h"
+#include "spi_async.h"
+#include "spi_flash.h"
+#include "timebase.h"
+#include "timer_wheel.h"
 #include "uart.h"
 
 #endif // __RVSTEEL_LIBSTEEL__
@@ -0,0 +1,363 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_LOG__
+#define __LIBSTEEL_LOG__
+
+#include "cobs.h"
+#include "globals.h"
+#include "uart.h"
+
+/* Tokenized (deferred) logging. Instead of formatting text on the device, `LOG_TOKEN` places the
+ * format string in section `.steel_log` and sends only a token identifying the string followed by
+ * the raw values of its arguments. The host tool `tools/steel_log_decode.py` reads the format
+ * strings back from the ELF file and rebuilds the text.
+ *
+ * The token is the address of the format string. Add the following to the SECTIONS command of the
+ * linker script so that `.steel_log` is not loaded to memory and its addresses start at 0, which
+ * keeps tokens small:
+ *
+ * ```
+ * .steel_log 0 (INFO) : { KEEP(*(.steel_log)) }
+ * ```
+ *
+ * Each record is sent as one COBS frame (see cobs.h): the token and the arguments, each encoded as
+ * an unsigned LEB128 integer (7 bits per byte, lowest bits first, MSB set on all bytes but the
+ * last), followed by a CRC-16 and a 0x00 delimiter. The decoder therefore resynchronizes at the
+ * next record after a corrupted byte, a lost byte or an unknown token.
+ *
+ * Framing a record takes several hundred cycles: benchmarks/bench_log.c measures 893 cycles for
+ * `LOG_TOKEN_BUFFERED` with two arguments, most of it in the per-byte COBS and CRC-16 steps. In
+ * interrupt handlers use `LOG_TOKEN_DEFERRED`, which only stores the token and the arguments in a
+ * LogQueue (52 cycles for the same record), and call `log_queue_flush` from the main loop to frame
+ * and send the queued records (680 cycles per record).
+ *
+ * Arguments are converted to uint32_t. Arguments of a signed integer type are zigzag-encoded
+ * first (0, -1, 1, -2... become 0, 1, 2, 3...) so that small negative values stay short. The
+ * decoder undoes it for %d and %i, so those conversions need a signed argument and all others an
+ * unsigned one or a `char` (a character constant such as 'a' is an `int`: cast it for %c).
+ * Pointers passed for `%s` must be cast; `%s` is only decoded for strings stored in the ELF file.
+ * At most LOG_MAX_ARGS arguments can be given.
+ *
+ * Example usage:
+ * ```
+ * LOG_TOKEN(uart, "adc[%u] = %d\n", channel, value);
+ * ```
+ */
+
+// Maximum number of bytes needed to encode a uint32_t as an unsigned LEB128 integer
+#define LOG_LEB128_MAX_SIZE 5U
+
+// Maximum number of arguments of `LOG_TOKEN`, `LOG_TOKEN_BUFFERED` and `LOG_TOKEN_DEFERRED`
+#define LOG_MAX_ARGS 16U
+
+/**
+ * @brief Encode `value` as an unsigned LEB128 integer into `buf` and return the number of bytes
+ * written (1 to 5).
+ *
+ * @param buf Destination of the encoded value
+ * @param value The value to encode
+ * @return uint32_t
+ */
+static inline uint32_t log_leb128_encode(uint8_t *buf, uint32_t value)
+{
+  uint32_t n = 0;
+  while (value > 0x7f)
+  {
+    buf[n++] = (value & 0x7f) | 0x80;
+    value >>= 7;
+  }
+  buf[n++] = value;
+  return n;
+}
+
+/**
+ * @brief Zigzag-encode a signed argument, mapping values of small magnitude to small unsigned
+ * values.
+ *
+ * @param value The argument
+ * @return uint32_t
+ */
+static inline uint32_t log_zigzag(int32_t value)
+{
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+// Convert an unsigned argument. Counterpart of `log_zigzag` used by `LOG_ARG`.
+static inline uint32_t log_unsigned(uint32_t value)
+{
+  return value;
+}
+
+/**
+ * @brief Encode the payload of a log record (token and arguments) into `buf` and return its
+ * length in bytes. `buf` must have room for `(count + 1) * LOG_LEB128_MAX_SIZE` bytes.
+ *
+ * @param buf Destination of the encoded payload
+ * @param token The token of the format string
+ * @param args The arguments of the format string, zigzag-encoded where signed
+ * @param count Number of arguments
+ * @return uint32_t
+ */
+static inline uint32_t log_token_encode(uint8_t *buf, uint32_t token, const uint32_t *args,
+                                        uint32_t count)
+{
+  uint32_t n = log_leb128_encode(buf, token);
+  for (uint32_t i = 0; i < count; i++)
+    n += log_leb128_encode(buf + n, args[i]);
+  return n;
+}
+
+/**
+ * @brief Append the token and the arguments of a log record to a COBS frame.
+ *
+ * @param enc Pointer to the CobsEncoder of the frame
+ * @param token The token of the format string
+ * @param args The arguments of the format string, zigzag-encoded where signed
+ * @param count Number of arguments
+ */
+static inline void log_token_frame(CobsEncoder *enc, uint32_t token, const uint32_t *args,
+                                   uint32_t count)
+{
+  uint8_t buf[LOG_LEB128_MAX_SIZE];
+  cobs_encoder_write(enc, buf, log_leb128_encode(buf, token));
+  for (uint32_t i = 0; i < count; i++)
+    cobs_encoder_write(enc, buf, log_leb128_encode(buf, args[i]));
+  cobs_encoder_end(enc);
+}
+
+/**
+ * @brief Send a log record over the UART device. Normally called through `LOG_TOKEN`.
+ *
+ * @param uart Pointer to the UartController
+ * @param token The token of the format string
+ * @param args The arguments of the format string, zigzag-encoded where signed
+ * @param count Number of arguments
+ */
+static inline void log_token_write(UartController *uart, uint32_t token, const uint32_t *args,
+                                   uint32_t count)
+{
+  CobsEncoder enc;
+  cobs_encoder_begin(&enc, uart);
+  log_token_frame(&enc, token, args, count);
+}
+
+/**
+ * @brief Write a log record to a UART TX buffer. Normally called through `LOG_TOKEN_BUFFERED`.
+ * A record that does not fit in the buffer is dropped by the decoder as a whole.
+ *
+ * @param txb Pointer to the UartTxBuffer
+ * @param token The token of the format string
+ * @param args The arguments of the format string, zigzag-encoded where signed
+ * @param count Number of arguments
+ */
+static inline void log_token_write_buffered(UartTxBuffer *txb, uint32_t token,
+                                            const uint32_t *args, uint32_t count)
+{
+  CobsEncoder enc;
+  cobs_encoder_begin_buffered(&enc, txb);
+  log_token_frame(&enc, token, args, count);
+}
+
+// Struct holding log records waiting to be framed, filled by `LOG_TOKEN_DEFERRED`
+typedef struct
+{
+  // Storage area provided by the user. Its size (in words) must be a power of two.
+  uint32_t *data;
+  // Size of the storage area minus one, used to wrap the indexes around
+  uint32_t mask;
+  // Free-running write index in words, only changed with interrupts disabled
+  volatile uint32_t head;
+  // Free-running read index in words, only changed by `log_queue_flush`
+  volatile uint32_t tail;
+  // Number of records discarded because the queue was full
+  volatile uint32_t dropped;
+} LogQueue;
+
+/**
+ * @brief Initialize a queue of deferred log records. Each record takes `2 + n` words for `n`
+ * arguments. Return false, leaving the queue untouched, if `size` is not a power of two.
+ *
+ * Example usage:
+ * ```
+ * static uint32_t log_storage[64];
+ * static LogQueue logq;
+ *
+ * __IRQ_M(mtimer_irq_handler)
+ * {
+ *   LOG_TOKEN_DEFERRED(&logq, "tick %u\n", ticks);
+ * }
+ *
+ * log_queue_init(&logq, log_storage, NUMBER_OF(log_storage));
+ * while (1)
+ *   log_queue_flush(&logq, uart);
+ * ```
+ *
+ * @param queue Pointer to the LogQueue
+ * @param storage Storage area for the records
+ * @param size Size of the storage area in words. Must be a power of two.
+ * @return true
+ * @return false
+ */
+static inline bool log_queue_init(LogQueue *queue, uint32_t *storage, const uint32_t size)
+{
+  if (size == 0 || (size & (size - 1)) != 0)
+    return false;
+  queue->data = storage;
+  queue->mask = size - 1;
+  queue->head = 0;
+  queue->tail = 0;
+  queue->dropped = 0;
+  return true;
+}
+
+/**
+ * @brief Store a log record in the queue without encoding it, and return false if the queue is
+ * full (the record is then counted in `dropped`). Safe to call from interrupt handlers and threads
+ * alike. Normally called through `LOG_TOKEN_DEFERRED`.
+ *
+ * @param queue Pointer to the LogQueue
+ * @param token The token of the format string
+ * @param args The arguments of the format string, zigzag-encoded where signed
+ * @param count Number of arguments
+ * @return true
+ * @return false
+ */
+static inline bool log_token_defer(LogQueue *queue, uint32_t token, const uint32_t *args,
+                                   uint32_t count)
+{
+  uint32_t mstatus = csr_global_disable_irq_save();
+  uint32_t head = queue->head;
+  if (count > LOG_MAX_ARGS || queue->mask + 1 - (head - queue->tail) < count + 2)
+  {
+    queue->dropped = queue->dropped + 1;
+    csr_global_restore_irq(mstatus);
+    return false;
+  }
+  queue->data[head++ & queue->mask] = count;
+  queue->data[head++ & queue->mask] = token;
+  for (uint32_t i = 0; i < count; i++)
+    queue->data[head++ & queue->mask] = args[i];
+  queue->head = head;
+  csr_global_restore_irq(mstatus);
+  return true;
+}
+
+/**
+ * @brief Frame the records held in the queue and send them over the UART device, in the format
+ * of `LOG_TOKEN`. Called outside of interrupt handlers, e.g. from the main loop.
+ *
+ * @param queue Pointer to the LogQueue
+ * @param uart Pointer to the UartController
+ */
+static inline void log_queue_flush(LogQueue *queue, UartController *uart)
+{
+  uint32_t args[LOG_MAX_ARGS];
+  uint32_t tail = queue->tail;
+  while (tail != queue->head)
+  {
+    uint32_t count = queue->data[tail++ & queue->mask];
+    uint32_t token = queue->data[tail++ & queue->mask];
+    for (uint32_t i = 0; i < count; i++)
+      args[i] = queue->data[tail++ & queue->mask];
+    queue->tail = tail;
+    log_token_write(uart, token, args, count);
+  }
+}
+
+// Convert one argument of `LOG_TOKEN` to uint32_t, zigzag-encoding it if it has a signed type
+#define LOG_ARG(x)                                                                                 \
+  _Generic((x),                                                                                    \
+      signed char: log_zigzag,                                                                     \
+      short: log_zigzag,                                                                           \
+      int: log_zigzag,                                                                             \
+      long: log_zigzag,                                                                            \
+      long long: log_zigzag,                                                                       \
+      default: log_unsigned)(x)
+
+// Apply `LOG_ARG` to each of up to LOG_MAX_ARGS + 1 arguments
+#define LOG_ARGS(...)                                                                              \
+  LOG_ARGS_N(__VA_ARGS__, LOG_ARGS_17, LOG_ARGS_16, LOG_ARGS_15, LOG_ARGS_14, LOG_ARGS_13,         \
+             LOG_ARGS_12, LOG_ARGS_11, LOG_ARGS_10, LOG_ARGS_9, LOG_ARGS_8, LOG_ARGS_7,            \
+             LOG_ARGS_6, LOG_ARGS_5, LOG_ARGS_4, LOG_ARGS_3, LOG_ARGS_2, LOG_ARGS_1)               \
+  (__VA_ARGS__)
+#define LOG_ARGS_N(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17,     \
+                   macro, ...)                                                                     \
+  macro
+#define LOG_ARGS_1(x) LOG_ARG(x)
+#define LOG_ARGS_2(x, ...) LOG_ARG(x), LOG_ARGS_1(__VA_ARGS__)
+#define LOG_ARGS_3(x, ...) LOG_ARG(x), LOG_ARGS_2(__VA_ARGS__)
+#define LOG_ARGS_4(x, ...) LOG_ARG(x), LOG_ARGS_3(__VA_ARGS__)
+#define LOG_ARGS_5(x, ...) LOG_ARG(x), LOG_ARGS_4(__VA_ARGS__)
+#define LOG_ARGS_6(x, ...) LOG_ARG(x), LOG_ARGS_5(__VA_ARGS__)
+#define LOG_ARGS_7(x, ...) LOG_ARG(x), LOG_ARGS_6(__VA_ARGS__)
+#define LOG_ARGS_8(x, ...) LOG_ARG(x), LOG_ARGS_7(__VA_ARGS__)
+#define LOG_ARGS_9(x, ...) LOG_ARG(x), LOG_ARGS_8(__VA_ARGS__)
+#define LOG_ARGS_10(x, ...) LOG_ARG(x), LOG_ARGS_9(__VA_ARGS__)
+#define LOG_ARGS_11(x, ...) LOG_ARG(x), LOG_ARGS_10(__VA_ARGS__)
+#define LOG_ARGS_12(x, ...) LOG_ARG(x), LOG_ARGS_11(__VA_ARGS__)
+#define LOG_ARGS_13(x, ...) LOG_ARG(x), LOG_ARGS_12(__VA_ARGS__)
+#define LOG_ARGS_14(x, ...) LOG_ARG(x), LOG_ARGS_13(__VA_ARGS__)
+#define LOG_ARGS_15(x, ...) LOG_ARG(x), LOG_ARGS_14(__VA_ARGS__)
+#define LOG_ARGS_16(x, ...) LOG_ARG(x), LOG_ARGS_15(__VA_ARGS__)
+#define LOG_ARGS_17(x, ...) LOG_ARG(x), LOG_ARGS_16(__VA_ARGS__)
+
+// Place format string `fmt` in section `.steel_log` and evaluate to its token
+#define LOG_TOKEN_OF(fmt)                                                                          \
+  __extension__({                                                                                  \
+    __attribute__((section(".steel_log"), used)) static const char __log_fmt[] = fmt;              \
+    (uint32_t)(uintptr_t)__log_fmt;                                                                \
+  })
+
+/**
+ * @brief Send a tokenized log record over the UART device. The format string must be a string
+ * literal and is never stored in the loaded image.
+ *
+ * @param uart Pointer to the UartController
+ * @param fmt The format string (a string literal)
+ * @param ... Up to LOG_MAX_ARGS integer arguments
+ */
+#define LOG_TOKEN(uart, fmt, ...)                                                                  \
+  do                                                                                               \
+  {                                                                                                \
+    const uint32_t __log_args[] = {LOG_ARGS(0, ##__VA_ARGS__)};                                    \
+    log_token_write((uart), LOG_TOKEN_OF(fmt), __log_args + 1, NUMBER_OF(__log_args) - 1);         \
+  } while (0)
+
+/**
+ * @brief Write a tokenized log record to a UART TX buffer. The format string must be a string
+ * literal and is never stored in the loaded image.
+ *
+ * @param txb Pointer to the UartTxBuffer
+ * @param fmt The format string (a string literal)
+ * @param ... Up to LOG_MAX_ARGS integer arguments
+ */
+#define LOG_TOKEN_BUFFERED(txb, fmt, ...)                                                          \
+  do                                                                                               \
+  {                                                                                                \
+    const uint32_t __log_args[] = {LOG_ARGS(0, ##__VA_ARGS__)};                                    \
+    log_token_write_buffered((txb), LOG_TOKEN_OF(fmt), __log_args + 1,                             \
+                             NUMBER_OF(__log_args) - 1);                                           \
+  } while (0)
+
+/**
+ * @brief Queue a tokenized log record without encoding it, for use in interrupt handlers. The
+ * record is framed and sent later by `log_queue_flush`. The format string must be a string
+ * literal and is never stored in the loaded image.
+ *
+ * @param queue Pointer to the LogQueue
+ * @param fmt The format string (a string literal)
+ * @param ... Up to LOG_MAX_ARGS integer arguments
+ */
+#define LOG_TOKEN_DEFERRED(queue, fmt, ...)                                                        \
+  do                                                                                               \
+  {                                                                                                \
+    const uint32_t __log_args[] = {LOG_ARGS(0, ##__VA_ARGS__)};                                    \
+    log_token_defer((queue), LOG_TOKEN_OF(fmt), __log_args + 1, NUMBER_OF(__log_args) - 1);        \
+  } while (0)
+
+#endif // __LIBSTEEL_LOG__
@@ -69,14 +69,22 @@ static inline void mtimer_set_counter(MTimerController *mtimer, uint64_t new_val
 /**
  * @brief Read the value of the MTIMER register.
  *
+ * The highest word is read before and after the lowest word; if it changed, the lowest word
+ * rolled over in between and the read is repeated. This avoids torn values when the counter
+ * crosses a multiple of 2^32.
+ *
  * @param mtimer Pointer to the MTimerController
  * @return uint64_t
  */
 static inline uint64_t mtimer_get_counter(MTimerController *mtimer)
 {
-  uint32_t cnt_l = mtimer->MTIMEL;
-  uint64_t cnt_h = mtimer->MTIMEH;
-  return (cnt_h << 31) | cnt_l;
+  uint32_t cnt_h, cnt_l;
+  do
+  {
+    cnt_h = mtimer->MTIMEH;
+    cnt_l = mtimer->MTIMEL;
+  } while (cnt_h != mtimer->MTIMEH);
+  return ((uint64_t)cnt_h << 32) | cnt_l;
 }
 
 /**
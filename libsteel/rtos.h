@@ -0,0 +1,767 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_RTOS__
+#define __LIBSTEEL_RTOS__
+
+#include <stddef.h>
+
+#include "csr.h"
+#include "globals.h"
+#include "mtimer.h"
+#include "rtos_port.h"
+#include "sleep.h"
+#include "timebase.h"
+
+/* Minimal preemptive kernel for RV32I.
+ *
+ * Threads run from static stacks given by the application and have a priority from 0 (highest) to
+ * RTOS_PRIORITIES - 2; the lowest priority is reserved for the idle thread, which is the context
+ * that called rtos_start(). The ready thread with the highest priority always runs, and threads of
+ * equal priority share the core when they yield or block. Ready threads are kept in one list per
+ * priority plus a bitmap, so picking the next thread is a ctz32.
+ *
+ * The kernel installs its own trap entry in MTVEC (direct mode) and keeps a pointer to the Rtos in
+ * MSCRATCH (see rtos_port.h). Threads switch in two ways:
+ * - A thread that blocks, yields, or wakes up a higher priority thread picks the next thread itself
+ *   and switches with `ecall`. The caller-saved registers are clobbered by the call, so the trap
+ *   only saves s0-s11 and mepc and does not call into C. `ecall` is reserved for the kernel.
+ * - Interrupts save the caller-saved registers, mepc and mstatus on the stack of the interrupted
+ *   thread and call the kernel. The callee-saved registers s0-s11 are preserved by the kernel code
+ *   itself, so they are only saved and restored when the trap actually switches threads. The
+ *   Machine Timer Interrupt wakes up sleeping threads; the kernel owns MTIMECMP and programs it to
+ *   the earliest wake-up time only, there is no periodic tick. Other interrupts are passed to the
+ *   handler set with rtos_set_trap_handler(), which may wake up a thread (e.g. by posting a
+ *   semaphore).
+ * gp and tp are shared by all threads and never saved.
+ *
+ * Every thread stack must have room for a trap frame (128 bytes) plus the stack used by the kernel
+ * and by the trap handler, on top of the needs of the thread itself.
+ *
+ * Mutexes implement priority inheritance: a thread blocked on a mutex lends its priority to the
+ * owner, transitively through chains of mutexes, until the owner unlocks it. Mutexes are not
+ * recursive. Semaphores can be posted from interrupt handlers.
+ *
+ * The cycles taken by each context switch are measured with CSR_MCYCLE, from the trap entry to the
+ * end of the restore sequence, leaving out only `mret` and up to 4 instructions before it. Measured
+ * with benchmarks/bench_rtos.c on tools/steel_sim.c (clang -O2), a switch through `ecall` takes 60
+ * cycles, or 75 up to the first instruction after `ecall` in the resumed thread. Resuming a thread
+ * preempted by an interrupt restores all its registers and takes 94 cycles. These switches stay
+ * within 100 cycles. A switch on the Machine Timer Interrupt takes 205 cycles: besides saving all
+ * the registers, the kernel must read MTIME, wake up the thread and program MTIMECMP.
+ *
+ * Example usage:
+ * ```
+ * static Timebase tb;
+ * static Rtos rtos;
+ * static RtosThread producer, consumer;
+ * static uint32_t producer_stack[256], consumer_stack[256];
+ * static RtosSemaphore items;
+ *
+ * static void produce(void *arg)
+ * {
+ *   while (true)
+ *   {
+ *     rtos_sleep(us_to_ticks(&tb, 1000));
+ *     rtos_semaphore_post(&items);
+ *   }
+ * }
+ *
+ * static void consume(void *arg)
+ * {
+ *   while (true)
+ *     rtos_semaphore_wait(&items);
+ * }
+ *
+ * void main(void)
+ * {
+ *   timebase_init(&tb, mtimer, 50000000);
+ *   rtos_init(&rtos, &tb);
+ *   rtos_semaphore_init(&items, 0);
+ *   rtos_thread_create(&rtos, &producer, produce, NULL, producer_stack, sizeof(producer_stack), 1);
+ *   rtos_thread_create(&rtos, &consumer, consume, NULL, consumer_stack, sizeof(consumer_stack), 2);
+ *   rtos_start(&rtos);
+ * }
+ * ```
+ */
+
+// Number of thread priorities. The lowest one (RTOS_PRIORITIES - 1) is used by the idle thread.
+#define RTOS_PRIORITIES 32U
+
+// Size of a trap frame in bytes: 16 caller-saved registers, 12 callee-saved registers, mepc,
+// mstatus, the kind of frame and 1 word of padding keeping the stack 16-byte aligned
+#define RTOS_FRAME_SIZE 128U
+
+// Word offsets in a trap frame (see rtos_port.h)
+#define RTOS_FRAME_RA 0U
+#define RTOS_FRAME_A0 4U
+#define RTOS_FRAME_MEPC 28U
+#define RTOS_FRAME_MSTATUS 29U
+#define RTOS_FRAME_KIND 30U
+
+// Enumeration with the states of a thread
+enum RtosThreadState
+{
+  // The thread has not been created or has returned
+  RTOS_THREAD_INACTIVE = 0,
+  // The thread is running or waiting for the core
+  RTOS_THREAD_READY = 1,
+  // The thread sleeps until its wake-up time
+  RTOS_THREAD_SLEEPING = 2,
+  // The thread waits for a mutex
+  RTOS_THREAD_BLOCKED_MUTEX = 3,
+  // The thread waits for a semaphore
+  RTOS_THREAD_BLOCKED_SEMAPHORE = 4
+};
+
+typedef struct RtosThread RtosThread;
+typedef struct RtosMutex RtosMutex;
+
+// Struct holding the state of a thread
+struct RtosThread
+{
+  // Stack pointer saved when the thread was switched out, pointing to its trap frame
+  uint32_t *sp;
+  // Next thread in the ready list, the sleeping list or the wait list of a mutex or semaphore
+  RtosThread *next;
+  // Previous thread in the ready list
+  RtosThread *prev;
+  // List of the mutexes owned by the thread
+  RtosMutex *held;
+  // Mutex the thread waits for, or NULL
+  RtosMutex *waiting_mutex;
+  // Wake-up time of a sleeping thread, in ticks
+  uint64_t wake;
+  // Current priority, raised above `base_priority` while the thread owns a mutex wanted by a
+  // higher priority thread
+  uint8_t priority;
+  // Priority given when the thread was created
+  uint8_t base_priority;
+  // One of the values of enum RtosThreadState
+  uint8_t state;
+};
+
+// Struct holding a mutex
+struct RtosMutex
+{
+  // Thread owning the mutex, or NULL if it is unlocked
+  RtosThread *owner;
+  // Threads waiting for the mutex
+  RtosThread *waiters;
+  // Next mutex owned by the same thread
+  RtosMutex *next_held;
+};
+
+// Struct holding a counting semaphore
+typedef struct
+{
+  // Number of available units
+  uint32_t count;
+  // Threads waiting for a unit
+  RtosThread *waiters;
+} RtosSemaphore;
+
+// Function handling interrupts and exceptions other than the MTimer interrupt and `ecall`
+typedef void (*RtosTrapHandler)(uint32_t mcause);
+
+// Struct holding the state of the kernel
+typedef struct Rtos
+{
+  // Kernel function called by the trap entry for interrupts and exceptions. Offset 0, used by the
+  // trap entry.
+  uint32_t *(*dispatch)(struct Rtos *rtos, uint32_t *frame);
+  // Value of CSR_MCYCLE at the last trap entry. Offset 4, used by the trap entry.
+  uint32_t trap_cycle;
+  // Cycles taken by the last context switch. Offset 8, used by the trap entry.
+  uint32_t switch_cycles;
+  // Largest number of cycles taken by a context switch. Offset 12, used by the trap entry.
+  uint32_t max_switch_cycles;
+  // Number of context switches
+  uint32_t switches;
+  // True once rtos_start() has been called
+  bool started;
+  // True while the kernel handles a trap
+  bool in_trap;
+  // Pointer to the Timebase
+  const Timebase *tb;
+  // Thread currently running
+  RtosThread *current;
+  // Bitmap of the priorities having ready threads
+  uint32_t ready_bitmap;
+  // First ready thread of each priority
+  RtosThread *ready_head[RTOS_PRIORITIES];
+  // Last ready thread of each priority
+  RtosThread *ready_tail[RTOS_PRIORITIES];
+  // Sleeping threads, ordered by wake-up time
+  RtosThread *sleeping;
+  // Function handling other traps, or NULL
+  RtosTrapHandler trap_handler;
+  // The idle thread, running the context that called rtos_start()
+  RtosThread idle;
+} Rtos;
+
+// Offsets used by rtos_trap_entry, where a pointer takes 4 bytes
+__STATIC_ASSERT(offsetof(Rtos, dispatch) == 0, "offset used by rtos_trap_entry");
+__STATIC_ASSERT(offsetof(Rtos, trap_cycle) == sizeof(void *), "offset used by rtos_trap_entry");
+__STATIC_ASSERT(offsetof(Rtos, switch_cycles) == sizeof(void *) + 4,
+                "offset used by rtos_trap_entry");
+__STATIC_ASSERT(offsetof(Rtos, max_switch_cycles) == sizeof(void *) + 8,
+                "offset used by rtos_trap_entry");
+
+/**
+ * @brief Append a thread to the ready list of its priority. Interrupts must be disabled.
+ *
+ * @param rtos Pointer to the Rtos
+ * @param thread Pointer to the RtosThread
+ */
+static inline void rtos_ready_insert(Rtos *rtos, RtosThread *thread)
+{
+  uint32_t priority = thread->priority;
+  thread->state = RTOS_THREAD_READY;
+  thread->next = NULL;
+  thread->prev = rtos->ready_tail[priority];
+  if (thread->prev != NULL)
+    thread->prev->next = thread;
+  else
+    rtos->ready_head[priority] = thread;
+  rtos->ready_tail[priority] = thread;
+  rtos->ready_bitmap |= 0x1U << priority;
+}
+
+/**
+ * @brief Remove a thread from the ready list of its priority. Interrupts must be disabled.
+ *
+ * @param rtos Pointer to the Rtos
+ * @param thread Pointer to the RtosThread
+ */
+static inline void rtos_ready_remove(Rtos *rtos, RtosThread *thread)
+{
+  uint32_t priority = thread->priority;
+  if (thread->prev != NULL)
+    thread->prev->next = thread->next;
+  else
+    rtos->ready_head[priority] = thread->next;
+  if (thread->next != NULL)
+    thread->next->prev = thread->prev;
+  else
+    rtos->ready_tail[priority] = thread->prev;
+  if (rtos->ready_head[priority] == NULL)
+    rtos->ready_bitmap &= ~(0x1U << priority);
+  thread->next = NULL;
+  thread->prev = NULL;
+}
+
+/**
+ * @brief Return the ready thread with the highest priority. The idle thread is always ready.
+ *
+ * @param rtos Pointer to the Rtos
+ * @return RtosThread*
+ */
+static inline RtosThread *rtos_highest_ready(const Rtos *rtos)
+{
+  return rtos->ready_head[ctz32(rtos->ready_bitmap)];
+}
+
+/**
+ * @brief Switch to the ready thread with the highest priority if it is not the current thread.
+ * From a thread this traps with `ecall`; from an interrupt handler the switch happens when the
+ * trap returns. Interrupts must be disabled.
+ *
+ * @param rtos Pointer to the Rtos
+ */
+static inline void rtos_reschedule(Rtos *rtos)
+{
+  if (rtos->in_trap)
+    return;
+  RtosThread *next = rtos_highest_ready(rtos);
+  RtosThread *previous = rtos->current;
+  if (next != previous)
+  {
+    rtos->current = next;
+    rtos->switches++;
+    rtos_switch_context(&previous->sp, next->sp);
+  }
+}
+
+/**
+ * @brief Program MTIMECMP for the first sleeping thread. Interrupts must be disabled.
+ *
+ * @param rtos Pointer to the Rtos
+ */
+static inline void rtos_program_timer(Rtos *rtos)
+{
+  mtimer_set_compare(rtos->tb->mtimer,
+                     rtos->sleeping != NULL ? rtos->sleeping->wake : UINT64_MAX);
+}
+
+/**
+ * @brief Kernel part of the trap handler for interrupts and exceptions other than `ecall`. Handle
+ * the trap, then return the stack pointer of the thread to resume.
+ *
+ * @param rtos Pointer to the Rtos
+ * @param frame Trap frame of the interrupted thread
+ * @return uint32_t*
+ */
+static inline uint32_t *rtos_dispatch(Rtos *rtos, uint32_t *frame)
+{
+  uint32_t mcause;
+  CSR_READ(CSR_MCAUSE, mcause);
+  rtos->in_trap = true;
+  rtos->current->sp = frame;
+  if (mcause == (0x80000000U | MIP_MIE_OFFSET_MTI))
+  {
+    uint64_t now = now_ticks(rtos->tb);
+    while (rtos->sleeping != NULL && rtos->sleeping->wake <= now)
+    {
+      RtosThread *thread = rtos->sleeping;
+      rtos->sleeping = thread->next;
+      rtos_ready_insert(rtos, thread);
+    }
+    rtos_program_timer(rtos);
+  }
+  else if (rtos->trap_handler != NULL)
+  {
+    rtos->trap_handler(mcause);
+  }
+  else
+  {
+    // Unhandled exception or interrupt
+    while (true)
+      ;
+  }
+  RtosThread *next = rtos_highest_ready(rtos);
+  if (next != rtos->current)
+  {
+    rtos->current = next;
+    rtos->switches++;
+  }
+  rtos->in_trap = false;
+  return next->sp;
+}
+
+/**
+ * @brief Initialize the kernel.
+ *
+ * @param rtos Pointer to the Rtos
+ * @param tb Pointer to an initialized Timebase
+ */
+static inline void rtos_init(Rtos *rtos, const Timebase *tb)
+{
+  rtos->dispatch = rtos_dispatch;
+  rtos->trap_cycle = 0;
+  rtos->switch_cycles = 0;
+  rtos->max_switch_cycles = 0;
+  rtos->switches = 0;
+  rtos->started = false;
+  rtos->in_trap = false;
+  rtos->tb = tb;
+  rtos->ready_bitmap = 0;
+  for (uint32_t i = 0; i < RTOS_PRIORITIES; i++)
+  {
+    rtos->ready_head[i] = NULL;
+    rtos->ready_tail[i] = NULL;
+  }
+  rtos->sleeping = NULL;
+  rtos->trap_handler = NULL;
+  RtosThread *idle = &rtos->idle;
+  idle->sp = NULL;
+  idle->held = NULL;
+  idle->waiting_mutex = NULL;
+  idle->wake = 0;
+  idle->priority = RTOS_PRIORITIES - 1;
+  idle->base_priority = RTOS_PRIORITIES - 1;
+  rtos_ready_insert(rtos, idle);
+  rtos->current = idle;
+}
+
+/**
+ * @brief Set the function handling interrupts and exceptions other than the MTimer interrupt and
+ * `ecall`. It runs in the kernel trap with interrupts disabled; it must clear the source of the
+ * interrupt and can post semaphores.
+ *
+ * @param rtos Pointer to the Rtos
+ * @param handler The handler
+ */
+static inline void rtos_set_trap_handler(Rtos *rtos, RtosTrapHandler handler)
+{
+  rtos->trap_handler = handler;
+}
+
+/**
+ * @brief End the current thread. Called when a thread function returns. The thread must not own
+ * any mutex.
+ *
+ */
+static inline __NO_RETURN void rtos_thread_exit()
+{
+  Rtos *rtos = rtos_kernel();
+  csr_global_disable_irq();
+  rtos_ready_remove(rtos, rtos->current);
+  rtos->current->state = RTOS_THREAD_INACTIVE;
+  rtos_reschedule(rtos);
+  while (true)
+    ;
+}
+
+/**
+ * @brief Create a thread, ready to run. Threads can be created before or after rtos_start().
+ * Return false, without creating the thread, if `priority` is above RTOS_PRIORITIES - 2: the
+ * lowest priority belongs to the idle thread, which never yields, and larger values have no ready
+ * list.
+ *
+ * @param rtos Pointer to the Rtos
+ * @param thread Pointer to the RtosThread
+ * @param entry Function run by the thread
+ * @param arg Argument passed to `entry`
+ * @param stack Memory used as the stack of the thread
+ * @param stack_size Size of the stack in bytes
+ * @param priority Priority of the thread, from 0 (highest) to RTOS_PRIORITIES - 2
+ * @return true
+ * @return false
+ */
+static inline bool rtos_thread_create(Rtos *rtos, RtosThread *thread, void (*entry)(void *arg),
+                                      void *arg, void *stack, size_t stack_size, uint8_t priority)
+{
+  if (priority > RTOS_PRIORITIES - 2)
+    return false;
+  uintptr_t top = ((uintptr_t)stack + stack_size) & ~(uintptr_t)0xF;
+  uint32_t *frame = (uint32_t *)(top - RTOS_FRAME_SIZE);
+  for (uint32_t i = 0; i < RTOS_FRAME_SIZE / 4; i++)
+    frame[i] = 0;
+  frame[RTOS_FRAME_RA] = (uint32_t)(uintptr_t)rtos_thread_exit;
+  frame[RTOS_FRAME_A0] = (uint32_t)(uintptr_t)arg;
+  frame[RTOS_FRAME_MEPC] = (uint32_t)(uintptr_t)entry;
+  // Resume in M-mode (MPP = 3) with interrupts enabled (MPIE = 1)
+  frame[RTOS_FRAME_MSTATUS] = (0x3U << 11) | MSTATUS_MPIE_MASK;
+  thread->sp = frame;
+  thread->held = NULL;
+  thread->waiting_mutex = NULL;
+  thread->wake = 0;
+  thread->priority = priority;
+  thread->base_priority = priority;
+  uint32_t mstatus = csr_global_disable_irq_save();
+  rtos_ready_insert(rtos, thread);
+  if (rtos->started)
+    rtos_reschedule(rtos);
+  csr_global_restore_irq(mstatus);
+  return true;
+}
+
+/**
+ * @brief Start the kernel. The calling context becomes the idle thread, which sleeps in `wfi`
+ * whenever no other thread is ready. Does not return.
+ *
+ * @param rtos Pointer to the Rtos
+ */
+static inline __NO_RETURN void rtos_start(Rtos *rtos)
+{
+  csr_global_disable_irq();
+  rtos_install(rtos);
+  rtos->started = true;
+  rtos_program_timer(rtos);
+  CSR_SET(CSR_MIE, MIP_MIE_MASK_MTI);
+  // Switch to the highest priority thread. The idle thread resumes here with interrupts disabled.
+  rtos_reschedule(rtos);
+  csr_global_enable_irq();
+  while (true)
+    wait_for_interrupt();
+}
+
+/**
+ * @brief Return the thread currently running.
+ *
+ * @return RtosThread*
+ */
+static inline RtosThread *rtos_current()
+{
+  return rtos_kernel()->current;
+}
+
+/**
+ * @brief Let the other ready threads of the same priority run.
+ *
+ */
+static inline void rtos_yield()
+{
+  Rtos *rtos = rtos_kernel();
+  uint32_t mstatus = csr_global_disable_irq_save();
+  rtos_ready_remove(rtos, rtos->current);
+  rtos_ready_insert(rtos, rtos->current);
+  rtos_reschedule(rtos);
+  csr_global_restore_irq(mstatus);
+}
+
+/**
+ * @brief Suspend the current thread until the deadline has passed.
+ *
+ * @param d The deadline
+ */
+static inline void rtos_sleep_until(Deadline d)
+{
+  Rtos *rtos = rtos_kernel();
+  uint32_t mstatus = csr_global_disable_irq_save();
+  RtosThread *thread = rtos->current;
+  if (d.ticks > now_ticks(rtos->tb))
+  {
+    rtos_ready_remove(rtos, thread);
+    thread->state = RTOS_THREAD_SLEEPING;
+    thread->wake = d.ticks;
+    RtosThread **link = &rtos->sleeping;
+    while (*link != NULL && (*link)->wake <= d.ticks)
+      link = &(*link)->next;
+    thread->next = *link;
+    *link = thread;
+    if (rtos->sleeping == thread)
+      rtos_program_timer(rtos);
+    rtos_reschedule(rtos);
+  }
+  csr_global_restore_irq(mstatus);
+}
+
+/**
+ * @brief Suspend the current thread for `ticks` ticks.
+ *
+ * @param ticks Number of ticks
+ */
+static inline void rtos_sleep(uint64_t ticks)
+{
+  rtos_sleep_until(deadline_after_ticks(rtos_kernel()->tb, ticks));
+}
+
+/**
+ * @brief Remove the waiting thread with the highest priority from a wait list and return it.
+ *
+ * @param waiters Pointer to the wait list, which must not be empty
+ * @return RtosThread*
+ */
+static inline RtosThread *rtos_take_waiter(RtosThread **waiters)
+{
+  RtosThread **best = waiters;
+  for (RtosThread **link = &(*waiters)->next; *link != NULL; link = &(*link)->next)
+    if ((*link)->priority < (*best)->priority)
+      best = link;
+  RtosThread *thread = *best;
+  *best = thread->next;
+  thread->next = NULL;
+  return thread;
+}
+
+/**
+ * @brief Change the priority of a thread, moving it to the right ready list if it is ready.
+ * Interrupts must be disabled.
+ *
+ * @param rtos Pointer to the Rtos
+ * @param thread Pointer to the RtosThread
+ * @param priority The new priority
+ */
+static inline void rtos_set_priority(Rtos *rtos, RtosThread *thread, uint8_t priority)
+{
+  if (thread->priority == priority)
+    return;
+  if (thread->state == RTOS_THREAD_READY)
+  {
+    rtos_ready_remove(rtos, thread);
+    thread->priority = priority;
+    rtos_ready_insert(rtos, thread);
+  }
+  else
+    thread->priority = priority;
+}
+
+/**
+ * @brief Return the priority a thread must run at: its base priority, raised to the priority of
+ * the most important thread waiting for a mutex it owns.
+ *
+ * @param thread Pointer to the RtosThread
+ * @return uint8_t
+ */
+static inline uint8_t rtos_inherited_priority(const RtosThread *thread)
+{
+  uint8_t priority = thread->base_priority;
+  for (const RtosMutex *m = thread->held; m != NULL; m = m->next_held)
+    for (const RtosThread *w = m->waiters; w != NULL; w = w->next)
+      if (w->priority < priority)
+        priority = w->priority;
+  return priority;
+}
+
+/**
+ * @brief Initialize an unlocked mutex.
+ *
+ * @param mutex Pointer to the RtosMutex
+ */
+static inline void rtos_mutex_init(RtosMutex *mutex)
+{
+  mutex->owner = NULL;
+  mutex->waiters = NULL;
+  mutex->next_held = NULL;
+}
+
+/**
+ * @brief Lock a mutex, waiting for it if needed. While waiting, the priority of the current
+ * thread is lent to the owner of the mutex and, if that owner waits for another mutex, to its
+ * owner as well.
+ *
+ * @param mutex Pointer to the RtosMutex
+ */
+static inline void rtos_mutex_lock(RtosMutex *mutex)
+{
+  Rtos *rtos = rtos_kernel();
+  uint32_t mstatus = csr_global_disable_irq_save();
+  RtosThread *thread = rtos->current;
+  if (mutex->owner == NULL)
+  {
+    mutex->owner = thread;
+    mutex->next_held = thread->held;
+    thread->held = mutex;
+  }
+  else
+  {
+    rtos_ready_remove(rtos, thread);
+    thread->state = RTOS_THREAD_BLOCKED_MUTEX;
+    thread->waiting_mutex = mutex;
+    thread->next = mutex->waiters;
+    mutex->waiters = thread;
+    for (RtosThread *owner = mutex->owner; owner != NULL && owner->priority > thread->priority;)
+    {
+      rtos_set_priority(rtos, owner, thread->priority);
+      owner = owner->waiting_mutex != NULL ? owner->waiting_mutex->owner : NULL;
+    }
+    // The mutex is handed over by rtos_mutex_unlock before this thread runs again
+    rtos_reschedule(rtos);
+  }
+  csr_global_restore_irq(mstatus);
+}
+
+/**
+ * @brief Try to lock a mutex without waiting. Return true if it was locked.
+ *
+ * @param mutex Pointer to the RtosMutex
+ * @return true
+ * @return false
+ */
+static inline bool rtos_mutex_try_lock(RtosMutex *mutex)
+{
+  Rtos *rtos = rtos_kernel();
+  uint32_t mstatus = csr_global_disable_irq_save();
+  bool locked = mutex->owner == NULL;
+  if (locked)
+  {
+    mutex->owner = rtos->current;
+    mutex->next_held = rtos->current->held;
+    rtos->current->held = mutex;
+  }
+  csr_global_restore_irq(mstatus);
+  return locked;
+}
+
+/**
+ * @brief Unlock a mutex owned by the current thread. The mutex is handed over to the waiting
+ * thread with the highest priority, and the current thread drops any priority it inherited
+ * through it.
+ *
+ * @param mutex Pointer to the RtosMutex
+ */
+static inline void rtos_mutex_unlock(RtosMutex *mutex)
+{
+  Rtos *rtos = rtos_kernel();
+  uint32_t mstatus = csr_global_disable_irq_save();
+  RtosThread *thread = rtos->current;
+  RtosMutex **link = &thread->held;
+  while (*link != mutex)
+    link = &(*link)->next_held;
+  *link = mutex->next_held;
+  mutex->next_held = NULL;
+  if (mutex->waiters != NULL)
+  {
+    RtosThread *next = rtos_take_waiter(&mutex->waiters);
+    next->waiting_mutex = NULL;
+    mutex->owner = next;
+    mutex->next_held = next->held;
+    next->held = mutex;
+    next->priority = rtos_inherited_priority(next);
+    rtos_ready_insert(rtos, next);
+  }
+  else
+    mutex->owner = NULL;
+  rtos_set_priority(rtos, thread, rtos_inherited_priority(thread));
+  rtos_reschedule(rtos);
+  csr_global_restore_irq(mstatus);
+}
+
+/**
+ * @brief Initialize a semaphore.
+ *
+ * @param sem Pointer to the RtosSemaphore
+ * @param count Initial number of units
+ */
+static inline void rtos_semaphore_init(RtosSemaphore *sem, uint32_t count)
+{
+  sem->count = count;
+  sem->waiters = NULL;
+}
+
+/**
+ * @brief Take a unit from a semaphore, waiting for one if needed.
+ *
+ * @param sem Pointer to the RtosSemaphore
+ */
+static inline void rtos_semaphore_wait(RtosSemaphore *sem)
+{
+  Rtos *rtos = rtos_kernel();
+  uint32_t mstatus = csr_global_disable_irq_save();
+  if (sem->count != 0)
+    sem->count--;
+  else
+  {
+    RtosThread *thread = rtos->current;
+    rtos_ready_remove(rtos, thread);
+    thread->state = RTOS_THREAD_BLOCKED_SEMAPHORE;
+    thread->next = sem->waiters;
+    sem->waiters = thread;
+    // The unit is handed over by rtos_semaphore_post before this thread runs again
+    rtos_reschedule(rtos);
+  }
+  csr_global_restore_irq(mstatus);
+}
+
+/**
+ * @brief Take a unit from a semaphore without waiting. Return true if a unit was taken.
+ *
+ * @param sem Pointer to the RtosSemaphore
+ * @return true
+ * @return false
+ */
+static inline bool rtos_semaphore_try_wait(RtosSemaphore *sem)
+{
+  uint32_t mstatus = csr_global_disable_irq_save();
+  bool taken = sem->count != 0;
+  if (taken)
+    sem->count--;
+  csr_global_restore_irq(mstatus);
+  return taken;
+}
+
+/**
+ * @brief Give a unit to a semaphore, waking up the waiting thread with the highest priority if
+ * there is one. Can be called from the trap handler.
+ *
+ * @param sem Pointer to the RtosSemaphore
+ */
+static inline void rtos_semaphore_post(RtosSemaphore *sem)
+{
+  Rtos *rtos = rtos_kernel();
+  uint32_t mstatus = csr_global_disable_irq_save();
+  if (sem->waiters != NULL)
+    rtos_ready_insert(rtos, rtos_take_waiter(&sem->waiters));
+  else
+    sem->count++;
+  rtos_reschedule(rtos);
+  csr_global_restore_irq(mstatus);
+}
+
+#endif // __LIBSTEEL_RTOS__
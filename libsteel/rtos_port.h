@@ -0,0 +1,227 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_RTOS_PORT__
+#define __LIBSTEEL_RTOS_PORT__
+
+#include "csr.h"
+#include "globals.h"
+
+/* RISC-V part of the kernel in rtos.h: the trap entry, the context switch requested by a thread and
+ * the access to the kernel through MSCRATCH. The host unit tests replace this file with
+ * tests/host_rtos_port.h.
+ *
+ * Trap frame layout (words): ra, t0-t2, a0-a7, t3-t6 (0-15), s0-s11 (16-27), mepc (28),
+ * mstatus (29), kind (30) and one word of padding. Two kinds of frames are saved:
+ * - A thread switching out with rtos_switch_context() traps with `ecall`. Its caller-saved
+ *   registers are clobbered by the call, so the frame only holds s0-s11 and mepc, and a non-zero
+ *   kind. Such a thread always switches out with interrupts disabled, so it resumes with MPIE
+ *   cleared and mstatus is not saved.
+ * - Any other trap saves all the registers, and a zero kind if it switches threads. It calls the
+ *   kernel with the Rtos (read from MSCRATCH) and the frame, and resumes the thread whose stack
+ *   pointer the kernel returns.
+ *
+ * The cycles taken by a context switch are measured with CSR_MCYCLE, from the third instruction of
+ * the trap entry to the end of the restore sequence. Only the last instructions are not counted:
+ * `addi` and `mret` when resuming an `ecall` frame, and 3 loads, `addi` and `mret` otherwise.
+ */
+
+struct Rtos;
+
+/**
+ * @brief Trap entry of the kernel, installed in MTVEC by rtos_install(). The Rtos struct holds the
+ * kernel function at offset 0 and the cycle counts at offsets 4 (CSR_MCYCLE at the trap entry),
+ * 8 (cycles of the last switch) and 12 (largest number of cycles of a switch).
+ */
+__NAKED __UNUSED __attribute__((aligned(4))) static void rtos_trap_entry()
+{
+  asm volatile("addi sp, sp, -128\n"
+               "sw t0, 4(sp)\n"
+               "csrr t0, mcycle\n"
+               "sw t1, 8(sp)\n"
+               "csrr t1, mcause\n"
+               "addi t1, t1, -11\n"
+               "bnez t1, 1f\n"
+               // ecall from rtos_switch_context: a0 points to where the stack pointer is saved and
+               // a1 is the stack pointer of the thread to resume
+               "csrr t1, mscratch\n"
+               "sw t0, 4(t1)\n"
+               "csrr t0, mepc\n"
+               "addi t0, t0, 4\n"
+               "sw t0, 112(sp)\n"
+               "sw t1, 120(sp)\n"
+               "sw s0, 64(sp)\n"
+               "sw s1, 68(sp)\n"
+               "sw s2, 72(sp)\n"
+               "sw s3, 76(sp)\n"
+               "sw s4, 80(sp)\n"
+               "sw s5, 84(sp)\n"
+               "sw s6, 88(sp)\n"
+               "sw s7, 92(sp)\n"
+               "sw s8, 96(sp)\n"
+               "sw s9, 100(sp)\n"
+               "sw s10, 104(sp)\n"
+               "sw s11, 108(sp)\n"
+               "sw sp, 0(a0)\n"
+               "mv sp, a1\n"
+               "j 2f\n"
+               // Any other trap: save the caller-saved registers and call the kernel
+               "1:\n"
+               "sw ra, 0(sp)\n"
+               "sw t2, 12(sp)\n"
+               "sw a0, 16(sp)\n"
+               "sw a1, 20(sp)\n"
+               "sw a2, 24(sp)\n"
+               "sw a3, 28(sp)\n"
+               "sw a4, 32(sp)\n"
+               "sw a5, 36(sp)\n"
+               "sw a6, 40(sp)\n"
+               "sw a7, 44(sp)\n"
+               "sw t3, 48(sp)\n"
+               "sw t4, 52(sp)\n"
+               "sw t5, 56(sp)\n"
+               "sw t6, 60(sp)\n"
+               "csrr a0, mscratch\n"
+               "sw t0, 4(a0)\n"
+               "csrr t0, mepc\n"
+               "sw t0, 112(sp)\n"
+               "csrr t0, mstatus\n"
+               "sw t0, 116(sp)\n"
+               "mv a1, sp\n"
+               "lw t0, 0(a0)\n"
+               "jalr t0\n"
+               "beq a0, sp, 4f\n"
+               // Switch threads: save s0-s11 of the old thread, then load those of the new one
+               "sw zero, 120(sp)\n"
+               "sw s0, 64(sp)\n"
+               "sw s1, 68(sp)\n"
+               "sw s2, 72(sp)\n"
+               "sw s3, 76(sp)\n"
+               "sw s4, 80(sp)\n"
+               "sw s5, 84(sp)\n"
+               "sw s6, 88(sp)\n"
+               "sw s7, 92(sp)\n"
+               "sw s8, 96(sp)\n"
+               "sw s9, 100(sp)\n"
+               "sw s10, 104(sp)\n"
+               "sw s11, 108(sp)\n"
+               "mv sp, a0\n"
+               "2:\n"
+               "lw s0, 64(sp)\n"
+               "lw s1, 68(sp)\n"
+               "lw s2, 72(sp)\n"
+               "lw s3, 76(sp)\n"
+               "lw s4, 80(sp)\n"
+               "lw s5, 84(sp)\n"
+               "lw s6, 88(sp)\n"
+               "lw s7, 92(sp)\n"
+               "lw s8, 96(sp)\n"
+               "lw s9, 100(sp)\n"
+               "lw s10, 104(sp)\n"
+               "lw s11, 108(sp)\n"
+               "lw t0, 112(sp)\n"
+               "csrw mepc, t0\n"
+               "lw t0, 120(sp)\n"
+               "beqz t0, 3f\n"
+               // Resume an ecall frame with interrupts disabled
+               "li t0, 0x80\n"
+               "csrc mstatus, t0\n"
+               "csrr t0, mcycle\n"
+               "csrr t1, mscratch\n"
+               "lw t2, 4(t1)\n"
+               "sub t0, t0, t2\n"
+               "sw t0, 8(t1)\n"
+               "lw t2, 12(t1)\n"
+               "bgeu t2, t0, 6f\n"
+               "sw t0, 12(t1)\n"
+               "6:\n"
+               "addi sp, sp, 128\n"
+               "mret\n"
+               // Resume a full frame, measuring the switch
+               "3:\n"
+               "li t2, 1\n"
+               "j 5f\n"
+               // Return from a trap that did not switch threads
+               "4:\n"
+               "li t2, 0\n"
+               "5:\n"
+               "lw t0, 116(sp)\n"
+               "csrw mstatus, t0\n"
+               "lw ra, 0(sp)\n"
+               "lw a0, 16(sp)\n"
+               "lw a1, 20(sp)\n"
+               "lw a2, 24(sp)\n"
+               "lw a3, 28(sp)\n"
+               "lw a4, 32(sp)\n"
+               "lw a5, 36(sp)\n"
+               "lw a6, 40(sp)\n"
+               "lw a7, 44(sp)\n"
+               "lw t3, 48(sp)\n"
+               "lw t4, 52(sp)\n"
+               "lw t5, 56(sp)\n"
+               "lw t6, 60(sp)\n"
+               "beqz t2, 7f\n"
+               "csrr t0, mcycle\n"
+               "csrr t1, mscratch\n"
+               "lw t2, 4(t1)\n"
+               "sub t0, t0, t2\n"
+               "sw t0, 8(t1)\n"
+               "lw t2, 12(t1)\n"
+               "bgeu t2, t0, 7f\n"
+               "sw t0, 12(t1)\n"
+               "7:\n"
+               "lw t0, 4(sp)\n"
+               "lw t1, 8(sp)\n"
+               "lw t2, 12(sp)\n"
+               "addi sp, sp, 128\n"
+               "mret\n");
+}
+
+/**
+ * @brief Return the kernel, whose address is kept in MSCRATCH once rtos_install() is called.
+ *
+ * @return struct Rtos*
+ */
+static inline struct Rtos *rtos_kernel()
+{
+  uint32_t rtos;
+  CSR_READ(CSR_MSCRATCH, rtos);
+  return (struct Rtos *)(uintptr_t)rtos;
+}
+
+/**
+ * @brief Keep the address of the kernel in MSCRATCH and install its trap entry in MTVEC (direct
+ * mode). Interrupts must be disabled.
+ *
+ * @param rtos Pointer to the Rtos
+ */
+static inline void rtos_install(struct Rtos *rtos)
+{
+  CSR_WRITE(CSR_MSCRATCH, (uint32_t)(uintptr_t)rtos);
+  CSR_WRITE(CSR_MTVEC, (uint32_t)(uintptr_t)rtos_trap_entry);
+}
+
+/**
+ * @brief Switch threads with `ecall`: save the context of the calling thread, store its stack
+ * pointer to `*save_sp` and resume the thread whose stack pointer is `load_sp`. Returns when the
+ * calling thread is resumed. Interrupts must be disabled.
+ *
+ * @param save_sp Where to store the stack pointer of the calling thread
+ * @param load_sp Stack pointer of the thread to resume
+ */
+static inline void rtos_switch_context(uint32_t **save_sp, uint32_t *load_sp)
+{
+  asm volatile("mv a0, %0\n"
+               "mv a1, %1\n"
+               "ecall\n"
+               :
+               : "r"(save_sp), "r"(load_sp)
+               : "ra", "t0", "t1", "t2", "t3", "t4", "t5", "t6", "a0", "a1", "a2", "a3", "a4", "a5",
+                 "a6", "a7", "memory");
+}
+
+#endif // __LIBSTEEL_RTOS_PORT__
@@ -0,0 +1,453 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_SCHEDULER__
+#define __LIBSTEEL_SCHEDULER__
+
+#include "csr.h"
+#include "globals.h"
+#include "sleep.h"
+#include "timebase.h"
+
+/* Cooperative run-to-completion scheduler for periodic and one-shot tasks.
+ *
+ * Each task has a phase (delay before its first release), a period (0 for one-shot tasks), a
+ * relative deadline and a priority, from 0 (highest) to 255 as in rtos.h. Tasks waiting for their
+ * release time are kept in a binary min-heap ordered by release time; released tasks move to a
+ * second heap ordered by priority (then release time), from which the next task to run is taken.
+ * Adding, removing and dispatching a task are O(log n).
+ *
+ * Release times come from the MTimer through the Timebase. When no task is ready, the scheduler
+ * sleeps in `wfi` (see sleep.h) until the next release or until an interrupt arrives, since an
+ * interrupt handler may add tasks.
+ *
+ * The execution time of every run is measured with CSR_MCYCLE. A run that finishes after the
+ * deadline of its release is an overrun: it is counted in the task and reported to an optional
+ * callback. Periodic tasks skip the releases missed by an overrun instead of running back to back.
+ * A periodic task that cannot be released again because the scheduler is full is stopped and
+ * counted in `dropped`.
+ *
+ * Example usage:
+ * ```
+ * static Timebase tb;
+ * static Scheduler sched;
+ * static SchedulerTask blink, report;
+ *
+ * void main(void)
+ * {
+ *   timebase_init(&tb, mtimer, 50000000);
+ *   scheduler_init(&sched, &tb, NULL, NULL);
+ *   scheduler_task_init(&blink, blink_led, NULL, 0, 0);
+ *   scheduler_task_init(&report, send_report, NULL, 1, 0);
+ *   scheduler_add(&sched, &blink, 0, us_to_ticks(&tb, 500000));
+ *   scheduler_add(&sched, &report, us_to_ticks(&tb, 250000), us_to_ticks(&tb, 1000000));
+ *   scheduler_run(&sched);
+ * }
+ * ```
+ */
+
+#ifndef SCHEDULER_MAX_TASKS
+// Maximum number of tasks added to a scheduler at the same time, waiting and ready together
+#define SCHEDULER_MAX_TASKS 16U
+#endif
+
+// Enumeration with the states of a scheduler task
+enum SchedulerTaskState
+{
+  // The task is not in the scheduler
+  SCHEDULER_TASK_IDLE = 0,
+  // The task waits for its release time
+  SCHEDULER_TASK_WAITING = 1,
+  // The task has been released and waits to run
+  SCHEDULER_TASK_READY = 2,
+  // The task is running
+  SCHEDULER_TASK_RUNNING = 3
+};
+
+// Function run by a scheduler task
+typedef void (*SchedulerTaskFunction)(void *context);
+
+// Struct holding a scheduler task and its statistics
+typedef struct
+{
+  // Function run at each release
+  SchedulerTaskFunction function;
+  // Argument passed to the function
+  void *context;
+  // Priority of the task. Among released tasks, lower values run first (0 is the highest).
+  uint8_t priority;
+  // One of the values of enum SchedulerTaskState
+  uint8_t state;
+  // Position of the task in the heap holding it
+  uint16_t heap_index;
+  // Time of the current (or next) release, in ticks
+  uint64_t release;
+  // Period in ticks, or 0 for a one-shot task
+  uint64_t period;
+  // Deadline relative to the release time, in ticks. 0 means the period (or no deadline for a
+  // one-shot task).
+  uint64_t deadline;
+  // Number of runs
+  uint32_t runs;
+  // Number of runs that finished after their deadline
+  uint32_t overruns;
+  // Number of releases skipped because of overruns
+  uint32_t skipped;
+  // Execution time of the last run, in cycles
+  uint32_t last_cycles;
+  // Longest execution time, in cycles
+  uint32_t max_cycles;
+  // Sum of the execution times of all runs, in cycles
+  uint64_t total_cycles;
+} SchedulerTask;
+
+// Function called when a task finishes after its deadline, `lateness` ticks late
+typedef void (*SchedulerOverrunCallback)(SchedulerTask *task, uint64_t lateness, void *context);
+
+// Struct holding the state of a scheduler
+typedef struct
+{
+  // Pointer to the Timebase providing release times
+  const Timebase *tb;
+  // Min-heap of the tasks waiting for their release, ordered by release time. The two heaps hold
+  // at most SCHEDULER_MAX_TASKS tasks together.
+  SchedulerTask *waiting[SCHEDULER_MAX_TASKS];
+  // Heap of the released tasks, ordered by priority and then release time
+  SchedulerTask *ready[SCHEDULER_MAX_TASKS];
+  // Number of tasks in the waiting heap
+  uint32_t waiting_count;
+  // Number of tasks in the ready heap
+  uint32_t ready_count;
+  // Function called on overruns, or NULL
+  SchedulerOverrunCallback on_overrun;
+  // Argument passed to `on_overrun`
+  void *context;
+  // Number of periodic tasks stopped because the scheduler was full when they had to be released
+  // again
+  uint32_t dropped;
+} Scheduler;
+
+/**
+ * @brief Initialize a scheduler task. The task runs once it is added to a scheduler.
+ *
+ * @param task Pointer to the SchedulerTask
+ * @param function Function run at each release
+ * @param context Argument passed to the function
+ * @param priority Priority of the task, from 0 (highest) to 255
+ * @param deadline Deadline relative to each release, in ticks, or 0 to use the period
+ */
+static inline void scheduler_task_init(SchedulerTask *task, SchedulerTaskFunction function,
+                                       void *context, uint8_t priority, uint64_t deadline)
+{
+  task->function = function;
+  task->context = context;
+  task->priority = priority;
+  task->state = SCHEDULER_TASK_IDLE;
+  task->heap_index = 0;
+  task->release = 0;
+  task->period = 0;
+  task->deadline = deadline;
+  task->runs = 0;
+  task->overruns = 0;
+  task->skipped = 0;
+  task->last_cycles = 0;
+  task->max_cycles = 0;
+  task->total_cycles = 0;
+}
+
+/**
+ * @brief Initialize a scheduler with no tasks.
+ *
+ * @param sched Pointer to the Scheduler
+ * @param tb Pointer to an initialized Timebase
+ * @param on_overrun Function called when a task overruns its deadline, or NULL
+ * @param context Argument passed to `on_overrun`
+ */
+static inline void scheduler_init(Scheduler *sched, const Timebase *tb,
+                                  SchedulerOverrunCallback on_overrun, void *context)
+{
+  sched->tb = tb;
+  sched->waiting_count = 0;
+  sched->ready_count = 0;
+  sched->on_overrun = on_overrun;
+  sched->context = context;
+  sched->dropped = 0;
+}
+
+/**
+ * @brief Return true if task `a` must be placed above task `b` in a heap.
+ *
+ * @param a Pointer to a SchedulerTask
+ * @param b Pointer to a SchedulerTask
+ * @param by_priority True for the ready heap, false for the waiting heap
+ * @return true
+ * @return false
+ */
+static inline bool scheduler_before(const SchedulerTask *a, const SchedulerTask *b,
+                                    bool by_priority)
+{
+  if (by_priority && a->priority != b->priority)
+    return a->priority < b->priority;
+  return a->release < b->release;
+}
+
+/**
+ * @brief Move the task at position `i` of a heap to its place, up or down.
+ *
+ * @param heap The heap
+ * @param count Number of tasks in the heap
+ * @param i Position of the task
+ * @param by_priority True for the ready heap, false for the waiting heap
+ */
+static inline void scheduler_heap_fix(SchedulerTask **heap, uint32_t count, uint32_t i,
+                                      bool by_priority)
+{
+  SchedulerTask *task = heap[i];
+  while (i > 0)
+  {
+    uint32_t parent = (i - 1) >> 1;
+    if (!scheduler_before(task, heap[parent], by_priority))
+      break;
+    heap[i] = heap[parent];
+    heap[i]->heap_index = i;
+    i = parent;
+  }
+  while (true)
+  {
+    uint32_t child = (i << 1) + 1;
+    if (child >= count)
+      break;
+    if (child + 1 < count && scheduler_before(heap[child + 1], heap[child], by_priority))
+      child++;
+    if (!scheduler_before(heap[child], task, by_priority))
+      break;
+    heap[i] = heap[child];
+    heap[i]->heap_index = i;
+    i = child;
+  }
+  heap[i] = task;
+  task->heap_index = i;
+}
+
+/**
+ * @brief Insert a task in a heap. The heap must not be full.
+ *
+ * @param heap The heap
+ * @param count Pointer to the number of tasks in the heap
+ * @param task Pointer to the SchedulerTask
+ * @param by_priority True for the ready heap, false for the waiting heap
+ */
+static inline void scheduler_heap_push(SchedulerTask **heap, uint32_t *count, SchedulerTask *task,
+                                       bool by_priority)
+{
+  heap[*count] = task;
+  (*count)++;
+  scheduler_heap_fix(heap, *count, *count - 1, by_priority);
+}
+
+/**
+ * @brief Remove the task at position `i` of a heap.
+ *
+ * @param heap The heap
+ * @param count Pointer to the number of tasks in the heap
+ * @param i Position of the task
+ * @param by_priority True for the ready heap, false for the waiting heap
+ */
+static inline void scheduler_heap_remove(SchedulerTask **heap, uint32_t *count, uint32_t i,
+                                         bool by_priority)
+{
+  (*count)--;
+  if (i == *count)
+    return;
+  heap[i] = heap[*count];
+  scheduler_heap_fix(heap, *count, i, by_priority);
+}
+
+/**
+ * @brief Return true if SCHEDULER_MAX_TASKS tasks are waiting or ready. A running task does not
+ * count, so it may not find room to be released again.
+ *
+ * @param sched Pointer to the Scheduler
+ * @return true
+ * @return false
+ */
+static inline bool scheduler_full(const Scheduler *sched)
+{
+  return sched->waiting_count + sched->ready_count >= SCHEDULER_MAX_TASKS;
+}
+
+/**
+ * @brief Add a task to the scheduler, or reschedule it if it is already waiting or ready. Return
+ * false if the scheduler is full. Can be called from interrupt handlers and from running tasks.
+ *
+ * @param sched Pointer to the Scheduler
+ * @param task Pointer to an initialized SchedulerTask
+ * @param phase Delay until the first release, in ticks
+ * @param period Period in ticks, or 0 for a one-shot task
+ * @return true
+ * @return false
+ */
+static inline bool scheduler_add(Scheduler *sched, SchedulerTask *task, uint64_t phase,
+                                 uint64_t period)
+{
+  uint32_t mstatus = csr_global_disable_irq_save();
+  if (task->state == SCHEDULER_TASK_WAITING)
+    scheduler_heap_remove(sched->waiting, &sched->waiting_count, task->heap_index, false);
+  else if (task->state == SCHEDULER_TASK_READY)
+    scheduler_heap_remove(sched->ready, &sched->ready_count, task->heap_index, true);
+  bool added = !scheduler_full(sched);
+  if (added)
+  {
+    task->release = now_ticks(sched->tb) + phase;
+    task->period = period;
+    task->state = SCHEDULER_TASK_WAITING;
+    scheduler_heap_push(sched->waiting, &sched->waiting_count, task, false);
+  }
+  else if (task->state != SCHEDULER_TASK_RUNNING)
+    task->state = SCHEDULER_TASK_IDLE;
+  csr_global_restore_irq(mstatus);
+  return added;
+}
+
+/**
+ * @brief Remove a task from the scheduler. A running task finishes its run but is not released
+ * again.
+ *
+ * @param sched Pointer to the Scheduler
+ * @param task Pointer to the SchedulerTask
+ */
+static inline void scheduler_remove(Scheduler *sched, SchedulerTask *task)
+{
+  uint32_t mstatus = csr_global_disable_irq_save();
+  if (task->state == SCHEDULER_TASK_WAITING)
+    scheduler_heap_remove(sched->waiting, &sched->waiting_count, task->heap_index, false);
+  else if (task->state == SCHEDULER_TASK_READY)
+    scheduler_heap_remove(sched->ready, &sched->ready_count, task->heap_index, true);
+  task->state = SCHEDULER_TASK_IDLE;
+  csr_global_restore_irq(mstatus);
+}
+
+/**
+ * @brief Return the release time of the next waiting task, or UINT64_MAX if there is none.
+ *
+ * @param sched Pointer to the Scheduler
+ * @return uint64_t
+ */
+static inline uint64_t scheduler_next_release(const Scheduler *sched)
+{
+  return sched->waiting_count == 0 ? UINT64_MAX : sched->waiting[0]->release;
+}
+
+/**
+ * @brief Return true if a task is ready to run now.
+ *
+ * @param context Pointer to the Scheduler
+ * @return true
+ * @return false
+ */
+static inline bool scheduler_has_work(void *context)
+{
+  Scheduler *sched = (Scheduler *)context;
+  return sched->ready_count != 0 || scheduler_next_release(sched) <= now_ticks(sched->tb);
+}
+
+/**
+ * @brief Release the tasks whose release time has come and run the ready task with the highest
+ * priority, if any. Return true if a task ran.
+ *
+ * @param sched Pointer to the Scheduler
+ * @return true
+ * @return false
+ */
+static inline bool scheduler_run_once(Scheduler *sched)
+{
+  uint32_t mstatus = csr_global_disable_irq_save();
+  uint64_t now = now_ticks(sched->tb);
+  while (sched->waiting_count != 0 && sched->waiting[0]->release <= now)
+  {
+    SchedulerTask *released = sched->waiting[0];
+    scheduler_heap_remove(sched->waiting, &sched->waiting_count, 0, false);
+    released->state = SCHEDULER_TASK_READY;
+    scheduler_heap_push(sched->ready, &sched->ready_count, released, true);
+  }
+  if (sched->ready_count == 0)
+  {
+    csr_global_restore_irq(mstatus);
+    return false;
+  }
+  SchedulerTask *task = sched->ready[0];
+  scheduler_heap_remove(sched->ready, &sched->ready_count, 0, true);
+  task->state = SCHEDULER_TASK_RUNNING;
+  uint64_t release = task->release;
+  uint64_t deadline = task->deadline != 0 ? task->deadline : task->period;
+  csr_global_restore_irq(mstatus);
+
+  uint32_t start, end;
+  CSR_READ(CSR_MCYCLE, start);
+  task->function(task->context);
+  CSR_READ(CSR_MCYCLE, end);
+
+  uint32_t cycles = end - start;
+  task->runs++;
+  task->last_cycles = cycles;
+  if (cycles > task->max_cycles)
+    task->max_cycles = cycles;
+  task->total_cycles += cycles;
+
+  now = now_ticks(sched->tb);
+  if (deadline != 0 && now > release + deadline)
+  {
+    task->overruns++;
+    if (sched->on_overrun != NULL)
+      sched->on_overrun(task, now - (release + deadline), sched->context);
+  }
+
+  // Unless the task added or removed itself while running, release it again if it is periodic
+  mstatus = csr_global_disable_irq_save();
+  if (task->state == SCHEDULER_TASK_RUNNING)
+  {
+    if (task->period != 0 && !scheduler_full(sched))
+    {
+      task->release += task->period;
+      // A release due right now is not missed
+      while (task->release < now)
+      {
+        task->release += task->period;
+        task->skipped++;
+      }
+      task->state = SCHEDULER_TASK_WAITING;
+      scheduler_heap_push(sched->waiting, &sched->waiting_count, task, false);
+    }
+    else
+    {
+      if (task->period != 0)
+        sched->dropped++;
+      task->state = SCHEDULER_TASK_IDLE;
+    }
+  }
+  csr_global_restore_irq(mstatus);
+  return true;
+}
+
+/**
+ * @brief Run tasks forever, sleeping in `wfi` whenever no task is ready.
+ *
+ * @param sched Pointer to the Scheduler
+ */
+static inline void scheduler_run(Scheduler *sched)
+{
+  while (true)
+  {
+    if (!scheduler_run_once(sched))
+    {
+      Deadline next = {scheduler_next_release(sched)};
+      sleep_once(sched->tb, next, scheduler_has_work, sched);
+    }
+  }
+}
+
+#endif // __LIBSTEEL_SCHEDULER__
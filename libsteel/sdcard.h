@@ -0,0 +1,544 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_SDCARD__
+#define __LIBSTEEL_SDCARD__
+
+#include "crc.h"
+#include "csr.h"
+#include "globals.h"
+#include "spi.h"
+
+/* Driver for SD, SDHC and SDXC cards in SPI mode, built on an SpiDevice. Blocks are 512 bytes and
+ * addressed by their index (LBA) regardless of the card type. Multi-block reads and writes stream
+ * all blocks after a single command (CMD18/CMD25) instead of sending one command per block.
+ *
+ * The SpiDevice must be initialized with SPI mode 0 and a clock configuration giving at most
+ * 400 kHz, as required during card initialization. After initialization the clock configuration
+ * given to `sd_init` is used.
+ *
+ * Example usage:
+ * ```
+ * SdCard card;
+ * if (sd_init(&card, &sd_dev, 0, 50000000, false) == SD_OK)
+ *   sd_read_blocks(&card, 0, buf, 4);
+ * ```
+ */
+
+// Size of a block in bytes
+#define SD_BLOCK_SIZE 512U
+
+#define SD_CMD_GO_IDLE_STATE 0U
+#define SD_CMD_SEND_IF_COND 8U
+#define SD_CMD_SEND_CSD 9U
+#define SD_CMD_STOP_TRANSMISSION 12U
+#define SD_CMD_SET_BLOCKLEN 16U
+#define SD_CMD_READ_SINGLE_BLOCK 17U
+#define SD_CMD_READ_MULTIPLE_BLOCK 18U
+#define SD_CMD_WRITE_BLOCK 24U
+#define SD_CMD_WRITE_MULTIPLE_BLOCK 25U
+#define SD_CMD_APP_CMD 55U
+#define SD_CMD_READ_OCR 58U
+#define SD_CMD_CRC_ON_OFF 59U
+#define SD_ACMD_SD_SEND_OP_COND 41U
+
+// R1 response bit set while the card is in the idle state
+#define SD_R1_IDLE 0x01U
+
+// R1 response bit set when the command is not supported by the card
+#define SD_R1_ILLEGAL_COMMAND 0x04U
+
+// Token sent before the data of a single-block read/write or of each block of a multi-block read
+#define SD_TOKEN_START_BLOCK 0xFEU
+
+// Token sent before the data of each block of a multi-block write
+#define SD_TOKEN_START_MULTI_WRITE 0xFCU
+
+// Token ending a multi-block write
+#define SD_TOKEN_STOP_MULTI_WRITE 0xFDU
+
+// Card Capacity Status (CCS) bit of the OCR register, set for SDHC/SDXC cards
+#define SD_OCR_CCS_MASK 0x40000000U
+
+// Maximum time taken by the card to initialize (in ms)
+#define SD_INIT_TIMEOUT_MS 1000U
+
+// Maximum time taken by the card to send a block (in ms)
+#define SD_READ_TIMEOUT_MS 100U
+
+// Maximum time taken by the card to write a block (in ms)
+#define SD_WRITE_TIMEOUT_MS 500U
+
+// Enumeration with the results of SD card operations
+enum SdStatus
+{
+  // The operation completed successfully
+  SD_OK = 0,
+  // The card did not answer in time
+  SD_ERROR_TIMEOUT = 1,
+  // The card rejected a command (the R1 response reported an error)
+  SD_ERROR_COMMAND = 2,
+  // The card is not supported (e.g. wrong voltage range or MMC card)
+  SD_ERROR_UNSUPPORTED = 3,
+  // A data block was received with a wrong CRC
+  SD_ERROR_CRC = 4,
+  // The card rejected a data block being written
+  SD_ERROR_WRITE = 5,
+  // A block address is past the end of the card
+  SD_ERROR_INVALID_ARGUMENT = 6
+};
+
+// Struct holding the state of an SD card
+typedef struct
+{
+  // Pointer to the SpiDevice of the card
+  SpiDevice *dev;
+  // True for SDHC/SDXC cards, which are addressed by block instead of by byte
+  bool block_addressing;
+  // True if data blocks carry a CRC that is checked (enabled with CMD59)
+  bool crc_enabled;
+  // Number of blocks of the card
+  uint32_t block_count;
+  // Number of CSR_MCYCLE cycles per millisecond, used for timeouts
+  uint32_t cycles_per_ms;
+  // Number of blocks read since initialization
+  uint32_t blocks_read;
+  // Number of blocks written since initialization
+  uint32_t blocks_written;
+  // Cycles spent in block reads since initialization. blocks_read / read_cycles * clock gives the
+  // read throughput in blocks per second.
+  uint64_t read_cycles;
+  // Cycles spent in block writes since initialization
+  uint64_t write_cycles;
+} SdCard;
+
+// Generic interface of a device storing data in fixed-size blocks
+typedef struct
+{
+  // Opaque pointer handed to the functions below (e.g. a pointer to an SdCard)
+  void *context;
+  // Size of a block in bytes
+  uint32_t block_size;
+  // Number of blocks of the device
+  uint32_t block_count;
+  // Read `count` blocks starting at block `lba`. Return 0 on success.
+  int (*read)(void *context, uint32_t lba, uint8_t *dst, uint32_t count);
+  // Write `count` blocks starting at block `lba`. Return 0 on success.
+  int (*write)(void *context, uint32_t lba, const uint8_t *src, uint32_t count);
+} BlockDevice;
+
+/**
+ * @brief Return the current value of CSR_MCYCLE (lowest 32 bits).
+ *
+ * @return uint32_t
+ */
+static inline uint32_t sd_cycles()
+{
+  uint32_t cycles;
+  CSR_READ(CSR_MCYCLE, cycles);
+  return cycles;
+}
+
+/**
+ * @brief Read bytes from the card until one differs from 0xff, for at most `timeout_ms`
+ * milliseconds. Return the byte read (0xff on timeout).
+ *
+ * @param card Pointer to the SdCard
+ * @param timeout_ms Maximum time to wait in milliseconds
+ * @return uint8_t
+ */
+static inline uint8_t sd_wait_token(SdCard *card, uint32_t timeout_ms)
+{
+  SpiController *spi = card->dev->bus->spi;
+  uint32_t timeout = card->cycles_per_ms * timeout_ms;
+  uint32_t start = sd_cycles();
+  uint8_t token;
+  do
+  {
+    token = spi_transfer(spi, 0xff);
+  } while (token == 0xff && sd_cycles() - start < timeout);
+  return token;
+}
+
+/**
+ * @brief Wait until the card releases the busy signal (holding its output low), for at most
+ * `timeout_ms` milliseconds.
+ *
+ * @param card Pointer to the SdCard
+ * @param timeout_ms Maximum time to wait in milliseconds
+ * @return enum SdStatus
+ */
+static inline enum SdStatus sd_wait_not_busy(SdCard *card, uint32_t timeout_ms)
+{
+  SpiController *spi = card->dev->bus->spi;
+  uint32_t timeout = card->cycles_per_ms * timeout_ms;
+  uint32_t start = sd_cycles();
+  while (spi_transfer(spi, 0xff) != 0xff)
+    if (sd_cycles() - start >= timeout)
+      return SD_ERROR_TIMEOUT;
+  return SD_OK;
+}
+
+/**
+ * @brief Select the card. Commands and data can then be sent until `sd_deselect` is called.
+ *
+ * @param card Pointer to the SdCard
+ */
+static inline void sd_select(SdCard *card)
+{
+  spi_device_begin(card->dev);
+}
+
+/**
+ * @brief Deselect the card and clock one more byte, which SD cards need to release their output.
+ *
+ * @param card Pointer to the SdCard
+ */
+static inline void sd_deselect(SdCard *card)
+{
+  spi_device_end(card->dev);
+  spi_write(card->dev->bus->spi, 0xff);
+}
+
+/**
+ * @brief Send a command to the selected card and return its R1 response (0xff if the card does not
+ * answer). Every command carries a valid CRC.
+ *
+ * @param card Pointer to the SdCard
+ * @param cmd The command index (0 to 63)
+ * @param arg The 32-bit argument of the command
+ * @return uint8_t
+ */
+static inline uint8_t sd_command(SdCard *card, uint8_t cmd, uint32_t arg)
+{
+  SpiController *spi = card->dev->bus->spi;
+  uint8_t frame[6] = {0x40 | cmd, arg >> 24, arg >> 16, arg >> 8, arg, 0};
+  uint8_t crc = CRC7_INIT;
+  for (uint32_t i = 0; i < 5; i++)
+    crc = crc7_update(crc, frame[i]);
+  frame[5] = crc | 1;
+  spi_write(spi, 0xff);
+  spi_write_buffer(spi, frame, sizeof(frame));
+  // The byte following CMD12 is a stuff byte and must be skipped
+  if (cmd == SD_CMD_STOP_TRANSMISSION)
+    spi_write(spi, 0xff);
+  uint8_t r1 = 0xff;
+  for (uint32_t i = 0; i < 10 && (r1 & 0x80) != 0; i++)
+    r1 = spi_transfer(spi, 0xff);
+  return r1;
+}
+
+/**
+ * @brief Send an application-specific command (ACMD) to the selected card and return its R1
+ * response.
+ *
+ * @param card Pointer to the SdCard
+ * @param acmd The application command index
+ * @param arg The 32-bit argument of the command
+ * @return uint8_t
+ */
+static inline uint8_t sd_app_command(SdCard *card, uint8_t acmd, uint32_t arg)
+{
+  sd_command(card, SD_CMD_APP_CMD, 0);
+  return sd_command(card, acmd, arg);
+}
+
+/**
+ * @brief Receive a data block of `length` bytes from the selected card, after its start token,
+ * and check its CRC if enabled.
+ *
+ * @param card Pointer to the SdCard
+ * @param dst Where the data is stored
+ * @param length Number of bytes in the block
+ * @return enum SdStatus
+ */
+static inline enum SdStatus sd_receive_data(SdCard *card, uint8_t *dst, size_t length)
+{
+  SpiController *spi = card->dev->bus->spi;
+  uint8_t token = sd_wait_token(card, SD_READ_TIMEOUT_MS);
+  if (token == 0xff)
+    return SD_ERROR_TIMEOUT;
+  if (token != SD_TOKEN_START_BLOCK)
+    return SD_ERROR_COMMAND;
+  spi_read_buffer(spi, dst, length, 0xff);
+  uint8_t crc[2];
+  spi_read_buffer(spi, crc, 2, 0xff);
+  if (card->crc_enabled && crc16_ccitt(CRC16_XMODEM_INIT, dst, length) != ((crc[0] << 8) | crc[1]))
+    return SD_ERROR_CRC;
+  return SD_OK;
+}
+
+/**
+ * @brief Send a data block to the selected card preceded by `token`, and wait until the card has
+ * written it.
+ *
+ * @param card Pointer to the SdCard
+ * @param token The start token
+ * @param src Pointer to the data
+ * @return enum SdStatus
+ */
+static inline enum SdStatus sd_send_data(SdCard *card, uint8_t token, const uint8_t *src)
+{
+  SpiController *spi = card->dev->bus->spi;
+  uint16_t crc = card->crc_enabled ? crc16_ccitt(CRC16_XMODEM_INIT, src, SD_BLOCK_SIZE) : 0xffff;
+  uint8_t trailer[2] = {crc >> 8, crc & 0xff};
+  spi_write(spi, token);
+  spi_write_buffer(spi, src, SD_BLOCK_SIZE);
+  spi_write_buffer(spi, trailer, 2);
+  // Data response: xxx0sss1, where sss = 010 means the data was accepted
+  if ((spi_transfer(spi, 0xff) & 0x1f) != 0x05)
+    return SD_ERROR_WRITE;
+  return sd_wait_not_busy(card, SD_WRITE_TIMEOUT_MS);
+}
+
+/**
+ * @brief Read the CSD register of the card and compute its number of blocks.
+ *
+ * @param card Pointer to the SdCard
+ * @return enum SdStatus
+ */
+static inline enum SdStatus sd_read_capacity(SdCard *card)
+{
+  uint8_t csd[16];
+  sd_select(card);
+  enum SdStatus status = SD_ERROR_COMMAND;
+  if (sd_command(card, SD_CMD_SEND_CSD, 0) == 0)
+    status = sd_receive_data(card, csd, sizeof(csd));
+  sd_deselect(card);
+  if (status != SD_OK)
+    return status;
+  if ((csd[0] >> 6) == 1)
+  {
+    // CSD version 2.0: capacity = (C_SIZE + 1) * 512 KB
+    uint32_t c_size = ((csd[7] & 0x3f) << 16) | (csd[8] << 8) | csd[9];
+    card->block_count = (c_size + 1) << 10;
+  }
+  else
+  {
+    // CSD version 1.0: capacity = (C_SIZE + 1) * 2^(C_SIZE_MULT + 2) * 2^READ_BL_LEN
+    uint32_t read_bl_len = csd[5] & 0x0f;
+    uint32_t c_size = ((csd[6] & 0x03) << 10) | (csd[7] << 2) | (csd[8] >> 6);
+    uint32_t c_size_mult = ((csd[9] & 0x03) << 1) | (csd[10] >> 7);
+    card->block_count = (c_size + 1) << (c_size_mult + 2 + read_bl_len - 9);
+  }
+  return SD_OK;
+}
+
+/**
+ * @brief Initialize an SD card: reset it into SPI mode, negotiate the operating conditions,
+ * detect whether it uses block addressing, read its capacity and finally switch the SPI clock to
+ * `fast_clock_conf`.
+ *
+ * @param card Pointer to the SdCard
+ * @param dev Pointer to the SpiDevice of the card, configured for at most 400 kHz
+ * @param fast_clock_conf Value of CLOCK_CONF used after initialization (see `spi_set_clock`)
+ * @param clock_hz Frequency of the system clock in Hz, used to compute timeouts
+ * @param enable_crc Check the CRC of every data block (costs extra time per block)
+ * @return enum SdStatus
+ */
+static inline enum SdStatus sd_init(SdCard *card, SpiDevice *dev, const uint8_t fast_clock_conf,
+                                    uint32_t clock_hz, bool enable_crc)
+{
+  card->dev = dev;
+  card->block_addressing = false;
+  card->crc_enabled = false;
+  card->block_count = 0;
+  card->cycles_per_ms = clock_hz / 1000;
+  card->blocks_read = 0;
+  card->blocks_written = 0;
+  card->read_cycles = 0;
+  card->write_cycles = 0;
+  SpiController *spi = dev->bus->spi;
+
+  // At least 74 clock cycles with the card deselected put it in its native mode, ready for CMD0
+  spi_device_configure(dev);
+  spi_deselect(spi);
+  for (uint32_t i = 0; i < 10; i++)
+    spi_write(spi, 0xff);
+
+  enum SdStatus status = SD_OK;
+  sd_select(card);
+  if (sd_command(card, SD_CMD_GO_IDLE_STATE, 0) != SD_R1_IDLE)
+    status = SD_ERROR_TIMEOUT;
+  bool sd_v2 = false;
+  if (status == SD_OK)
+  {
+    // CMD8 is only supported by SD version 2.00 or later. It checks the 2.7-3.6 V range.
+    uint8_t r7[4];
+    if ((sd_command(card, SD_CMD_SEND_IF_COND, 0x1AA) & SD_R1_ILLEGAL_COMMAND) == 0)
+    {
+      spi_read_buffer(spi, r7, sizeof(r7), 0xff);
+      if ((r7[2] & 0x0f) != 0x01 || r7[3] != 0xAA)
+        status = SD_ERROR_UNSUPPORTED;
+      sd_v2 = true;
+    }
+  }
+  if (status == SD_OK)
+  {
+    uint32_t timeout = card->cycles_per_ms * SD_INIT_TIMEOUT_MS;
+    uint32_t start = sd_cycles();
+    uint8_t r1;
+    while ((r1 = sd_app_command(card, SD_ACMD_SD_SEND_OP_COND, sd_v2 ? SD_OCR_CCS_MASK : 0)) ==
+           SD_R1_IDLE)
+      if (sd_cycles() - start >= timeout)
+        break;
+    if (r1 != 0)
+      status = r1 == SD_R1_IDLE ? SD_ERROR_TIMEOUT : SD_ERROR_UNSUPPORTED;
+  }
+  if (status == SD_OK && sd_v2)
+  {
+    uint8_t ocr[4];
+    if (sd_command(card, SD_CMD_READ_OCR, 0) != 0)
+      status = SD_ERROR_COMMAND;
+    spi_read_buffer(spi, ocr, sizeof(ocr), 0xff);
+    card->block_addressing = (ocr[0] & (SD_OCR_CCS_MASK >> 24)) != 0;
+  }
+  if (status == SD_OK && !card->block_addressing &&
+      sd_command(card, SD_CMD_SET_BLOCKLEN, SD_BLOCK_SIZE) != 0)
+    status = SD_ERROR_COMMAND;
+  if (status == SD_OK && enable_crc)
+  {
+    if (sd_command(card, SD_CMD_CRC_ON_OFF, 1) != 0)
+      status = SD_ERROR_COMMAND;
+    card->crc_enabled = true;
+  }
+  sd_deselect(card);
+  if (status != SD_OK)
+    return status;
+
+  dev->clock_conf = fast_clock_conf;
+  spi_device_configure(dev);
+  return sd_read_capacity(card);
+}
+
+/**
+ * @brief Return the address sent in read/write commands for block `lba`.
+ *
+ * @param card Pointer to the SdCard
+ * @param lba The block index
+ * @return uint32_t
+ */
+static inline uint32_t sd_block_address(SdCard *card, uint32_t lba)
+{
+  return card->block_addressing ? lba : lba * SD_BLOCK_SIZE;
+}
+
+/**
+ * @brief Read `count` consecutive blocks starting at block `lba`. A single block is read with
+ * CMD17; more blocks are streamed after a single CMD18.
+ *
+ * @param card Pointer to the SdCard
+ * @param lba Index of the first block
+ * @param dst Where the data is stored (`count * SD_BLOCK_SIZE` bytes)
+ * @param count Number of blocks to read
+ * @return enum SdStatus
+ */
+static inline enum SdStatus sd_read_blocks(SdCard *card, uint32_t lba, uint8_t *dst,
+                                           uint32_t count)
+{
+  if (count == 0)
+    return SD_OK;
+  if (lba + count > card->block_count || lba + count < lba)
+    return SD_ERROR_INVALID_ARGUMENT;
+  uint32_t start = sd_cycles();
+  enum SdStatus status = SD_OK;
+  sd_select(card);
+  uint8_t cmd = count == 1 ? SD_CMD_READ_SINGLE_BLOCK : SD_CMD_READ_MULTIPLE_BLOCK;
+  if (sd_command(card, cmd, sd_block_address(card, lba)) != 0)
+    status = SD_ERROR_COMMAND;
+  uint32_t done = 0;
+  while (status == SD_OK && done < count)
+  {
+    status = sd_receive_data(card, dst + done * SD_BLOCK_SIZE, SD_BLOCK_SIZE);
+    if (status == SD_OK)
+      done++;
+  }
+  if (cmd == SD_CMD_READ_MULTIPLE_BLOCK)
+  {
+    sd_command(card, SD_CMD_STOP_TRANSMISSION, 0);
+    sd_wait_not_busy(card, SD_READ_TIMEOUT_MS);
+  }
+  sd_deselect(card);
+  card->blocks_read += done;
+  card->read_cycles += sd_cycles() - start;
+  return status;
+}
+
+/**
+ * @brief Write `count` consecutive blocks starting at block `lba`. A single block is written with
+ * CMD24; more blocks are streamed after a single CMD25.
+ *
+ * @param card Pointer to the SdCard
+ * @param lba Index of the first block
+ * @param src Pointer to the data (`count * SD_BLOCK_SIZE` bytes)
+ * @param count Number of blocks to write
+ * @return enum SdStatus
+ */
+static inline enum SdStatus sd_write_blocks(SdCard *card, uint32_t lba, const uint8_t *src,
+                                            uint32_t count)
+{
+  if (count == 0)
+    return SD_OK;
+  if (lba + count > card->block_count || lba + count < lba)
+    return SD_ERROR_INVALID_ARGUMENT;
+  uint32_t start = sd_cycles();
+  enum SdStatus status = SD_OK;
+  sd_select(card);
+  bool multi = count > 1;
+  uint8_t cmd = multi ? SD_CMD_WRITE_MULTIPLE_BLOCK : SD_CMD_WRITE_BLOCK;
+  if (sd_command(card, cmd, sd_block_address(card, lba)) != 0)
+    status = SD_ERROR_COMMAND;
+  uint8_t token = multi ? SD_TOKEN_START_MULTI_WRITE : SD_TOKEN_START_BLOCK;
+  bool accepted = status == SD_OK;
+  uint32_t done = 0;
+  while (status == SD_OK && done < count)
+  {
+    status = sd_send_data(card, token, src + done * SD_BLOCK_SIZE);
+    if (status == SD_OK)
+      done++;
+  }
+  if (multi && accepted)
+  {
+    spi_write(card->dev->bus->spi, SD_TOKEN_STOP_MULTI_WRITE);
+    spi_write(card->dev->bus->spi, 0xff);
+    enum SdStatus stop_status = sd_wait_not_busy(card, SD_WRITE_TIMEOUT_MS);
+    if (status == SD_OK)
+      status = stop_status;
+  }
+  sd_deselect(card);
+  card->blocks_written += done;
+  card->write_cycles += sd_cycles() - start;
+  return status;
+}
+
+// Read function of the BlockDevice returned by `sd_block_device`
+static inline int sd_block_device_read(void *context, uint32_t lba, uint8_t *dst, uint32_t count)
+{
+  return sd_read_blocks((SdCard *)context, lba, dst, count);
+}
+
+// Write function of the BlockDevice returned by `sd_block_device`
+static inline int sd_block_device_write(void *context, uint32_t lba, const uint8_t *src,
+                                        uint32_t count)
+{
+  return sd_write_blocks((SdCard *)context, lba, src, count);
+}
+
+/**
+ * @brief Return a BlockDevice giving access to an initialized SD card.
+ *
+ * @param card Pointer to the SdCard
+ * @return BlockDevice
+ */
+static inline BlockDevice sd_block_device(SdCard *card)
+{
+  BlockDevice bd = {card, SD_BLOCK_SIZE, card->block_count, sd_block_device_read,
+                    sd_block_device_write};
+  return bd;
+}
+
+#endif // __LIBSTEEL_SDCARD__
@@ -0,0 +1,151 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_SLEEP__
+#define __LIBSTEEL_SLEEP__
+
+#include "csr.h"
+#include "globals.h"
+#include "mtimer.h"
+#include "timebase.h"
+
+/* Tickless idle: instead of spinning until a deadline, the core programs MTIMECMP for it and stops
+ * in `wfi` until an interrupt arrives. No periodic tick is needed.
+ *
+ * The sleep functions cooperate with other users of MTIMECMP (e.g. a TimerWheel): MTIMECMP is only
+ * moved earlier for the duration of the sleep and its previous value is restored on wake-up, so a
+ * timer due before the deadline still fires. If that timer is already due, its interrupt is the
+ * wake-up and the core does not stop. The Machine Timer Interrupt (MTI) is enabled in MIE while
+ * sleeping and restored afterwards, so no MTimer interrupt handler is required just to sleep.
+ * Interrupts are globally disabled around `wfi` to avoid missing a wake-up, and re-enabled (if
+ * they were enabled) after each wake-up so pending handlers run before sleeping again.
+ *
+ * Example usage:
+ * ```
+ * Deadline next = deadline_after_us(&tb, 1000);
+ * while (true)
+ * {
+ *   sleep_until(&tb, next);
+ *   next.ticks += us_to_ticks(&tb, 1000);
+ *   // ... periodic work ...
+ * }
+ * ```
+ */
+
+/**
+ * @brief Return the value of the MTIMECMP register.
+ *
+ * @param mtimer Pointer to the MTimerController
+ * @return uint64_t
+ */
+static inline uint64_t sleep_get_compare(MTimerController *mtimer)
+{
+  return ((uint64_t)mtimer->MTIMECMPH << 32) | mtimer->MTIMECMPL;
+}
+
+/**
+ * @brief Stop the core in `wfi` once, with MTIMECMP moved to the deadline if it is earlier, unless
+ * the deadline has passed or `condition(context)` is true. Return after the next interrupt, once
+ * its handler has run (if interrupts are globally enabled).
+ *
+ * When the value of MTIMECMP has already been reached, MTIP is pending. If MTI was enabled in MIE,
+ * another user of MTIMECMP is due: the core does not stop, so that its handler runs once interrupts
+ * are restored, and MTIMECMP is left untouched. Otherwise the value is stale (e.g. the reset value
+ * in a program that does not use the MTimer) and is moved to the deadline, as `wfi` would return
+ * at once and turn the sleep into a busy loop. Only the registers actually changed are written
+ * back.
+ *
+ * @param tb Pointer to the Timebase
+ * @param d The deadline
+ * @param condition Function returning true when the wait is over, or NULL
+ * @param context Argument passed to `condition`
+ */
+static inline void sleep_once(const Timebase *tb, Deadline d, bool (*condition)(void *context),
+                              void *context)
+{
+  MTimerController *mtimer = tb->mtimer;
+  uint32_t mstatus = csr_global_disable_irq_save();
+  uint32_t mie;
+  CSR_READ_SET(CSR_MIE, mie, MIP_MIE_MASK_MTI);
+  uint64_t previous = sleep_get_compare(mtimer);
+  bool reached = previous <= now_ticks(tb);
+  bool mti_enabled = (mie & MIP_MIE_MASK_MTI) != 0;
+  // The MTI already pending is the wake-up
+  bool pending = reached && mti_enabled;
+  bool moved = !pending && (d.ticks < previous || reached);
+  if (moved)
+    mtimer_set_compare(mtimer, d.ticks);
+  // Check again with interrupts disabled, a handler may have run since the caller checked
+  if ((condition == NULL || !condition(context)) && !deadline_expired(tb, d) && !pending)
+    wait_for_interrupt();
+  if (moved)
+    mtimer_set_compare(mtimer, previous);
+  if (!mti_enabled)
+    CSR_CLEAR(CSR_MIE, MIP_MIE_MASK_MTI);
+  csr_global_restore_irq(mstatus);
+}
+
+/**
+ * @brief Sleep until the deadline has passed, waking up only for interrupts. Interrupt handlers
+ * keep running while sleeping, if interrupts are globally enabled.
+ *
+ * @param tb Pointer to the Timebase
+ * @param d The deadline
+ */
+static inline void sleep_until(const Timebase *tb, Deadline d)
+{
+  while (!deadline_expired(tb, d))
+    sleep_once(tb, d, NULL, NULL);
+}
+
+/**
+ * @brief Sleep for `ticks` ticks, waking up only for interrupts.
+ *
+ * @param tb Pointer to the Timebase
+ * @param ticks Number of ticks
+ */
+static inline void sleep_for(const Timebase *tb, uint64_t ticks)
+{
+  sleep_until(tb, deadline_after_ticks(tb, ticks));
+}
+
+/**
+ * @brief Sleep for `us` microseconds, waking up only for interrupts.
+ *
+ * @param tb Pointer to the Timebase
+ * @param us Number of microseconds
+ */
+static inline void sleep_for_us(const Timebase *tb, uint64_t us)
+{
+  sleep_until(tb, deadline_after_us(tb, us));
+}
+
+/**
+ * @brief Sleep until `condition(context)` returns true or the deadline passes, checking the
+ * condition after every wake-up. Return true if the condition became true. The condition is
+ * expected to be set by an interrupt handler, e.g. the UART receive interrupt.
+ *
+ * @param tb Pointer to the Timebase
+ * @param condition Function returning true when the wait is over
+ * @param context Argument passed to `condition`
+ * @param d The deadline
+ * @return true
+ * @return false
+ */
+static inline bool sleep_until_condition(const Timebase *tb, bool (*condition)(void *context),
+                                         void *context, Deadline d)
+{
+  while (!condition(context))
+  {
+    if (deadline_expired(tb, d))
+      return false;
+    sleep_once(tb, d, condition, context);
+  }
+  return true;
+}
+
+#endif // __LIBSTEEL_SLEEP__
@@ -199,6 +199,61 @@ static inline void spi_set_clock(SpiController *spi, const uint8_t conf)
   spi->CLOCK_CONF = conf;
 }
 
+/* Helpers to derive CLOCK_CONF from the frequency of the system `clock` and the highest SCLK
+ * frequency supported by an SPI peripheral. With constant arguments they are integer constant
+ * expressions, evaluated by the compiler, so no division is left in the program:
+ *
+ * ```
+ * #define CLOCK_HZ 50000000
+ * SPI_CLOCK_CONF_ASSERT(CLOCK_HZ, 400000); // Fails to compile if 400 kHz cannot be reached
+ * spi_set_clock(spi, SPI_CLOCK_CONF(CLOCK_HZ, 400000)); // conf = 62, SCLK = 396825 Hz
+ * ```
+ */
+
+// Value of CLOCK_CONF giving the fastest SCLK not above `max_sclk_hz`, without range checking. The
+// smallest divider `k = conf + 1` with `clock_hz / (2 * k) <= max_sclk_hz` is ceil(ceil(clock_hz /
+// 2) / max_sclk_hz).
+#define SPI_CLOCK_CONF_UNCHECKED(clock_hz, max_sclk_hz)                                            \
+  (((clock_hz) / 2 + ((clock_hz) & 1) + (max_sclk_hz) - 1) / (max_sclk_hz) > 0                     \
+       ? ((clock_hz) / 2 + ((clock_hz) & 1) + (max_sclk_hz) - 1) / (max_sclk_hz) - 1              \
+       : 0)
+
+// Value of CLOCK_CONF giving the fastest SCLK not above `max_sclk_hz`. Use SPI_CLOCK_CONF_ASSERT
+// to reject targets that cannot be reached at compile time.
+#define SPI_CLOCK_CONF(clock_hz, max_sclk_hz)                                                      \
+  ((uint8_t)SPI_CLOCK_CONF_UNCHECKED(clock_hz, max_sclk_hz))
+
+// Compile-time check that SCLK can be brought down to `max_sclk_hz` (at least `clock_hz / 512`)
+#define SPI_CLOCK_CONF_ASSERT(clock_hz, max_sclk_hz)                                               \
+  __STATIC_ASSERT((max_sclk_hz) > 0 && SPI_CLOCK_CONF_UNCHECKED(clock_hz, max_sclk_hz) <= 255,     \
+                  "SPI: the requested SCLK frequency is below clock / 512 and cannot be reached")
+
+// Frequency of SCLK, in Hz, for a given system `clock` frequency and CLOCK_CONF value
+#define SPI_SCLK_HZ(clock_hz, conf) ((clock_hz) / (2 * ((conf) + 1)))
+
+/**
+ * @brief Set the SCLK frequency to the fastest value not above `max_sclk_hz` and return the
+ * frequency achieved, in Hz. If `max_sclk_hz` is below `clock_hz / 512` it cannot be reached: the
+ * clock configuration is left unchanged and 0 is returned. With constant arguments the divider is
+ * computed at compile time.
+ *
+ * @param spi Pointer to the SpiController.
+ * @param clock_hz Frequency of the system `clock` in Hz.
+ * @param max_sclk_hz Highest SCLK frequency supported by the SPI peripheral, in Hz.
+ * @return uint32_t
+ */
+static inline uint32_t spi_set_sclk(SpiController *spi, const uint32_t clock_hz,
+                                    const uint32_t max_sclk_hz)
+{
+  if (max_sclk_hz == 0)
+    return 0;
+  uint32_t conf = SPI_CLOCK_CONF_UNCHECKED(clock_hz, max_sclk_hz);
+  if (conf > 255)
+    return 0;
+  spi_set_clock(spi, conf);
+  return SPI_SCLK_HZ(clock_hz, conf);
+}
+
 /**
  * @brief Read the configuration of the clock register (CLOCK_CONF). Based on the return value of
  * this function, the frequency of the SCLK pin can be calculated as: `SCLKf = clockf / (2 * (conf +
@@ -239,4 +294,270 @@ static inline uint8_t spi_transfer(SpiController *spi, const uint8_t wdata)
   return spi->RDATA;
 }
 
-#endif
\ No newline at end of file
+/**
+ * @brief Send `length` bytes to the selected SPI peripheral while storing the bytes received over
+ * the POCI pin in `rx` (full-duplex). `tx` and `rx` may point to the same buffer. Each byte waits
+ * for the previous transfer to complete.
+ *
+ * @param spi Pointer to the SpiController.
+ * @param tx Pointer to the bytes to be sent.
+ * @param rx Pointer to where the received bytes are stored.
+ * @param length Number of bytes to transfer.
+ */
+static inline void spi_transfer_buffer(SpiController *spi, const uint8_t *tx, uint8_t *rx,
+                                       size_t length)
+{
+  const uint8_t *end = tx + length;
+  while (tx != end)
+  {
+    spi->WDATA = *tx++;
+    while (spi->BUSY != 0)
+      ;
+    *rx++ = spi->RDATA;
+  }
+}
+
+/**
+ * @brief Send `length` bytes to the selected SPI peripheral. The bytes received over the POCI pin
+ * are ignored and register RDATA is never read.
+ *
+ * @param spi Pointer to the SpiController.
+ * @param tx Pointer to the bytes to be sent.
+ * @param length Number of bytes to send.
+ */
+static inline void spi_write_buffer(SpiController *spi, const uint8_t *tx, size_t length)
+{
+  const uint8_t *end = tx + length;
+  while (tx != end)
+  {
+    spi->WDATA = *tx++;
+    while (spi->BUSY != 0)
+      ;
+  }
+}
+
+/**
+ * @brief Receive `length` bytes from the selected SPI peripheral, sending the byte `fill` during
+ * each transfer (usually 0xff or 0x00, as required by the peripheral).
+ *
+ * @param spi Pointer to the SpiController.
+ * @param rx Pointer to where the received bytes are stored.
+ * @param length Number of bytes to receive.
+ * @param fill The byte sent during each transfer.
+ */
+static inline void spi_read_buffer(SpiController *spi, uint8_t *rx, size_t length,
+                                   const uint8_t fill)
+{
+  uint8_t *end = rx + length;
+  while (rx != end)
+  {
+    spi->WDATA = fill;
+    while (spi->BUSY != 0)
+      ;
+    *rx++ = spi->RDATA;
+  }
+}
+
+/**
+ * @brief Send the byte `fill` `length` times to the selected SPI peripheral, ignoring the bytes
+ * received. Used to provide clock cycles to a peripheral, e.g. the dummy bytes of a command.
+ *
+ * @param spi Pointer to the SpiController.
+ * @param fill The byte sent during each transfer.
+ * @param length Number of bytes to send.
+ */
+static inline void spi_fill(SpiController *spi, const uint8_t fill, size_t length)
+{
+  for (; length != 0; length--)
+  {
+    spi->WDATA = fill;
+    while (spi->BUSY != 0)
+      ;
+  }
+}
+
+// Struct caching the configuration of an SPI Controller shared by several peripherals
+typedef struct
+{
+  // Pointer to the SpiController
+  SpiController *spi;
+  // Clock polarity currently held by register CPOL
+  uint8_t cpol;
+  // Clock phase currently held by register CPHA
+  uint8_t cpha;
+  // Value currently held by register CLOCK_CONF
+  uint8_t clock_conf;
+} SpiBus;
+
+// Struct describing an SPI peripheral attached to an SpiBus
+typedef struct
+{
+  // Pointer to the SpiBus the peripheral is attached to
+  SpiBus *bus;
+  // SPI mode required by the peripheral
+  enum SpiMode mode;
+  // Value of register CLOCK_CONF required by the peripheral
+  uint8_t clock_conf;
+  // ID of the Chip Select line connected to the peripheral
+  uint8_t cs;
+  // Byte sent during segments that only receive data. Set to 0xff by `spi_device_init`.
+  uint8_t fill;
+} SpiDevice;
+
+// Struct describing a segment of an SPI transaction
+typedef struct
+{
+  // Bytes to be sent, or NULL to send the fill byte of the device
+  const uint8_t *tx;
+  // Where received bytes are stored, or NULL to ignore them. A segment with both `tx` and `rx`
+  // NULL sends `length` fill bytes.
+  uint8_t *rx;
+  // Number of bytes to transfer
+  size_t length;
+} SpiSegment;
+
+/**
+ * @brief Read back the configuration registers of the SPI Controller into the SpiBus cache. Call
+ * it if the registers were changed without going through an SpiDevice.
+ *
+ * @param bus Pointer to the SpiBus.
+ */
+static inline void spi_bus_sync(SpiBus *bus)
+{
+  bus->cpol = bus->spi->CPOL;
+  bus->cpha = bus->spi->CPHA;
+  bus->clock_conf = bus->spi->CLOCK_CONF;
+}
+
+/**
+ * @brief Initialize an SpiBus for an SPI Controller shared by several peripherals.
+ *
+ * @param bus Pointer to the SpiBus.
+ * @param spi Pointer to the SpiController.
+ */
+static inline void spi_bus_init(SpiBus *bus, SpiController *spi)
+{
+  bus->spi = spi;
+  spi_bus_sync(bus);
+}
+
+/**
+ * @brief Initialize an SpiDevice with the mode, clock configuration and Chip Select line of an SPI
+ * peripheral. No register is written until a transaction is started.
+ *
+ * @param dev Pointer to the SpiDevice.
+ * @param bus Pointer to the SpiBus the peripheral is attached to.
+ * @param mode The SPI mode required by the peripheral.
+ * @param clock_conf Value of CLOCK_CONF required by the peripheral (see `spi_set_clock`).
+ * @param cs ID of the Chip Select line connected to the peripheral.
+ */
+static inline void spi_device_init(SpiDevice *dev, SpiBus *bus, enum SpiMode mode,
+                                   const uint8_t clock_conf, const uint8_t cs)
+{
+  dev->bus = bus;
+  dev->mode = mode;
+  dev->clock_conf = clock_conf;
+  dev->cs = cs;
+  dev->fill = 0xff;
+}
+
+/**
+ * @brief Apply the mode and clock configuration of an SPI peripheral to the bus. Only the
+ * registers whose cached value differs from the one required are written.
+ *
+ * @param dev Pointer to the SpiDevice.
+ */
+static inline void spi_device_configure(SpiDevice *dev)
+{
+  SpiBus *bus = dev->bus;
+  uint8_t cpol = (dev->mode >> 1) & 1;
+  uint8_t cpha = dev->mode & 1;
+  if (bus->cpol != cpol)
+  {
+    bus->spi->CPOL = cpol;
+    bus->cpol = cpol;
+  }
+  if (bus->cpha != cpha)
+  {
+    bus->spi->CPHA = cpha;
+    bus->cpha = cpha;
+  }
+  if (bus->clock_conf != dev->clock_conf)
+  {
+    bus->spi->CLOCK_CONF = dev->clock_conf;
+    bus->clock_conf = dev->clock_conf;
+  }
+}
+
+/**
+ * @brief Configure the bus for an SPI peripheral and select it. Transfers can then be made with
+ * the functions taking an SpiController (e.g. `spi_transfer_buffer(dev->bus->spi, ...)`) until
+ * `spi_device_end` is called.
+ *
+ * @param dev Pointer to the SpiDevice.
+ */
+static inline void spi_device_begin(SpiDevice *dev)
+{
+  spi_device_configure(dev);
+  spi_select(dev->bus->spi, dev->cs);
+}
+
+/**
+ * @brief Deselect an SPI peripheral selected with `spi_device_begin`.
+ *
+ * @param dev Pointer to the SpiDevice.
+ */
+static inline void spi_device_end(SpiDevice *dev)
+{
+  spi_deselect(dev->bus->spi);
+}
+
+/**
+ * @brief Transfer a single segment to/from the SPI peripheral currently selected, using the most
+ * specific transfer function for it.
+ *
+ * @param dev Pointer to the SpiDevice.
+ * @param segment Pointer to the segment.
+ */
+static inline void spi_device_transfer_segment(SpiDevice *dev, const SpiSegment *segment)
+{
+  SpiController *spi = dev->bus->spi;
+  if (segment->tx == NULL)
+  {
+    if (segment->rx == NULL)
+      spi_fill(spi, dev->fill, segment->length);
+    else
+      spi_read_buffer(spi, segment->rx, segment->length, dev->fill);
+  }
+  else if (segment->rx == NULL)
+    spi_write_buffer(spi, segment->tx, segment->length);
+  else
+    spi_transfer_buffer(spi, segment->tx, segment->rx, segment->length);
+}
+
+/**
+ * @brief Run a transaction made of a list of segments with an SPI peripheral. The bus is
+ * configured for the peripheral if needed and its Chip Select line is kept asserted from the first
+ * to the last segment.
+ *
+ * Example usage (read 16 bytes from a SPI NOR flash):
+ * ```
+ * uint8_t cmd[4] = {0x03, addr >> 16, addr >> 8, addr};
+ * SpiSegment segments[] = {{cmd, NULL, sizeof(cmd)}, {NULL, data, 16}};
+ * spi_device_transaction(&flash, segments, NUMBER_OF(segments));
+ * ```
+ *
+ * @param dev Pointer to the SpiDevice.
+ * @param segments Array of segments.
+ * @param count Number of segments in the array.
+ */
+static inline void spi_device_transaction(SpiDevice *dev, const SpiSegment *segments,
+                                          size_t count)
+{
+  spi_device_begin(dev);
+  for (size_t i = 0; i < count; i++)
+    spi_device_transfer_segment(dev, &segments[i]);
+  spi_device_end(dev);
+}
+
+#endif
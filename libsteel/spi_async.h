@@ -0,0 +1,244 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_SPI_ASYNC__
+#define __LIBSTEEL_SPI_ASYNC__
+
+#include "csr.h"
+#include "globals.h"
+#include "spi.h"
+
+/* Asynchronous SPI engine. Transactions (see `spi_device_transaction`) are queued and carried out
+ * one byte at a time by `spi_engine_poll`, which never waits for the SPI Controller: it finishes
+ * the byte on the wire if BUSY is clear, starts the next one and returns. Call it from an
+ * interrupt handler declared with `__IRQ_M` (e.g. a periodic MTimer interrupt) or from the main
+ * loop, so the core can run other work while each byte is being shifted.
+ *
+ * Example usage:
+ * ```
+ * static SpiEngine engine;
+ * static SpiAsyncTransaction read_adc = {&adc, segments, NUMBER_OF(segments), adc_done, NULL};
+ *
+ * spi_engine_init(&engine);
+ * spi_engine_submit(&engine, &read_adc);
+ * while (true)
+ * {
+ *   spi_engine_poll(&engine);
+ *   // ... other work ...
+ * }
+ * ```
+ */
+
+typedef struct SpiAsyncTransaction SpiAsyncTransaction;
+
+// Type of the function called when an asynchronous SPI transaction completes
+typedef void (*SpiAsyncCallback)(SpiAsyncTransaction *transaction, void *context);
+
+// Struct describing an asynchronous SPI transaction. It must stay valid until it completes.
+struct SpiAsyncTransaction
+{
+  // Pointer to the SpiDevice the transaction is addressed to
+  SpiDevice *dev;
+  // Array of segments of the transaction
+  const SpiSegment *segments;
+  // Number of segments in the array
+  size_t count;
+  // Function called when the transaction completes, or NULL
+  SpiAsyncCallback callback;
+  // Opaque pointer handed to the callback
+  void *context;
+  // Value of CSR_MCYCLE when the transaction was submitted. Set by the engine.
+  uint32_t submit_cycle;
+  // Cycles elapsed from submission to completion. Set by the engine.
+  uint32_t latency;
+  // Next transaction in the queue. Used by the engine.
+  SpiAsyncTransaction *next;
+};
+
+// Struct holding the state of an asynchronous SPI engine
+typedef struct
+{
+  // Transaction in progress (head of the queue)
+  SpiAsyncTransaction *head;
+  // Last transaction in the queue
+  SpiAsyncTransaction *tail;
+  // Index of the segment in progress
+  size_t segment;
+  // Index of the next byte in the segment in progress
+  size_t offset;
+  // True if the transaction in progress has selected its peripheral
+  bool active;
+  // True if a byte is being shifted and its received value was not read yet
+  bool in_flight;
+  // Number of transactions in the queue, including the one in progress
+  uint32_t depth;
+  // Highest number of transactions in the queue since the last statistics reset
+  uint32_t max_depth;
+  // Number of transactions completed since the last statistics reset
+  uint32_t completed;
+  // Latency in cycles of the last transaction completed
+  uint32_t last_latency;
+  // Highest latency in cycles since the last statistics reset
+  uint32_t max_latency;
+} SpiEngine;
+
+/**
+ * @brief Initialize an asynchronous SPI engine with an empty queue.
+ *
+ * @param eng Pointer to the SpiEngine.
+ */
+static inline void spi_engine_init(SpiEngine *eng)
+{
+  eng->head = NULL;
+  eng->tail = NULL;
+  eng->segment = 0;
+  eng->offset = 0;
+  eng->active = false;
+  eng->in_flight = false;
+  eng->depth = 0;
+  eng->max_depth = 0;
+  eng->completed = 0;
+  eng->last_latency = 0;
+  eng->max_latency = 0;
+}
+
+/**
+ * @brief Add a transaction to the end of the queue and return immediately. The callback of the
+ * transaction is called from `spi_engine_poll` once it completes.
+ *
+ * @param eng Pointer to the SpiEngine.
+ * @param transaction Pointer to the transaction. It must stay valid until it completes.
+ */
+static inline void spi_engine_submit(SpiEngine *eng, SpiAsyncTransaction *transaction)
+{
+  uint32_t cycle;
+  CSR_READ(CSR_MCYCLE, cycle);
+  transaction->submit_cycle = cycle;
+  transaction->latency = 0;
+  transaction->next = NULL;
+  uint32_t mstatus = csr_global_disable_irq_save();
+  if (eng->tail == NULL)
+    eng->head = transaction;
+  else
+    eng->tail->next = transaction;
+  eng->tail = transaction;
+  eng->depth++;
+  if (eng->depth > eng->max_depth)
+    eng->max_depth = eng->depth;
+  csr_global_restore_irq(mstatus);
+}
+
+/**
+ * @brief Complete the transaction at the head of the queue: deselect its peripheral, update the
+ * statistics and call its callback.
+ *
+ * @param eng Pointer to the SpiEngine.
+ */
+static inline void spi_engine_complete(SpiEngine *eng)
+{
+  SpiAsyncTransaction *t = eng->head;
+  spi_device_end(t->dev);
+  uint32_t cycle;
+  CSR_READ(CSR_MCYCLE, cycle);
+  t->latency = cycle - t->submit_cycle;
+  uint32_t mstatus = csr_global_disable_irq_save();
+  eng->head = t->next;
+  if (eng->head == NULL)
+    eng->tail = NULL;
+  eng->depth--;
+  csr_global_restore_irq(mstatus);
+  eng->segment = 0;
+  eng->offset = 0;
+  eng->active = false;
+  eng->completed++;
+  eng->last_latency = t->latency;
+  if (t->latency > eng->max_latency)
+    eng->max_latency = t->latency;
+  if (t->callback != NULL)
+    t->callback(t, t->context);
+}
+
+/**
+ * @brief Advance the engine by at most one byte without waiting. If the byte on the wire is done,
+ * its received value is stored and the next byte is started; a transaction whose last byte is done
+ * is completed. Must not be called concurrently from two contexts.
+ *
+ * @param eng Pointer to the SpiEngine.
+ */
+static inline void spi_engine_poll(SpiEngine *eng)
+{
+  SpiAsyncTransaction *t = eng->head;
+  if (t == NULL)
+    return;
+  SpiController *spi = t->dev->bus->spi;
+  if (eng->in_flight)
+  {
+    if (spi->BUSY != 0)
+      return;
+    uint8_t *rx = t->segments[eng->segment].rx;
+    if (rx != NULL)
+      rx[eng->offset] = spi->RDATA;
+    eng->offset++;
+    eng->in_flight = false;
+  }
+  else if (!eng->active)
+  {
+    spi_device_begin(t->dev);
+    eng->active = true;
+  }
+  while (eng->segment < t->count && eng->offset >= t->segments[eng->segment].length)
+  {
+    eng->segment++;
+    eng->offset = 0;
+  }
+  if (eng->segment == t->count)
+  {
+    spi_engine_complete(eng);
+    return;
+  }
+  const uint8_t *tx = t->segments[eng->segment].tx;
+  spi->WDATA = tx != NULL ? tx[eng->offset] : t->dev->fill;
+  eng->in_flight = true;
+}
+
+/**
+ * @brief Return true if the queue of the engine is empty.
+ *
+ * @param eng Pointer to the SpiEngine.
+ * @return true
+ * @return false
+ */
+static inline bool spi_engine_idle(SpiEngine *eng)
+{
+  return eng->head == NULL;
+}
+
+/**
+ * @brief Poll the engine until all queued transactions are complete.
+ *
+ * @param eng Pointer to the SpiEngine.
+ */
+static inline void spi_engine_flush(SpiEngine *eng)
+{
+  while (!spi_engine_idle(eng))
+    spi_engine_poll(eng);
+}
+
+/**
+ * @brief Reset the queue depth, completion and latency statistics of the engine.
+ *
+ * @param eng Pointer to the SpiEngine.
+ */
+static inline void spi_engine_reset_stats(SpiEngine *eng)
+{
+  eng->max_depth = eng->depth;
+  eng->completed = 0;
+  eng->last_latency = 0;
+  eng->max_latency = 0;
+}
+
+#endif // __LIBSTEEL_SPI_ASYNC__
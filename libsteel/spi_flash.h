@@ -0,0 +1,344 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_SPI_FLASH__
+#define __LIBSTEEL_SPI_FLASH__
+
+#include "csr.h"
+#include "globals.h"
+#include "spi.h"
+
+/* Driver for JEDEC-compliant SPI NOR flash memories with 3-byte addresses (up to 16 MB), built on
+ * an SpiDevice. Reads use the Fast Read command and keep the Chip Select line asserted for the
+ * whole read. Geometry (capacity and erase sizes) is taken from the SFDP tables when available.
+ *
+ * Example usage:
+ * ```
+ * SpiFlash flash;
+ * spi_flash_init(&flash, &flash_dev, 50000000);
+ * spi_flash_erase(&flash, 0x10000, 0x1000);
+ * spi_flash_write(&flash, 0x10000, data, sizeof(data));
+ * spi_flash_read(&flash, 0x10000, buf, sizeof(buf));
+ * ```
+ */
+
+#define SPI_FLASH_CMD_WRITE_ENABLE 0x06U
+#define SPI_FLASH_CMD_READ_STATUS 0x05U
+#define SPI_FLASH_CMD_READ_JEDEC_ID 0x9FU
+#define SPI_FLASH_CMD_READ_SFDP 0x5AU
+#define SPI_FLASH_CMD_FAST_READ 0x0BU
+#define SPI_FLASH_CMD_PAGE_PROGRAM 0x02U
+#define SPI_FLASH_CMD_ERASE_4K 0x20U
+#define SPI_FLASH_CMD_ERASE_32K 0x52U
+#define SPI_FLASH_CMD_ERASE_64K 0xD8U
+
+// Mask of the Write In Progress (WIP) bit of the status register
+#define SPI_FLASH_STATUS_WIP_MASK 0x01U
+
+// Size of a program page in bytes
+#define SPI_FLASH_PAGE_SIZE 256U
+
+// Largest capacity reachable with 3-byte addresses
+#define SPI_FLASH_MAX_CAPACITY 0x1000000U
+
+// Maximum time taken by a page program (in ms), used for timeouts
+#define SPI_FLASH_PROGRAM_TIMEOUT_MS 5U
+
+// Maximum time taken by a 64 KB block erase (in ms), used for timeouts
+#define SPI_FLASH_ERASE_TIMEOUT_MS 2000U
+
+// Enumeration with the results of SPI NOR flash operations
+enum SpiFlashStatus
+{
+  // The operation completed successfully
+  SPI_FLASH_OK = 0,
+  // The flash did not finish the operation in time
+  SPI_FLASH_TIMEOUT = 1,
+  // An address or length is not valid for the operation (e.g. not aligned to an erase sector)
+  SPI_FLASH_INVALID_ARGUMENT = 2,
+  // The flash did not answer with a valid JEDEC ID
+  SPI_FLASH_NOT_FOUND = 3
+};
+
+// Erase sizes supported by the driver, from the smallest to the largest
+enum SpiFlashEraseSize
+{
+  SPI_FLASH_ERASE_4K = 0,
+  SPI_FLASH_ERASE_32K = 1,
+  SPI_FLASH_ERASE_64K = 2
+};
+
+// Size in bytes of each erase size, indexed by enum SpiFlashEraseSize
+static const uint32_t spi_flash_erase_bytes[] = {0x1000, 0x8000, 0x10000};
+
+// Struct holding the state of an SPI NOR flash
+typedef struct
+{
+  // Pointer to the SpiDevice of the flash
+  SpiDevice *dev;
+  // Manufacturer ID, memory type and capacity bytes returned by the JEDEC ID command
+  uint8_t jedec_id[3];
+  // Capacity of the flash in bytes
+  uint32_t capacity;
+  // Opcodes of the 4 KB, 32 KB and 64 KB erase commands, or 0 if not supported
+  uint8_t erase_opcode[3];
+  // Number of CSR_MCYCLE cycles per millisecond, used for timeouts
+  uint32_t cycles_per_ms;
+} SpiFlash;
+
+/**
+ * @brief Send a command with a 3-byte address, optionally followed by `dummy` dummy bytes, and
+ * then transfer the data segment described by `tx`, `rx` and `length` in the same transaction.
+ *
+ * @param flash Pointer to the SpiFlash
+ * @param cmd The command opcode
+ * @param addr The 24-bit address
+ * @param dummy Number of dummy bytes (0 or 1)
+ * @param tx Bytes to be sent after the address, or NULL
+ * @param rx Where the bytes received after the address are stored, or NULL
+ * @param length Number of bytes in the data segment
+ */
+static inline void spi_flash_command(SpiFlash *flash, uint8_t cmd, uint32_t addr, uint32_t dummy,
+                                     const uint8_t *tx, uint8_t *rx, size_t length)
+{
+  uint8_t header[5] = {cmd, addr >> 16, addr >> 8, addr, 0xff};
+  SpiSegment segments[] = {{header, NULL, 4 + dummy}, {tx, rx, length}};
+  spi_device_transaction(flash->dev, segments, NUMBER_OF(segments));
+}
+
+/**
+ * @brief Send a command made of a single opcode.
+ *
+ * @param flash Pointer to the SpiFlash
+ * @param cmd The command opcode
+ */
+static inline void spi_flash_simple_command(SpiFlash *flash, uint8_t cmd)
+{
+  SpiSegment segment = {&cmd, NULL, 1};
+  spi_device_transaction(flash->dev, &segment, 1);
+}
+
+/**
+ * @brief Read the 3-byte JEDEC ID (manufacturer, memory type and capacity) of the flash.
+ *
+ * @param flash Pointer to the SpiFlash
+ * @param id Where the three ID bytes are stored
+ */
+static inline void spi_flash_read_jedec_id(SpiFlash *flash, uint8_t id[3])
+{
+  uint8_t cmd = SPI_FLASH_CMD_READ_JEDEC_ID;
+  SpiSegment segments[] = {{&cmd, NULL, 1}, {NULL, id, 3}};
+  spi_device_transaction(flash->dev, segments, NUMBER_OF(segments));
+}
+
+/**
+ * @brief Read `length` bytes of the Serial Flash Discoverable Parameters (SFDP) area.
+ *
+ * @param flash Pointer to the SpiFlash
+ * @param addr Address in the SFDP area
+ * @param dst Where the bytes read are stored
+ * @param length Number of bytes to read
+ */
+static inline void spi_flash_read_sfdp(SpiFlash *flash, uint32_t addr, uint8_t *dst, size_t length)
+{
+  spi_flash_command(flash, SPI_FLASH_CMD_READ_SFDP, addr, 1, NULL, dst, length);
+}
+
+/**
+ * @brief Read the Basic Flash Parameter Table from the SFDP area and update the capacity and erase
+ * opcodes of the flash. Return false, changing nothing, if the flash has no valid SFDP data.
+ *
+ * @param flash Pointer to the SpiFlash
+ * @return true
+ * @return false
+ */
+static inline bool spi_flash_probe_sfdp(SpiFlash *flash)
+{
+  uint8_t header[16];
+  spi_flash_read_sfdp(flash, 0, header, sizeof(header));
+  if (header[0] != 'S' || header[1] != 'F' || header[2] != 'D' || header[3] != 'P')
+    return false;
+  // The first parameter header always describes the Basic Flash Parameter Table (BFPT)
+  uint32_t bfpt_addr = header[12] | (header[13] << 8) | ((uint32_t)header[14] << 16);
+  if (header[11] < 9)
+    return false;
+  uint32_t bfpt[9];
+  spi_flash_read_sfdp(flash, bfpt_addr, (uint8_t *)bfpt, sizeof(bfpt));
+  // DWORD 2 holds the density in bits: N-1 if bit 31 is clear, otherwise 2^N. Densities whose
+  // size in bytes does not fit 32 bits give 0, like an unknown JEDEC capacity.
+  uint32_t density = bfpt[1];
+  uint32_t exponent = density & 0x7fffffffU;
+  if ((density & 0x80000000U) == 0)
+    flash->capacity = (density + 1) >> 3;
+  else if (exponent >= 3 && exponent < 35)
+    flash->capacity = 1U << (exponent - 3);
+  else
+    flash->capacity = 0;
+  // DWORDs 8 and 9 hold up to four (size exponent, opcode) pairs of erase types
+  flash->erase_opcode[SPI_FLASH_ERASE_4K] = SPI_FLASH_CMD_ERASE_4K;
+  flash->erase_opcode[SPI_FLASH_ERASE_32K] = 0;
+  flash->erase_opcode[SPI_FLASH_ERASE_64K] = 0;
+  const uint8_t *erase_types = (const uint8_t *)&bfpt[7];
+  for (uint32_t i = 0; i < 8; i += 2)
+  {
+    if (erase_types[i] == 12)
+      flash->erase_opcode[SPI_FLASH_ERASE_4K] = erase_types[i + 1];
+    else if (erase_types[i] == 15)
+      flash->erase_opcode[SPI_FLASH_ERASE_32K] = erase_types[i + 1];
+    else if (erase_types[i] == 16)
+      flash->erase_opcode[SPI_FLASH_ERASE_64K] = erase_types[i + 1];
+  }
+  return true;
+}
+
+/**
+ * @brief Initialize the driver for an SPI NOR flash: read its JEDEC ID and, if available, its SFDP
+ * tables. Without SFDP, the standard 4/32/64 KB erase opcodes are assumed and the capacity is
+ * derived from the JEDEC ID. Return SPI_FLASH_NOT_FOUND if no flash answers.
+ *
+ * @param flash Pointer to the SpiFlash
+ * @param dev Pointer to the SpiDevice of the flash
+ * @param clock_hz Frequency of the system clock in Hz, used to compute timeouts
+ * @return enum SpiFlashStatus
+ */
+static inline enum SpiFlashStatus spi_flash_init(SpiFlash *flash, SpiDevice *dev,
+                                                 uint32_t clock_hz)
+{
+  flash->dev = dev;
+  flash->cycles_per_ms = clock_hz / 1000;
+  spi_flash_read_jedec_id(flash, flash->jedec_id);
+  if (flash->jedec_id[0] == 0x00 || flash->jedec_id[0] == 0xff)
+    return SPI_FLASH_NOT_FOUND;
+  flash->capacity = flash->jedec_id[2] < 32 ? 1U << flash->jedec_id[2] : 0;
+  flash->erase_opcode[SPI_FLASH_ERASE_4K] = SPI_FLASH_CMD_ERASE_4K;
+  flash->erase_opcode[SPI_FLASH_ERASE_32K] = SPI_FLASH_CMD_ERASE_32K;
+  flash->erase_opcode[SPI_FLASH_ERASE_64K] = SPI_FLASH_CMD_ERASE_64K;
+  spi_flash_probe_sfdp(flash);
+  // Only the lowest 16 MB are reachable with 3-byte addresses
+  if (flash->capacity == 0 || flash->capacity > SPI_FLASH_MAX_CAPACITY)
+    flash->capacity = SPI_FLASH_MAX_CAPACITY;
+  return SPI_FLASH_OK;
+}
+
+/**
+ * @brief Wait until the Write In Progress (WIP) bit of the status register is cleared, for at
+ * most `timeout_ms` milliseconds. The status register is read continuously within a single
+ * transaction.
+ *
+ * @param flash Pointer to the SpiFlash
+ * @param timeout_ms Maximum time to wait in milliseconds
+ * @return enum SpiFlashStatus
+ */
+static inline enum SpiFlashStatus spi_flash_wait_ready(SpiFlash *flash, uint32_t timeout_ms)
+{
+  SpiController *spi = flash->dev->bus->spi;
+  uint32_t timeout = flash->cycles_per_ms * timeout_ms;
+  uint32_t start, now;
+  enum SpiFlashStatus status = SPI_FLASH_TIMEOUT;
+  CSR_READ(CSR_MCYCLE, start);
+  spi_device_begin(flash->dev);
+  spi_write(spi, SPI_FLASH_CMD_READ_STATUS);
+  do
+  {
+    if ((spi_transfer(spi, 0xff) & SPI_FLASH_STATUS_WIP_MASK) == 0)
+    {
+      status = SPI_FLASH_OK;
+      break;
+    }
+    CSR_READ(CSR_MCYCLE, now);
+  } while (now - start < timeout);
+  spi_device_end(flash->dev);
+  return status;
+}
+
+/**
+ * @brief Read `length` bytes starting at `addr` with the Fast Read command. The Chip Select line
+ * stays asserted for the whole read.
+ *
+ * @param flash Pointer to the SpiFlash
+ * @param addr Address of the first byte to read
+ * @param dst Where the bytes read are stored
+ * @param length Number of bytes to read
+ * @return enum SpiFlashStatus
+ */
+static inline enum SpiFlashStatus spi_flash_read(SpiFlash *flash, uint32_t addr, uint8_t *dst,
+                                                 size_t length)
+{
+  if (addr + length > flash->capacity || addr + length < addr)
+    return SPI_FLASH_INVALID_ARGUMENT;
+  spi_flash_command(flash, SPI_FLASH_CMD_FAST_READ, addr, 1, NULL, dst, length);
+  return SPI_FLASH_OK;
+}
+
+/**
+ * @brief Program `length` bytes starting at `addr`. The data is split at page boundaries and each
+ * page program is awaited before the next one is started. The area must have been erased.
+ *
+ * @param flash Pointer to the SpiFlash
+ * @param addr Address of the first byte to program
+ * @param data Pointer to the bytes to program
+ * @param length Number of bytes to program
+ * @return enum SpiFlashStatus
+ */
+static inline enum SpiFlashStatus spi_flash_write(SpiFlash *flash, uint32_t addr,
+                                                  const uint8_t *data, size_t length)
+{
+  if (addr + length > flash->capacity || addr + length < addr)
+    return SPI_FLASH_INVALID_ARGUMENT;
+  while (length > 0)
+  {
+    size_t chunk = SPI_FLASH_PAGE_SIZE - (addr & (SPI_FLASH_PAGE_SIZE - 1));
+    if (chunk > length)
+      chunk = length;
+    spi_flash_simple_command(flash, SPI_FLASH_CMD_WRITE_ENABLE);
+    spi_flash_command(flash, SPI_FLASH_CMD_PAGE_PROGRAM, addr, 0, data, NULL, chunk);
+    enum SpiFlashStatus status = spi_flash_wait_ready(flash, SPI_FLASH_PROGRAM_TIMEOUT_MS);
+    if (status != SPI_FLASH_OK)
+      return status;
+    addr += chunk;
+    data += chunk;
+    length -= chunk;
+  }
+  return SPI_FLASH_OK;
+}
+
+/**
+ * @brief Erase `length` bytes starting at `addr`, both multiple of 4 KB. The largest erase
+ * command supported by the flash that fits the remaining area and its alignment is used at each
+ * step, which minimizes the total erase time.
+ *
+ * @param flash Pointer to the SpiFlash
+ * @param addr Address of the first byte to erase, aligned to 4 KB
+ * @param length Number of bytes to erase, multiple of 4 KB
+ * @return enum SpiFlashStatus
+ */
+static inline enum SpiFlashStatus spi_flash_erase(SpiFlash *flash, uint32_t addr, size_t length)
+{
+  if (((addr | length) & 0xfff) != 0 || addr + length > flash->capacity || addr + length < addr)
+    return SPI_FLASH_INVALID_ARGUMENT;
+  while (length > 0)
+  {
+    // Fall back to the next smaller erase size when the largest is not supported, not aligned or
+    // would go past the end of the area. 4 KB erases are always possible.
+    uint32_t size = SPI_FLASH_ERASE_64K;
+    while (size != SPI_FLASH_ERASE_4K &&
+           (flash->erase_opcode[size] == 0 || (addr & (spi_flash_erase_bytes[size] - 1)) != 0 ||
+            length < spi_flash_erase_bytes[size]))
+      size--;
+    uint32_t bytes = spi_flash_erase_bytes[size];
+    spi_flash_simple_command(flash, SPI_FLASH_CMD_WRITE_ENABLE);
+    spi_flash_command(flash, flash->erase_opcode[size], addr, 0, NULL, NULL, 0);
+    enum SpiFlashStatus status = spi_flash_wait_ready(flash, SPI_FLASH_ERASE_TIMEOUT_MS);
+    if (status != SPI_FLASH_OK)
+      return status;
+    addr += bytes;
+    length -= bytes;
+  }
+  return SPI_FLASH_OK;
+}
+
+#endif // __LIBSTEEL_SPI_FLASH__
@@ -0,0 +1,254 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_TIMEBASE__
+#define __LIBSTEEL_TIMEBASE__
+
+#include "globals.h"
+#include "mtimer.h"
+
+/* Monotonic time on top of the MTimer. One tick is one period of the system clock, since MTIME is
+ * incremented at every rising edge of `clock`. At 64 bits the counter does not wrap in practice
+ * (more than 500 years at 1 GHz), so ticks and deadlines are compared directly.
+ *
+ * Conversions between ticks and microseconds/nanoseconds use scale factors computed once by
+ * timebase_init(). Each factor is a 32.32 fixed-point number applied with multiplies and shifts
+ * only: RV32I has no multiply or divide instructions, and a 64-bit software division costs many
+ * times more than the three 32x32-bit software multiplications used instead. The factors are
+ * rounded to nearest, so a converted value is within one unit of the exact result plus 2^-33 units
+ * per unit of input (at most 21 us per hour of ticks converted at 50 MHz).
+ *
+ * Example usage:
+ * ```
+ * Timebase tb;
+ * timebase_init(&tb, mtimer, 50000000);
+ * Deadline d = deadline_after_us(&tb, 250);
+ * while (!deadline_expired(&tb, d))
+ *   ;
+ * ```
+ */
+
+// Unsigned 32.32 fixed-point scale factor used to convert between time units
+typedef struct
+{
+  // Integer part of the factor
+  uint32_t whole;
+  // Fractional part of the factor, in units of 2^-32
+  uint32_t frac;
+} TimeScale;
+
+// Struct holding the monotonic timebase of the system
+typedef struct
+{
+  // Pointer to the MTimerController
+  MTimerController *mtimer;
+  // Frequency of the system clock (and of MTIME) in Hz
+  uint32_t clock_hz;
+  // Factor converting microseconds to ticks
+  TimeScale ticks_per_us;
+  // Factor converting nanoseconds to ticks
+  TimeScale ticks_per_ns;
+  // Factor converting ticks to microseconds
+  TimeScale us_per_tick;
+  // Factor converting ticks to nanoseconds
+  TimeScale ns_per_tick;
+} Timebase;
+
+// A point in time, in ticks, after which something is due
+typedef struct
+{
+  // Value of MTIME at which the deadline expires
+  uint64_t ticks;
+} Deadline;
+
+/**
+ * @brief Compute `numerator / denominator` as a 32.32 fixed-point factor, rounded to nearest. This
+ * divides, so it is meant to be called once at initialization only.
+ *
+ * @param numerator The numerator
+ * @param denominator The denominator, not zero
+ * @return TimeScale
+ */
+static inline TimeScale time_scale(uint32_t numerator, uint32_t denominator)
+{
+  TimeScale scale;
+  scale.whole = numerator / denominator;
+  uint32_t remainder = numerator % denominator;
+  scale.frac = (((uint64_t)remainder << 32) + (denominator >> 1)) / denominator;
+  return scale;
+}
+
+/**
+ * @brief Multiply `value` by a 32.32 fixed-point factor, discarding the fractional part of the
+ * result. The 96-bit product is built from 32x32-bit multiplies, without any division.
+ *
+ * @param value The value to scale
+ * @param scale The factor
+ * @return uint64_t
+ */
+static inline uint64_t time_scale_apply(uint64_t value, TimeScale scale)
+{
+  uint32_t lo = (uint32_t)value;
+  uint32_t hi = (uint32_t)(value >> 32);
+  uint64_t result = value * scale.whole;
+  result += (uint64_t)hi * scale.frac;
+  result += ((uint64_t)lo * scale.frac) >> 32;
+  return result;
+}
+
+/**
+ * @brief Initialize the timebase and enable MTIME counting. The current value of MTIME is kept.
+ *
+ * @param tb Pointer to the Timebase
+ * @param mtimer Pointer to the MTimerController
+ * @param clock_hz Frequency of the system clock in Hz
+ */
+static inline void timebase_init(Timebase *tb, MTimerController *mtimer, uint32_t clock_hz)
+{
+  tb->mtimer = mtimer;
+  tb->clock_hz = clock_hz;
+  tb->ticks_per_us = time_scale(clock_hz, 1000000);
+  tb->ticks_per_ns = time_scale(clock_hz, 1000000000);
+  tb->us_per_tick = time_scale(1000000, clock_hz);
+  tb->ns_per_tick = time_scale(1000000000, clock_hz);
+  mtimer_enable(mtimer);
+}
+
+/**
+ * @brief Return the current value of MTIME, in ticks.
+ *
+ * @param tb Pointer to the Timebase
+ * @return uint64_t
+ */
+static inline uint64_t now_ticks(const Timebase *tb)
+{
+  return mtimer_get_counter(tb->mtimer);
+}
+
+/**
+ * @brief Convert a number of ticks to microseconds, rounding down.
+ *
+ * @param tb Pointer to the Timebase
+ * @param ticks Number of ticks
+ * @return uint64_t
+ */
+static inline uint64_t ticks_to_us(const Timebase *tb, uint64_t ticks)
+{
+  return time_scale_apply(ticks, tb->us_per_tick);
+}
+
+/**
+ * @brief Convert a number of ticks to nanoseconds, rounding down.
+ *
+ * @param tb Pointer to the Timebase
+ * @param ticks Number of ticks
+ * @return uint64_t
+ */
+static inline uint64_t ticks_to_ns(const Timebase *tb, uint64_t ticks)
+{
+  return time_scale_apply(ticks, tb->ns_per_tick);
+}
+
+/**
+ * @brief Convert a number of microseconds to ticks, rounding down.
+ *
+ * @param tb Pointer to the Timebase
+ * @param us Number of microseconds
+ * @return uint64_t
+ */
+static inline uint64_t us_to_ticks(const Timebase *tb, uint64_t us)
+{
+  return time_scale_apply(us, tb->ticks_per_us);
+}
+
+/**
+ * @brief Convert a number of nanoseconds to ticks, rounding down.
+ *
+ * @param tb Pointer to the Timebase
+ * @param ns Number of nanoseconds
+ * @return uint64_t
+ */
+static inline uint64_t ns_to_ticks(const Timebase *tb, uint64_t ns)
+{
+  return time_scale_apply(ns, tb->ticks_per_ns);
+}
+
+/**
+ * @brief Return the time elapsed since MTIME was last cleared, in microseconds.
+ *
+ * @param tb Pointer to the Timebase
+ * @return uint64_t
+ */
+static inline uint64_t now_us(const Timebase *tb)
+{
+  return ticks_to_us(tb, now_ticks(tb));
+}
+
+/**
+ * @brief Return a deadline `ticks` ticks from now.
+ *
+ * @param tb Pointer to the Timebase
+ * @param ticks Number of ticks
+ * @return Deadline
+ */
+static inline Deadline deadline_after_ticks(const Timebase *tb, uint64_t ticks)
+{
+  Deadline d = {now_ticks(tb) + ticks};
+  return d;
+}
+
+/**
+ * @brief Return a deadline `us` microseconds from now.
+ *
+ * @param tb Pointer to the Timebase
+ * @param us Number of microseconds
+ * @return Deadline
+ */
+static inline Deadline deadline_after_us(const Timebase *tb, uint64_t us)
+{
+  return deadline_after_ticks(tb, us_to_ticks(tb, us));
+}
+
+/**
+ * @brief Return a deadline `ns` nanoseconds from now.
+ *
+ * @param tb Pointer to the Timebase
+ * @param ns Number of nanoseconds
+ * @return Deadline
+ */
+static inline Deadline deadline_after_ns(const Timebase *tb, uint64_t ns)
+{
+  return deadline_after_ticks(tb, ns_to_ticks(tb, ns));
+}
+
+/**
+ * @brief Return true if the deadline has passed.
+ *
+ * @param tb Pointer to the Timebase
+ * @param d The deadline
+ * @return true
+ * @return false
+ */
+static inline bool deadline_expired(const Timebase *tb, Deadline d)
+{
+  return now_ticks(tb) >= d.ticks;
+}
+
+/**
+ * @brief Return the number of ticks left until the deadline, or 0 if it has passed.
+ *
+ * @param tb Pointer to the Timebase
+ * @param d The deadline
+ * @return uint64_t
+ */
+static inline uint64_t deadline_remaining_ticks(const Timebase *tb, Deadline d)
+{
+  uint64_t now = now_ticks(tb);
+  return now >= d.ticks ? 0 : d.ticks - now;
+}
+
+#endif // __LIBSTEEL_TIMEBASE__
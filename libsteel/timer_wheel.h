@@ -0,0 +1,514 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_TIMER_WHEEL__
+#define __LIBSTEEL_TIMER_WHEEL__
+
+#include "csr.h"
+#include "globals.h"
+#include "mtimer.h"
+#include "timebase.h"
+
+/* Software timers multiplexed onto the single MTIMECMP register of the MTimer.
+ *
+ * Timers are kept in a hierarchical timer wheel of TIMER_WHEEL_LEVELS levels with
+ * TIMER_WHEEL_SLOTS slots each. Time is divided into slots of 2^resolution_shift ticks; level 0
+ * holds timers expiring in the next 32 slots, level 1 in the next 32 x 32 slots, and so on. Timers
+ * further away than the top level are parked in its last slot and moved down when it is reached.
+ * Each slot is an intrusive doubly-linked list, so starting and cancelling a timer are O(1), and a
+ * bitmap of non-empty slots per level lets the wheel skip empty slots with ctz32 instead of
+ * walking them one by one.
+ *
+ * MTIMECMP is always programmed to the start of the slot holding the earliest timer (or to the
+ * maximum value when no timer is pending), so the interrupt only fires when a timer is due. The
+ * only exception are timers further away than the range of the wheel (2^20 slots), which cost one
+ * extra interrupt each time the range elapses while they are parked. A timer fires at most
+ * 2^resolution_shift - 1 ticks after its expiry time, plus interrupt latency. The actual lateness
+ * of every timer fired is recorded in the wheel statistics. Periodic timers must have a period of
+ * at least one slot; shorter periods are rejected by timer_wheel_start.
+ *
+ * Callbacks run from `timer_wheel_service`, with interrupts disabled when it is called from the
+ * MTimer interrupt handler. They can start and cancel any timer, including their own.
+ *
+ * Example usage:
+ * ```
+ * static Timebase tb;
+ * static TimerWheel wheel;
+ * static SoftTimer blink;
+ *
+ * static void on_blink(SoftTimer *timer, void *context)
+ * {
+ *   gpio_toggle(gpio, 0);
+ * }
+ *
+ * __IRQ_M(mtimer_irq_handler)
+ * {
+ *   timer_wheel_service(&wheel);
+ * }
+ *
+ * void main(void)
+ * {
+ *   timebase_init(&tb, mtimer, 50000000);
+ *   timer_wheel_init(&wheel, &tb, 10);
+ *   soft_timer_init(&blink, on_blink, NULL);
+ *   timer_wheel_start_after(&wheel, &blink, us_to_ticks(&tb, 500000), us_to_ticks(&tb, 500000));
+ *   csr_global_enable_irq();
+ *   CSR_SET(CSR_MIE, MIP_MIE_MASK_MTI);
+ * }
+ * ```
+ */
+
+// Number of levels of the timer wheel
+#define TIMER_WHEEL_LEVELS 4U
+
+// Number of bits of the slot index at each level
+#define TIMER_WHEEL_SLOT_BITS 5U
+
+// Number of slots at each level. Must match the width of the slot bitmaps (32 bits).
+#define TIMER_WHEEL_SLOTS (1U << TIMER_WHEEL_SLOT_BITS)
+
+typedef struct SoftTimer SoftTimer;
+
+// Function called when a software timer expires
+typedef void (*SoftTimerCallback)(SoftTimer *timer, void *context);
+
+// Struct holding a software timer. It must stay in memory while it is pending.
+struct SoftTimer
+{
+  // Next timer in the same slot
+  SoftTimer *next;
+  // Pointer to the pointer referencing this timer in its slot, or NULL if the timer is not pending
+  SoftTimer **pprev;
+  // Time at which the timer expires, in ticks
+  uint64_t expiry;
+  // Slot (in units of 2^resolution_shift ticks) in which the timer expires
+  uint64_t slot;
+  // Period of the timer in ticks, or 0 for a one-shot timer
+  uint64_t period;
+  // Function called when the timer expires
+  SoftTimerCallback callback;
+  // Argument passed to the callback
+  void *context;
+  // Level of the wheel holding the timer
+  uint8_t level;
+  // Index of the slot holding the timer within its level
+  uint8_t index;
+};
+
+// Struct holding the state of a timer wheel
+typedef struct
+{
+  // Pointer to the Timebase providing the MTimer and the current time
+  const Timebase *tb;
+  // Each slot lasts 2^resolution_shift ticks
+  uint32_t resolution_shift;
+  // First slot not yet processed
+  uint64_t current;
+  // Slot currently programmed in MTIMECMP, or UINT64_MAX if none
+  uint64_t programmed;
+  // Bitmap of the non-empty slots of each level
+  uint32_t occupied[TIMER_WHEEL_LEVELS];
+  // Lists of timers of each slot
+  SoftTimer *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  // Number of timers fired since the last statistics reset
+  uint32_t fired;
+  // Lateness of the last timer fired, in ticks
+  uint32_t last_lateness;
+  // Largest lateness since the last statistics reset, in ticks
+  uint32_t max_lateness;
+  // Sum of the lateness of all timers fired since the last statistics reset, in ticks
+  uint64_t total_lateness;
+} TimerWheel;
+
+/**
+ * @brief Initialize a software timer. The timer is not pending until it is started.
+ *
+ * @param timer Pointer to the SoftTimer
+ * @param callback Function called when the timer expires
+ * @param context Argument passed to the callback
+ */
+static inline void soft_timer_init(SoftTimer *timer, SoftTimerCallback callback, void *context)
+{
+  timer->next = NULL;
+  timer->pprev = NULL;
+  timer->expiry = 0;
+  timer->slot = 0;
+  timer->period = 0;
+  timer->callback = callback;
+  timer->context = context;
+  timer->level = 0;
+  timer->index = 0;
+}
+
+/**
+ * @brief Return true if the timer has been started and has not expired or been cancelled yet.
+ *
+ * @param timer Pointer to the SoftTimer
+ * @return true
+ * @return false
+ */
+static inline bool soft_timer_pending(const SoftTimer *timer)
+{
+  return timer->pprev != NULL;
+}
+
+/**
+ * @brief Initialize a timer wheel with no pending timers and set MTIMECMP to its maximum value.
+ *
+ * @param tw Pointer to the TimerWheel
+ * @param tb Pointer to an initialized Timebase
+ * @param resolution_shift Each slot lasts 2^resolution_shift ticks. Larger values extend the range
+ * of the wheel and reduce work done when timers cascade down, at the cost of firing later.
+ */
+static inline void timer_wheel_init(TimerWheel *tw, const Timebase *tb, uint32_t resolution_shift)
+{
+  tw->tb = tb;
+  tw->resolution_shift = resolution_shift;
+  tw->current = now_ticks(tb) >> resolution_shift;
+  tw->programmed = UINT64_MAX;
+  for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++)
+  {
+    tw->occupied[level] = 0;
+    for (uint32_t i = 0; i < TIMER_WHEEL_SLOTS; i++)
+      tw->slots[level][i] = NULL;
+  }
+  tw->fired = 0;
+  tw->last_lateness = 0;
+  tw->max_lateness = 0;
+  tw->total_lateness = 0;
+  mtimer_set_compare(tb->mtimer, UINT64_MAX);
+}
+
+/**
+ * @brief Rotate a slot bitmap right, so that slot `index` moves to bit 0.
+ *
+ * @param bitmap The bitmap
+ * @param index The slot index
+ * @return uint32_t
+ */
+static inline uint32_t timer_wheel_rotate(uint32_t bitmap, uint32_t index)
+{
+  index &= TIMER_WHEEL_SLOTS - 1;
+  return index == 0 ? bitmap : (bitmap >> index) | (bitmap << (TIMER_WHEEL_SLOTS - index));
+}
+
+/**
+ * @brief Return the first block of `2^(5 * level)` slots of a level that the wheel has not entered
+ * yet. Level 0 blocks are single slots and include the current one.
+ *
+ * @param tw Pointer to the TimerWheel
+ * @param level The level
+ * @return uint64_t
+ */
+static inline uint64_t timer_wheel_first_block(const TimerWheel *tw, uint32_t level)
+{
+  uint32_t shift = level * TIMER_WHEEL_SLOT_BITS;
+  return (tw->current + ((uint64_t)1 << shift) - 1) >> shift;
+}
+
+/**
+ * @brief Link a timer into the slot matching its expiry slot. Interrupts must be disabled.
+ *
+ * @param tw Pointer to the TimerWheel
+ * @param timer Pointer to the SoftTimer
+ */
+static inline void timer_wheel_link(TimerWheel *tw, SoftTimer *timer)
+{
+  uint64_t slot = timer->slot < tw->current ? tw->current : timer->slot;
+  uint32_t level = 0;
+  uint64_t block = slot;
+  if (slot - tw->current >= TIMER_WHEEL_SLOTS)
+  {
+    for (level = 1; level < TIMER_WHEEL_LEVELS; level++)
+    {
+      uint32_t shift = level * TIMER_WHEEL_SLOT_BITS;
+      block = slot >> shift;
+      if (block - (tw->current >> shift) < TIMER_WHEEL_SLOTS)
+        break;
+    }
+    // Beyond the range of the wheel: park the timer in the last slot of the top level
+    if (level == TIMER_WHEEL_LEVELS)
+    {
+      level = TIMER_WHEEL_LEVELS - 1;
+      block = (tw->current >> (level * TIMER_WHEEL_SLOT_BITS)) + TIMER_WHEEL_SLOTS - 1;
+    }
+  }
+  uint32_t index = block & (TIMER_WHEEL_SLOTS - 1);
+  SoftTimer **head = &tw->slots[level][index];
+  timer->level = level;
+  timer->index = index;
+  timer->next = *head;
+  if (*head != NULL)
+    (*head)->pprev = &timer->next;
+  timer->pprev = head;
+  *head = timer;
+  tw->occupied[level] |= 0x1U << index;
+}
+
+/**
+ * @brief Unlink a pending timer from its slot. Interrupts must be disabled.
+ *
+ * @param tw Pointer to the TimerWheel
+ * @param timer Pointer to the SoftTimer
+ */
+static inline void timer_wheel_unlink(TimerWheel *tw, SoftTimer *timer)
+{
+  *timer->pprev = timer->next;
+  if (timer->next != NULL)
+    timer->next->pprev = timer->pprev;
+  if (tw->slots[timer->level][timer->index] == NULL)
+    tw->occupied[timer->level] &= ~(0x1U << timer->index);
+  timer->next = NULL;
+  timer->pprev = NULL;
+}
+
+/**
+ * @brief Return the earliest expiry slot of all pending timers, or UINT64_MAX if there are none.
+ * Only the first non-empty slot of each level is searched.
+ *
+ * @param tw Pointer to the TimerWheel
+ * @return uint64_t
+ */
+static inline uint64_t timer_wheel_earliest(const TimerWheel *tw)
+{
+  uint64_t earliest = UINT64_MAX;
+  for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++)
+  {
+    if (tw->occupied[level] == 0)
+      continue;
+    uint32_t shift = level * TIMER_WHEEL_SLOT_BITS;
+    uint64_t first = timer_wheel_first_block(tw, level);
+    uint64_t block = first + ctz32(timer_wheel_rotate(tw->occupied[level], first));
+    for (SoftTimer *t = tw->slots[level][block & (TIMER_WHEEL_SLOTS - 1)]; t != NULL; t = t->next)
+    {
+      // Parked and overdue timers are due when their block is entered
+      uint64_t slot = (t->slot >> shift) == block ? t->slot : block << shift;
+      if (slot < earliest)
+        earliest = slot;
+    }
+  }
+  return earliest;
+}
+
+/**
+ * @brief Return true if MTIMECMP may have been programmed for a pending timer, so that it must be
+ * reprogrammed when the timer is removed. Timers of the top level are always considered: a parked
+ * timer is due at the start of its block, before its expiry slot.
+ *
+ * @param tw Pointer to the TimerWheel
+ * @param timer Pointer to a pending SoftTimer
+ * @return true
+ * @return false
+ */
+static inline bool timer_wheel_is_programmed(const TimerWheel *tw, const SoftTimer *timer)
+{
+  return timer->slot <= tw->programmed || timer->level == TIMER_WHEEL_LEVELS - 1;
+}
+
+/**
+ * @brief Program MTIMECMP to the start of the earliest expiry slot. Interrupts must be disabled.
+ *
+ * @param tw Pointer to the TimerWheel
+ */
+static inline void timer_wheel_program(TimerWheel *tw)
+{
+  uint64_t earliest = timer_wheel_earliest(tw);
+  tw->programmed = earliest;
+  mtimer_set_compare(tw->tb->mtimer,
+                     earliest == UINT64_MAX ? UINT64_MAX : earliest << tw->resolution_shift);
+}
+
+/**
+ * @brief Start (or restart) a timer to expire at an absolute time. Return false, leaving the timer
+ * unchanged, if `period` is non-zero but shorter than one slot (2^resolution_shift ticks): such a
+ * timer would be due again before the end of the slot being serviced, and fire in a loop.
+ *
+ * @param tw Pointer to the TimerWheel
+ * @param timer Pointer to an initialized SoftTimer
+ * @param expiry Time at which the timer expires, in ticks
+ * @param period Period in ticks after which the timer is started again once it expires, or 0 for
+ * a one-shot timer
+ * @return true
+ * @return false
+ */
+static inline bool timer_wheel_start(TimerWheel *tw, SoftTimer *timer, uint64_t expiry,
+                                     uint64_t period)
+{
+  if (period != 0 && period < ((uint64_t)1 << tw->resolution_shift))
+    return false;
+  uint32_t mstatus = csr_global_disable_irq_save();
+  bool was_earliest = false;
+  if (timer->pprev != NULL)
+  {
+    was_earliest = timer_wheel_is_programmed(tw, timer);
+    timer_wheel_unlink(tw, timer);
+  }
+  timer->expiry = expiry;
+  timer->period = period;
+  // Round up, so the slot is never entered before the expiry time
+  timer->slot = (expiry + ((uint64_t)1 << tw->resolution_shift) - 1) >> tw->resolution_shift;
+  timer_wheel_link(tw, timer);
+  if (was_earliest || timer->slot < tw->programmed)
+    timer_wheel_program(tw);
+  csr_global_restore_irq(mstatus);
+  return true;
+}
+
+/**
+ * @brief Start (or restart) a timer to expire `delay` ticks from now. Return false under the same
+ * condition as `timer_wheel_start`.
+ *
+ * @param tw Pointer to the TimerWheel
+ * @param timer Pointer to an initialized SoftTimer
+ * @param delay Number of ticks until the timer expires
+ * @param period Period in ticks after which the timer is started again once it expires, or 0 for
+ * a one-shot timer
+ * @return true
+ * @return false
+ */
+static inline bool timer_wheel_start_after(TimerWheel *tw, SoftTimer *timer, uint64_t delay,
+                                           uint64_t period)
+{
+  return timer_wheel_start(tw, timer, now_ticks(tw->tb) + delay, period);
+}
+
+/**
+ * @brief Cancel a timer. Return true if it was pending.
+ *
+ * MTIMECMP is only reprogrammed if the timer was the earliest one or in the top level, which takes
+ * a search of the first non-empty slot of each level; other cancellations are O(1).
+ *
+ * @param tw Pointer to the TimerWheel
+ * @param timer Pointer to the SoftTimer
+ * @return true
+ * @return false
+ */
+static inline bool timer_wheel_cancel(TimerWheel *tw, SoftTimer *timer)
+{
+  uint32_t mstatus = csr_global_disable_irq_save();
+  bool pending = timer->pprev != NULL;
+  if (pending)
+  {
+    bool programmed = timer_wheel_is_programmed(tw, timer);
+    timer_wheel_unlink(tw, timer);
+    if (programmed)
+      timer_wheel_program(tw);
+  }
+  csr_global_restore_irq(mstatus);
+  return pending;
+}
+
+/**
+ * @brief Return the next slot, not after `target`, where the wheel has work to do: either a
+ * non-empty level 0 slot, or the start of a block whose higher-level slot must cascade down.
+ * Return UINT64_MAX if there is none.
+ *
+ * @param tw Pointer to the TimerWheel
+ * @param target Last slot to consider
+ * @return uint64_t
+ */
+static inline uint64_t timer_wheel_next_event(const TimerWheel *tw, uint64_t target)
+{
+  uint64_t next = UINT64_MAX;
+  for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++)
+  {
+    if (tw->occupied[level] == 0)
+      continue;
+    uint64_t first = timer_wheel_first_block(tw, level);
+    uint32_t offset = ctz32(timer_wheel_rotate(tw->occupied[level], first));
+    uint64_t slot = (first + offset) << (level * TIMER_WHEEL_SLOT_BITS);
+    if (slot < next)
+      next = slot;
+  }
+  return next <= target ? next : UINT64_MAX;
+}
+
+/**
+ * @brief Fire the timers due and reprogram MTIMECMP for the next one. Call it from the MTimer
+ * interrupt handler.
+ *
+ * @param tw Pointer to the TimerWheel
+ */
+static inline void timer_wheel_service(TimerWheel *tw)
+{
+  uint32_t mstatus = csr_global_disable_irq_save();
+  uint64_t target = now_ticks(tw->tb) >> tw->resolution_shift;
+  uint64_t slot;
+  while ((slot = timer_wheel_next_event(tw, target)) != UINT64_MAX)
+  {
+    tw->current = slot;
+    // Move the timers of higher-level slots whose block starts here down the wheel
+    for (uint32_t level = TIMER_WHEEL_LEVELS - 1; level > 0; level--)
+    {
+      uint32_t shift = level * TIMER_WHEEL_SLOT_BITS;
+      if ((slot & (((uint64_t)1 << shift) - 1)) != 0)
+        continue;
+      uint32_t index = (slot >> shift) & (TIMER_WHEEL_SLOTS - 1);
+      SoftTimer *list = tw->slots[level][index];
+      tw->slots[level][index] = NULL;
+      tw->occupied[level] &= ~(0x1U << index);
+      while (list != NULL)
+      {
+        SoftTimer *timer = list;
+        list = timer->next;
+        timer_wheel_link(tw, timer);
+      }
+    }
+    // Detach the expired list, so callbacks can cancel timers in it
+    uint32_t index = slot & (TIMER_WHEEL_SLOTS - 1);
+    SoftTimer *expired = tw->slots[0][index];
+    tw->slots[0][index] = NULL;
+    tw->occupied[0] &= ~(0x1U << index);
+    if (expired != NULL)
+      expired->pprev = &expired;
+    tw->current = slot + 1;
+    while (expired != NULL)
+    {
+      SoftTimer *timer = expired;
+      expired = timer->next;
+      if (expired != NULL)
+        expired->pprev = &expired;
+      timer->next = NULL;
+      timer->pprev = NULL;
+      uint64_t lateness = now_ticks(tw->tb) - timer->expiry;
+      tw->last_lateness = lateness > UINT32_MAX ? UINT32_MAX : (uint32_t)lateness;
+      if (tw->last_lateness > tw->max_lateness)
+        tw->max_lateness = tw->last_lateness;
+      tw->total_lateness += lateness;
+      tw->fired++;
+      if (timer->period != 0)
+      {
+        timer->expiry += timer->period;
+        timer->slot = (timer->expiry + ((uint64_t)1 << tw->resolution_shift) - 1) >>
+                      tw->resolution_shift;
+        timer_wheel_link(tw, timer);
+      }
+      timer->callback(timer, timer->context);
+    }
+  }
+  if (tw->current <= target)
+    tw->current = target + 1;
+  timer_wheel_program(tw);
+  csr_global_restore_irq(mstatus);
+}
+
+/**
+ * @brief Reset the lateness statistics of the timer wheel.
+ *
+ * @param tw Pointer to the TimerWheel
+ */
+static inline void timer_wheel_reset_stats(TimerWheel *tw)
+{
+  uint32_t mstatus = csr_global_disable_irq_save();
+  tw->fired = 0;
+  tw->last_lateness = 0;
+  tw->max_lateness = 0;
+  tw->total_lateness = 0;
+  csr_global_restore_irq(mstatus);
+}
+
+#endif // __LIBSTEEL_TIMER_WHEEL__
@@ -8,6 +8,7 @@
 #ifndef __LIBSTEEL_UART__
 #define __LIBSTEEL_UART__
 
+#include "csr.h"
 #include "globals.h"
 
 // Struct providing access to RISC-V Steel UART Controller registers
@@ -90,4 +91,418 @@ static inline bool uart_data_received(UartController *uart)
   return uart->RXSTATUS == 1;
 }
 
+/**
+ * @brief Send `length` bytes over the UART device. Unlike `uart_write_string`, the data may contain
+ * zeros. Register READY is polled once per byte, right before the byte is written to WDATA.
+ *
+ * @param uart Pointer to the UartController
+ * @param data Pointer to the bytes to be sent
+ * @param length Number of bytes to be sent
+ */
+static inline void uart_write_buffer(UartController *uart, const uint8_t *data, size_t length)
+{
+  const uint8_t *end = data + length;
+  while (data != end)
+  {
+    while (!uart_ready_to_send(uart))
+      ;
+    uart->WDATA = *data++;
+  }
+}
+
+// Struct describing a segment of data sent by `uart_write_segments`
+typedef struct
+{
+  // Pointer to the first byte of the segment
+  const uint8_t *data;
+  // Number of bytes in the segment
+  size_t length;
+} UartSegment;
+
+/**
+ * @brief Send a list of data segments over the UART device, one after the other, as if they were a
+ * single buffer. Useful to send a header, a payload and a trailer without copying them together.
+ *
+ * Example usage:
+ * ```
+ * UartSegment frame[] = {{header, sizeof(header)}, {payload, payload_len}, {crc, 2}};
+ * uart_write_segments(uart, frame, NUMBER_OF(frame));
+ * ```
+ *
+ * @param uart Pointer to the UartController
+ * @param segments Array of segments to be sent
+ * @param count Number of segments in the array
+ */
+static inline void uart_write_segments(UartController *uart, const UartSegment *segments,
+                                       size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+    uart_write_buffer(uart, segments[i].data, segments[i].length);
+}
+
+// Enumeration with the policies applied when data is written to a full UART TX buffer
+enum UartOverflowPolicy
+{
+  // Discard the new data and count it as dropped
+  UART_OVERFLOW_DROP = 0,
+  // Wait until there is room for the new data, draining the buffer by polling if needed
+  UART_OVERFLOW_BLOCK = 1,
+  // Discard the oldest data still in the buffer to make room for the new data
+  UART_OVERFLOW_OVERWRITE = 2
+};
+
+// Struct holding the state of a UART TX ring buffer
+typedef struct
+{
+  // Pointer to the UartController drained by this buffer
+  UartController *uart;
+  // Storage area provided by the user. Its size must be a power of two.
+  uint8_t *data;
+  // Size of the storage area minus one, used to wrap the indexes around
+  uint32_t mask;
+  // Policy applied when data is written to a full buffer
+  enum UartOverflowPolicy policy;
+  // Free-running write index, only changed by the producer
+  volatile uint32_t head;
+  // Free-running read index, only changed by the consumer (the interrupt handler)
+  volatile uint32_t tail;
+  // Highest number of bytes held by the buffer since the last statistics reset
+  uint32_t high_water_mark;
+  // Number of bytes discarded with the UART_OVERFLOW_DROP or UART_OVERFLOW_OVERWRITE policies
+  uint32_t dropped;
+} UartTxBuffer;
+
+/**
+ * @brief Initialize a UART TX ring buffer. Bytes written to the buffer are sent by calling
+ * `uart_tx_buffer_service`, usually from an interrupt handler declared with `__IRQ_M`. Return
+ * false, leaving the buffer untouched, if `size` is not a power of two.
+ *
+ * Example usage:
+ * ```
+ * static uint8_t tx_storage[256];
+ * static UartTxBuffer txb;
+ *
+ * __IRQ_M(mtimer_irq_handler)
+ * {
+ *   uart_tx_buffer_service(&txb);
+ *   // ...
+ * }
+ *
+ * uart_tx_buffer_init(&txb, uart, tx_storage, sizeof(tx_storage), UART_OVERFLOW_DROP);
+ * ```
+ *
+ * @param txb Pointer to the UartTxBuffer
+ * @param uart Pointer to the UartController
+ * @param storage Storage area for the buffered bytes
+ * @param size Size of the storage area in bytes. Must be a power of two.
+ * @param policy Policy applied when data is written to a full buffer
+ * @return true
+ * @return false
+ */
+static inline bool uart_tx_buffer_init(UartTxBuffer *txb, UartController *uart, uint8_t *storage,
+                                       const uint32_t size, enum UartOverflowPolicy policy)
+{
+  if (size == 0 || (size & (size - 1)) != 0)
+    return false;
+  txb->uart = uart;
+  txb->data = storage;
+  txb->mask = size - 1;
+  txb->policy = policy;
+  txb->head = 0;
+  txb->tail = 0;
+  txb->high_water_mark = 0;
+  txb->dropped = 0;
+  return true;
+}
+
+/**
+ * @brief Return the number of bytes waiting in the UART TX buffer.
+ *
+ * @param txb Pointer to the UartTxBuffer
+ * @return uint32_t
+ */
+static inline uint32_t uart_tx_buffer_count(UartTxBuffer *txb)
+{
+  return txb->head - txb->tail;
+}
+
+/**
+ * @brief Return the number of bytes that can be written to the UART TX buffer before it is full.
+ *
+ * @param txb Pointer to the UartTxBuffer
+ * @return uint32_t
+ */
+static inline uint32_t uart_tx_buffer_free(UartTxBuffer *txb)
+{
+  return txb->mask + 1 - uart_tx_buffer_count(txb);
+}
+
+/**
+ * @brief Move bytes from the UART TX buffer to register WDATA for as long as the UART is ready to
+ * send. It never waits, so it is safe to call from an interrupt handler. It must not be called
+ * concurrently from two contexts.
+ *
+ * @param txb Pointer to the UartTxBuffer
+ */
+static inline void uart_tx_buffer_service(UartTxBuffer *txb)
+{
+  uint32_t tail = txb->tail;
+  while (tail != txb->head && uart_ready_to_send(txb->uart))
+  {
+    txb->uart->WDATA = txb->data[tail & txb->mask];
+    tail++;
+    txb->tail = tail;
+  }
+}
+
+/**
+ * @brief Write a byte to the UART TX buffer and return immediately. If the buffer is full, the
+ * overflow policy chosen in `uart_tx_buffer_init` is applied. Return false if the byte was
+ * discarded.
+ *
+ * @param txb Pointer to the UartTxBuffer
+ * @param data A byte as uint8_t
+ * @return true
+ * @return false
+ */
+static inline bool uart_tx_buffer_put(UartTxBuffer *txb, uint8_t data)
+{
+  uint32_t head = txb->head;
+  if (head - txb->tail > txb->mask)
+  {
+    uint32_t mstatus;
+    switch (txb->policy)
+    {
+    case UART_OVERFLOW_BLOCK:
+      // The interrupt handler may not run while we wait (or there may be none), so drain the
+      // buffer here with interrupts disabled to avoid racing with it.
+      while (head - txb->tail > txb->mask)
+      {
+        mstatus = csr_global_disable_irq_save();
+        uart_tx_buffer_service(txb);
+        csr_global_restore_irq(mstatus);
+      }
+      break;
+    case UART_OVERFLOW_OVERWRITE:
+      mstatus = csr_global_disable_irq_save();
+      if (head - txb->tail > txb->mask)
+      {
+        txb->tail = txb->tail + 1;
+        txb->dropped++;
+      }
+      csr_global_restore_irq(mstatus);
+      break;
+    default:
+      txb->dropped++;
+      return false;
+    }
+  }
+  txb->data[head & txb->mask] = data;
+  txb->head = head + 1;
+  if (head + 1 - txb->tail > txb->high_water_mark)
+    txb->high_water_mark = head + 1 - txb->tail;
+  return true;
+}
+
+/**
+ * @brief Write `length` bytes to the UART TX buffer. Return the number of bytes actually written,
+ * which is less than `length` only with the UART_OVERFLOW_DROP policy.
+ *
+ * @param txb Pointer to the UartTxBuffer
+ * @param data Pointer to the bytes to be written
+ * @param length Number of bytes to be written
+ * @return uint32_t
+ */
+static inline uint32_t uart_tx_buffer_write(UartTxBuffer *txb, const uint8_t *data,
+                                            const uint32_t length)
+{
+  uint32_t written = 0;
+  for (uint32_t i = 0; i < length; i++)
+    written += uart_tx_buffer_put(txb, data[i]);
+  return written;
+}
+
+/**
+ * @brief Write a C-string to the UART TX buffer. Return the number of bytes actually written.
+ *
+ * @param txb Pointer to the UartTxBuffer
+ * @param str A null-terminated C-string
+ * @return uint32_t
+ */
+static inline uint32_t uart_tx_buffer_write_string(UartTxBuffer *txb, const char *str)
+{
+  uint32_t written = 0;
+  while (*(str) != '\0')
+  {
+    written += uart_tx_buffer_put(txb, *(str));
+    str++;
+  }
+  return written;
+}
+
+/**
+ * @brief Reset the high-water mark and the dropped bytes counter of the UART TX buffer.
+ *
+ * @param txb Pointer to the UartTxBuffer
+ */
+static inline void uart_tx_buffer_reset_stats(UartTxBuffer *txb)
+{
+  txb->high_water_mark = uart_tx_buffer_count(txb);
+  txb->dropped = 0;
+}
+
+// Struct holding the state of a UART RX ring buffer
+typedef struct
+{
+  // Pointer to the UartController feeding this buffer
+  UartController *uart;
+  // Storage area provided by the user. Its size must be a power of two.
+  uint8_t *data;
+  // Size of the storage area minus one, used to wrap the indexes around
+  uint32_t mask;
+  // Free-running write index, only changed by the producer (the interrupt handler)
+  volatile uint32_t head;
+  // Free-running read index, only changed by the consumer
+  volatile uint32_t tail;
+  // Highest number of bytes held by the buffer since the last statistics reset
+  uint32_t high_water_mark;
+  // Number of received bytes lost because the buffer was full
+  volatile uint32_t overruns;
+} UartRxBuffer;
+
+/**
+ * @brief Initialize a UART RX ring buffer. The buffer is filled by calling
+ * `uart_rx_buffer_service` from the UART interrupt handler. Return false, leaving the buffer
+ * untouched, if `size` is not a power of two.
+ *
+ * Example usage:
+ * ```
+ * static uint8_t rx_storage[128];
+ * static UartRxBuffer rxb;
+ *
+ * __IRQ_M(uart_irq_handler)
+ * {
+ *   uart_rx_buffer_service(&rxb);
+ * }
+ *
+ * uart_rx_buffer_init(&rxb, uart, rx_storage, sizeof(rx_storage));
+ * ```
+ *
+ * @param rxb Pointer to the UartRxBuffer
+ * @param uart Pointer to the UartController
+ * @param storage Storage area for the received bytes
+ * @param size Size of the storage area in bytes. Must be a power of two.
+ * @return true
+ * @return false
+ */
+static inline bool uart_rx_buffer_init(UartRxBuffer *rxb, UartController *uart, uint8_t *storage,
+                                       const uint32_t size)
+{
+  if (size == 0 || (size & (size - 1)) != 0)
+    return false;
+  rxb->uart = uart;
+  rxb->data = storage;
+  rxb->mask = size - 1;
+  rxb->head = 0;
+  rxb->tail = 0;
+  rxb->high_water_mark = 0;
+  rxb->overruns = 0;
+  return true;
+}
+
+/**
+ * @brief Return the number of received bytes waiting in the UART RX buffer.
+ *
+ * @param rxb Pointer to the UartRxBuffer
+ * @return uint32_t
+ */
+static inline uint32_t uart_rx_buffer_count(UartRxBuffer *rxb)
+{
+  return rxb->head - rxb->tail;
+}
+
+/**
+ * @brief Move the byte held in register RDATA to the UART RX buffer if register RXSTATUS reports
+ * new data. Meant to be called from the UART interrupt handler. When the buffer is full the byte
+ * is discarded and counted as an overrun.
+ *
+ * @param rxb Pointer to the UartRxBuffer
+ */
+static inline void uart_rx_buffer_service(UartRxBuffer *rxb)
+{
+  if (!uart_data_received(rxb->uart))
+    return;
+  uint8_t data = uart_read(rxb->uart);
+  uint32_t head = rxb->head;
+  uint32_t count = head - rxb->tail;
+  if (count > rxb->mask)
+  {
+    rxb->overruns = rxb->overruns + 1;
+    return;
+  }
+  rxb->data[head & rxb->mask] = data;
+  rxb->head = head + 1;
+  if (count + 1 > rxb->high_water_mark)
+    rxb->high_water_mark = count + 1;
+}
+
+/**
+ * @brief Copy up to `max` received bytes from the UART RX buffer to `dst` in a single call, and
+ * return the number of bytes copied. It never waits for new data.
+ *
+ * @param rxb Pointer to the UartRxBuffer
+ * @param dst Destination of the bytes read
+ * @param max Maximum number of bytes to read
+ * @return uint32_t
+ */
+static inline uint32_t uart_rx_buffer_read(UartRxBuffer *rxb, uint8_t *dst, const uint32_t max)
+{
+  uint32_t tail = rxb->tail;
+  uint32_t count = rxb->head - tail;
+  if (count > max)
+    count = max;
+  // Copy in at most two contiguous runs: up to the end of the storage, then from its start
+  uint32_t start = tail & rxb->mask;
+  uint32_t first = rxb->mask + 1 - start;
+  if (first > count)
+    first = count;
+  const uint8_t *src = rxb->data + start;
+  for (uint32_t i = 0; i < first; i++)
+    dst[i] = src[i];
+  for (uint32_t i = first; i < count; i++)
+    dst[i] = rxb->data[i - first];
+  rxb->tail = tail + count;
+  return count;
+}
+
+/**
+ * @brief Read a single byte from the UART RX buffer into `data`. Return false if the buffer is
+ * empty.
+ *
+ * @param rxb Pointer to the UartRxBuffer
+ * @param data Destination of the byte read
+ * @return true
+ * @return false
+ */
+static inline bool uart_rx_buffer_get(UartRxBuffer *rxb, uint8_t *data)
+{
+  uint32_t tail = rxb->tail;
+  if (tail == rxb->head)
+    return false;
+  *data = rxb->data[tail & rxb->mask];
+  rxb->tail = tail + 1;
+  return true;
+}
+
+/**
+ * @brief Reset the high-water mark and the overrun counter of the UART RX buffer.
+ *
+ * @param rxb Pointer to the UartRxBuffer
+ */
+static inline void uart_rx_buffer_reset_stats(UartRxBuffer *rxb)
+{
+  rxb->high_water_mark = uart_rx_buffer_count(rxb);
+  rxb->overruns = 0;
+}
+
 #endif // __LIBSTEEL_UART__
@@ -0,0 +1,113 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_HOST_CSR__
+#define __LIBSTEEL_HOST_CSR__
+
+/* Stand-in for csr.h used by the host unit tests. It must be included before any libsteel header.
+ * The CSRs are plain variables, so the drivers can be compiled and run on the build machine and
+ * their peripherals replaced by models operating on ordinary structs. */
+
+#define __LIBSTEEL_CSR__
+
+#include "libsteel/globals.h"
+
+#define CSR_CYCLE 0xC00
+#define CSR_MSTATUS 0x300
+#define CSR_MIE 0x304
+#define CSR_MTVEC 0x305
+#define CSR_MSCRATCH 0x340
+#define CSR_MEPC 0x341
+#define CSR_MCAUSE 0x342
+#define CSR_MIP 0x344
+#define CSR_MCYCLE 0xB00
+
+#define MSTATUS_MIE_OFFSET 3U
+#define MSTATUS_MPIE_OFFSET 7U
+#define MSTATUS_MIE_MASK (1U << MSTATUS_MIE_OFFSET)
+#define MSTATUS_MPIE_MASK (1U << MSTATUS_MPIE_OFFSET)
+#define MIP_MIE_OFFSET_MTI 7U
+#define MIP_MIE_MASK_MTI (1U << MIP_MIE_OFFSET_MTI)
+#define MCAUSE_EXCP_ENVIRONMENT_CALL_FROM_M_MODE 11U
+
+// CSR file of the host model
+static uint32_t host_csr[4096];
+
+// Number of cycles the cycle counters advance on each read, so that busy-wait loops terminate
+static uint32_t host_cycles_per_read = 1;
+
+// Optional hook called on each read of the cycle counters, e.g. to advance a peripheral model
+static void (*host_cycle_hook)(uint32_t cycle);
+
+static inline uint32_t host_csr_read(uint32_t address)
+{
+  if (address == CSR_MCYCLE || address == CSR_CYCLE)
+  {
+    host_csr[CSR_MCYCLE] += host_cycles_per_read;
+    if (host_cycle_hook != NULL)
+      host_cycle_hook(host_csr[CSR_MCYCLE]);
+    return host_csr[CSR_MCYCLE];
+  }
+  return host_csr[address];
+}
+
+#define CSR_READ(csr_address, uint32_var) ((uint32_var) = host_csr_read(csr_address))
+#define CSR_WRITE(csr_address, uint32_value) (host_csr[csr_address] = (uint32_value))
+#define CSR_READ_WRITE(csr_address, uint32_var, uint32_value)                                      \
+  do                                                                                               \
+  {                                                                                                \
+    (uint32_var) = host_csr[csr_address];                                                          \
+    host_csr[csr_address] = (uint32_value);                                                        \
+  } while (0)
+#define CSR_SET(csr_address, bit_mask) (host_csr[csr_address] |= (bit_mask))
+#define CSR_CLEAR(csr_address, bit_mask) (host_csr[csr_address] &= ~(uint32_t)(bit_mask))
+#define CSR_READ_SET(csr_address, uint32_var, bit_mask)                                            \
+  do                                                                                               \
+  {                                                                                                \
+    (uint32_var) = host_csr[csr_address];                                                          \
+    host_csr[csr_address] |= (bit_mask);                                                           \
+  } while (0)
+#define CSR_READ_CLEAR(csr_address, uint32_var, bit_mask)                                          \
+  do                                                                                               \
+  {                                                                                                \
+    (uint32_var) = host_csr[csr_address];                                                          \
+    host_csr[csr_address] &= ~(uint32_t)(bit_mask);                                                \
+  } while (0)
+
+static inline void csr_global_enable_irq()
+{
+  CSR_SET(CSR_MSTATUS, MSTATUS_MIE_MASK);
+}
+
+static inline void csr_global_disable_irq()
+{
+  CSR_CLEAR(CSR_MSTATUS, MSTATUS_MIE_MASK);
+}
+
+static inline uint32_t csr_global_disable_irq_save()
+{
+  uint32_t mstatus;
+  CSR_READ_CLEAR(CSR_MSTATUS, mstatus, MSTATUS_MIE_MASK);
+  return mstatus;
+}
+
+static inline void csr_global_restore_irq(uint32_t mstatus)
+{
+  CSR_SET(CSR_MSTATUS, mstatus & MSTATUS_MIE_MASK);
+}
+
+// Optional hook called by `wait_for_interrupt` in place of `wfi`, e.g. to advance a timer model to
+// the next interrupt
+static void (*host_wfi_hook)(void);
+
+static inline void wait_for_interrupt()
+{
+  if (host_wfi_hook != NULL)
+    host_wfi_hook();
+}
+
+#endif // __LIBSTEEL_HOST_CSR__
@@ -0,0 +1,174 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_HOST_MMIO__
+#define __LIBSTEEL_HOST_MMIO__
+
+/* Memory-mapped peripheral models for the host unit tests (Linux on x86-64 only).
+ *
+ * The registers of a modeled peripheral live in a page that is kept inaccessible. Each access by
+ * the driver faults: the model is told about a read before it happens, so it can update the
+ * register, and about a write after the faulting instruction has been single-stepped, so it can
+ * react to the value written. The drivers are therefore tested exactly as they are compiled, with
+ * their volatile register accesses. */
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__x86_64__)
+#define HOST_MMIO_SUPPORTED 1
+#else
+#define HOST_MMIO_SUPPORTED 0
+#endif
+
+// Exit code of a test that cannot run on this host, reported as skipped by ctest
+#define HOST_MMIO_SKIP 77
+
+// Size of the register page of each modeled peripheral
+#define HOST_MMIO_PAGE_SIZE 4096U
+
+// Maximum number of modeled peripherals
+#define HOST_MMIO_MAX_REGIONS 4U
+
+// Struct describing a modeled peripheral
+typedef struct
+{
+  // Registers of the peripheral, in a page of their own
+  void *base;
+  // Called before the driver reads the register at byte offset `offset`, or NULL
+  void (*read)(void *context, uint32_t offset);
+  // Called after the driver wrote the register at byte offset `offset`, or NULL
+  void (*write)(void *context, uint32_t offset);
+  // Opaque pointer handed to the callbacks
+  void *context;
+} HostMmio;
+
+static HostMmio host_mmio_regions[HOST_MMIO_MAX_REGIONS];
+static uint32_t host_mmio_count;
+// Region and offset of the write being single-stepped, if any
+static HostMmio *host_mmio_stepping;
+static uint32_t host_mmio_step_offset;
+static bool host_mmio_step_write;
+
+#if HOST_MMIO_SUPPORTED
+
+// Trap flag of register RFLAGS, requesting a debug exception after the next instruction
+#define HOST_MMIO_TRAP_FLAG 0x100
+
+static void host_mmio_segv(int sig, siginfo_t *info, void *ucontext)
+{
+  ucontext_t *uc = (ucontext_t *)ucontext;
+  uintptr_t address = (uintptr_t)info->si_addr;
+  for (uint32_t i = 0; i < host_mmio_count; i++)
+  {
+    HostMmio *region = &host_mmio_regions[i];
+    uintptr_t base = (uintptr_t)region->base;
+    if (address < base || address >= base + HOST_MMIO_PAGE_SIZE)
+      continue;
+    uint32_t offset = (address - base) & ~3U;
+    mprotect(region->base, HOST_MMIO_PAGE_SIZE, PROT_READ | PROT_WRITE);
+    host_mmio_step_write = (uc->uc_mcontext.gregs[REG_ERR] & 2) != 0;
+    if (!host_mmio_step_write && region->read != NULL)
+      region->read(region->context, offset);
+    host_mmio_stepping = region;
+    host_mmio_step_offset = offset;
+    uc->uc_mcontext.gregs[REG_EFL] |= HOST_MMIO_TRAP_FLAG;
+    return;
+  }
+  // Not a modeled peripheral: let the access fault again with the default handler
+  signal(sig, SIG_DFL);
+}
+
+static void host_mmio_trap(int sig, siginfo_t *info, void *ucontext)
+{
+  (void)sig;
+  (void)info;
+  ucontext_t *uc = (ucontext_t *)ucontext;
+  uc->uc_mcontext.gregs[REG_EFL] &= ~HOST_MMIO_TRAP_FLAG;
+  HostMmio *region = host_mmio_stepping;
+  if (region == NULL)
+    return;
+  host_mmio_stepping = NULL;
+  if (host_mmio_step_write && region->write != NULL)
+    region->write(region->context, host_mmio_step_offset);
+  mprotect(region->base, HOST_MMIO_PAGE_SIZE, PROT_NONE);
+}
+
+#endif
+
+/**
+ * @brief Allocate the register page of a modeled peripheral, initialized to zero. Set up the
+ * initial register values, then call `host_mmio_start`.
+ *
+ * @return void*
+ */
+static inline void *host_mmio_alloc()
+{
+  void *page = mmap(NULL, HOST_MMIO_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1, 0);
+  return page == MAP_FAILED ? NULL : page;
+}
+
+/**
+ * @brief Start trapping the accesses to the registers at `base`. Return false if peripheral
+ * models are not supported on this host, in which case the test should exit with HOST_MMIO_SKIP.
+ *
+ * @param base Register page returned by `host_mmio_alloc`
+ * @param read Called before each register read, or NULL
+ * @param write Called after each register write, or NULL
+ * @param context Opaque pointer handed to the callbacks
+ * @return true
+ * @return false
+ */
+static inline bool host_mmio_start(void *base, void (*read)(void *context, uint32_t offset),
+                                   void (*write)(void *context, uint32_t offset), void *context)
+{
+#if HOST_MMIO_SUPPORTED
+  if (base == NULL || host_mmio_count == HOST_MMIO_MAX_REGIONS)
+    return false;
+  if (host_mmio_count == 0)
+  {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_flags = SA_SIGINFO;
+    action.sa_sigaction = host_mmio_segv;
+    sigaction(SIGSEGV, &action, NULL);
+    action.sa_sigaction = host_mmio_trap;
+    sigaction(SIGTRAP, &action, NULL);
+  }
+  host_mmio_regions[host_mmio_count++] = (HostMmio){base, read, write, context};
+  mprotect(base, HOST_MMIO_PAGE_SIZE, PROT_NONE);
+  return true;
+#else
+  (void)base;
+  (void)read;
+  (void)write;
+  (void)context;
+  return false;
+#endif
+}
+
+/**
+ * @brief Give the test direct access to the registers of all modeled peripherals (`unlocked`
+ * true), e.g. to inspect or change them, or trap the driver accesses again (`unlocked` false).
+ *
+ * @param unlocked True to allow direct accesses
+ */
+static inline void host_mmio_unlock(bool unlocked)
+{
+  for (uint32_t i = 0; i < host_mmio_count; i++)
+    mprotect(host_mmio_regions[i].base, HOST_MMIO_PAGE_SIZE,
+             unlocked ? PROT_READ | PROT_WRITE : PROT_NONE);
+}
+
+#endif // __LIBSTEEL_HOST_MMIO__
@@ -0,0 +1,44 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_HOST_RTOS_PORT__
+#define __LIBSTEEL_HOST_RTOS_PORT__
+
+/* Stand-in for rtos_port.h used by the host unit tests. It must be included after host_csr.h and
+ * before rtos.h. There is no trap entry and no real context: a test acts as whatever thread the
+ * kernel made current, and calls rtos_dispatch() itself to model a trap. */
+
+#define __LIBSTEEL_RTOS_PORT__
+
+#include "libsteel/globals.h"
+
+struct Rtos;
+
+// Kernel returned by rtos_kernel(), set by rtos_install()
+static struct Rtos *host_rtos;
+
+// Number of calls to rtos_switch_context(), i.e. of `ecall` executed by threads
+static uint32_t host_rtos_context_switches;
+
+static inline struct Rtos *rtos_kernel()
+{
+  return host_rtos;
+}
+
+static inline void rtos_install(struct Rtos *rtos)
+{
+  host_rtos = rtos;
+}
+
+static inline void rtos_switch_context(uint32_t **save_sp, uint32_t *load_sp)
+{
+  (void)save_sp;
+  (void)load_sp;
+  host_rtos_context_switches++;
+}
+
+#endif // __LIBSTEEL_HOST_RTOS_PORT__
@@ -0,0 +1,48 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#ifndef __LIBSTEEL_TEST__
+#define __LIBSTEEL_TEST__
+
+/* Minimal assertion helpers shared by the host unit tests. A test program returns the value of
+ * `test_result()` from main, so that ctest reports any failed check. */
+
+#include <stdio.h>
+
+static int test_failures;
+
+#define CHECK(condition)                                                                           \
+  do                                                                                               \
+  {                                                                                                \
+    if (!(condition))                                                                              \
+    {                                                                                              \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);               \
+      test_failures++;                                                                             \
+    }                                                                                              \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                 \
+  do                                                                                               \
+  {                                                                                                \
+    unsigned long long actual_ = (unsigned long long)(actual);                                     \
+    unsigned long long expected_ = (unsigned long long)(expected);                                 \
+    if (actual_ != expected_)                                                                      \
+    {                                                                                              \
+      fprintf(stderr, "%s:%d: %s == 0x%llx, expected 0x%llx\n", __FILE__, __LINE__, #actual,       \
+              actual_, expected_);                                                                 \
+      test_failures++;                                                                             \
+    }                                                                                              \
+  } while (0)
+
+static inline int test_result()
+{
+  if (test_failures != 0)
+    fprintf(stderr, "%d check(s) failed\n", test_failures);
+  return test_failures != 0;
+}
+
+#endif // __LIBSTEEL_TEST__
@@ -0,0 +1,222 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "host_csr.h"
+#include "test.h"
+
+#include "libsteel/cobs.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static UartController uart = {.READY = 1};
+static uint8_t tx_storage[4096];
+static UartTxBuffer txb;
+
+// Reference COBS encoder (one pass over the whole input), output terminated by the delimiter
+static size_t reference_encode(const uint8_t *data, size_t length, uint8_t *out)
+{
+  size_t code_index = 0;
+  size_t n = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < length; i++)
+  {
+    if (data[i] != 0)
+    {
+      out[n++] = data[i];
+      code++;
+    }
+    if (data[i] == 0 || code == 0xff)
+    {
+      out[code_index] = code;
+      code = 1;
+      code_index = n++;
+      // A full block at the very end of the input is not followed by an empty block
+      if (data[i] != 0 && i + 1 == length)
+      {
+        out[code_index] = 0;
+        return n;
+      }
+    }
+  }
+  out[code_index] = code;
+  out[n++] = 0;
+  return n;
+}
+
+// Encode `payload` through the TX ring buffer and return the number of bytes of the frame
+static size_t encode(const uint8_t *payload, size_t length, uint8_t *out)
+{
+  uart_tx_buffer_init(&txb, &uart, tx_storage, sizeof(tx_storage), UART_OVERFLOW_DROP);
+  cobs_send_frame_buffered(&txb, payload, length);
+  size_t n = uart_tx_buffer_count(&txb);
+  for (size_t i = 0; i < n; i++)
+    out[i] = tx_storage[(txb.tail + i) & txb.mask];
+  return n;
+}
+
+static void check_round_trip(const uint8_t *payload, size_t length)
+{
+  static uint8_t framed[2048];
+  static uint8_t expected[2048];
+  static uint8_t encoded[2048];
+  static uint8_t decoded[2048];
+
+  // The frame on the wire is the canonical COBS encoding of the payload followed by its CRC
+  memcpy(framed, payload, length);
+  uint16_t crc = crc16_ccitt(CRC16_CCITT_INIT, payload, length);
+  framed[length] = crc >> 8;
+  framed[length + 1] = crc & 0xff;
+  size_t expected_length = reference_encode(framed, length + 2, expected);
+  size_t encoded_length = encode(payload, length, encoded);
+  CHECK_EQ(encoded_length, expected_length);
+  CHECK(memcmp(encoded, expected, expected_length) == 0);
+  CHECK(memchr(encoded, 0, encoded_length - 1) == NULL);
+  CHECK_EQ(encoded[encoded_length - 1], 0);
+
+  CobsDecoder dec;
+  cobs_decoder_init(&dec, decoded, sizeof(decoded));
+  for (size_t i = 0; i + 1 < encoded_length; i++)
+    CHECK_EQ(cobs_decoder_feed(&dec, encoded[i]), COBS_IN_PROGRESS);
+  CHECK_EQ(cobs_decoder_feed(&dec, 0), COBS_FRAME_READY);
+  CHECK_EQ(cobs_decoder_payload_length(&dec), length);
+  CHECK(memcmp(decoded, payload, length) == 0);
+  CHECK_EQ(dec.errors, 0);
+}
+
+static void test_runs()
+{
+  static uint8_t payload[1024];
+  // Runs of non-zero bytes around the block size, alone and followed by a zero
+  const size_t lengths[] = {0, 1, 252, 253, 254, 255, 256, 507, 508, 509, 510, 1000};
+  for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+  {
+    for (size_t j = 0; j < lengths[i]; j++)
+      payload[j] = 1 + j % 255;
+    check_round_trip(payload, lengths[i]);
+    payload[lengths[i]] = 0;
+    check_round_trip(payload, lengths[i] + 1);
+    // Zero first, then the run
+    memmove(payload + 1, payload, lengths[i]);
+    payload[0] = 0;
+    check_round_trip(payload, lengths[i] + 1);
+  }
+}
+
+static void test_all_zero()
+{
+  static uint8_t payload[600];
+  memset(payload, 0, sizeof(payload));
+  const size_t lengths[] = {1, 2, 254, 255, 256, 600};
+  for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+    check_round_trip(payload, lengths[i]);
+
+  // Each zero costs exactly one code byte
+  uint8_t encoded[1024];
+  size_t n = encode(payload, 256, encoded);
+  for (size_t i = 0; i < 256; i++)
+    CHECK_EQ(encoded[i], 1);
+  CHECK_EQ(n, 256 + 1 + 2 + 1);
+}
+
+static void test_random()
+{
+  static uint8_t payload[1500];
+  srand(1);
+  for (int round = 0; round < 500; round++)
+  {
+    size_t length = rand() % sizeof(payload);
+    // Vary the density of zeros to exercise both short and full blocks
+    int zero_one_in = 1 + rand() % 300;
+    for (size_t i = 0; i < length; i++)
+      payload[i] = (rand() % zero_one_in == 0) ? 0 : 1 + rand() % 255;
+    check_round_trip(payload, length);
+  }
+}
+
+static void test_decoder_errors()
+{
+  const uint8_t payload[] = {0x11, 0x00, 0x22, 0x33};
+  uint8_t encoded[32];
+  uint8_t decoded[16];
+  CobsDecoder dec;
+  size_t n = encode(payload, sizeof(payload), encoded);
+
+  // Corrupted data byte
+  cobs_decoder_init(&dec, decoded, sizeof(decoded));
+  encoded[3] ^= 0x40;
+  for (size_t i = 0; i + 1 < n; i++)
+    cobs_decoder_feed(&dec, encoded[i]);
+  CHECK_EQ(cobs_decoder_feed(&dec, 0), COBS_ERROR_CRC);
+  encoded[3] ^= 0x40;
+
+  // Frame cut in the middle of a block
+  for (size_t i = 0; i < 3; i++)
+    cobs_decoder_feed(&dec, encoded[i]);
+  CHECK_EQ(cobs_decoder_feed(&dec, 0), COBS_ERROR_FRAMING);
+
+  // Frame larger than the buffer of the decoder
+  cobs_decoder_init(&dec, decoded, 3);
+  for (size_t i = 0; i + 1 < n; i++)
+    cobs_decoder_feed(&dec, encoded[i]);
+  CHECK_EQ(cobs_decoder_feed(&dec, 0), COBS_ERROR_OVERFLOW);
+  CHECK_EQ(dec.errors, 1);
+
+  // Repeated delimiters are ignored and the next frame is received intact
+  cobs_decoder_init(&dec, decoded, sizeof(decoded));
+  CHECK_EQ(cobs_decoder_feed(&dec, 0), COBS_IN_PROGRESS);
+  CHECK_EQ(cobs_decoder_feed(&dec, 0), COBS_IN_PROGRESS);
+  for (size_t i = 0; i + 1 < n; i++)
+    cobs_decoder_feed(&dec, encoded[i]);
+  CHECK_EQ(cobs_decoder_feed(&dec, 0), COBS_FRAME_READY);
+  CHECK_EQ(cobs_decoder_payload_length(&dec), sizeof(payload));
+  CHECK(memcmp(decoded, payload, sizeof(payload)) == 0);
+  CHECK_EQ(dec.errors, 0);
+}
+
+static void test_buffer_overflow()
+{
+  // A frame that does not fit in a TX buffer with the drop policy loses bytes, its delimiter
+  // included. The receiver rejects it at the next delimiter instead of delivering a corrupted
+  // payload, and decodes the following frame intact.
+  static uint8_t small_storage[16];
+  uint8_t payload[32];
+  uint8_t decoded[64];
+  for (size_t i = 0; i < sizeof(payload); i++)
+    payload[i] = i + 1;
+  uart_tx_buffer_init(&txb, &uart, small_storage, sizeof(small_storage), UART_OVERFLOW_DROP);
+  cobs_send_frame_buffered(&txb, payload, sizeof(payload));
+  CHECK(txb.dropped > 0);
+
+  CobsDecoder dec;
+  cobs_decoder_init(&dec, decoded, sizeof(decoded));
+  uint32_t count = uart_tx_buffer_count(&txb);
+  for (uint32_t i = 0; i < count; i++)
+    CHECK_EQ(cobs_decoder_feed(&dec, small_storage[(txb.tail + i) & txb.mask]), COBS_IN_PROGRESS);
+  enum CobsStatus status = cobs_decoder_feed(&dec, 0);
+  CHECK(status == COBS_ERROR_CRC || status == COBS_ERROR_FRAMING);
+  CHECK_EQ(dec.errors, 1);
+
+  uint8_t encoded[32];
+  size_t n = encode(payload, 8, encoded);
+  for (size_t i = 0; i + 1 < n; i++)
+    CHECK_EQ(cobs_decoder_feed(&dec, encoded[i]), COBS_IN_PROGRESS);
+  CHECK_EQ(cobs_decoder_feed(&dec, encoded[n - 1]), COBS_FRAME_READY);
+  CHECK_EQ(cobs_decoder_payload_length(&dec), 8);
+  CHECK(memcmp(decoded, payload, 8) == 0);
+  CHECK_EQ(dec.errors, 1);
+}
+
+int main()
+{
+  test_runs();
+  test_all_zero();
+  test_random();
+  test_decoder_errors();
+  test_buffer_overflow();
+  return test_result();
+}
@@ -0,0 +1,131 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+// Built once for each value of CRC_IMPLEMENTATION (see tests/CMakeLists.txt)
+
+#include "host_csr.h"
+#include "test.h"
+
+#include "libsteel/crc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t check_input[] = "123456789";
+
+// Bitwise reference implementations, independent of crc.h
+static uint32_t reference_msb_first(uint32_t crc, uint32_t width, uint32_t poly,
+                                    const uint8_t *data, size_t length)
+{
+  uint32_t top = 1U << (width - 1);
+  uint32_t mask = top | (top - 1);
+  for (size_t i = 0; i < length; i++)
+  {
+    crc ^= (uint32_t)data[i] << (width - 8);
+    for (int b = 0; b < 8; b++)
+      crc = (crc & top) ? ((crc << 1) ^ poly) & mask : (crc << 1) & mask;
+  }
+  return crc;
+}
+
+static uint32_t reference_crc32(uint32_t crc, const uint8_t *data, size_t length)
+{
+  for (size_t i = 0; i < length; i++)
+  {
+    crc ^= data[i];
+    for (int b = 0; b < 8; b++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320U : crc >> 1;
+  }
+  return crc;
+}
+
+static void test_check_values()
+{
+  const size_t n = sizeof(check_input) - 1;
+  CHECK_EQ(crc8(CRC8_INIT, check_input, n), 0xF4);
+  CHECK_EQ(crc16_ccitt(CRC16_CCITT_INIT, check_input, n), 0x29B1);
+  CHECK_EQ(crc16_ccitt(CRC16_XMODEM_INIT, check_input, n), 0x31C3);
+  CHECK_EQ(crc32_final(crc32(CRC32_INIT, check_input, n)), 0xCBF43926U);
+
+  // CRC-7/MMC check value 0x75, kept in the 7 most significant bits
+  uint8_t crc7 = CRC7_INIT;
+  for (size_t i = 0; i < n; i++)
+    crc7 = crc7_update(crc7, check_input[i]);
+  CHECK_EQ(crc7 >> 1, 0x75);
+
+  // The per-byte update functions give the same results as the buffer functions
+  uint8_t c8 = CRC8_INIT;
+  uint16_t c16 = CRC16_CCITT_INIT;
+  uint32_t c32 = CRC32_INIT;
+  for (size_t i = 0; i < n; i++)
+  {
+    c8 = crc8_update(c8, check_input[i]);
+    c16 = crc16_ccitt_update(c16, check_input[i]);
+    c32 = crc32_update(c32, check_input[i]);
+  }
+  CHECK_EQ(c8, 0xF4);
+  CHECK_EQ(c16, 0x29B1);
+  CHECK_EQ(crc32_final(c32), 0xCBF43926U);
+}
+
+static void test_sd_command()
+{
+  // CMD0 (GO_IDLE_STATE) is sent with the well-known CRC byte 0x95
+  const uint8_t cmd0[] = {0x40, 0x00, 0x00, 0x00, 0x00};
+  uint8_t crc7 = CRC7_INIT;
+  for (size_t i = 0; i < sizeof(cmd0); i++)
+    crc7 = crc7_update(crc7, cmd0[i]);
+  CHECK_EQ(crc7 | 1, 0x95);
+  // CMD8 with argument 0x1AA is sent with the CRC byte 0x87
+  const uint8_t cmd8[] = {0x48, 0x00, 0x00, 0x01, 0xAA};
+  crc7 = CRC7_INIT;
+  for (size_t i = 0; i < sizeof(cmd8); i++)
+    crc7 = crc7_update(crc7, cmd8[i]);
+  CHECK_EQ(crc7 | 1, 0x87);
+}
+
+static void test_random_buffers()
+{
+  static uint8_t data[1031];
+  srand(1);
+  for (size_t i = 0; i < sizeof(data); i++)
+    data[i] = rand();
+  // Every length and start offset around the 4-byte blocks of the slice-by-4 implementation
+  for (size_t offset = 0; offset < 4; offset++)
+    for (size_t length = 0; length + offset <= sizeof(data); length += 1 + length / 16)
+    {
+      const uint8_t *p = data + offset;
+      CHECK_EQ(crc8(0x5A, p, length), reference_msb_first(0x5A, 8, 0x07, p, length));
+      CHECK_EQ(crc16_ccitt(0x1D0F, p, length), reference_msb_first(0x1D0F, 16, 0x1021, p, length));
+      CHECK_EQ(crc32(0x12345678U, p, length), reference_crc32(0x12345678U, p, length));
+    }
+}
+
+static void test_pieces()
+{
+  // Processing data in pieces gives the same CRC as processing it at once
+  static uint8_t data[300];
+  for (size_t i = 0; i < sizeof(data); i++)
+    data[i] = i * 7 + 3;
+  uint32_t whole = crc32(CRC32_INIT, data, sizeof(data));
+  for (size_t split = 0; split <= sizeof(data); split += 13)
+    CHECK_EQ(crc32(crc32(CRC32_INIT, data, split), data + split, sizeof(data) - split), whole);
+  uint16_t whole16 = crc16_ccitt(CRC16_CCITT_INIT, data, sizeof(data));
+  for (size_t split = 0; split <= sizeof(data); split += 13)
+    CHECK_EQ(crc16_ccitt(crc16_ccitt(CRC16_CCITT_INIT, data, split), data + split,
+                         sizeof(data) - split),
+             whole16);
+}
+
+int main()
+{
+  test_check_values();
+  test_sd_command();
+  test_random_buffers();
+  test_pieces();
+  return test_result();
+}
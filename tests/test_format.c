@@ -0,0 +1,108 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "host_csr.h"
+#include "test.h"
+
+#include "libsteel/format.h"
+
+#include <inttypes.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK_FORMAT(expected, ...)                                                                \
+  do                                                                                               \
+  {                                                                                                \
+    char buf_[64];                                                                                 \
+    uint32_t count_ = format_snprintf(buf_, sizeof(buf_), __VA_ARGS__);                            \
+    if (strcmp(buf_, expected) != 0 || count_ != strlen(expected))                                 \
+    {                                                                                              \
+      fprintf(stderr, "%s:%d: got \"%s\" (%u), expected \"%s\"\n", __FILE__, __LINE__, buf_,      \
+              count_, expected);                                                                   \
+      test_failures++;                                                                             \
+    }                                                                                              \
+  } while (0)
+
+static void test_conversions()
+{
+  CHECK_FORMAT("0", "%d", 0);
+  CHECK_FORMAT("-42", "%d", -42);
+  CHECK_FORMAT("-2147483648", "%i", INT_MIN);
+  CHECK_FORMAT("4294967295", "%u", UINT_MAX);
+  CHECK_FORMAT("1000000000", "%u", 1000000000U);
+  CHECK_FORMAT("deadbeef DEADBEEF 0", "%x %X %x", 0xdeadbeefU, 0xdeadbeefU, 0U);
+  const char *volatile none = NULL;
+  CHECK_FORMAT("a|b c|(null)|%", "%c|%s|%s|%%", 'a', "b c", none);
+}
+
+static void test_width()
+{
+  CHECK_FORMAT("0000ff", "%06x", 0xffU);
+  CHECK_FORMAT("   -7", "%5d", -7);
+  CHECK_FORMAT("-0007", "%05d", -7);
+  CHECK_FORMAT("-7   |", "%-5d|", -7);
+  CHECK_FORMAT("ab  |", "%-4s|", "ab");
+  CHECK_FORMAT("123456", "%3d", 123456);
+}
+
+static void test_length_modifiers()
+{
+  // The <inttypes.h> macros expand to whatever length modifier the target uses
+  CHECK_FORMAT("4294967295", "%" PRIu32, UINT32_MAX);
+  CHECK_FORMAT("-2147483648", "%" PRId32, INT32_MIN);
+  CHECK_FORMAT("0000beef", "%08" PRIx32, (uint32_t)0xbeef);
+  CHECK_FORMAT("18446744073709551615", "%" PRIu64, UINT64_MAX);
+  CHECK_FORMAT("-9223372036854775808", "%" PRId64, INT64_MIN);
+  CHECK_FORMAT("123456789abcdef0", "%" PRIx64, (uint64_t)0x123456789abcdef0ULL);
+  CHECK_FORMAT("1000000000F", "%" PRIX64, (uint64_t)0x1000000000FULL);
+
+  CHECK_FORMAT("4000000000 -5", "%lu %ld", 4000000000UL, -5L);
+  CHECK_FORMAT("10000000000 -1", "%llu %lld", 10000000000ULL, -1LL);
+  CHECK_FORMAT("4294967296", "%llu", 4294967296ULL);
+  CHECK_FORMAT("12 7", "%zu %zd", sizeof(uint32_t) * 3, (ptrdiff_t)7);
+  // Arguments are converted to the type named by the modifier
+  CHECK_FORMAT("44 -1 4464 -1", "%hhu %hhd %hu %hd", 300, 255, 70000, 65535);
+  // A 64-bit argument does not shift the following ones
+  CHECK_FORMAT("1 2 3", "%d %lld %d", 1, 2LL, 3);
+}
+
+static void test_against_libc()
+{
+  char expected[64];
+  char buf[64];
+  srand(1);
+  for (int i = 0; i < 20000; i++)
+  {
+    uint64_t value = ((uint64_t)rand() << 62) ^ ((uint64_t)rand() << 31) ^ (uint64_t)rand();
+    value >>= rand() % 64;
+    uint32_t low = (uint32_t)value;
+    snprintf(expected, sizeof(expected), "%" PRIu64 " %" PRId64 " %" PRIx64 " %u %d %x", value,
+             (int64_t)value, value, low, (int32_t)low, low);
+    format_snprintf(buf, sizeof(buf), "%" PRIu64 " %" PRId64 " %" PRIx64 " %u %d %x", value,
+                    (int64_t)value, value, low, (int32_t)low, low);
+    CHECK(strcmp(buf, expected) == 0);
+  }
+}
+
+static void test_truncation()
+{
+  char buf[6];
+  CHECK_EQ(format_snprintf(buf, sizeof(buf), "%s-%u", "abcd", 1234U), 9);
+  CHECK(strcmp(buf, "abcd-") == 0);
+  CHECK_EQ(format_snprintf(buf, 0, "%d", 5), 1);
+}
+
+int main()
+{
+  test_conversions();
+  test_width();
+  test_length_modifiers();
+  test_against_libc();
+  test_truncation();
+  return test_result();
+}
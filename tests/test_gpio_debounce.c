@@ -0,0 +1,138 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "host_csr.h"
+#include "test.h"
+
+#include "libsteel/gpio_debounce.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Recorded input of one pin, one character per sample ('0' or '1'), and the debounced edges
+// expected at each sample ('R' for rising, 'F' for falling, '.' for none)
+typedef struct
+{
+  uint32_t pin;
+  const char *input;
+  const char *edges;
+} PinTrace;
+
+// Replay the traces of several pins sampled together and check the edges reported at each sample
+static void replay(const PinTrace *traces, uint32_t count, uint32_t initial_state)
+{
+  GpioDebouncer deb;
+  gpio_debounce_init(&deb, initial_state);
+  uint32_t length = strlen(traces[0].input);
+  uint32_t rising = 0;
+  uint32_t falling = 0;
+  for (uint32_t i = 0; i < length; i++)
+  {
+    uint32_t sample = initial_state;
+    uint32_t expected_rising = 0;
+    uint32_t expected_falling = 0;
+    for (uint32_t t = 0; t < count; t++)
+    {
+      uint32_t bit = 1U << traces[t].pin;
+      sample = traces[t].input[i] == '1' ? sample | bit : sample & ~bit;
+      expected_rising |= traces[t].edges[i] == 'R' ? bit : 0;
+      expected_falling |= traces[t].edges[i] == 'F' ? bit : 0;
+    }
+    uint32_t changed = gpio_debounce_update(&deb, sample);
+    if (changed != (expected_rising | expected_falling))
+      fprintf(stderr, "sample %u: ", i);
+    CHECK_EQ(changed, expected_rising | expected_falling);
+    CHECK_EQ(changed & gpio_debounce_state(&deb), expected_rising);
+    rising |= expected_rising;
+    falling |= expected_falling;
+  }
+  // Edges accumulate until taken, and taking them clears them
+  CHECK_EQ(gpio_debounce_take_rising(&deb), rising);
+  CHECK_EQ(gpio_debounce_take_falling(&deb), falling);
+  CHECK_EQ(gpio_debounce_take_rising(&deb), 0);
+  CHECK_EQ(gpio_debounce_take_falling(&deb), 0);
+}
+
+static void test_bounce_shorter_than_threshold()
+{
+  // Bursts of up to 3 samples away from the debounced state never produce an edge
+  const PinTrace traces[] = {
+      {0, "0001011011100101110110111000", "............................"},
+      {5, "1110100100011010001001000111", "............................"}};
+  replay(traces, NUMBER_OF(traces), 0x20);
+}
+
+static void test_bounce_longer_than_threshold()
+{
+  // A press bouncing before settling: the edge comes on the 4th consecutive sample of the new
+  // value, and the release bounces the same way
+  const PinTrace traces[] = {
+      {2, "00010110111111111101001000000", "...........R..............F.."}};
+  replay(traces, NUMBER_OF(traces), 0);
+  // Exactly 4 samples are enough, and the counter restarts for the edge back
+  const PinTrace exact[] = {{9, "1111000011110000", ".......F...R...F"}};
+  replay(exact, NUMBER_OF(exact), 0x200);
+}
+
+static void test_edges_on_several_pins()
+{
+  // Rising and falling edges of several pins in the same sample, and on pins 0 and 31
+  const PinTrace traces[] = {{0, "0000111111000000", ".......R.....F.."},
+                             {3, "1111000000111111", ".......F.....R.."},
+                             {17, "0110111101111001", ".......R........"},
+                             {31, "1000011110000011", "....F...R...F..."}};
+  replay(traces, NUMBER_OF(traces), 0x80000008);
+}
+
+// Scalar reference: a pin changes state after 4 consecutive samples differing from it
+static void test_random_traces()
+{
+  GpioDebouncer deb;
+  uint32_t state = 0x5a5a5a5a;
+  uint8_t counters[32] = {0};
+  uint32_t levels = state;
+  gpio_debounce_init(&deb, state);
+  srand(17);
+  for (uint32_t i = 0; i < 100000; i++)
+  {
+    // Each pin flips with a probability depending on the pin, so both short bounces and long
+    // stable periods occur
+    for (uint32_t pin = 0; pin < 32; pin++)
+      if ((uint32_t)(rand() % 64) < (pin % 8) + 1)
+        levels ^= 1U << pin;
+    uint32_t expected = 0;
+    for (uint32_t pin = 0; pin < 32; pin++)
+    {
+      uint32_t bit = 1U << pin;
+      if ((levels ^ state) & bit)
+      {
+        if (++counters[pin] == 4)
+        {
+          counters[pin] = 0;
+          state ^= bit;
+          expected |= bit;
+        }
+      }
+      else
+        counters[pin] = 0;
+    }
+    uint32_t changed = gpio_debounce_update(&deb, levels);
+    CHECK_EQ(changed, expected);
+    if (changed != expected)
+      break;
+  }
+  CHECK_EQ(gpio_debounce_state(&deb), state);
+}
+
+int main()
+{
+  test_bounce_shorter_than_threshold();
+  test_bounce_longer_than_threshold();
+  test_edges_on_several_pins();
+  test_random_traces();
+  return test_result();
+}
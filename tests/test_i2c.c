@@ -0,0 +1,371 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "host_csr.h"
+#include "host_mmio.h"
+#include "test.h"
+
+#include "libsteel/i2c.h"
+
+#define SCL_PIN 4U
+#define SDA_PIN 5U
+#define SCL_MASK (1U << SCL_PIN)
+#define SDA_MASK (1U << SDA_PIN)
+
+#define MODEL_CLOCK_HZ 50000000U
+#define SLAVE_ADDRESS 0x50U
+
+enum SlaveMode
+{
+  // Waiting for a START condition
+  SLAVE_IDLE,
+  // Receiving a byte from the master (address or data)
+  SLAVE_RECEIVE,
+  // Sending a byte to the master
+  SLAVE_SEND
+};
+
+// Model of an I2C bus with pull-up resistors, driven by the GPIO Controller (open-drain through
+// OE) and by a register-based slave that can stretch the clock after each acknowledge
+typedef struct
+{
+  GpioController *regs;
+  // Slave state
+  enum SlaveMode mode;
+  bool addressed;
+  bool first_data;
+  bool send_after_ack;
+  uint32_t bits;
+  uint8_t shift;
+  bool hold_sda;
+  bool hold_scl;
+  uint32_t hold_scl_until;
+  uint8_t pointer;
+  uint8_t registers[256];
+  // Number of cycles SCL is held low after each acknowledge (UINT32_MAX: forever)
+  uint32_t stretch;
+  // Line levels and statistics
+  bool scl;
+  bool sda;
+  uint32_t starts;
+  uint32_t stops;
+  uint32_t read_addressed;
+  uint32_t write_addressed;
+  uint32_t scl_falls;
+  uint32_t last_edge;
+  uint32_t min_low;
+  uint32_t min_high;
+} BusModel;
+
+static BusModel bus;
+
+static uint32_t now()
+{
+  return host_csr[CSR_MCYCLE];
+}
+
+static void slave_scl_rising()
+{
+  bool sda = bus.sda;
+  if (bus.mode == SLAVE_RECEIVE && bus.bits < 8)
+    bus.shift = (bus.shift << 1) | sda;
+  else if (bus.mode == SLAVE_SEND && bus.bits == 8 && sda)
+    bus.mode = SLAVE_IDLE; // NACK from the master: the read ends
+  bus.bits++;
+}
+
+// Hold SCL low after an acknowledge, if the slave stretches the clock
+static void slave_stretch()
+{
+  if (bus.stretch == 0)
+    return;
+  bus.hold_scl = true;
+  bus.hold_scl_until = now() + bus.stretch;
+}
+
+// Drive the most significant bit of the next register to send
+static void slave_load()
+{
+  bus.mode = SLAVE_SEND;
+  bus.bits = 0;
+  bus.shift = bus.registers[bus.pointer++];
+  bus.hold_sda = (bus.shift & 0x80) == 0;
+}
+
+// Put the next bit sent by the slave on SDA, after a falling edge of SCL
+static void slave_scl_falling()
+{
+  if (bus.mode == SLAVE_RECEIVE && bus.bits == 8)
+  {
+    // Byte received: acknowledge our address and all data bytes
+    bool ack = true;
+    if (!bus.addressed)
+    {
+      ack = (bus.shift >> 1) == SLAVE_ADDRESS;
+      bus.addressed = ack;
+      bus.send_after_ack = ack && (bus.shift & 1);
+      if (bus.send_after_ack)
+        bus.read_addressed++;
+      else if (ack)
+        bus.write_addressed++;
+    }
+    else if (bus.first_data)
+    {
+      bus.pointer = bus.shift;
+      bus.first_data = false;
+    }
+    else
+      bus.registers[bus.pointer++] = bus.shift;
+    bus.hold_sda = ack;
+    if (!ack)
+      bus.mode = SLAVE_IDLE;
+  }
+  else if (bus.mode == SLAVE_RECEIVE && bus.bits == 9)
+  {
+    bus.hold_sda = false;
+    bus.bits = 0;
+    slave_stretch();
+    if (bus.send_after_ack)
+      slave_load();
+  }
+  else if (bus.mode == SLAVE_SEND && bus.bits < 8)
+    bus.hold_sda = ((bus.shift << bus.bits) & 0x80) == 0;
+  else if (bus.mode == SLAVE_SEND && bus.bits == 8)
+    bus.hold_sda = false; // the master acknowledges
+  else if (bus.mode == SLAVE_SEND)
+  {
+    // Acknowledged by the master: next register
+    slave_stretch();
+    slave_load();
+  }
+}
+
+// Compute the line levels and let the slave react to their changes
+static void bus_update()
+{
+  if (bus.hold_scl && bus.stretch != UINT32_MAX && (int32_t)(now() - bus.hold_scl_until) >= 0)
+    bus.hold_scl = false;
+  for (;;)
+  {
+    uint32_t oe = bus.regs->OE;
+    bool scl = !(oe & SCL_MASK) && !bus.hold_scl;
+    bool sda = !(oe & SDA_MASK) && !bus.hold_sda;
+    if (scl == bus.scl && sda == bus.sda)
+      break;
+    bool scl_rose = scl && !bus.scl;
+    bool scl_fell = !scl && bus.scl;
+    bool sda_changed = sda != bus.sda;
+    uint32_t elapsed = now() - bus.last_edge;
+    if (scl_rose || scl_fell)
+    {
+      if (scl_fell && elapsed < bus.min_high)
+        bus.min_high = elapsed;
+      if (scl_rose && elapsed < bus.min_low)
+        bus.min_low = elapsed;
+      bus.last_edge = now();
+    }
+    bus.scl = scl;
+    bus.sda = sda;
+    if (scl && !scl_rose && sda_changed)
+    {
+      if (!sda)
+      {
+        // START (or repeated START)
+        bus.starts++;
+        bus.mode = SLAVE_RECEIVE;
+        bus.addressed = false;
+        bus.first_data = true;
+        bus.send_after_ack = false;
+        bus.bits = 0;
+        bus.shift = 0;
+      }
+      else
+      {
+        bus.stops++;
+        bus.mode = SLAVE_IDLE;
+      }
+      bus.hold_sda = false;
+    }
+    else if (scl_rose && bus.mode != SLAVE_IDLE)
+      slave_scl_rising();
+    else if (scl_fell)
+    {
+      bus.scl_falls++;
+      if (bus.mode != SLAVE_IDLE)
+        slave_scl_falling();
+    }
+  }
+  uint32_t in = bus.regs->IN & ~(SCL_MASK | SDA_MASK);
+  bus.regs->IN = in | (bus.scl ? SCL_MASK : 0) | (bus.sda ? SDA_MASK : 0);
+}
+
+static void bus_read(void *context, uint32_t offset)
+{
+  (void)context;
+  if (offset == offsetof(GpioController, IN))
+    bus_update();
+}
+
+static void bus_write(void *context, uint32_t offset)
+{
+  (void)context;
+  GpioController *regs = bus.regs;
+  if (offset == offsetof(GpioController, SET))
+    regs->OUT |= regs->SET;
+  else if (offset == offsetof(GpioController, CLR))
+    regs->OUT &= ~regs->CLR;
+  bus_update();
+}
+
+static void bus_reset(uint32_t stretch)
+{
+  bus.stretch = stretch;
+  bus.hold_scl = false;
+  bus.hold_sda = false;
+  bus.mode = SLAVE_IDLE;
+  bus.starts = bus.stops = 0;
+  bus.read_addressed = bus.write_addressed = 0;
+  bus.scl_falls = 0;
+  bus.min_low = bus.min_high = UINT32_MAX;
+  bus.last_edge = now();
+}
+
+// Make the slave release SCL after a stretch timeout
+static void bus_recover()
+{
+  host_mmio_unlock(true);
+  bus.hold_scl = false;
+  bus.stretch = 0;
+  bus.mode = SLAVE_IDLE;
+  bus_update();
+  host_mmio_unlock(false);
+}
+
+static void check_idle()
+{
+  host_mmio_unlock(true);
+  CHECK_EQ(bus.regs->OE & (SCL_MASK | SDA_MASK), 0);
+  host_mmio_unlock(false);
+  CHECK(bus.scl);
+  CHECK(bus.sda);
+}
+
+static void test_registers(I2cMaster *i2c)
+{
+  const uint8_t values[] = {0x12, 0x80, 0xff, 0x00, 0x5a};
+  uint8_t readback[5] = {0};
+  bus_reset(0);
+  CHECK_EQ(i2c_write_registers(i2c, SLAVE_ADDRESS, 0x20, values, sizeof(values)), I2C_OK);
+  CHECK(memcmp(&bus.registers[0x20], values, sizeof(values)) == 0);
+  CHECK_EQ(i2c_read_registers(i2c, SLAVE_ADDRESS, 0x20, readback, sizeof(readback)), I2C_OK);
+  CHECK(memcmp(readback, values, sizeof(values)) == 0);
+  CHECK_EQ(bus.starts, 3);
+  CHECK_EQ(bus.stops, 2);
+  check_idle();
+  // Both phases of SCL last at least their nominal duration (give or take the few cycles between
+  // the end of a wait and the register write)
+  CHECK(bus.min_low + 4 >= i2c->t_low);
+  CHECK(bus.min_high + 4 >= i2c->t_high);
+
+  // No slave at this address
+  CHECK_EQ(i2c_write(i2c, SLAVE_ADDRESS + 1, values, 1), I2C_NACK);
+  check_idle();
+}
+
+static void test_read_zero_bytes(I2cMaster *i2c)
+{
+  // The slave is addressed for a write, so the STOP condition is not blocked by a data bit
+  bus_reset(0);
+  CHECK_EQ(i2c_read(i2c, SLAVE_ADDRESS, NULL, 0), I2C_OK);
+  CHECK_EQ(bus.write_addressed, 1);
+  CHECK_EQ(bus.read_addressed, 0);
+  CHECK_EQ(bus.stops, 1);
+  check_idle();
+  CHECK_EQ(i2c_read(i2c, SLAVE_ADDRESS + 1, NULL, 0), I2C_NACK);
+  CHECK_EQ(i2c_read_registers(i2c, SLAVE_ADDRESS, 0x20, NULL, 0), I2C_OK);
+  check_idle();
+}
+
+static void test_clock_stretching(I2cMaster *i2c)
+{
+  const uint8_t values[] = {0xa1, 0xb2, 0xc3};
+  uint8_t readback[3] = {0};
+  // Stretching shorter than the timeout is waited for
+  bus_reset(2000);
+  CHECK_EQ(i2c_write_registers(i2c, SLAVE_ADDRESS, 0x40, values, sizeof(values)), I2C_OK);
+  CHECK_EQ(i2c_read_registers(i2c, SLAVE_ADDRESS, 0x40, readback, sizeof(readback)), I2C_OK);
+  CHECK(memcmp(readback, values, sizeof(values)) == 0);
+  check_idle();
+
+  // The slave never releases SCL after acknowledging its address: the transaction is aborted
+  // without clocking any further bit
+  bus_reset(UINT32_MAX);
+  uint32_t start = now();
+  CHECK_EQ(i2c_write_registers(i2c, SLAVE_ADDRESS, 0x40, values, sizeof(values)), I2C_TIMEOUT);
+  // One falling edge for the START and one per bit of the address byte
+  CHECK_EQ(bus.scl_falls, 10);
+  CHECK(now() - start < i2c->stretch_timeout + 20 * (i2c->t_low + i2c->t_high));
+  bus_recover();
+  check_idle();
+  CHECK_EQ(i2c_read_registers(i2c, SLAVE_ADDRESS, 0x40, readback, sizeof(readback)), I2C_OK);
+  CHECK(memcmp(readback, values, sizeof(values)) == 0);
+}
+
+// Simulates an interrupt delaying the driver once, on the given read of CSR_MCYCLE
+static uint32_t delay_countdown;
+static uint32_t delay_cycles;
+
+static void delay_hook(uint32_t cycle)
+{
+  (void)cycle;
+  if (delay_countdown != 0 && --delay_countdown == 0)
+    host_csr[CSR_MCYCLE] += delay_cycles;
+}
+
+static void test_late_edges(I2cMaster *i2c)
+{
+  const uint8_t values[4] = {0x01, 0x02, 0x03, 0x04};
+  host_cycle_hook = delay_hook;
+  // The delay hits the driver at various points of the transaction; the phases after it must not
+  // be shortened to catch up
+  for (uint32_t at = 50; at < 3000; at += 293)
+  {
+    bus_reset(0);
+    delay_countdown = at;
+    delay_cycles = 5 * (i2c->t_low + i2c->t_high);
+    CHECK_EQ(i2c_write_registers(i2c, SLAVE_ADDRESS, 0x60, values, sizeof(values)), I2C_OK);
+    CHECK(bus.min_low + 4 >= i2c->t_low);
+    CHECK(bus.min_high + 4 >= i2c->t_high);
+  }
+  host_cycle_hook = NULL;
+  CHECK(memcmp(&bus.registers[0x60], values, sizeof(values)) == 0);
+}
+
+int main()
+{
+  bus.regs = (GpioController *)host_mmio_alloc();
+  if (!host_mmio_start(bus.regs, bus_read, bus_write, &bus))
+    return HOST_MMIO_SKIP;
+  bus.scl = bus.sda = true;
+  host_mmio_unlock(true);
+  bus.regs->IN = SCL_MASK | SDA_MASK;
+  bus.regs->OUT = SCL_MASK;
+  host_mmio_unlock(false);
+
+  I2cMaster i2c;
+  i2c_init(&i2c, bus.regs, SCL_PIN, SDA_PIN, MODEL_CLOCK_HZ, I2C_FAST_MODE);
+  host_mmio_unlock(true);
+  CHECK_EQ(bus.regs->OUT & (SCL_MASK | SDA_MASK), 0);
+  host_mmio_unlock(false);
+  check_idle();
+
+  test_registers(&i2c);
+  test_read_zero_bytes(&i2c);
+  test_clock_stretching(&i2c);
+  test_late_edges(&i2c);
+  return test_result();
+}
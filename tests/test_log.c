@@ -0,0 +1,253 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "host_csr.h"
+#include "host_mmio.h"
+#include "test.h"
+
+#include "libsteel/log.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static UartController uart = {.READY = 1};
+static uint8_t tx_storage[1024];
+static UartTxBuffer txb;
+
+// Decode the next record held in the TX buffer into `values` (token first) and return the number
+// of LEB128 values it holds, or -1 if no valid frame was found
+static int next_record(uint32_t *values, int max)
+{
+  uint8_t payload[128];
+  CobsDecoder dec;
+  cobs_decoder_init(&dec, payload, sizeof(payload));
+  while (uart_tx_buffer_count(&txb) != 0)
+  {
+    uint8_t byte = tx_storage[txb.tail & txb.mask];
+    txb.tail++;
+    enum CobsStatus status = cobs_decoder_feed(&dec, byte);
+    if (status == COBS_IN_PROGRESS)
+      continue;
+    if (status != COBS_FRAME_READY)
+      return -1;
+    uint32_t length = cobs_decoder_payload_length(&dec);
+    int count = 0;
+    uint32_t value = 0;
+    uint32_t shift = 0;
+    for (uint32_t i = 0; i < length && count < max; i++)
+    {
+      value |= (uint32_t)(payload[i] & 0x7f) << shift;
+      shift += 7;
+      if (payload[i] < 0x80)
+      {
+        values[count++] = value;
+        value = 0;
+        shift = 0;
+      }
+    }
+    return count;
+  }
+  return -1;
+}
+
+// Inverse of `log_zigzag`, as done by the decoder
+static uint32_t unzigzag(uint32_t value)
+{
+  return (value >> 1) ^ -(value & 1);
+}
+
+static void test_zigzag()
+{
+  CHECK_EQ(log_zigzag(0), 0);
+  CHECK_EQ(log_zigzag(-1), 1);
+  CHECK_EQ(log_zigzag(1), 2);
+  CHECK_EQ(log_zigzag(-2), 3);
+  CHECK_EQ(log_zigzag(INT32_MAX), 0xfffffffeU);
+  CHECK_EQ(log_zigzag(INT32_MIN), 0xffffffffU);
+  for (int32_t v = -100000; v <= 100000; v += 7)
+    CHECK_EQ(unzigzag(log_zigzag(v)), (uint32_t)v);
+}
+
+static void test_records()
+{
+  uart_tx_buffer_init(&txb, &uart, tx_storage, sizeof(tx_storage), UART_OVERFLOW_DROP);
+  int negative = -3;
+  short small = -300;
+  unsigned int big = 0xffffffffU;
+  uint8_t byte = 200;
+  char c = 'x';
+  LOG_TOKEN_BUFFERED(&txb, "%d %d %u %u %c\n", negative, small, big, byte, c);
+  LOG_TOKEN_BUFFERED(&txb, "no arguments\n");
+  LOG_TOKEN_BUFFERED(&txb, "%d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d\n", 1, -2, 3, -4, 5,
+                     -6, 7, -8, 9, -10, 11, -12, 13, -14, 15, -16);
+
+  uint32_t values[20];
+  CHECK_EQ(next_record(values, 20), 6);
+  CHECK_EQ(unzigzag(values[1]), (uint32_t)-3);
+  CHECK_EQ(unzigzag(values[2]), (uint32_t)-300);
+  CHECK_EQ(values[3], 0xffffffffU);
+  CHECK_EQ(values[4], 200);
+  CHECK_EQ(values[5], 'x');
+  CHECK_EQ(next_record(values, 20), 1);
+  CHECK_EQ(next_record(values, 20), 17);
+  for (int i = 1; i <= 16; i++)
+    CHECK_EQ(unzigzag(values[i]), (uint32_t)((i & 1) ? i : -i));
+  CHECK_EQ(next_record(values, 20), -1);
+}
+
+static void test_record_size()
+{
+  // A small negative argument takes one byte instead of five
+  uart_tx_buffer_init(&txb, &uart, tx_storage, sizeof(tx_storage), UART_OVERFLOW_DROP);
+  const uint32_t args[] = {log_zigzag(-1)};
+  log_token_write_buffered(&txb, 5, args, 1);
+  // Code byte, token, argument, 2 CRC bytes and delimiter. A zero CRC byte is replaced by a code
+  // byte and does not make the frame longer.
+  CHECK_EQ(uart_tx_buffer_count(&txb), 1 + 1 + 1 + 2 + 1);
+}
+
+static void test_resync()
+{
+  // A corrupted record is rejected and the next one is decoded intact
+  uart_tx_buffer_init(&txb, &uart, tx_storage, sizeof(tx_storage), UART_OVERFLOW_DROP);
+  const uint32_t first[] = {log_zigzag(-7), 42};
+  const uint32_t second[] = {log_zigzag(1234)};
+  log_token_write_buffered(&txb, 0x10, first, 2);
+  tx_storage[2] ^= 0x01;
+  log_token_write_buffered(&txb, 0x20, second, 1);
+
+  uint32_t values[4];
+  CHECK_EQ(next_record(values, 4), -1);
+  CHECK_EQ(next_record(values, 4), 2);
+  CHECK_EQ(values[0], 0x20);
+  CHECK_EQ(unzigzag(values[1]), 1234);
+}
+
+// Model of the UART device collecting the bytes sent by `log_queue_flush`
+typedef struct
+{
+  UartController *regs;
+  uint8_t sent[256];
+  uint32_t count;
+} UartModel;
+
+static UartModel model;
+
+static void uart_model_read(void *context, uint32_t offset)
+{
+  UartModel *m = (UartModel *)context;
+  if (offset == 0x08)
+    m->regs->READY = 1;
+}
+
+static void uart_model_write(void *context, uint32_t offset)
+{
+  UartModel *m = (UartModel *)context;
+  if (offset == 0x00 && m->count < sizeof(m->sent))
+    m->sent[m->count++] = m->regs->WDATA;
+}
+
+static void test_deferred()
+{
+  // Records are queued as words (count, token, arguments) and dropped as a whole when they do
+  // not fit
+  static uint32_t storage[8];
+  LogQueue queue;
+  CHECK(!log_queue_init(&queue, storage, 6));
+  CHECK(log_queue_init(&queue, storage, NUMBER_OF(storage)));
+  const uint32_t first[] = {log_zigzag(-7), 42};
+  const uint32_t second[] = {1, 2, 3};
+  const uint32_t third[] = {log_zigzag(1234), 7};
+  CHECK(log_token_defer(&queue, 0x10, first, 2));
+  CHECK(!log_token_defer(&queue, 0x20, second, 3));
+  CHECK(log_token_defer(&queue, 0x30, third, 2));
+  CHECK(!log_token_defer(&queue, 0x40, NULL, 0));
+  CHECK_EQ(queue.dropped, 2);
+  CHECK_EQ(queue.head, 8);
+  CHECK_EQ(storage[0], 2);
+  CHECK_EQ(storage[1], 0x10);
+  CHECK_EQ(storage[2], log_zigzag(-7));
+  CHECK_EQ(storage[3], 42);
+  CHECK_EQ(storage[4], 2);
+  CHECK_EQ(storage[5], 0x30);
+  uint32_t many[LOG_MAX_ARGS + 1] = {0};
+  CHECK(!log_token_defer(&queue, 0x50, many, LOG_MAX_ARGS + 1));
+
+  // The flushed frames are those of `LOG_TOKEN`, and a record wrapping around the end of the
+  // storage is read back intact
+  uint8_t expected[64];
+  uint32_t expected_count = 0;
+  uart_tx_buffer_init(&txb, &uart, tx_storage, sizeof(tx_storage), UART_OVERFLOW_DROP);
+  log_token_write_buffered(&txb, 0x10, first, 2);
+  log_token_write_buffered(&txb, 0x30, third, 2);
+  log_token_write_buffered(&txb, 0x20, second, 3);
+  while (uart_tx_buffer_count(&txb) != 0)
+    expected[expected_count++] = tx_storage[txb.tail++ & txb.mask];
+
+  model.count = 0;
+  log_queue_flush(&queue, model.regs);
+  CHECK_EQ(queue.tail, 8);
+  CHECK(log_token_defer(&queue, 0x20, second, 3));
+  CHECK_EQ(queue.head, 13);
+  log_queue_flush(&queue, model.regs);
+  CHECK_EQ(queue.tail, 13);
+  CHECK_EQ(model.count, expected_count);
+  CHECK(memcmp(model.sent, expected, expected_count) == 0);
+
+  // LOG_TOKEN_DEFERRED converts its arguments like LOG_TOKEN
+  LOG_TOKEN_DEFERRED(&queue, "%d %u\n", -3, 5U);
+  CHECK_EQ(queue.head - queue.tail, 4);
+  CHECK_EQ(storage[(queue.tail + 2) & 7], log_zigzag(-3));
+  CHECK_EQ(storage[(queue.tail + 3) & 7], 5);
+}
+
+// Write records for tests/test_log_decode.py to `path`: the tokens are offsets in the table of
+// format strings built by that script (64 bytes per string), and 0x1000 is the address of a
+// string in its loaded section
+static int write_decoder_stream(const char *path)
+{
+  uart_tx_buffer_init(&txb, &uart, tx_storage, sizeof(tx_storage), UART_OVERFLOW_DROP);
+  short small = -300;
+  uint8_t byte = 200;
+  const uint32_t first[] = {LOG_ARGS(-3, small, 0xffffffffU, byte, (char)'x')};
+  const uint32_t third[] = {LOG_ARGS(0x1000U, -42)};
+  const uint32_t fourth[] = {LOG_ARGS(0xdeadbeefU)};
+  log_token_write_buffered(&txb, 0, first, NUMBER_OF(first));
+  log_token_write_buffered(&txb, 64, NULL, 0);
+  log_token_write_buffered(&txb, 128, third, NUMBER_OF(third));
+  log_token_write_buffered(&txb, 192, fourth, NUMBER_OF(fourth));
+  // A corrupted record, then a record with an unknown token
+  uint32_t corrupted = txb.head + 1;
+  log_token_write_buffered(&txb, 192, fourth, NUMBER_OF(fourth));
+  tx_storage[corrupted & txb.mask] ^= 0x01;
+  log_token_write_buffered(&txb, 0x4000, NULL, 0);
+  log_token_write_buffered(&txb, 64, NULL, 0);
+
+  FILE *f = fopen(path, "wb");
+  if (f == NULL)
+    return 1;
+  while (uart_tx_buffer_count(&txb) != 0)
+    fputc(tx_storage[txb.tail++ & txb.mask], f);
+  return fclose(f) == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc == 2)
+    return write_decoder_stream(argv[1]);
+
+  test_zigzag();
+  test_records();
+  test_record_size();
+  test_resync();
+  model.regs = (UartController *)host_mmio_alloc();
+  if (host_mmio_start(model.regs, uart_model_read, uart_model_write, &model))
+    test_deferred();
+  else
+    printf("test_deferred skipped: UART model not supported on this host\n");
+  return test_result();
+}
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+# ----------------------------------------------------------------------------
+# Copyright (c) 2020-2024 RISC-V Steel contributors
+#
+# This work is licensed under the MIT License, see LICENSE file for details.
+# SPDX-License-Identifier: MIT
+# ----------------------------------------------------------------------------
+
+"""Round trip of tokenized log records through tools/steel_log_decode.py.
+
+The records are written by test_log (see write_decoder_stream in tests/test_log.c). This script
+builds a 32-bit ELF file holding their format strings in section .steel_log, runs the decoder on
+the records and compares its output with the expected text:
+
+    test_log_decode.py path/to/test_log path/to/steel_log_decode.py
+"""
+
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+# Format strings, 64 bytes apart in .steel_log so that their tokens are 0, 64, 128...
+FORMATS = ["%d %d %u %u %c\n", "no arguments\n", "%s: %5d%%\n", "0x%08x\n"]
+
+# String at address 0x1000 of a loaded section, passed for %s
+STRING_ADDRESS = 0x1000
+STRING = b"sensor\0"
+
+EXPECTED = (
+    "-3 -300 4294967295 200 x\n"
+    "no arguments\n"
+    "sensor:   -42%\n"
+    "0xdeadbeef\n"
+    "<corrupted record>\n"
+    "<unknown token 0x4000>\n"
+    "no arguments\n"
+)
+
+SHT_PROGBITS = 1
+SHT_STRTAB = 3
+SHF_ALLOC = 0x2
+
+
+def build_elf(path):
+    strings = b"".join(f.encode().ljust(64, b"\0") for f in FORMATS)
+    # Name, type, flags, address and contents of each section after the null section
+    sections = [
+        (".steel_log", SHT_PROGBITS, 0, 0, strings),
+        (".rodata", SHT_PROGBITS, SHF_ALLOC, STRING_ADDRESS, STRING),
+    ]
+    names = b"\0"
+    offsets = []
+    for name, *_ in sections + [(".shstrtab",)]:
+        offsets.append(len(names))
+        names += name.encode() + b"\0"
+    sections.append((".shstrtab", SHT_STRTAB, 0, 0, names))
+
+    header_size = 52
+    data = b""
+    headers = [bytes(40)]
+    for (_, type_, flags, address, contents), name in zip(sections, offsets):
+        offset = header_size + len(data)
+        headers.append(struct.pack("<IIIIIIIIII", name, type_, flags, address, offset,
+                                   len(contents), 0, 0, 1, 0))
+        data += contents
+    shoff = header_size + len(data)
+    ident = b"\x7fELF" + bytes([1, 1, 1]) + bytes(9)
+    # ET_EXEC for EM_RISCV (243), with no program headers
+    header = ident + struct.pack("<HHIIIIIHHHHHH", 2, 243, 1, 0, 0, shoff, 0, header_size, 0, 0,
+                                 40, len(headers), len(headers) - 1)
+    with open(path, "wb") as f:
+        f.write(header + data + b"".join(headers))
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    test_log, decoder = sys.argv[1:]
+    with tempfile.TemporaryDirectory() as tmp:
+        elf = os.path.join(tmp, "firmware.elf")
+        stream = os.path.join(tmp, "records.bin")
+        build_elf(elf)
+        subprocess.run([test_log, stream], check=True)
+        result = subprocess.run([sys.executable, decoder, elf, stream], check=True,
+                                capture_output=True, text=True)
+    if result.stdout != EXPECTED:
+        sys.exit(f"decoded:\n{result.stdout}expected:\n{EXPECTED}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,356 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "host_csr.h"
+#include "host_rtos_port.h"
+#include "test.h"
+
+#include "libsteel/rtos.h"
+
+// The MTimer is modeled by its registers in RAM. The test code runs as the current thread of the
+// kernel: after a call that switches threads, it goes on as the new current thread.
+static MTimerController mtimer;
+static Timebase tb;
+static Rtos rtos;
+static RtosThread threads[6];
+static uint32_t stacks[6][64];
+// Trap frame passed to rtos_dispatch() to model a trap
+static uint32_t frame[RTOS_FRAME_SIZE / 4];
+
+static void set_time(uint64_t ticks)
+{
+  mtimer.MTIMEH = ticks >> 32;
+  mtimer.MTIMEL = (uint32_t)ticks;
+}
+
+static void entry(void *arg)
+{
+  (void)arg;
+}
+
+static void setup()
+{
+  set_time(1000);
+  timebase_init(&tb, &mtimer, 50000000);
+  rtos_init(&rtos, &tb);
+  host_csr[CSR_MSTATUS] = MSTATUS_MIE_MASK;
+  host_rtos_context_switches = 0;
+}
+
+// rtos_start() without its idle loop
+static void start()
+{
+  rtos_install(&rtos);
+  rtos.started = true;
+  rtos_program_timer(&rtos);
+  rtos_reschedule(&rtos);
+}
+
+static RtosThread *create(uint32_t i, uint8_t priority)
+{
+  CHECK(rtos_thread_create(&rtos, &threads[i], entry, &threads[i], stacks[i], sizeof(stacks[i]),
+                           priority));
+  return &threads[i];
+}
+
+// Model a trap with the given cause and return the stack pointer of the thread to resume
+static uint32_t *trap(uint32_t mcause)
+{
+  host_csr[CSR_MCAUSE] = mcause;
+  uint32_t switches = host_rtos_context_switches;
+  uint32_t *sp = rtos.dispatch(&rtos, frame);
+  // Threads woken up by the trap run when it returns, not through `ecall`
+  CHECK_EQ(host_rtos_context_switches, switches);
+  CHECK(!rtos.in_trap);
+  return sp;
+}
+
+static uint64_t compare()
+{
+  return sleep_get_compare(&mtimer);
+}
+
+// Check the ready lists against the bitmap and the state and priority of their threads, and
+// return the number of ready threads
+static uint32_t check_ready()
+{
+  uint32_t count = 0;
+  for (uint32_t priority = 0; priority < RTOS_PRIORITIES; priority++)
+  {
+    RtosThread *previous = NULL;
+    for (RtosThread *t = rtos.ready_head[priority]; t != NULL; t = t->next)
+    {
+      CHECK(t->prev == previous);
+      CHECK_EQ(t->state, RTOS_THREAD_READY);
+      CHECK_EQ(t->priority, priority);
+      previous = t;
+      count++;
+    }
+    CHECK(rtos.ready_tail[priority] == previous);
+    CHECK_EQ((rtos.ready_bitmap >> priority) & 1, previous != NULL);
+  }
+  // The idle thread is always ready and, once started, the kernel runs the first thread of the
+  // highest priority
+  CHECK(rtos.ready_head[RTOS_PRIORITIES - 1] == &rtos.idle);
+  CHECK(!rtos.started || rtos.current == rtos_highest_ready(&rtos));
+  return count;
+}
+
+static void test_ready_lists()
+{
+  setup();
+  CHECK_EQ(rtos.ready_bitmap, 0x1U << (RTOS_PRIORITIES - 1));
+  CHECK(rtos.current == &rtos.idle);
+
+  // Threads created before the start are only made ready
+  RtosThread *a = create(0, 5);
+  RtosThread *b = create(1, 5);
+  RtosThread *c = create(2, 0);
+  RtosThread *d = create(3, RTOS_PRIORITIES - 2);
+  CHECK_EQ(host_rtos_context_switches, 0);
+  CHECK_EQ(rtos.ready_bitmap, 0x1U | 0x1U << 5 | 0x3U << (RTOS_PRIORITIES - 2));
+  CHECK(rtos.ready_head[5] == a && a->next == b && rtos.ready_tail[5] == b);
+  CHECK_EQ(check_ready(), 5);
+
+  // The initial frame resumes the entry function in M-mode with interrupts enabled
+  uint32_t *top = (uint32_t *)&stacks[0][64];
+  CHECK(a->sp == top - RTOS_FRAME_SIZE / 4);
+  CHECK(a->sp[RTOS_FRAME_MEPC] == (uint32_t)(uintptr_t)entry);
+  CHECK(a->sp[RTOS_FRAME_A0] == (uint32_t)(uintptr_t)a);
+  CHECK_EQ(a->sp[RTOS_FRAME_MSTATUS], (0x3U << 11) | MSTATUS_MPIE_MASK);
+  CHECK_EQ(a->sp[RTOS_FRAME_KIND], 0);
+
+  // The lowest priority belongs to the idle thread and larger ones have no ready list
+  RtosThread *e = &threads[4];
+  CHECK(!rtos_thread_create(&rtos, e, entry, NULL, stacks[4], sizeof(stacks[4]),
+                            RTOS_PRIORITIES - 1));
+  CHECK(!rtos_thread_create(&rtos, e, entry, NULL, stacks[4], sizeof(stacks[4]), 255));
+  CHECK_EQ(e->state, RTOS_THREAD_INACTIVE);
+  CHECK_EQ(check_ready(), 5);
+
+  start();
+  CHECK(rtos.current == c);
+  CHECK_EQ(host_rtos_context_switches, 1);
+  CHECK_EQ(rtos.switches, 1);
+  CHECK_EQ(compare(), UINT64_MAX);
+
+  // Alone at its priority, c keeps running when it yields
+  rtos_yield();
+  CHECK(rtos.current == c);
+  CHECK_EQ(host_rtos_context_switches, 1);
+
+  // Sleeping threads are ordered by wake-up time and MTIMECMP follows the first one
+  rtos_sleep_until((Deadline){1300});
+  CHECK_EQ(c->state, RTOS_THREAD_SLEEPING);
+  CHECK_EQ(rtos.ready_bitmap & 1, 0);
+  CHECK_EQ(compare(), 1300);
+  CHECK(rtos.current == a);
+  rtos_sleep(200);
+  CHECK(rtos.sleeping == a && a->next == c);
+  CHECK_EQ(compare(), 1200);
+  CHECK(rtos.current == b);
+  CHECK_EQ(check_ready(), 3);
+
+  // A deadline already passed does not block
+  rtos_sleep_until((Deadline){1000});
+  CHECK(rtos.current == b);
+
+  // Threads of the same priority take turns when they yield
+  RtosThread *f = create(4, 5);
+  CHECK(rtos.current == b);
+  rtos_yield();
+  CHECK(rtos.current == f);
+  CHECK(rtos.ready_head[5] == f && rtos.ready_tail[5] == b);
+  CHECK_EQ(check_ready(), 4);
+
+  // A thread created with a higher priority runs at once
+  RtosThread *g = create(5, 1);
+  CHECK(rtos.current == g);
+  CHECK_EQ(check_ready(), 5);
+
+  // The MTimer interrupt wakes up the threads due and preempts the current one
+  set_time(1250);
+  uint32_t *sp = trap(0x80000000U | MIP_MIE_OFFSET_MTI);
+  CHECK(g->sp == frame);
+  CHECK(sp == g->sp);
+  CHECK(rtos.current == g);
+  CHECK_EQ(a->state, RTOS_THREAD_READY);
+  CHECK(rtos.ready_tail[5] == a);
+  CHECK(rtos.sleeping == c);
+  CHECK_EQ(compare(), 1300);
+  set_time(1300);
+  sp = trap(0x80000000U | MIP_MIE_OFFSET_MTI);
+  CHECK(rtos.current == c);
+  CHECK(sp == c->sp);
+  CHECK(g->sp == frame);
+  CHECK(rtos.sleeping == NULL);
+  CHECK_EQ(compare(), UINT64_MAX);
+  CHECK_EQ(check_ready(), 7);
+  CHECK_EQ(d->state, RTOS_THREAD_READY);
+}
+
+static void test_inheritance_chain()
+{
+  // L owns A, M owns B and waits for A, H waits for B: H lends its priority to M and, through A,
+  // to L
+  setup();
+  RtosMutex a, b;
+  rtos_mutex_init(&a);
+  rtos_mutex_init(&b);
+  RtosThread *low = create(0, 20);
+  start();
+  rtos_mutex_lock(&a);
+  CHECK(a.owner == low && low->held == &a);
+
+  RtosThread *medium = create(1, 10);
+  CHECK(rtos.current == medium);
+  rtos_mutex_lock(&b);
+  rtos_mutex_lock(&a);
+  CHECK_EQ(medium->state, RTOS_THREAD_BLOCKED_MUTEX);
+  CHECK(medium->waiting_mutex == &a);
+  CHECK_EQ(low->priority, 10);
+  CHECK(rtos.current == low);
+  CHECK_EQ(check_ready(), 2);
+
+  RtosThread *high = create(2, 5);
+  CHECK(rtos.current == high);
+  CHECK(!rtos_mutex_try_lock(&b));
+  rtos_mutex_lock(&b);
+  CHECK_EQ(medium->priority, 5);
+  CHECK_EQ(low->priority, 5);
+  CHECK(rtos.ready_head[5] == low);
+  CHECK(rtos.current == low);
+  CHECK_EQ(check_ready(), 2);
+
+  // Unlocking A hands it over to M, which keeps the priority of H, and L drops back to its base
+  rtos_mutex_unlock(&a);
+  CHECK(a.owner == medium);
+  CHECK(medium->waiting_mutex == NULL);
+  CHECK_EQ(medium->priority, 5);
+  CHECK_EQ(low->priority, 20);
+  CHECK(low->held == NULL);
+  CHECK(rtos.current == medium);
+  CHECK_EQ(check_ready(), 3);
+
+  rtos_mutex_unlock(&a);
+  CHECK(a.owner == NULL);
+  CHECK_EQ(medium->priority, 5);
+  CHECK(rtos.current == medium);
+
+  // Unlocking B hands it over to H, and M drops back to its base
+  rtos_mutex_unlock(&b);
+  CHECK(b.owner == high && high->held == &b);
+  CHECK_EQ(high->priority, 5);
+  CHECK_EQ(medium->priority, 10);
+  CHECK(medium->held == NULL);
+  CHECK(rtos.current == high);
+  rtos_mutex_unlock(&b);
+  CHECK(b.owner == NULL);
+  CHECK_EQ(check_ready(), 4);
+}
+
+static void test_inheritance_restore()
+{
+  // L owns A and C, M waits for C and H for A. Unlocking A leaves L at the priority of M, not at
+  // its base.
+  setup();
+  RtosMutex a, c;
+  RtosSemaphore parked;
+  rtos_mutex_init(&a);
+  rtos_mutex_init(&c);
+  rtos_semaphore_init(&parked, 0);
+  RtosThread *low = create(0, 20);
+  start();
+  rtos_mutex_lock(&a);
+  CHECK(rtos_mutex_try_lock(&c));
+  CHECK(low->held == &c && c.next_held == &a);
+
+  RtosThread *medium = create(1, 10);
+  rtos_mutex_lock(&c);
+  CHECK_EQ(low->priority, 10);
+  RtosThread *high = create(2, 5);
+  rtos_mutex_lock(&a);
+  CHECK_EQ(low->priority, 5);
+  CHECK(rtos.current == low);
+
+  rtos_mutex_unlock(&a);
+  CHECK(a.owner == high);
+  CHECK_EQ(low->priority, 10);
+  CHECK(rtos.current == high);
+  CHECK_EQ(check_ready(), 3);
+
+  rtos_semaphore_wait(&parked);
+  CHECK_EQ(high->state, RTOS_THREAD_BLOCKED_SEMAPHORE);
+  CHECK(rtos.current == low);
+  rtos_mutex_unlock(&c);
+  CHECK(c.owner == medium);
+  CHECK_EQ(low->priority, 20);
+  CHECK(rtos.current == medium);
+  CHECK_EQ(check_ready(), 3);
+}
+
+static RtosSemaphore irq_semaphore;
+static uint32_t handler_calls;
+
+static void handler(uint32_t mcause)
+{
+  CHECK_EQ(mcause, 0x8000000BU);
+  CHECK(rtos.in_trap);
+  handler_calls++;
+  rtos_semaphore_post(&irq_semaphore);
+}
+
+static void test_semaphore_from_trap()
+{
+  setup();
+  handler_calls = 0;
+  rtos_semaphore_init(&irq_semaphore, 0);
+  rtos_set_trap_handler(&rtos, handler);
+  RtosThread *high = create(0, 3);
+  RtosThread *low = create(1, 7);
+  start();
+  rtos_semaphore_wait(&irq_semaphore);
+  CHECK(rtos.current == low);
+  rtos_semaphore_wait(&irq_semaphore);
+  CHECK(rtos.current == &rtos.idle);
+  CHECK_EQ(check_ready(), 1);
+  uint32_t switches = rtos.switches;
+
+  // A post from the handler wakes up the waiting thread with the highest priority, which runs
+  // when the trap returns
+  uint32_t *sp = trap(0x8000000BU);
+  CHECK_EQ(handler_calls, 1);
+  CHECK(rtos.idle.sp == frame);
+  CHECK(rtos.current == high);
+  CHECK(sp == high->sp);
+  CHECK_EQ(rtos.switches, switches + 1);
+  CHECK_EQ(low->state, RTOS_THREAD_BLOCKED_SEMAPHORE);
+
+  // Waking up a thread of lower priority does not switch
+  sp = trap(0x8000000BU);
+  CHECK(sp == frame);
+  CHECK(rtos.current == high);
+  CHECK_EQ(low->state, RTOS_THREAD_READY);
+  CHECK_EQ(rtos.switches, switches + 1);
+  CHECK_EQ(check_ready(), 3);
+
+  // With no thread waiting, a post is counted
+  trap(0x8000000BU);
+  CHECK_EQ(irq_semaphore.count, 1);
+  CHECK(rtos_semaphore_try_wait(&irq_semaphore));
+  CHECK(!rtos_semaphore_try_wait(&irq_semaphore));
+  CHECK_EQ(handler_calls, 3);
+}
+
+int main()
+{
+  test_ready_lists();
+  test_inheritance_chain();
+  test_inheritance_restore();
+  test_semaphore_from_trap();
+  return test_result();
+}
@@ -0,0 +1,333 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "host_csr.h"
+#include "test.h"
+
+#include "libsteel/scheduler.h"
+
+#include <stdlib.h>
+
+// The MTimer is modeled by its registers in RAM. Task functions advance MTIME and MCYCLE to
+// model their execution time.
+static MTimerController mtimer;
+static Timebase tb;
+static Scheduler sched;
+static SchedulerTask tasks[SCHEDULER_MAX_TASKS + 4];
+
+static void set_time(uint64_t ticks)
+{
+  mtimer.MTIMEH = ticks >> 32;
+  mtimer.MTIMEL = (uint32_t)ticks;
+}
+
+static void advance(uint64_t ticks, uint32_t cycles)
+{
+  set_time(now_ticks(&tb) + ticks);
+  host_csr[CSR_MCYCLE] += cycles;
+}
+
+static void setup(SchedulerOverrunCallback on_overrun)
+{
+  set_time(1000);
+  timebase_init(&tb, &mtimer, 50000000);
+  scheduler_init(&sched, &tb, on_overrun, NULL);
+  host_cycles_per_read = 0;
+}
+
+// Check the heap order, the positions stored in the tasks and their states
+static void check_heap(SchedulerTask **heap, uint32_t count, bool by_priority, uint8_t state)
+{
+  for (uint32_t i = 0; i < count; i++)
+  {
+    CHECK_EQ(heap[i]->heap_index, i);
+    CHECK_EQ(heap[i]->state, state);
+    if (i > 0)
+      CHECK(!scheduler_before(heap[i], heap[(i - 1) >> 1], by_priority));
+  }
+}
+
+static void check_heaps()
+{
+  check_heap(sched.waiting, sched.waiting_count, false, SCHEDULER_TASK_WAITING);
+  check_heap(sched.ready, sched.ready_count, true, SCHEDULER_TASK_READY);
+  CHECK(sched.waiting_count + sched.ready_count <= SCHEDULER_MAX_TASKS);
+}
+
+// Task run last, with its release time and state while running
+static SchedulerTask *ran;
+static uint64_t ran_release;
+static uint8_t ran_state;
+// Execution time of the next runs
+static uint64_t run_ticks;
+static uint32_t run_cycles;
+
+static void record(void *context)
+{
+  ran = (SchedulerTask *)context;
+  ran_release = ran->release;
+  ran_state = ran->state;
+  advance(run_ticks, run_cycles);
+}
+
+static void test_random()
+{
+  // Random adds, removes and runs, checked against a scan of all the tasks: the task run must be
+  // the released one with the highest priority and then the earliest release
+  setup(NULL);
+  srand(1);
+  for (uint32_t i = 0; i < NUMBER_OF(tasks); i++)
+    scheduler_task_init(&tasks[i], record, &tasks[i], rand() % 4, 0);
+  uint32_t runs = 0;
+  for (uint32_t step = 0; step < 100000; step++)
+  {
+    SchedulerTask *task = &tasks[rand() % NUMBER_OF(tasks)];
+    uint32_t live = sched.waiting_count + sched.ready_count;
+    switch (rand() % 8)
+    {
+    case 0:
+    case 1:
+    {
+      bool queued = task->state == SCHEDULER_TASK_WAITING || task->state == SCHEDULER_TASK_READY;
+      bool added = scheduler_add(&sched, task, rand() % 200, rand() % 2 ? rand() % 300 + 1 : 0);
+      CHECK_EQ(added, queued || live < SCHEDULER_MAX_TASKS);
+      CHECK_EQ(task->state, added ? SCHEDULER_TASK_WAITING : SCHEDULER_TASK_IDLE);
+      break;
+    }
+    case 2:
+      scheduler_remove(&sched, task);
+      CHECK_EQ(task->state, SCHEDULER_TASK_IDLE);
+      break;
+    case 3:
+      advance(rand() % 50, 0);
+      break;
+    default:
+    {
+      uint64_t now = now_ticks(&tb);
+      SchedulerTask *expected = NULL;
+      for (uint32_t i = 0; i < NUMBER_OF(tasks); i++)
+      {
+        SchedulerTask *t = &tasks[i];
+        if ((t->state == SCHEDULER_TASK_WAITING || t->state == SCHEDULER_TASK_READY) &&
+            t->release <= now && (expected == NULL || scheduler_before(t, expected, true)))
+          expected = t;
+      }
+      // The run may release the expected task again
+      uint64_t expected_release = expected != NULL ? expected->release : 0;
+      run_ticks = rand() % 20;
+      run_cycles = 0;
+      ran = NULL;
+      CHECK_EQ(scheduler_run_once(&sched), expected != NULL);
+      CHECK((ran != NULL) == (expected != NULL));
+      if (expected != NULL && ran != NULL)
+      {
+        CHECK_EQ(ran->priority, expected->priority);
+        CHECK_EQ(ran_release, expected_release);
+        CHECK_EQ(ran_state, SCHEDULER_TASK_RUNNING);
+        runs++;
+      }
+      break;
+    }
+    }
+    check_heaps();
+  }
+  CHECK(runs > 10000);
+}
+
+static SchedulerTask *overrun_task;
+static uint64_t overrun_lateness;
+static uint32_t overrun_calls;
+
+static void on_overrun(SchedulerTask *task, uint64_t lateness, void *context)
+{
+  (void)context;
+  overrun_task = task;
+  overrun_lateness = lateness;
+  overrun_calls++;
+}
+
+static void test_overrun()
+{
+  setup(on_overrun);
+  overrun_calls = 0;
+  SchedulerTask *periodic = &tasks[0];
+  scheduler_task_init(periodic, record, periodic, 0, 0);
+  CHECK(scheduler_add(&sched, periodic, 0, 100));
+
+  // On time: released again one period later
+  run_ticks = 50;
+  run_cycles = 1234;
+  CHECK(scheduler_run_once(&sched));
+  CHECK_EQ(periodic->runs, 1);
+  CHECK_EQ(periodic->last_cycles, 1234);
+  CHECK_EQ(periodic->overruns, 0);
+  CHECK_EQ(periodic->release, 1100);
+  CHECK_EQ(periodic->state, SCHEDULER_TASK_WAITING);
+  CHECK(!scheduler_run_once(&sched));
+
+  // Released at 1100 with the period as deadline, finishes at 1350: 150 ticks late, and the
+  // releases at 1200 and 1300 are skipped
+  set_time(1100);
+  run_ticks = 250;
+  run_cycles = 5000;
+  CHECK(scheduler_run_once(&sched));
+  CHECK_EQ(periodic->runs, 2);
+  CHECK_EQ(periodic->overruns, 1);
+  CHECK_EQ(overrun_calls, 1);
+  CHECK(overrun_task == periodic);
+  CHECK_EQ(overrun_lateness, 150);
+  CHECK_EQ(periodic->skipped, 2);
+  CHECK_EQ(periodic->release, 1400);
+  CHECK_EQ(periodic->last_cycles, 5000);
+  CHECK_EQ(periodic->max_cycles, 5000);
+  CHECK_EQ(periodic->total_cycles, 6234);
+  CHECK(!scheduler_run_once(&sched));
+
+  // Finishing exactly at the deadline is not an overrun, nor is the next release skipped
+  set_time(1400);
+  run_ticks = 100;
+  CHECK(scheduler_run_once(&sched));
+  CHECK_EQ(periodic->overruns, 1);
+  CHECK_EQ(periodic->skipped, 2);
+  CHECK_EQ(periodic->release, 1500);
+  scheduler_remove(&sched, periodic);
+
+  // A one-shot task overruns its explicit deadline and is not released again
+  SchedulerTask *once = &tasks[1];
+  scheduler_task_init(once, record, once, 0, 10);
+  CHECK(scheduler_add(&sched, once, 0, 0));
+  run_ticks = 25;
+  CHECK(scheduler_run_once(&sched));
+  CHECK_EQ(once->overruns, 1);
+  CHECK_EQ(overrun_calls, 2);
+  CHECK_EQ(overrun_lateness, 15);
+  CHECK_EQ(once->state, SCHEDULER_TASK_IDLE);
+  CHECK_EQ(sched.waiting_count + sched.ready_count, 0);
+
+  // With no deadline, a one-shot task never overruns
+  scheduler_task_init(once, record, once, 0, 0);
+  CHECK(scheduler_add(&sched, once, 0, 0));
+  run_ticks = 1000000;
+  CHECK(scheduler_run_once(&sched));
+  CHECK_EQ(once->overruns, 0);
+  CHECK_EQ(overrun_calls, 2);
+}
+
+// Tasks added by `add_more` while it runs, and the results of scheduler_add
+static uint32_t more_first;
+static uint32_t more_count;
+static bool more_added[4];
+
+static void add_more(void *context)
+{
+  (void)context;
+  for (uint32_t i = 0; i < more_count; i++)
+    more_added[i] = scheduler_add(&sched, &tasks[more_first + i], 1000, 0);
+}
+
+static void test_full()
+{
+  setup(NULL);
+  for (uint32_t i = 0; i < NUMBER_OF(tasks); i++)
+    scheduler_task_init(&tasks[i], record, &tasks[i], 1, 0);
+
+  // Waiting and ready tasks share the SCHEDULER_MAX_TASKS places: once all are released, none
+  // can be added, and one more only once a task runs
+  for (uint32_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+    CHECK(scheduler_add(&sched, &tasks[i], 0, 0));
+  CHECK(!scheduler_add(&sched, &tasks[SCHEDULER_MAX_TASKS], 0, 0));
+  CHECK_EQ(tasks[SCHEDULER_MAX_TASKS].state, SCHEDULER_TASK_IDLE);
+  // Rescheduling a queued task needs no room
+  CHECK(scheduler_add(&sched, &tasks[0], 0, 0));
+
+  tasks[0].function = add_more;
+  tasks[0].priority = 0;
+  more_first = SCHEDULER_MAX_TASKS;
+  more_count = 2;
+  more_added[0] = more_added[1] = false;
+  CHECK(scheduler_run_once(&sched));
+  CHECK_EQ(sched.ready_count, SCHEDULER_MAX_TASKS - 1);
+  CHECK(more_added[0]);
+  CHECK(!more_added[1]);
+  CHECK_EQ(sched.waiting_count, 1);
+  check_heaps();
+
+  // A periodic task finding the scheduler full when it ends is stopped and counted
+  setup(NULL);
+  for (uint32_t i = 0; i < NUMBER_OF(tasks); i++)
+    scheduler_task_init(&tasks[i], record, &tasks[i], 1, 0);
+  scheduler_task_init(&tasks[0], add_more, NULL, 0, 0);
+  CHECK(scheduler_add(&sched, &tasks[0], 0, 100));
+  for (uint32_t i = 1; i < SCHEDULER_MAX_TASKS; i++)
+    CHECK(scheduler_add(&sched, &tasks[i], 0, 0));
+  more_count = 1;
+  more_added[0] = false;
+  run_ticks = 0;
+  CHECK(scheduler_run_once(&sched));
+  CHECK(more_added[0]);
+  CHECK_EQ(tasks[0].state, SCHEDULER_TASK_IDLE);
+  CHECK_EQ(sched.dropped, 1);
+  CHECK_EQ(sched.waiting_count + sched.ready_count, SCHEDULER_MAX_TASKS);
+  check_heaps();
+}
+
+static void remove_self(void *context)
+{
+  scheduler_remove(&sched, (SchedulerTask *)context);
+}
+
+static void add_self(void *context)
+{
+  scheduler_add(&sched, (SchedulerTask *)context, 500, 0);
+}
+
+static void test_running()
+{
+  // A periodic task removing itself while running is not released again
+  setup(NULL);
+  SchedulerTask *task = &tasks[0];
+  scheduler_task_init(task, remove_self, task, 0, 0);
+  CHECK(scheduler_add(&sched, task, 0, 100));
+  CHECK(scheduler_run_once(&sched));
+  CHECK_EQ(task->state, SCHEDULER_TASK_IDLE);
+  CHECK_EQ(sched.waiting_count, 0);
+
+  // A periodic task adding itself again while running keeps the new release, once
+  scheduler_task_init(task, add_self, task, 0, 0);
+  CHECK(scheduler_add(&sched, task, 0, 100));
+  CHECK(scheduler_run_once(&sched));
+  CHECK_EQ(task->state, SCHEDULER_TASK_WAITING);
+  CHECK_EQ(task->release, 1500);
+  CHECK_EQ(task->period, 0);
+  CHECK_EQ(sched.waiting_count, 1);
+  check_heaps();
+
+  // Removing a released task before it runs
+  SchedulerTask *other = &tasks[1];
+  scheduler_task_init(other, record, other, 1, 0);
+  set_time(1500);
+  CHECK(scheduler_add(&sched, other, 0, 0));
+  CHECK(scheduler_has_work(&sched));
+  CHECK(scheduler_run_once(&sched));
+  CHECK_EQ(other->state, SCHEDULER_TASK_READY);
+  CHECK(scheduler_has_work(&sched));
+  scheduler_remove(&sched, other);
+  CHECK_EQ(other->state, SCHEDULER_TASK_IDLE);
+  CHECK_EQ(sched.ready_count, 0);
+  CHECK(!scheduler_has_work(&sched));
+  CHECK(!scheduler_run_once(&sched));
+  CHECK_EQ(scheduler_next_release(&sched), 2000);
+}
+
+int main()
+{
+  test_random();
+  test_overrun();
+  test_full();
+  test_running();
+  return test_result();
+}
@@ -0,0 +1,682 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "host_csr.h"
+#include "host_mmio.h"
+#include "test.h"
+
+#include "libsteel/sdcard.h"
+
+#include <stdlib.h>
+
+// Number of blocks of the modeled card (the smallest capacity a version 2.0 CSD can describe)
+#define MODEL_BLOCKS 1024U
+
+// System clock of the modeled board and SPI clock configuration used after initialization
+#define MODEL_CLOCK_HZ 50000000U
+#define MODEL_FAST_CLOCK_CONF 0U
+
+// Chip Select line of the card
+#define MODEL_CS 1U
+
+// Script of an SD card in SPI mode behind the SPI Controller. The card decodes the bytes sent
+// while it is selected and queues its answers, which are shifted out on the following transfers.
+typedef struct
+{
+  // Card type: version 1 cards reject CMD8, version 2 cards report CCS in their OCR
+  uint32_t version;
+  bool high_capacity;
+  // The card never answers
+  bool silent;
+  // Number of ACMD41 answered with the idle bit still set
+  uint32_t idle_polls;
+  // The R7 response echoes a wrong check pattern
+  bool bad_r7;
+  // Index of the command answered with a CRC error (-1 for none)
+  int crc_error_command;
+  // Index of the data block sent with a wrong CRC (-1 for none), counted since initialization
+  int corrupt_block;
+  // The card never sends the start token of read data
+  bool no_read_token;
+  // Data response sent for written blocks (0 for the normal 0x05 or 0x0B on CRC errors)
+  uint8_t data_response;
+  // The card stays busy forever after a block is written
+  bool busy_forever;
+  // Number of bytes between a command and its R1 response (NCR, 1 to 8)
+  uint32_t ncr;
+  // Number of bytes between the R1 response and a data block (NAC)
+  uint32_t nac;
+  // Number of busy bytes after a block is written
+  uint32_t busy_bytes;
+} CardScript;
+
+typedef struct
+{
+  SpiController *regs;
+  CardScript script;
+  uint8_t memory[MODEL_BLOCKS * SD_BLOCK_SIZE];
+  // Protocol state
+  bool selected;
+  bool initialized;
+  bool app_command;
+  bool crc_on;
+  uint8_t frame[6];
+  uint32_t frame_length;
+  // Bytes to shift out, as a ring buffer
+  uint8_t queue[2048];
+  uint32_t head;
+  uint32_t tail;
+  // Multi-block read in progress and address of the next block
+  bool streaming;
+  uint32_t next_block;
+  // Write in progress: waiting for a token or receiving a block
+  bool writing;
+  bool multi_write;
+  bool receiving;
+  uint8_t block[SD_BLOCK_SIZE + 2];
+  uint32_t block_length;
+  bool busy;
+  // Statistics
+  uint32_t blocks_sent;
+  uint32_t commands[64];
+  uint32_t unselected_bytes;
+} CardModel;
+
+static CardModel model;
+
+// Reference CRC-7 of command frames, computed bit by bit (polynomial x^7 + x^3 + 1)
+static uint8_t reference_crc7(const uint8_t *data, uint32_t length)
+{
+  uint8_t crc = 0;
+  for (uint32_t i = 0; i < length; i++)
+    for (int bit = 7; bit >= 0; bit--)
+    {
+      bool feedback = ((crc >> 6) ^ (data[i] >> bit)) & 1;
+      crc = (crc << 1) & 0x7f;
+      if (feedback)
+        crc ^= 0x09;
+    }
+  return crc;
+}
+
+// Reference CRC-16 of data blocks (CRC-16/XMODEM), computed bit by bit
+static uint16_t reference_crc16(const uint8_t *data, uint32_t length)
+{
+  uint16_t crc = 0;
+  for (uint32_t i = 0; i < length; i++)
+  {
+    crc ^= data[i] << 8;
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+static void queue_byte(uint8_t data)
+{
+  model.queue[model.tail++ % sizeof(model.queue)] = data;
+}
+
+static void queue_fill(uint8_t data, uint32_t count)
+{
+  while (count-- != 0)
+    queue_byte(data);
+}
+
+static bool queue_empty()
+{
+  return model.head == model.tail;
+}
+
+static void queue_clear()
+{
+  model.head = model.tail;
+}
+
+// Queue NCR idle bytes followed by an R1 response
+static void queue_r1(uint8_t r1)
+{
+  queue_fill(0xff, model.script.ncr);
+  queue_byte(r1);
+}
+
+// Queue a data block: NAC idle bytes, start token, data and CRC (corrupted if so scripted)
+static void queue_data(const uint8_t *data, uint32_t length)
+{
+  queue_fill(0xff, model.script.nac);
+  if (model.script.no_read_token)
+    return;
+  queue_byte(SD_TOKEN_START_BLOCK);
+  for (uint32_t i = 0; i < length; i++)
+    queue_byte(data[i]);
+  uint16_t crc = reference_crc16(data, length);
+  if ((int)model.blocks_sent++ == model.script.corrupt_block)
+    crc ^= 0x0100;
+  queue_byte(crc >> 8);
+  queue_byte(crc & 0xff);
+}
+
+// Return the block addressed by the argument of a read/write command, or -1 if out of range
+static int32_t model_block(uint32_t arg)
+{
+  uint32_t block = model.script.high_capacity ? arg : arg / SD_BLOCK_SIZE;
+  if (!model.script.high_capacity && arg % SD_BLOCK_SIZE != 0)
+    return -1;
+  return block < MODEL_BLOCKS ? (int32_t)block : -1;
+}
+
+static void model_csd(uint8_t *csd)
+{
+  memset(csd, 0, 16);
+  if (model.script.version == 2)
+  {
+    // CSD version 2.0 with C_SIZE = MODEL_BLOCKS / 1024 - 1
+    csd[0] = 0x40;
+    uint32_t c_size = MODEL_BLOCKS / 1024 - 1;
+    csd[7] = (c_size >> 16) & 0x3f;
+    csd[8] = c_size >> 8;
+    csd[9] = c_size;
+  }
+  else
+  {
+    // CSD version 1.0 with READ_BL_LEN = 10 (1 KB), C_SIZE_MULT = 0 and C_SIZE = 127, giving
+    // 128 * 4 * 1024 bytes
+    csd[5] = 10;
+    uint32_t c_size = MODEL_BLOCKS / 8 - 1;
+    csd[6] = (c_size >> 10) & 0x03;
+    csd[7] = c_size >> 2;
+    csd[8] = (c_size & 0x03) << 6;
+  }
+}
+
+static void model_command()
+{
+  uint8_t cmd = model.frame[0] & 0x3f;
+  uint32_t arg = (model.frame[1] << 24) | (model.frame[2] << 16) | (model.frame[3] << 8) |
+                 model.frame[4];
+  model.commands[cmd]++;
+  bool app = model.app_command;
+  model.app_command = false;
+
+  if (cmd == SD_CMD_STOP_TRANSMISSION)
+  {
+    // The card stops sending data: a stuff byte, R1 and a short busy period follow
+    queue_clear();
+    model.streaming = false;
+    queue_byte(0x3c);
+    queue_byte(0x00);
+    queue_fill(0x00, 2);
+    return;
+  }
+  // CMD0 and CMD8 always carry a valid CRC; the card checks the others after CMD59
+  bool check_crc = model.crc_on || cmd == SD_CMD_GO_IDLE_STATE || cmd == SD_CMD_SEND_IF_COND;
+  uint8_t idle = model.initialized ? 0 : SD_R1_IDLE;
+  if ((check_crc && (reference_crc7(model.frame, 5) << 1 | 1) != model.frame[5]) ||
+      (int)cmd == model.script.crc_error_command)
+  {
+    queue_r1(idle | 0x08);
+    return;
+  }
+  if (app)
+  {
+    if (cmd == SD_ACMD_SD_SEND_OP_COND)
+    {
+      if (model.script.idle_polls > 0)
+        model.script.idle_polls--;
+      else
+        model.initialized = true;
+      queue_r1(model.initialized ? 0 : SD_R1_IDLE);
+    }
+    else
+      queue_r1(idle | SD_R1_ILLEGAL_COMMAND);
+    return;
+  }
+  int32_t block = model_block(arg);
+  uint8_t csd[16];
+  switch (cmd)
+  {
+  case SD_CMD_GO_IDLE_STATE:
+    model.initialized = false;
+    model.crc_on = false;
+    queue_r1(SD_R1_IDLE);
+    break;
+  case SD_CMD_SEND_IF_COND:
+    if (model.script.version == 1)
+    {
+      queue_r1(idle | SD_R1_ILLEGAL_COMMAND);
+      break;
+    }
+    queue_r1(idle);
+    queue_byte(0x00);
+    queue_byte(0x00);
+    queue_byte((arg >> 8) & 0x0f);
+    queue_byte(model.script.bad_r7 ? 0x55 : arg & 0xff);
+    break;
+  case SD_CMD_APP_CMD:
+    model.app_command = true;
+    queue_r1(idle);
+    break;
+  case SD_CMD_READ_OCR:
+    queue_r1(idle);
+    queue_byte(0x80 | (model.script.high_capacity ? 0x40 : 0x00));
+    queue_byte(0xff);
+    queue_byte(0x80);
+    queue_byte(0x00);
+    break;
+  case SD_CMD_SET_BLOCKLEN:
+    queue_r1(idle | (arg == SD_BLOCK_SIZE ? 0 : 0x40));
+    break;
+  case SD_CMD_CRC_ON_OFF:
+    model.crc_on = arg & 1;
+    queue_r1(idle);
+    break;
+  case SD_CMD_SEND_CSD:
+    queue_r1(idle);
+    model_csd(csd);
+    queue_data(csd, sizeof(csd));
+    break;
+  case SD_CMD_READ_SINGLE_BLOCK:
+  case SD_CMD_READ_MULTIPLE_BLOCK:
+    if (block < 0)
+    {
+      queue_r1(0x40);
+      break;
+    }
+    queue_r1(0);
+    queue_data(&model.memory[block * SD_BLOCK_SIZE], SD_BLOCK_SIZE);
+    model.streaming = cmd == SD_CMD_READ_MULTIPLE_BLOCK;
+    model.next_block = block + 1;
+    break;
+  case SD_CMD_WRITE_BLOCK:
+  case SD_CMD_WRITE_MULTIPLE_BLOCK:
+    if (block < 0)
+    {
+      queue_r1(0x40);
+      break;
+    }
+    queue_r1(0);
+    model.writing = true;
+    model.multi_write = cmd == SD_CMD_WRITE_MULTIPLE_BLOCK;
+    model.next_block = block;
+    break;
+  default:
+    queue_r1(idle | SD_R1_ILLEGAL_COMMAND);
+    break;
+  }
+}
+
+// Handle a byte received while a write command is in progress
+static void model_write_byte(uint8_t data)
+{
+  if (model.receiving)
+  {
+    model.block[model.block_length++] = data;
+    if (model.block_length < sizeof(model.block))
+      return;
+    model.receiving = false;
+    uint16_t crc = (model.block[SD_BLOCK_SIZE] << 8) | model.block[SD_BLOCK_SIZE + 1];
+    uint8_t response = 0x05;
+    if (model.crc_on && crc != reference_crc16(model.block, SD_BLOCK_SIZE))
+      response = 0x0b;
+    if (model.script.data_response != 0)
+      response = model.script.data_response;
+    queue_byte(0xe0 | response);
+    if ((response & 0x1f) != 0x05 || model.next_block >= MODEL_BLOCKS)
+    {
+      model.writing = model.multi_write;
+      return;
+    }
+    memcpy(&model.memory[model.next_block++ * SD_BLOCK_SIZE], model.block, SD_BLOCK_SIZE);
+    model.busy = model.script.busy_forever;
+    queue_fill(0x00, model.script.busy_bytes);
+    model.writing = model.multi_write;
+    return;
+  }
+  if ((data == SD_TOKEN_START_BLOCK && !model.multi_write) ||
+      (data == SD_TOKEN_START_MULTI_WRITE && model.multi_write))
+  {
+    model.receiving = true;
+    model.block_length = 0;
+  }
+  else if (data == SD_TOKEN_STOP_MULTI_WRITE && model.multi_write)
+  {
+    // One byte is skipped, then the card is busy while it finishes programming
+    model.writing = false;
+    queue_byte(0xff);
+    queue_fill(0x00, model.script.busy_bytes);
+  }
+}
+
+// Exchange one byte with the card: return the byte shifted out while `data` is shifted in
+static uint8_t model_exchange(uint8_t data)
+{
+  if (!model.selected)
+  {
+    model.unselected_bytes++;
+    return 0xff;
+  }
+  if (model.script.silent)
+    return 0xff;
+  uint8_t out = 0xff;
+  if (!queue_empty())
+    out = model.queue[model.head++ % sizeof(model.queue)];
+  else if (model.busy)
+    out = 0x00;
+  else if (model.streaming)
+  {
+    // Blocks of a multi-block read keep coming until CMD12
+    queue_data(&model.memory[(model.next_block++ % MODEL_BLOCKS) * SD_BLOCK_SIZE], SD_BLOCK_SIZE);
+    out = model.queue[model.head++ % sizeof(model.queue)];
+  }
+
+  if (model.writing && model.frame_length == 0)
+  {
+    model_write_byte(data);
+    return out;
+  }
+  if (model.frame_length == 0 && (data & 0xc0) != 0x40)
+    return out;
+  model.frame[model.frame_length++] = data;
+  if (model.frame_length == sizeof(model.frame))
+  {
+    model.frame_length = 0;
+    model_command();
+  }
+  return out;
+}
+
+static void model_write(void *context, uint32_t offset)
+{
+  (void)context;
+  if (offset == offsetof(SpiController, CHIP_SELECT))
+  {
+    bool selected = model.regs->CHIP_SELECT == MODEL_CS;
+    if (!selected && model.selected)
+    {
+      // Deselecting the card aborts any command being received or answer being sent
+      queue_clear();
+      model.frame_length = 0;
+      model.streaming = false;
+    }
+    model.selected = selected;
+  }
+  else if (offset == offsetof(SpiController, WDATA))
+  {
+    model.regs->RDATA = model_exchange(model.regs->WDATA);
+    // Time taken by the transfer: 8 SCLK periods of 2 * (CLOCK_CONF + 1) system clock cycles
+    host_csr[CSR_MCYCLE] += 16 * (model.regs->CLOCK_CONF + 1);
+  }
+}
+
+static void model_reset(uint32_t version, bool high_capacity)
+{
+  memset(&model.script, 0, sizeof(model.script));
+  model.script.version = version;
+  model.script.high_capacity = high_capacity;
+  model.script.idle_polls = 3;
+  model.script.crc_error_command = -1;
+  model.script.corrupt_block = -1;
+  model.script.ncr = 2;
+  model.script.nac = 4;
+  model.script.busy_bytes = 8;
+  model.selected = false;
+  model.initialized = false;
+  model.app_command = false;
+  model.crc_on = false;
+  model.frame_length = 0;
+  queue_clear();
+  model.streaming = false;
+  model.writing = false;
+  model.receiving = false;
+  model.busy = false;
+  model.blocks_sent = 0;
+  memset(model.commands, 0, sizeof(model.commands));
+  model.unselected_bytes = 0;
+}
+
+static SpiBus bus;
+static SpiDevice dev;
+
+static enum SdStatus init_card(SdCard *card, bool enable_crc)
+{
+  // 50 MHz / 128 = 390 kHz during initialization
+  spi_device_init(&dev, &bus, SPI_MODE0_CPOL0_CPHA0, 63, MODEL_CS);
+  return sd_init(card, &dev, MODEL_FAST_CLOCK_CONF, MODEL_CLOCK_HZ, enable_crc);
+}
+
+static void test_init_sdhc()
+{
+  SdCard card;
+  model_reset(2, true);
+  CHECK_EQ(init_card(&card, true), SD_OK);
+  CHECK(card.block_addressing);
+  CHECK(card.crc_enabled);
+  CHECK(model.crc_on);
+  CHECK_EQ(card.block_count, MODEL_BLOCKS);
+  // At least 74 clock cycles with the card deselected precede CMD0
+  CHECK(model.unselected_bytes >= 10);
+  CHECK_EQ(model.commands[SD_CMD_GO_IDLE_STATE], 1);
+  CHECK_EQ(model.commands[SD_CMD_SEND_IF_COND], 1);
+  CHECK_EQ(model.commands[SD_ACMD_SD_SEND_OP_COND], 4);
+  CHECK_EQ(model.commands[SD_CMD_READ_OCR], 1);
+  // Block-addressed cards have a fixed block length
+  CHECK_EQ(model.commands[SD_CMD_SET_BLOCKLEN], 0);
+  CHECK_EQ(model.commands[SD_CMD_SEND_CSD], 1);
+  // The fast clock is used after initialization
+  host_mmio_unlock(true);
+  CHECK_EQ(model.regs->CLOCK_CONF, MODEL_FAST_CLOCK_CONF);
+  host_mmio_unlock(false);
+}
+
+static void test_init_sdsc()
+{
+  SdCard card;
+  // Version 2.0 standard capacity card: byte addressing, 512-byte blocks set with CMD16
+  model_reset(2, false);
+  CHECK_EQ(init_card(&card, false), SD_OK);
+  CHECK(!card.block_addressing);
+  CHECK(!card.crc_enabled);
+  CHECK_EQ(model.commands[SD_CMD_SET_BLOCKLEN], 1);
+  CHECK_EQ(model.commands[SD_CMD_CRC_ON_OFF], 0);
+
+  // Version 1.x card: CMD8 is an illegal command and there is no OCR to read
+  model_reset(1, false);
+  CHECK_EQ(init_card(&card, true), SD_OK);
+  CHECK(!card.block_addressing);
+  CHECK_EQ(card.block_count, MODEL_BLOCKS);
+  CHECK_EQ(model.commands[SD_CMD_READ_OCR], 0);
+  CHECK_EQ(model.commands[SD_CMD_SET_BLOCKLEN], 1);
+}
+
+static void test_init_errors()
+{
+  SdCard card;
+  // No card: CMD0 is never answered
+  model_reset(2, true);
+  model.script.silent = true;
+  CHECK_EQ(init_card(&card, false), SD_ERROR_TIMEOUT);
+
+  // Wrong check pattern in the R7 response
+  model_reset(2, true);
+  model.script.bad_r7 = true;
+  CHECK_EQ(init_card(&card, false), SD_ERROR_UNSUPPORTED);
+
+  // The card stays idle past SD_INIT_TIMEOUT_MS
+  model_reset(2, true);
+  model.script.idle_polls = 0xffffffffU;
+  host_cycles_per_read = MODEL_CLOCK_HZ / 1000 * 10;
+  CHECK_EQ(init_card(&card, false), SD_ERROR_TIMEOUT);
+  CHECK(model.commands[SD_ACMD_SD_SEND_OP_COND] > 1);
+  host_cycles_per_read = 1;
+
+  // CRC error reported for CMD59 and for CMD58
+  model_reset(2, true);
+  model.script.crc_error_command = SD_CMD_CRC_ON_OFF;
+  CHECK_EQ(init_card(&card, true), SD_ERROR_COMMAND);
+  model_reset(2, true);
+  model.script.crc_error_command = SD_CMD_READ_OCR;
+  CHECK_EQ(init_card(&card, true), SD_ERROR_COMMAND);
+
+  // CSD received with a wrong CRC
+  model_reset(2, true);
+  model.script.corrupt_block = 0;
+  CHECK_EQ(init_card(&card, true), SD_ERROR_CRC);
+}
+
+static void fill_random(uint8_t *data, uint32_t length)
+{
+  for (uint32_t i = 0; i < length; i++)
+    data[i] = rand();
+}
+
+static void test_read_write(uint32_t version, bool high_capacity)
+{
+  static uint8_t data[8 * SD_BLOCK_SIZE];
+  static uint8_t readback[8 * SD_BLOCK_SIZE];
+  SdCard card;
+  model_reset(version, high_capacity);
+  CHECK_EQ(init_card(&card, true), SD_OK);
+  fill_random(model.memory, sizeof(model.memory));
+
+  // Multi-block read: a single CMD18 and a CMD12
+  CHECK_EQ(sd_read_blocks(&card, 100, readback, 8), SD_OK);
+  CHECK(memcmp(readback, &model.memory[100 * SD_BLOCK_SIZE], 8 * SD_BLOCK_SIZE) == 0);
+  CHECK_EQ(model.commands[SD_CMD_READ_MULTIPLE_BLOCK], 1);
+  CHECK_EQ(model.commands[SD_CMD_STOP_TRANSMISSION], 1);
+  // Single-block read of the last block
+  CHECK_EQ(sd_read_blocks(&card, MODEL_BLOCKS - 1, readback, 1), SD_OK);
+  CHECK(memcmp(readback, &model.memory[(MODEL_BLOCKS - 1) * SD_BLOCK_SIZE], SD_BLOCK_SIZE) == 0);
+  CHECK_EQ(model.commands[SD_CMD_READ_SINGLE_BLOCK], 1);
+  CHECK_EQ(card.blocks_read, 9);
+
+  // Multi-block and single-block writes, read back
+  fill_random(data, sizeof(data));
+  CHECK_EQ(sd_write_blocks(&card, 10, data, 8), SD_OK);
+  CHECK(memcmp(data, &model.memory[10 * SD_BLOCK_SIZE], 8 * SD_BLOCK_SIZE) == 0);
+  CHECK_EQ(model.commands[SD_CMD_WRITE_MULTIPLE_BLOCK], 1);
+  CHECK(!model.writing);
+  CHECK_EQ(sd_write_blocks(&card, 0, data + SD_BLOCK_SIZE, 1), SD_OK);
+  CHECK(memcmp(data + SD_BLOCK_SIZE, model.memory, SD_BLOCK_SIZE) == 0);
+  CHECK_EQ(model.commands[SD_CMD_WRITE_BLOCK], 1);
+  CHECK_EQ(card.blocks_written, 9);
+  CHECK_EQ(sd_read_blocks(&card, 10, readback, 8), SD_OK);
+  CHECK(memcmp(data, readback, 8 * SD_BLOCK_SIZE) == 0);
+
+  // Blocks past the end of the card are rejected before any command is sent
+  uint32_t commands = model.commands[SD_CMD_READ_MULTIPLE_BLOCK];
+  CHECK_EQ(sd_read_blocks(&card, MODEL_BLOCKS - 1, readback, 2), SD_ERROR_INVALID_ARGUMENT);
+  CHECK_EQ(sd_write_blocks(&card, 0xffffffffU, data, 2), SD_ERROR_INVALID_ARGUMENT);
+  CHECK_EQ(model.commands[SD_CMD_READ_MULTIPLE_BLOCK], commands);
+  CHECK_EQ(sd_read_blocks(&card, 0, readback, 0), SD_OK);
+}
+
+static void test_data_errors()
+{
+  static uint8_t data[4 * SD_BLOCK_SIZE];
+  SdCard card;
+  model_reset(2, true);
+  CHECK_EQ(init_card(&card, true), SD_OK);
+
+  // Third block of a multi-block read received with a wrong CRC: the transfer is stopped
+  model.script.corrupt_block = model.blocks_sent + 2;
+  CHECK_EQ(sd_read_blocks(&card, 0, data, 4), SD_ERROR_CRC);
+  CHECK_EQ(card.blocks_read, 2);
+  CHECK_EQ(model.commands[SD_CMD_STOP_TRANSMISSION], 1);
+  CHECK(!model.streaming);
+  // The card is usable afterwards
+  CHECK_EQ(sd_read_blocks(&card, 0, data, 4), SD_OK);
+
+  // The card never sends the data: timeout after SD_READ_TIMEOUT_MS
+  model.script.no_read_token = true;
+  host_cycles_per_read = MODEL_CLOCK_HZ / 1000;
+  CHECK_EQ(sd_read_blocks(&card, 0, data, 1), SD_ERROR_TIMEOUT);
+  host_cycles_per_read = 1;
+  model.script.no_read_token = false;
+
+  // Block written with a wrong CRC (simulated by the card answering 0x0B)
+  model.script.data_response = 0x0b;
+  CHECK_EQ(sd_write_blocks(&card, 0, data, 1), SD_ERROR_WRITE);
+  // Write error in the middle of a multi-block write: the stop token is still sent
+  model.script.data_response = 0x0d;
+  uint32_t written = card.blocks_written;
+  CHECK_EQ(sd_write_blocks(&card, 0, data, 3), SD_ERROR_WRITE);
+  CHECK_EQ(card.blocks_written, written);
+  CHECK(!model.writing);
+  model.script.data_response = 0;
+
+  // The card stays busy after a write: timeout after SD_WRITE_TIMEOUT_MS
+  model.script.busy_forever = true;
+  host_cycles_per_read = MODEL_CLOCK_HZ / 1000;
+  CHECK_EQ(sd_write_blocks(&card, 0, data, 1), SD_ERROR_TIMEOUT);
+  host_cycles_per_read = 1;
+  model.busy = false;
+  model.script.busy_forever = false;
+  CHECK_EQ(sd_write_blocks(&card, 0, data, 2), SD_OK);
+}
+
+// Measure the throughput of the driver with the SPI clock at its fastest (MODEL_CLOCK_HZ / 2).
+// CSR_MCYCLE only advances by the duration of the SPI transfers (and one cycle per read), so
+// these figures are the upper bound set by the bus and protocol overhead of each access pattern.
+static void test_throughput()
+{
+  static uint8_t data[64 * SD_BLOCK_SIZE];
+  SdCard card;
+  model_reset(2, true);
+  model.script.nac = 2;
+  model.script.busy_bytes = 2;
+  CHECK_EQ(init_card(&card, false), SD_OK);
+
+  struct
+  {
+    const char *name;
+    uint32_t blocks_per_call;
+    bool write;
+  } patterns[] = {{"read, 1 block per call", 1, false},
+                  {"read, 64 blocks per call", 64, false},
+                  {"write, 1 block per call", 1, true},
+                  {"write, 64 blocks per call", 64, true}};
+  for (uint32_t p = 0; p < NUMBER_OF(patterns); p++)
+  {
+    card.blocks_read = card.blocks_written = 0;
+    card.read_cycles = card.write_cycles = 0;
+    for (uint32_t lba = 0; lba < 64; lba += patterns[p].blocks_per_call)
+    {
+      uint8_t *block = data + lba * SD_BLOCK_SIZE;
+      enum SdStatus status = patterns[p].write
+                                 ? sd_write_blocks(&card, lba, block, patterns[p].blocks_per_call)
+                                 : sd_read_blocks(&card, lba, block, patterns[p].blocks_per_call);
+      CHECK_EQ(status, SD_OK);
+    }
+    uint32_t blocks = patterns[p].write ? card.blocks_written : card.blocks_read;
+    uint64_t cycles = patterns[p].write ? card.write_cycles : card.read_cycles;
+    CHECK_EQ(blocks, 64);
+    printf("%-26s %7llu sectors/s (%llu cycles per sector at %u Hz)\n", patterns[p].name,
+           (unsigned long long)blocks * MODEL_CLOCK_HZ / cycles,
+           (unsigned long long)cycles / blocks, MODEL_CLOCK_HZ);
+  }
+  // Streaming saves the command, NCR/NAC and deselect bytes of each block
+  CHECK(card.write_cycles / 64 < 16 * (SD_BLOCK_SIZE + 16));
+}
+
+int main()
+{
+  model.regs = (SpiController *)host_mmio_alloc();
+  if (!host_mmio_start(model.regs, NULL, model_write, &model))
+    return HOST_MMIO_SKIP;
+  spi_bus_init(&bus, model.regs);
+  srand(12);
+
+  test_init_sdhc();
+  test_init_sdsc();
+  test_init_errors();
+  test_read_write(2, true);
+  test_read_write(2, false);
+  test_read_write(1, false);
+  test_data_errors();
+  test_throughput();
+  return test_result();
+}
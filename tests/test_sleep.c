@@ -0,0 +1,177 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "host_csr.h"
+#include "test.h"
+
+#include "libsteel/sleep.h"
+
+// The MTimer is modeled by its registers in RAM. `wfi` is modeled by `wfi_model`, which advances
+// MTIME to the next interrupt: MTIMECMP if MTI is enabled in MIE, or another interrupt source
+// `other_interrupt_after` ticks later
+static MTimerController mtimer;
+static Timebase tb;
+
+static uint32_t wfi_count;
+// Value of MTIMECMP when the core last stopped
+static uint64_t wfi_compare;
+// True if the core stopped with no interrupt able to wake it up
+static bool stuck;
+static uint64_t other_interrupt_after;
+static volatile bool other_interrupt_handled;
+
+static void set_time(uint64_t ticks)
+{
+  mtimer.MTIMEH = ticks >> 32;
+  mtimer.MTIMEL = (uint32_t)ticks;
+}
+
+static uint64_t compare()
+{
+  return sleep_get_compare(&mtimer);
+}
+
+static void wfi_model()
+{
+  uint64_t now = now_ticks(&tb);
+  wfi_count++;
+  wfi_compare = compare();
+  bool mti = (host_csr[CSR_MIE] & MIP_MIE_MASK_MTI) != 0;
+  uint64_t wake = mti ? wfi_compare : UINT64_MAX;
+  if (other_interrupt_after != UINT64_MAX && now + other_interrupt_after < wake)
+  {
+    set_time(now + other_interrupt_after);
+    other_interrupt_handled = true;
+    return;
+  }
+  if (wake == UINT64_MAX)
+  {
+    stuck = true;
+    return;
+  }
+  if (wake > now)
+    set_time(wake);
+}
+
+static void setup(uint64_t now, uint64_t compare_value, bool mti_enabled)
+{
+  set_time(now);
+  timebase_init(&tb, &mtimer, 50000000);
+  mtimer_set_compare(&mtimer, compare_value);
+  host_csr[CSR_MIE] = mti_enabled ? MIP_MIE_MASK_MTI : 0;
+  host_csr[CSR_MSTATUS] = MSTATUS_MIE_MASK;
+  host_wfi_hook = wfi_model;
+  wfi_count = 0;
+  wfi_compare = 0;
+  stuck = false;
+  other_interrupt_after = UINT64_MAX;
+  other_interrupt_handled = false;
+}
+
+static void test_stale_compare()
+{
+  // MTIMECMP left at its reset value with MTI disabled: it is moved to the deadline for the
+  // sleep, instead of leaving MTIP pending and `wfi` returning at once
+  setup(1000, 0, false);
+  sleep_until(&tb, (Deadline){2000});
+  CHECK_EQ(wfi_count, 1);
+  CHECK_EQ(wfi_compare, 2000);
+  CHECK_EQ(now_ticks(&tb), 2000);
+  CHECK_EQ(compare(), 0);
+  CHECK_EQ(host_csr[CSR_MIE], 0);
+  CHECK_EQ(host_csr[CSR_MSTATUS], MSTATUS_MIE_MASK);
+}
+
+static void test_pending_timer()
+{
+  // Another user of MTIMECMP is due, and its interrupt is pending but not taken yet because
+  // interrupts are masked: the core does not stop and MTIMECMP is kept, so the handler runs
+  // as soon as interrupts are restored
+  setup(1000, 995, true);
+  sleep_once(&tb, (Deadline){2000}, NULL, NULL);
+  CHECK_EQ(wfi_count, 0);
+  CHECK_EQ(now_ticks(&tb), 1000);
+  CHECK_EQ(compare(), 995);
+  CHECK_EQ(host_csr[CSR_MIE], MIP_MIE_MASK_MTI);
+  CHECK_EQ(host_csr[CSR_MSTATUS], MSTATUS_MIE_MASK);
+
+  // Same with no deadline, as `scheduler_run` does when no task is waiting
+  sleep_once(&tb, (Deadline){UINT64_MAX}, NULL, NULL);
+  CHECK_EQ(wfi_count, 0);
+  CHECK(!stuck);
+  CHECK_EQ(compare(), 995);
+}
+
+static void test_earlier_deadline()
+{
+  // The deadline comes before the next timer: MTIMECMP is moved for the sleep, then restored
+  setup(1000, 5000, true);
+  sleep_until(&tb, (Deadline){2000});
+  CHECK_EQ(wfi_count, 1);
+  CHECK_EQ(wfi_compare, 2000);
+  CHECK_EQ(now_ticks(&tb), 2000);
+  CHECK_EQ(compare(), 5000);
+  CHECK_EQ(host_csr[CSR_MIE], MIP_MIE_MASK_MTI);
+}
+
+static void test_later_deadline()
+{
+  // The next timer comes before the deadline: MTIMECMP is not moved and the timer wakes the
+  // core up
+  setup(1000, 1500, true);
+  sleep_once(&tb, (Deadline){2000}, NULL, NULL);
+  CHECK_EQ(wfi_count, 1);
+  CHECK_EQ(wfi_compare, 1500);
+  CHECK_EQ(now_ticks(&tb), 1500);
+  CHECK_EQ(compare(), 1500);
+  // Its handler has not run yet (interrupts are disabled in the model): sleeping again does not
+  // stop the core while it is pending
+  sleep_once(&tb, (Deadline){2000}, NULL, NULL);
+  CHECK_EQ(wfi_count, 1);
+  CHECK_EQ(compare(), 1500);
+}
+
+static bool handled(void *context)
+{
+  (void)context;
+  return other_interrupt_handled;
+}
+
+static void test_condition()
+{
+  // Another interrupt ends the wait before the deadline, and MTIMECMP is restored
+  setup(1000, 0, false);
+  other_interrupt_after = 100;
+  CHECK(sleep_until_condition(&tb, handled, NULL, (Deadline){2000}));
+  CHECK_EQ(wfi_count, 1);
+  CHECK_EQ(now_ticks(&tb), 1100);
+  CHECK_EQ(compare(), 0);
+  CHECK_EQ(host_csr[CSR_MIE], 0);
+  // A condition already true does not stop the core
+  CHECK(sleep_until_condition(&tb, handled, NULL, (Deadline){2000}));
+  sleep_once(&tb, (Deadline){2000}, handled, NULL);
+  CHECK_EQ(wfi_count, 1);
+
+  // Nor does a deadline already passed
+  setup(1000, 5000, true);
+  other_interrupt_after = 100;
+  CHECK(!sleep_until_condition(&tb, handled, NULL, (Deadline){900}));
+  sleep_until(&tb, (Deadline){1000});
+  CHECK_EQ(wfi_count, 0);
+  CHECK_EQ(compare(), 5000);
+}
+
+int main()
+{
+  test_stale_compare();
+  test_pending_timer();
+  test_earlier_deadline();
+  test_later_deadline();
+  test_condition();
+  CHECK(!stuck);
+  return test_result();
+}
@@ -0,0 +1,159 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "host_csr.h"
+#include "host_mmio.h"
+#include "test.h"
+
+#include "libsteel/spi.h"
+
+// Model of the SPI Controller: each byte sent is logged with the Chip Select line active at that
+// time, and the byte received is the one sent plus one
+typedef struct
+{
+  SpiController *regs;
+  uint8_t sent[64];
+  uint32_t cs[64];
+  uint32_t count;
+  uint32_t register_writes[7];
+} SpiModel;
+
+static void spi_model_write(void *context, uint32_t offset)
+{
+  SpiModel *model = (SpiModel *)context;
+  model->register_writes[offset / 4]++;
+  if (offset == offsetof(SpiController, WDATA) && model->count < 64)
+  {
+    uint8_t data = model->regs->WDATA;
+    model->sent[model->count] = data;
+    model->cs[model->count] = model->regs->CHIP_SELECT;
+    model->count++;
+    model->regs->RDATA = (uint8_t)(data + 1);
+  }
+}
+
+static SpiModel model;
+
+static void test_segments(SpiDevice *dev)
+{
+  const uint8_t cmd[] = {0x0B, 0x01, 0x02, 0x03};
+  const uint8_t tx[] = {0x40, 0x41};
+  uint8_t rx_only[2] = {0};
+  uint8_t rx_both[2] = {0};
+  // Command, 3 dummy bytes, 2 bytes read, 2 bytes exchanged
+  const SpiSegment segments[] = {
+      {cmd, NULL, sizeof(cmd)}, {NULL, NULL, 3}, {NULL, rx_only, 2}, {tx, rx_both, 2}};
+  model.count = 0;
+  spi_device_transaction(dev, segments, NUMBER_OF(segments));
+
+  const uint8_t expected[] = {0x0B, 0x01, 0x02, 0x03, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0x40, 0x41};
+  CHECK_EQ(model.count, sizeof(expected));
+  for (uint32_t i = 0; i < sizeof(expected) && i < model.count; i++)
+  {
+    CHECK_EQ(model.sent[i], expected[i]);
+    CHECK_EQ(model.cs[i], 2);
+  }
+  CHECK_EQ(rx_only[0], 0xA6);
+  CHECK_EQ(rx_only[1], 0xA6);
+  CHECK_EQ(rx_both[0], 0x41);
+  CHECK_EQ(rx_both[1], 0x42);
+  host_mmio_unlock(true);
+  CHECK_EQ(model.regs->CHIP_SELECT, 0xffffffffU);
+  host_mmio_unlock(false);
+}
+
+static void test_fill()
+{
+  model.count = 0;
+  spi_fill(model.regs, 0x00, 5);
+  spi_fill(model.regs, 0xff, 0);
+  CHECK_EQ(model.count, 5);
+  for (uint32_t i = 0; i < 5; i++)
+    CHECK_EQ(model.sent[i], 0x00);
+}
+
+static void test_configuration_cache(SpiBus *bus, SpiDevice *dev)
+{
+  // A second device with the same mode and clock does not rewrite the configuration registers
+  SpiDevice twin;
+  spi_device_init(&twin, bus, SPI_MODE3_CPOL1_CPHA1, 4, 1);
+  memset(model.register_writes, 0, sizeof(model.register_writes));
+  spi_device_configure(dev);
+  spi_device_configure(&twin);
+  CHECK_EQ(model.register_writes[0], 0);
+  CHECK_EQ(model.register_writes[1], 0);
+  CHECK_EQ(model.register_writes[3], 0);
+  // A device with another mode does
+  SpiDevice other;
+  spi_device_init(&other, bus, SPI_MODE0_CPOL0_CPHA0, 4, 3);
+  spi_device_configure(&other);
+  CHECK_EQ(model.register_writes[0], 1);
+  CHECK_EQ(model.register_writes[1], 1);
+  CHECK_EQ(model.register_writes[3], 0);
+}
+
+// Checked at compile time: the slowest SCLK of a 51.2 MHz clock is exactly 100 kHz (conf = 255)
+SPI_CLOCK_CONF_ASSERT(51200000, 100000);
+SPI_CLOCK_CONF_ASSERT(50000000, 100000000);
+
+static void test_clock_conf()
+{
+  // Exact divisors
+  CHECK_EQ(SPI_CLOCK_CONF(50000000, 25000000), 0);
+  CHECK_EQ(SPI_CLOCK_CONF(50000000, 12500000), 1);
+  CHECK_EQ(SPI_CLOCK_CONF(50000000, 5000000), 4);
+  CHECK_EQ(SPI_SCLK_HZ(50000000, 4), 5000000);
+  // Inexact divisor: the next slower SCLK is chosen
+  CHECK_EQ(SPI_CLOCK_CONF(50000000, 400000), 62);
+  CHECK_EQ(SPI_SCLK_HZ(50000000, 62), 396825);
+  // Odd clocks: clock / 2 is not an integer, and 25000001 / 2 Hz is above 12.5 MHz
+  CHECK_EQ(SPI_CLOCK_CONF(25000001, 12500000), 1);
+  CHECK_EQ(SPI_CLOCK_CONF(25000001, 12500001), 0);
+  CHECK_EQ(SPI_SCLK_HZ(25000001, 1), 6250000);
+  CHECK_EQ(SPI_CLOCK_CONF(3, 1), 1);
+  // conf = 255 boundary: 51.2 MHz / 512 = 100 kHz is reached, anything slower is not
+  CHECK_EQ(SPI_CLOCK_CONF(51200000, 100000), 255);
+  CHECK_EQ(SPI_SCLK_HZ(51200000, 255), 100000);
+  CHECK_EQ(SPI_CLOCK_CONF_UNCHECKED(51200000, 99999), 256);
+  CHECK_EQ(SPI_CLOCK_CONF_UNCHECKED(51200001, 100000), 256);
+  CHECK_EQ(SPI_CLOCK_CONF(51199999, 100000), 255);
+  // Targets above clock / 2 give the fastest SCLK
+  CHECK_EQ(SPI_CLOCK_CONF(50000000, 100000000), 0);
+  CHECK_EQ(SPI_CLOCK_CONF(50000000, 25000001), 0);
+  CHECK_EQ(SPI_CLOCK_CONF(1, 1), 0);
+
+  // For any clock and target, SCLK (clock / (2 * k), not rounded) is not above the target and
+  // the next faster divider k - 1 would be
+  const uint64_t clocks[] = {1, 2, 3, 1000001, 25000000, 50000000, 51200001, 100000007};
+  for (uint32_t i = 0; i < NUMBER_OF(clocks); i++)
+    for (uint64_t target = 1; target <= clocks[i]; target = target * 3 + 1)
+    {
+      uint64_t k = SPI_CLOCK_CONF_UNCHECKED(clocks[i], target) + 1;
+      CHECK(clocks[i] <= 2 * k * target);
+      CHECK(k == 1 || clocks[i] > 2 * (k - 1) * target);
+    }
+}
+
+int main()
+{
+  test_clock_conf();
+
+  model.regs = (SpiController *)host_mmio_alloc();
+  if (!host_mmio_start(model.regs, NULL, spi_model_write, &model))
+    return HOST_MMIO_SKIP;
+
+  SpiBus bus;
+  SpiDevice dev;
+  spi_bus_init(&bus, model.regs);
+  spi_device_init(&dev, &bus, SPI_MODE3_CPOL1_CPHA1, 4, 2);
+  dev.fill = 0xA5;
+
+  test_segments(&dev);
+  test_fill();
+  test_configuration_cache(&bus, &dev);
+  return test_result();
+}
@@ -0,0 +1,261 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "host_csr.h"
+#include "host_mmio.h"
+#include "test.h"
+
+#include "libsteel/spi_flash.h"
+
+#include <stdlib.h>
+
+// Size of the memory array of the modeled flash
+#define MODEL_SIZE 0x40000U
+
+// Model of an SPI NOR flash behind the SPI Controller. Commands are decoded byte by byte while
+// Chip Select is asserted and take effect when it is released.
+typedef struct
+{
+  SpiController *regs;
+  uint8_t jedec_id[3];
+  uint8_t sfdp[64];
+  bool has_sfdp;
+  uint8_t memory[MODEL_SIZE];
+  bool selected;
+  uint8_t command[8];
+  uint32_t index;
+  bool write_enabled;
+  // Number of status reads that still report the flash as busy
+  uint32_t busy_polls;
+  // Log of the erase commands received: opcode and address
+  uint8_t erase_opcodes[32];
+  uint32_t erase_addresses[32];
+  uint32_t erase_count;
+} FlashModel;
+
+static FlashModel model;
+
+static uint32_t model_address()
+{
+  return (model.command[1] << 16) | (model.command[2] << 8) | model.command[3];
+}
+
+static uint8_t model_exchange(uint8_t data)
+{
+  uint32_t i = model.index++;
+  if (i < sizeof(model.command))
+    model.command[i] = data;
+  uint8_t opcode = model.command[0];
+  if (i == 0)
+    return 0xff;
+  switch (opcode)
+  {
+  case SPI_FLASH_CMD_READ_JEDEC_ID:
+    return i <= 3 ? model.jedec_id[i - 1] : 0xff;
+  case SPI_FLASH_CMD_READ_STATUS:
+    if (model.busy_polls == 0)
+      return model.write_enabled ? 0x02 : 0x00;
+    model.busy_polls--;
+    return 0x03;
+  case SPI_FLASH_CMD_READ_SFDP:
+    if (i < 5 || !model.has_sfdp)
+      return 0xff;
+    return (model_address() + i - 5 < sizeof(model.sfdp)) ? model.sfdp[model_address() + i - 5]
+                                                          : 0xff;
+  case SPI_FLASH_CMD_FAST_READ:
+    return i < 5 ? 0xff : model.memory[(model_address() + i - 5) % MODEL_SIZE];
+  case SPI_FLASH_CMD_PAGE_PROGRAM:
+    if (i >= 4 && model.write_enabled)
+    {
+      // The address wraps around within the page, and programming only clears bits
+      uint32_t addr = model_address();
+      uint32_t offset = (addr + i - 4) & 0xff;
+      model.memory[((addr & ~0xffU) | offset) % MODEL_SIZE] &= data;
+    }
+    return 0xff;
+  default:
+    return 0xff;
+  }
+}
+
+static void model_end_command()
+{
+  uint8_t opcode = model.command[0];
+  if (model.index == 0)
+    return;
+  if (opcode == SPI_FLASH_CMD_WRITE_ENABLE)
+    model.write_enabled = true;
+  else if (opcode == SPI_FLASH_CMD_PAGE_PROGRAM && model.write_enabled)
+  {
+    model.write_enabled = false;
+    model.busy_polls = 3;
+  }
+  else if ((opcode == SPI_FLASH_CMD_ERASE_4K || opcode == SPI_FLASH_CMD_ERASE_32K ||
+            opcode == SPI_FLASH_CMD_ERASE_64K || opcode == 0x21 || opcode == 0xDC) &&
+           model.write_enabled && model.index == 4)
+  {
+    uint32_t size = (opcode == SPI_FLASH_CMD_ERASE_64K || opcode == 0xDC) ? 0x10000
+                    : opcode == SPI_FLASH_CMD_ERASE_32K ? 0x8000
+                                                        : 0x1000;
+    uint32_t addr = model_address() & ~(size - 1);
+    if (addr + size <= MODEL_SIZE)
+      memset(model.memory + addr, 0xff, size);
+    if (model.erase_count < 32)
+    {
+      model.erase_opcodes[model.erase_count] = opcode;
+      model.erase_addresses[model.erase_count] = model_address();
+      model.erase_count++;
+    }
+    model.write_enabled = false;
+    model.busy_polls = 10;
+  }
+}
+
+static void flash_model_write(void *context, uint32_t offset)
+{
+  (void)context;
+  if (offset == offsetof(SpiController, CHIP_SELECT))
+  {
+    bool selected = model.regs->CHIP_SELECT == 0;
+    if (model.selected && !selected)
+      model_end_command();
+    if (selected && !model.selected)
+      model.index = 0;
+    model.selected = selected;
+  }
+  else if (offset == offsetof(SpiController, WDATA))
+    model.regs->RDATA = model.selected ? model_exchange(model.regs->WDATA) : 0xff;
+}
+
+// Fill the SFDP area with a header and a Basic Flash Parameter Table holding `density` and the
+// given erase types (size exponent and opcode pairs)
+static void model_set_sfdp(uint32_t density, const uint8_t erase_types[8])
+{
+  memset(model.sfdp, 0xff, sizeof(model.sfdp));
+  memcpy(model.sfdp, "SFDP", 4);
+  model.sfdp[11] = 9;
+  model.sfdp[12] = 16;
+  model.sfdp[13] = 0;
+  model.sfdp[14] = 0;
+  uint8_t *bfpt = model.sfdp + 16;
+  memcpy(bfpt + 4, &density, 4);
+  memcpy(bfpt + 28, erase_types, 8);
+  model.has_sfdp = true;
+}
+
+static SpiBus bus;
+static SpiDevice dev;
+static SpiFlash flash;
+
+static void test_capacity()
+{
+  static const uint8_t erase_types[8] = {12, 0x20, 15, 0x52, 16, 0xD8, 0, 0};
+  // SFDP density forms: N-1 bits, then 2^N bits with N = 21, 34 (2 GB), 35 (4 GB, does not fit
+  // 32 bits), 40 and nonsensical values. Capacities over 16 MB are limited to the reach of
+  // 3-byte addresses.
+  const uint32_t densities[] = {0x001FFFFF, 0x80000015, 0x80000022, 0x80000023,
+                                0x80000028, 0xFFFFFFFF, 0x80000002, 0x7FFFFFFF};
+  const uint32_t capacities[] = {0x40000, 0x40000, SPI_FLASH_MAX_CAPACITY, SPI_FLASH_MAX_CAPACITY,
+                                 SPI_FLASH_MAX_CAPACITY, SPI_FLASH_MAX_CAPACITY,
+                                 SPI_FLASH_MAX_CAPACITY, SPI_FLASH_MAX_CAPACITY};
+  for (uint32_t i = 0; i < NUMBER_OF(densities); i++)
+  {
+    model_set_sfdp(densities[i], erase_types);
+    CHECK_EQ(spi_flash_init(&flash, &dev, 50000000), SPI_FLASH_OK);
+    CHECK_EQ(flash.capacity, capacities[i]);
+  }
+
+  // Without SFDP, the capacity comes from the JEDEC ID
+  model.has_sfdp = false;
+  CHECK_EQ(spi_flash_init(&flash, &dev, 50000000), SPI_FLASH_OK);
+  CHECK_EQ(flash.capacity, 1U << 18);
+  CHECK_EQ(flash.erase_opcode[SPI_FLASH_ERASE_32K], SPI_FLASH_CMD_ERASE_32K);
+}
+
+static void test_erase()
+{
+  // 4 KB, 32 KB and 64 KB erases: the largest one fitting the alignment and length is used
+  static const uint8_t erase_types[8] = {12, 0x20, 15, 0x52, 16, 0xD8, 0, 0};
+  model_set_sfdp(0x001FFFFF, erase_types);
+  CHECK_EQ(spi_flash_init(&flash, &dev, 50000000), SPI_FLASH_OK);
+  model.erase_count = 0;
+  CHECK_EQ(spi_flash_erase(&flash, 0x7000, 0x1000 + 0x8000 + 0x10000 + 0x1000), SPI_FLASH_OK);
+  const uint8_t opcodes[] = {0x20, 0x52, 0xD8, 0x20};
+  const uint32_t addresses[] = {0x7000, 0x8000, 0x10000, 0x20000};
+  CHECK_EQ(model.erase_count, NUMBER_OF(opcodes));
+  for (uint32_t i = 0; i < NUMBER_OF(opcodes); i++)
+  {
+    CHECK_EQ(model.erase_opcodes[i], opcodes[i]);
+    CHECK_EQ(model.erase_addresses[i], addresses[i]);
+  }
+
+  // Without a 32 KB erase type, 4 KB erases are used until the next 64 KB boundary, with the
+  // opcodes given by SFDP
+  static const uint8_t no_32k[8] = {12, 0x21, 16, 0xDC, 0, 0, 0, 0};
+  model_set_sfdp(0x001FFFFF, no_32k);
+  CHECK_EQ(spi_flash_init(&flash, &dev, 50000000), SPI_FLASH_OK);
+  model.erase_count = 0;
+  CHECK_EQ(spi_flash_erase(&flash, 0xE000, 0x12000), SPI_FLASH_OK);
+  CHECK_EQ(model.erase_count, 3);
+  CHECK_EQ(model.erase_opcodes[0], 0x21);
+  CHECK_EQ(model.erase_opcodes[1], 0x21);
+  CHECK_EQ(model.erase_opcodes[2], 0xDC);
+  CHECK_EQ(model.erase_addresses[2], 0x10000);
+
+  CHECK_EQ(spi_flash_erase(&flash, 0x800, 0x1000), SPI_FLASH_INVALID_ARGUMENT);
+  CHECK_EQ(spi_flash_erase(&flash, 0x3F000, 0x2000), SPI_FLASH_INVALID_ARGUMENT);
+}
+
+static void test_write_read()
+{
+  static uint8_t data[700];
+  static uint8_t back[700];
+  model.has_sfdp = false;
+  CHECK_EQ(spi_flash_init(&flash, &dev, 50000000), SPI_FLASH_OK);
+  CHECK_EQ(spi_flash_erase(&flash, 0x1000, 0x1000), SPI_FLASH_OK);
+  for (uint32_t i = 0; i < sizeof(data); i++)
+    data[i] = rand();
+  // Starts in the middle of a page and crosses two page boundaries
+  CHECK_EQ(spi_flash_write(&flash, 0x1080, data, sizeof(data)), SPI_FLASH_OK);
+  CHECK_EQ(spi_flash_read(&flash, 0x1080, back, sizeof(back)), SPI_FLASH_OK);
+  CHECK(memcmp(data, back, sizeof(data)) == 0);
+  CHECK_EQ(spi_flash_read(&flash, MODEL_SIZE - 1, back, 2), SPI_FLASH_INVALID_ARGUMENT);
+}
+
+static void test_timeout()
+{
+  // A flash that stays busy makes the operation fail instead of hanging
+  CHECK_EQ(spi_flash_init(&flash, &dev, 50000000), SPI_FLASH_OK);
+  model.busy_polls = 0xffffffff;
+  host_cycles_per_read = 1000;
+  CHECK_EQ(spi_flash_wait_ready(&flash, 1), SPI_FLASH_TIMEOUT);
+  host_cycles_per_read = 1;
+  model.busy_polls = 0;
+}
+
+int main()
+{
+  model.regs = (SpiController *)host_mmio_alloc();
+  if (model.regs == NULL)
+    return HOST_MMIO_SKIP;
+  model.regs->CHIP_SELECT = 0xffffffff;
+  if (!host_mmio_start(model.regs, NULL, flash_model_write, &model))
+    return HOST_MMIO_SKIP;
+  model.jedec_id[0] = 0xEF;
+  model.jedec_id[1] = 0x40;
+  model.jedec_id[2] = 18;
+  memset(model.memory, 0xff, sizeof(model.memory));
+
+  spi_bus_init(&bus, model.regs);
+  spi_device_init(&dev, &bus, SPI_MODE0_CPOL0_CPHA0, 0, 0);
+
+  test_capacity();
+  test_erase();
+  test_write_read();
+  test_timeout();
+  return test_result();
+}
@@ -0,0 +1,417 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+#include "host_csr.h"
+#include "test.h"
+
+#include "libsteel/timer_wheel.h"
+
+#include <stdlib.h>
+
+// The MTimer is modeled by its registers in RAM: the test sets MTIME, and the interrupt is taken
+// by calling timer_wheel_service() once MTIME has reached MTIMECMP
+static MTimerController mtimer;
+static Timebase tb;
+static TimerWheel wheel;
+
+static void set_time(uint64_t ticks)
+{
+  mtimer.MTIMEH = ticks >> 32;
+  mtimer.MTIMEL = (uint32_t)ticks;
+}
+
+static uint64_t compare()
+{
+  return ((uint64_t)mtimer.MTIMECMPH << 32) | mtimer.MTIMECMPL;
+}
+
+static void setup(uint64_t now, uint32_t resolution_shift)
+{
+  set_time(now);
+  timebase_init(&tb, &mtimer, 50000000);
+  timer_wheel_init(&wheel, &tb, resolution_shift);
+}
+
+// Order in which the timers of the directed tests fire, and the time at which they did
+static SoftTimer *fired_order[8];
+static uint64_t fired_at[8];
+static uint32_t fired_count;
+
+static void record(SoftTimer *timer, void *context)
+{
+  (void)context;
+  if (fired_count < NUMBER_OF(fired_order))
+  {
+    fired_order[fired_count] = timer;
+    fired_at[fired_count] = now_ticks(&tb);
+  }
+  fired_count++;
+}
+
+static void test_rotate()
+{
+  CHECK_EQ(timer_wheel_rotate(0x00000001, 0), 0x00000001);
+  CHECK_EQ(timer_wheel_rotate(0x00000001, 1), 0x80000000);
+  CHECK_EQ(timer_wheel_rotate(0x80000000, 31), 0x00000001);
+  CHECK_EQ(timer_wheel_rotate(0x000000f0, 4), 0x0000000f);
+  CHECK_EQ(timer_wheel_rotate(0x12345678, 33), timer_wheel_rotate(0x12345678, 1));
+  // Offset from slot 8 of the next occupied slot, wrapping around the end of the level
+  CHECK_EQ(ctz32(timer_wheel_rotate((1U << 3) | (1U << 10), 8)), 2);
+  CHECK_EQ(ctz32(timer_wheel_rotate(1U << 3, 8)), 27);
+  CHECK_EQ(ctz32(timer_wheel_rotate(1U << 8, 8)), 0);
+  CHECK_EQ(ctz32(0x80000000), 31);
+  CHECK_EQ(ctz32(0x00010000), 16);
+
+  setup(0, 0);
+  for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    CHECK_EQ(timer_wheel_first_block(&wheel, level), 0);
+  wheel.current = 1;
+  CHECK_EQ(timer_wheel_first_block(&wheel, 0), 1);
+  CHECK_EQ(timer_wheel_first_block(&wheel, 1), 1);
+  CHECK_EQ(timer_wheel_first_block(&wheel, 3), 1);
+  wheel.current = 32;
+  CHECK_EQ(timer_wheel_first_block(&wheel, 1), 1);
+  CHECK_EQ(timer_wheel_first_block(&wheel, 2), 1);
+  wheel.current = 33;
+  CHECK_EQ(timer_wheel_first_block(&wheel, 1), 2);
+  wheel.current = 1024;
+  CHECK_EQ(timer_wheel_first_block(&wheel, 2), 1);
+  CHECK_EQ(timer_wheel_first_block(&wheel, 3), 1);
+}
+
+static void test_link_levels()
+{
+  // Slot at which each timer expires (one tick per slot), and the level and index expected
+  static const struct
+  {
+    uint64_t now;
+    uint64_t slot;
+    uint8_t level;
+    uint8_t index;
+  } cases[] = {
+      {0, 5, 0, 5},
+      {0, 31, 0, 31},
+      {0, 32, 1, 1},
+      {0, 1023, 1, 31},
+      {0, 1024, 2, 1},
+      {0, (1U << 15) - 1, 2, 31},
+      {0, 1U << 15, 3, 1},
+      {0, (1U << 20) - 1, 3, 31},
+      // Beyond the range of the wheel: parked in the last slot of the top level
+      {0, 1U << 20, 3, 31},
+      {0, 1ULL << 40, 3, 31},
+      {40, 70, 0, 6},
+      {40, 72, 1, 2},
+      {40, 2, 0, 8},
+      {(1U << 15) + 7, (1U << 15) + (1U << 20), 3, 0},
+      {(1U << 15) + 7, (1U << 15) + (1U << 20) - 1, 3, 0},
+  };
+  for (uint32_t i = 0; i < NUMBER_OF(cases); i++)
+  {
+    setup(cases[i].now, 0);
+    SoftTimer timer;
+    soft_timer_init(&timer, record, NULL);
+    CHECK(timer_wheel_start(&wheel, &timer, cases[i].slot, 0));
+    CHECK_EQ(timer.level, cases[i].level);
+    CHECK_EQ(timer.index, cases[i].index);
+    CHECK_EQ(wheel.occupied[cases[i].level], 1U << cases[i].index);
+    CHECK(timer_wheel_cancel(&wheel, &timer));
+    CHECK_EQ(wheel.occupied[cases[i].level], 0);
+    CHECK_EQ(compare(), UINT64_MAX);
+  }
+}
+
+static void test_cascade()
+{
+  // A timer at level 3 moves down one level at a time as the blocks holding it are entered
+  setup(0, 0);
+  fired_count = 0;
+  SoftTimer a, b, c;
+  soft_timer_init(&a, record, NULL);
+  soft_timer_init(&b, record, NULL);
+  soft_timer_init(&c, record, NULL);
+  timer_wheel_start(&wheel, &a, 1000, 0);
+  timer_wheel_start(&wheel, &b, 40000, 0);
+  timer_wheel_start(&wheel, &c, 39990, 0);
+  CHECK_EQ(a.level, 1);
+  CHECK_EQ(b.level, 3);
+  CHECK_EQ(b.index, 1);
+  CHECK_EQ(compare(), 1000);
+
+  set_time(1000);
+  timer_wheel_service(&wheel);
+  CHECK_EQ(fired_count, 1);
+  CHECK(fired_order[0] == &a);
+  CHECK_EQ(compare(), 39990);
+
+  // Block 1 of level 3 (slot 32768) and block 39 of level 2 (slot 39936) have been entered
+  set_time(39990);
+  timer_wheel_service(&wheel);
+  CHECK_EQ(fired_count, 2);
+  CHECK(fired_order[1] == &c);
+  CHECK(soft_timer_pending(&b));
+  CHECK_EQ(b.level, 1);
+  CHECK_EQ(b.index, (40000 >> 5) & 31);
+  CHECK_EQ(compare(), 40000);
+
+  // Servicing late fires the overdue timer once, at the time of the service
+  set_time(40100);
+  timer_wheel_service(&wheel);
+  CHECK_EQ(fired_count, 3);
+  CHECK(fired_order[2] == &b);
+  CHECK_EQ(fired_at[2], 40100);
+  CHECK_EQ(wheel.last_lateness, 100);
+  CHECK_EQ(wheel.max_lateness, 100);
+  CHECK_EQ(compare(), UINT64_MAX);
+}
+
+static void test_parking()
+{
+  // A timer beyond the 2^20 slots of the wheel costs one interrupt when the last block of the
+  // top level is entered, then fires on time
+  const uint32_t shift = 3;
+  const uint64_t expiry = ((1ULL << 20) + 5) << shift;
+  setup(0, shift);
+  fired_count = 0;
+  SoftTimer timer;
+  soft_timer_init(&timer, record, NULL);
+  timer_wheel_start(&wheel, &timer, expiry, 0);
+  CHECK_EQ(timer.level, 3);
+  CHECK_EQ(timer.index, 31);
+  uint32_t interrupts = 0;
+  while (compare() != UINT64_MAX && interrupts < 10)
+  {
+    set_time(compare());
+    timer_wheel_service(&wheel);
+    interrupts++;
+  }
+  CHECK_EQ(interrupts, 2);
+  CHECK_EQ(fired_count, 1);
+  CHECK_EQ(fired_at[0], expiry);
+
+  // Further away, one extra interrupt per range of the wheel
+  setup(0, 0);
+  fired_count = 0;
+  timer_wheel_start(&wheel, &timer, 3ULL << 20, 0);
+  interrupts = 0;
+  while (compare() != UINT64_MAX && interrupts < 10)
+  {
+    set_time(compare());
+    timer_wheel_service(&wheel);
+    interrupts++;
+  }
+  CHECK_EQ(interrupts, 4);
+  CHECK_EQ(fired_count, 1);
+  CHECK_EQ(fired_at[0], 3ULL << 20);
+}
+
+static void test_short_period()
+{
+  // Periods shorter than one slot are rejected, leaving the timer unchanged
+  setup(1000, 4);
+  SoftTimer timer;
+  soft_timer_init(&timer, record, NULL);
+  CHECK(!timer_wheel_start(&wheel, &timer, 2000, 15));
+  CHECK(!timer_wheel_start_after(&wheel, &timer, 100, 1));
+  CHECK(!soft_timer_pending(&timer));
+  CHECK_EQ(compare(), UINT64_MAX);
+  CHECK(timer_wheel_start(&wheel, &timer, 2000, 16));
+  CHECK(timer_wheel_start_after(&wheel, &timer, 100, 0));
+  CHECK(soft_timer_pending(&timer));
+  CHECK(!timer_wheel_start(&wheel, &timer, 3000, 8));
+  CHECK_EQ(timer.expiry, 1100);
+  CHECK_EQ(timer.period, 0);
+}
+
+static SoftTimer same_slot[3];
+
+static void cancel_next(SoftTimer *timer, void *context)
+{
+  (void)context;
+  record(timer, NULL);
+  // On its first expiry: the other timers of the slot being serviced are still pending and can
+  // be cancelled
+  if (timer == &same_slot[0] && fired_count == 1)
+  {
+    CHECK(timer_wheel_cancel(&wheel, &same_slot[1]));
+    CHECK(!soft_timer_pending(&same_slot[1]));
+    CHECK(timer_wheel_start(&wheel, timer, now_ticks(&tb) + 50, 0));
+  }
+}
+
+static void test_callbacks()
+{
+  // Timers of the same slot fire in one service; a callback cancels one of them and restarts
+  // itself
+  setup(0, 2);
+  fired_count = 0;
+  // Timers are added to the head of their slot: the last one started fires first
+  for (uint32_t i = NUMBER_OF(same_slot); i-- > 0;)
+  {
+    soft_timer_init(&same_slot[i], cancel_next, NULL);
+    timer_wheel_start(&wheel, &same_slot[i], 97 + i, 0);
+  }
+  CHECK_EQ(compare(), 100);
+  set_time(103);
+  timer_wheel_service(&wheel);
+  CHECK_EQ(fired_count, 2);
+  CHECK(!soft_timer_pending(&same_slot[1]));
+  CHECK(soft_timer_pending(&same_slot[0]));
+  CHECK_EQ(compare(), 156);
+  set_time(156);
+  timer_wheel_service(&wheel);
+  CHECK_EQ(fired_count, 3);
+  CHECK(fired_order[2] == &same_slot[0]);
+  CHECK_EQ(compare(), UINT64_MAX);
+}
+
+// Random test: the timers start and cancel each other from their callbacks and from the main
+// program, and each of them is checked against a reference model
+#define RANDOM_TIMERS 24
+#define RANDOM_SHIFT 3
+#define MAX_LATENCY 5
+
+typedef struct
+{
+  bool pending;
+  uint64_t expiry;
+  uint64_t period;
+} Reference;
+
+static SoftTimer timers[RANDOM_TIMERS];
+static Reference reference[RANDOM_TIMERS];
+static bool far_timers;
+static uint32_t random_fired;
+
+static uint64_t random_delay()
+{
+  if (far_timers && rand() % 16 == 0)
+    return (uint64_t)rand() << (RANDOM_SHIFT + 4);
+  switch (rand() % 4)
+  {
+  case 0:
+    return rand() % 8;
+  case 1:
+    return rand() % 300;
+  case 2:
+    return rand() % 10000;
+  default:
+    return rand() % 1000000;
+  }
+}
+
+static void random_action()
+{
+  uint32_t i = rand() % RANDOM_TIMERS;
+  if (rand() % 3 == 0)
+  {
+    CHECK_EQ(timer_wheel_cancel(&wheel, &timers[i]), reference[i].pending);
+    reference[i].pending = false;
+    return;
+  }
+  uint64_t period = rand() % 4 == 0 ? (1U << RANDOM_SHIFT) + rand() % 5000 : 0;
+  uint64_t expiry = now_ticks(&tb) + random_delay();
+  CHECK(timer_wheel_start(&wheel, &timers[i], expiry, period));
+  reference[i] = (Reference){true, expiry, period};
+}
+
+static void random_callback(SoftTimer *timer, void *context)
+{
+  (void)timer;
+  uint32_t i = (uint32_t)(uintptr_t)context;
+  uint64_t now = now_ticks(&tb);
+  // Never early, and at most one slot late plus the interrupt latency (overdue timers started
+  // on a slot boundary wait for the next slot)
+  CHECK(reference[i].pending);
+  CHECK(reference[i].expiry <= now);
+  CHECK(now - reference[i].expiry <= (1U << RANDOM_SHIFT) + MAX_LATENCY);
+  if (reference[i].period != 0)
+    reference[i].expiry += reference[i].period;
+  else
+    reference[i].pending = false;
+  random_fired++;
+  if (rand() % 2 == 0)
+    random_action();
+}
+
+// Start of the slot where the earliest pending timer of the reference model is due
+static uint64_t reference_compare()
+{
+  uint64_t earliest = UINT64_MAX;
+  for (uint32_t i = 0; i < RANDOM_TIMERS; i++)
+  {
+    if (!reference[i].pending)
+      continue;
+    uint64_t slot = timers[i].slot < wheel.current ? wheel.current : timers[i].slot;
+    if (slot << RANDOM_SHIFT < earliest)
+      earliest = slot << RANDOM_SHIFT;
+  }
+  return earliest;
+}
+
+static void check_compare()
+{
+  // Parked timers are due earlier than their expiry, other timers exactly when it is reached
+  if (far_timers)
+    CHECK(compare() <= reference_compare());
+  else
+    CHECK_EQ(compare(), reference_compare());
+}
+
+static void run_random(bool far, uint32_t steps)
+{
+  setup(12345, RANDOM_SHIFT);
+  far_timers = far;
+  random_fired = 0;
+  for (uint32_t i = 0; i < RANDOM_TIMERS; i++)
+  {
+    soft_timer_init(&timers[i], random_callback, (void *)(uintptr_t)i);
+    reference[i].pending = false;
+  }
+  uint32_t empty_interrupts = 0;
+  for (uint32_t step = 0; step < steps; step++)
+  {
+    uint64_t now = now_ticks(&tb);
+    uint64_t due = compare();
+    if (due == UINT64_MAX || rand() % 3 == 0)
+    {
+      // Main program: start or cancel a timer, before the next interrupt
+      if (due != UINT64_MAX && due > now)
+        set_time(now + rand() % (due - now));
+      random_action();
+      check_compare();
+      continue;
+    }
+    set_time((due > now ? due : now) + rand() % (MAX_LATENCY + 1));
+    uint32_t before = random_fired;
+    timer_wheel_service(&wheel);
+    if (random_fired == before)
+      empty_interrupts++;
+    CHECK(compare() > now_ticks(&tb));
+    check_compare();
+    for (uint32_t i = 0; i < RANDOM_TIMERS; i++)
+      CHECK_EQ(soft_timer_pending(&timers[i]), reference[i].pending);
+  }
+  CHECK(random_fired > steps / 4);
+  // Without timers beyond the range of the wheel, the interrupt only fires when a timer is due
+  if (!far)
+    CHECK_EQ(empty_interrupts, 0);
+}
+
+int main()
+{
+  test_rotate();
+  test_link_levels();
+  test_cascade();
+  test_parking();
+  test_short_period();
+  test_callbacks();
+  srand(1);
+  run_random(false, 200000);
+  run_random(true, 200000);
+  return test_result();
+}
@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+# ----------------------------------------------------------------------------
+# Copyright (c) 2020-2024 RISC-V Steel contributors
+#
+# This work is licensed under the MIT License, see LICENSE file for details.
+# SPDX-License-Identifier: MIT
+# ----------------------------------------------------------------------------
+
+"""Decode tokenized log records sent by LOG_TOKEN (see libsteel/log.h).
+
+Each record is a COBS frame holding the token and the arguments as LEB128 integers, followed by a
+CRC-16. Corrupted records and unknown tokens are reported and decoding resumes at the next frame.
+
+The format strings are read from section .steel_log of the ELF file the firmware was built into.
+The log stream is read from a file, a serial device or the standard input:
+
+    steel_log_decode.py firmware.elf /dev/ttyUSB0
+    cat capture.bin | steel_log_decode.py firmware.elf
+"""
+
+import re
+import struct
+import sys
+
+SHF_ALLOC = 0x2
+CONVERSION = re.compile(r"%([-0]*)(\d*)(?:hh|h|ll|l|z)?([diuxXcs%])")
+
+
+class Elf32:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.image = f.read()
+        if self.image[:4] != b"\x7fELF" or self.image[4] != 1:
+            raise ValueError(f"{path} is not a 32-bit ELF file")
+        shoff, = struct.unpack_from("<I", self.image, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", self.image, 0x2E)
+        headers = [struct.unpack_from("<IIIIIIIIII", self.image, shoff + i * shentsize)
+                   for i in range(shnum)]
+        names = headers[shstrndx][4]
+        self.sections = []
+        for name, type_, flags, addr, offset, size, *_ in headers:
+            end = self.image.index(b"\0", names + name)
+            data = self.image[offset:offset + size] if type_ != 8 else b""  # 8 = SHT_NOBITS
+            self.sections.append((self.image[names + name:end].decode(), flags, addr, data))
+
+    def section(self, name):
+        for section in self.sections:
+            if section[0] == name:
+                return section
+        raise KeyError(f"section {name} not found")
+
+    def string_at(self, address, loaded_only=True):
+        for _, flags, addr, data in self.sections:
+            if (flags & SHF_ALLOC or not loaded_only) and addr <= address < addr + len(data):
+                start = address - addr
+                return data[start:data.index(b"\0", start)].decode(errors="replace")
+        return None
+
+
+def crc16_ccitt(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021 if crc & 0x8000 else crc << 1) & 0xFFFF
+    return crc
+
+
+def read_frames(stream):
+    """Yield the COBS-decoded payload of each frame, or None for a corrupted frame."""
+    frame = bytearray()
+    while True:
+        byte = stream.read(1)
+        if not byte:
+            return
+        if byte[0] != 0:
+            frame += byte
+            continue
+        if not frame:
+            continue
+        yield cobs_decode(frame)
+        frame = bytearray()
+
+
+def cobs_decode(frame):
+    data = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if i + code > len(frame):
+            return None
+        data += frame[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(frame):
+            data.append(0)
+    if len(data) < 2 or crc16_ccitt(data) != 0:
+        return None
+    return bytes(data[:-2])
+
+
+def read_leb128(data, pos):
+    value, shift = 0, 0
+    while True:
+        if pos >= len(data):
+            raise EOFError
+        value |= (data[pos] & 0x7F) << shift
+        shift += 7
+        pos += 1
+        if data[pos - 1] < 0x80:
+            return value, pos
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def render(elf, fmt, args):
+    args = iter(args)
+
+    def convert(match):
+        flags, width, kind = match.groups()
+        if kind == "%":
+            return "%"
+        value = next(args)
+        if kind in "di":
+            value = unzigzag(value)
+        elif kind == "s":
+            text = elf.string_at(value)
+            value = text if text is not None else f"<0x{value:08x}>"
+        elif kind == "c":
+            value = chr(value & 0xFF)
+        return ("%" + flags + width + {"i": "d", "c": "s"}.get(kind, kind)) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode_record(elf, base, strings, record):
+    if record is None:
+        return "<corrupted record>\n"
+    try:
+        token, pos = read_leb128(record, 0)
+    except EOFError:
+        return "<empty record>\n"
+    offset = token - base
+    if not 0 <= offset < len(strings):
+        return f"<unknown token 0x{token:x}>\n"
+    fmt = strings[offset:strings.index(b"\0", offset)].decode(errors="replace")
+    count = sum(1 for m in CONVERSION.finditer(fmt) if m.group(3) != "%")
+    args = []
+    try:
+        for _ in range(count):
+            value, pos = read_leb128(record, pos)
+            args.append(value)
+    except EOFError:
+        return f"<truncated record for token 0x{token:x}>\n"
+    return render(elf, fmt, args)
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit(__doc__)
+    elf = Elf32(sys.argv[1])
+    _, _, base, strings = elf.section(".steel_log")
+    stream = open(sys.argv[2], "rb", buffering=0) if len(sys.argv) == 3 else sys.stdin.buffer
+    try:
+        for record in read_frames(stream):
+            sys.stdout.write(decode_record(elf, base, strings, record))
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,605 @@
+// ----------------------------------------------------------------------------
+// Copyright (c) 2020-2024 RISC-V Steel contributors
+//
+// This work is licensed under the MIT License, see LICENSE file for details.
+// SPDX-License-Identifier: MIT
+// ----------------------------------------------------------------------------
+
+/* Instruction-level simulator of an RV32I + Zicsr core with the peripherals used by the benchmarks
+ * (see benchmarks/), so that their cycle counts can be reproduced on the build machine:
+ *
+ *     steel_sim bench_crc.elf
+ *
+ * The program is loaded at its physical addresses in 1 MiB of RAM starting at 0. It runs until it
+ * jumps to itself (the `j .` after main() in benchmarks/start.S), and register a0 is then returned
+ * as the exit status. Characters written to the UART go to the standard output.
+ *
+ * Cycle model, an approximation of the RISC-V Steel pipeline: 1 cycle per instruction, plus 1 for
+ * loads, plus 2 for taken branches, jumps and mret (pipeline refill), plus 3 for taking a trap.
+ * CSR_MCYCLE and MTIME both advance with this count. `wfi` skips the cycles until an enabled
+ * interrupt is pending.
+ *
+ * Peripherals (the addresses of benchmarks/benchmark.h):
+ * - UART at 0x80000000: WDATA prints a character, READY always reads 1.
+ * - MTimer at 0x80010000: CR, MTIME and MTIMECMP; MTIP is set while MTIME >= MTIMECMP.
+ * - GPIO at 0x80020000: IN, OE, OUT, CLR and SET; IN reads back the pins driven as outputs.
+ * - SPI at 0x80030000: loopback (RDATA returns the last byte written to WDATA); BUSY is set for
+ *   16 * (CLOCK_CONF + 1) cycles after each write.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RAM_SIZE (1U << 20)
+#define UART_BASE 0x80000000U
+#define MTIMER_BASE 0x80010000U
+#define GPIO_BASE 0x80020000U
+#define SPI_BASE 0x80030000U
+#define PERIPHERAL_SIZE 0x100U
+
+// Programs stuck for this many cycles (about 40 s at 50 MHz) are stopped
+#define MAX_CYCLES 2000000000ULL
+
+#define MSTATUS_MIE 0x8U
+#define MSTATUS_MPIE 0x80U
+#define MIP_MTIP 0x80U
+
+static uint8_t ram[RAM_SIZE];
+static uint32_t x[32];
+static uint32_t pc;
+static uint64_t cycles;
+static uint64_t instret;
+static uint32_t mstatus, mie, mip, mtvec, mepc, mcause, mscratch;
+
+static uint32_t mtimer_cr;
+static uint64_t mtime;
+static uint64_t mtimecmp = UINT64_MAX;
+static uint32_t gpio_oe, gpio_out;
+static uint32_t spi_cpol, spi_cpha, spi_cs = UINT32_MAX, spi_clock_conf, spi_rdata;
+static uint64_t spi_busy_until;
+
+static void fail(const char *message)
+{
+  fflush(stdout);
+  fprintf(stderr, "steel_sim: %s at pc 0x%08x\n", message, pc);
+  exit(2);
+}
+
+static void advance(uint64_t n)
+{
+  cycles += n;
+  if (mtimer_cr & 1)
+    mtime += n;
+}
+
+static void update_mip()
+{
+  if (mtime >= mtimecmp)
+    mip |= MIP_MTIP;
+  else
+    mip &= ~MIP_MTIP;
+}
+
+static uint32_t peripheral_read(uint32_t address)
+{
+  uint32_t base = address & ~(PERIPHERAL_SIZE - 1);
+  uint32_t offset = address & (PERIPHERAL_SIZE - 1);
+  if (base == UART_BASE)
+    return offset == 0x08 ? 1 : 0;
+  if (base == MTIMER_BASE)
+  {
+    switch (offset)
+    {
+    case 0x00:
+      return mtimer_cr;
+    case 0x04:
+      return (uint32_t)mtime;
+    case 0x08:
+      return (uint32_t)(mtime >> 32);
+    case 0x0c:
+      return (uint32_t)mtimecmp;
+    case 0x10:
+      return (uint32_t)(mtimecmp >> 32);
+    }
+  }
+  if (base == GPIO_BASE)
+  {
+    switch (offset)
+    {
+    case 0x00:
+      return gpio_out & gpio_oe;
+    case 0x04:
+      return gpio_oe;
+    case 0x08:
+      return gpio_out;
+    }
+  }
+  if (base == SPI_BASE)
+  {
+    switch (offset)
+    {
+    case 0x00:
+      return spi_cpol;
+    case 0x04:
+      return spi_cpha;
+    case 0x08:
+      return spi_cs;
+    case 0x0c:
+      return spi_clock_conf;
+    case 0x14:
+      return spi_rdata;
+    case 0x18:
+      return cycles < spi_busy_until;
+    }
+  }
+  return 0;
+}
+
+static void peripheral_write(uint32_t address, uint32_t value)
+{
+  uint32_t base = address & ~(PERIPHERAL_SIZE - 1);
+  uint32_t offset = address & (PERIPHERAL_SIZE - 1);
+  if (base == UART_BASE && offset == 0x00)
+    putchar(value & 0xff);
+  else if (base == MTIMER_BASE)
+  {
+    switch (offset)
+    {
+    case 0x00:
+      mtimer_cr = value;
+      break;
+    case 0x04:
+      mtime = (mtime & 0xffffffff00000000ULL) | value;
+      break;
+    case 0x08:
+      mtime = (mtime & 0xffffffffULL) | ((uint64_t)value << 32);
+      break;
+    case 0x0c:
+      mtimecmp = (mtimecmp & 0xffffffff00000000ULL) | value;
+      break;
+    case 0x10:
+      mtimecmp = (mtimecmp & 0xffffffffULL) | ((uint64_t)value << 32);
+      break;
+    }
+  }
+  else if (base == GPIO_BASE)
+  {
+    switch (offset)
+    {
+    case 0x04:
+      gpio_oe = value;
+      break;
+    case 0x08:
+      gpio_out = value;
+      break;
+    case 0x0c:
+      gpio_out &= ~value;
+      break;
+    case 0x10:
+      gpio_out |= value;
+      break;
+    }
+  }
+  else if (base == SPI_BASE)
+  {
+    switch (offset)
+    {
+    case 0x00:
+      spi_cpol = value & 1;
+      break;
+    case 0x04:
+      spi_cpha = value & 1;
+      break;
+    case 0x08:
+      spi_cs = value;
+      break;
+    case 0x0c:
+      spi_clock_conf = value & 0xff;
+      break;
+    case 0x10:
+      spi_rdata = value & 0xff;
+      spi_busy_until = cycles + 16 * (spi_clock_conf + 1);
+      break;
+    }
+  }
+}
+
+static uint32_t load(uint32_t address, uint32_t size)
+{
+  if (address >= UART_BASE)
+    return peripheral_read(address & ~3U) >> (8 * (address & 3));
+  if (address + size > RAM_SIZE)
+    fail("load outside RAM");
+  uint32_t value = 0;
+  memcpy(&value, &ram[address], size);
+  return value;
+}
+
+static void store(uint32_t address, uint32_t value, uint32_t size)
+{
+  if (address >= UART_BASE)
+    peripheral_write(address & ~3U, value);
+  else if (address + size > RAM_SIZE)
+    fail("store outside RAM");
+  else
+    memcpy(&ram[address], &value, size);
+}
+
+static uint32_t *csr_register(uint32_t number)
+{
+  switch (number)
+  {
+  case 0x300:
+    return &mstatus;
+  case 0x304:
+    return &mie;
+  case 0x305:
+    return &mtvec;
+  case 0x340:
+    return &mscratch;
+  case 0x341:
+    return &mepc;
+  case 0x342:
+    return &mcause;
+  }
+  return NULL;
+}
+
+static uint32_t csr_read(uint32_t number)
+{
+  switch (number)
+  {
+  case 0xb00:
+  case 0xc00:
+    return (uint32_t)cycles;
+  case 0xb80:
+  case 0xc80:
+    return (uint32_t)(cycles >> 32);
+  case 0xb02:
+  case 0xc02:
+    return (uint32_t)instret;
+  case 0xb82:
+  case 0xc82:
+    return (uint32_t)(instret >> 32);
+  case 0x344:
+    update_mip();
+    return mip;
+  }
+  uint32_t *reg = csr_register(number);
+  return reg != NULL ? *reg : 0;
+}
+
+static void csr_write(uint32_t number, uint32_t value)
+{
+  if (number == 0xb00)
+    cycles = (cycles & 0xffffffff00000000ULL) | value;
+  else if (number == 0xb80)
+    cycles = (cycles & 0xffffffffULL) | ((uint64_t)value << 32);
+  else if (csr_register(number) != NULL)
+    *csr_register(number) = value;
+}
+
+static void trap(uint32_t cause)
+{
+  mepc = pc;
+  mcause = cause;
+  mstatus = (mstatus & ~(MSTATUS_MIE | MSTATUS_MPIE)) | ((mstatus & MSTATUS_MIE) << 4);
+  // Vectored mode applies to interrupts only
+  if ((mtvec & 1) && (cause & 0x80000000U))
+    pc = (mtvec & ~3U) + 4 * (cause & 0x7fffffffU);
+  else
+    pc = mtvec & ~3U;
+  advance(3);
+}
+
+static int32_t sign_extend(uint32_t value, uint32_t bits)
+{
+  return (int32_t)(value << (32 - bits)) >> (32 - bits);
+}
+
+static void load_elf(const char *path)
+{
+  FILE *file = fopen(path, "rb");
+  if (file == NULL)
+  {
+    perror(path);
+    exit(2);
+  }
+  uint8_t header[52];
+  if (fread(header, 1, sizeof(header), file) != sizeof(header) || header[0] != 0x7f ||
+      memcmp(&header[1], "ELF", 3) != 0 || header[4] != 1 || header[5] != 1)
+  {
+    fprintf(stderr, "steel_sim: %s is not a 32-bit little-endian ELF file\n", path);
+    exit(2);
+  }
+  uint32_t entry, phoff;
+  uint16_t phentsize, phnum;
+  memcpy(&entry, &header[0x18], 4);
+  memcpy(&phoff, &header[0x1c], 4);
+  memcpy(&phentsize, &header[0x2a], 2);
+  memcpy(&phnum, &header[0x2c], 2);
+  for (uint32_t i = 0; i < phnum; i++)
+  {
+    // Program header: type, offset, vaddr, paddr, filesz, memsz
+    uint32_t ph[6];
+    if (fseek(file, phoff + i * phentsize, SEEK_SET) != 0 || fread(ph, 4, 6, file) != 6)
+      break;
+    if (ph[0] != 1)
+      continue;
+    if (ph[3] + ph[5] > RAM_SIZE || ph[4] > ph[5])
+    {
+      fprintf(stderr, "steel_sim: segment at 0x%08x does not fit in RAM\n", ph[3]);
+      exit(2);
+    }
+    if (fseek(file, ph[1], SEEK_SET) != 0 || fread(&ram[ph[3]], 1, ph[4], file) != ph[4])
+    {
+      fprintf(stderr, "steel_sim: %s is truncated\n", path);
+      exit(2);
+    }
+  }
+  fclose(file);
+  pc = entry;
+}
+
+// Execute one instruction, or take a pending interrupt. Return false once the program has ended.
+static int step()
+{
+  update_mip();
+  if ((mstatus & MSTATUS_MIE) && (mip & mie & MIP_MTIP))
+  {
+    trap(0x80000007U);
+    return 1;
+  }
+  uint32_t insn = load(pc, 4);
+  uint32_t next = pc + 4;
+  uint32_t opcode = insn & 0x7f;
+  uint32_t rd = (insn >> 7) & 31;
+  uint32_t funct3 = (insn >> 12) & 7;
+  uint32_t rs1 = (insn >> 15) & 31;
+  uint32_t rs2 = (insn >> 20) & 31;
+  uint32_t funct7 = insn >> 25;
+  uint32_t a = x[rs1];
+  uint32_t b = x[rs2];
+  uint32_t result = 0;
+  uint64_t cost = 1;
+  int writes_rd = 1;
+  switch (opcode)
+  {
+  case 0x37: // lui
+    result = insn & 0xfffff000U;
+    break;
+  case 0x17: // auipc
+    result = pc + (insn & 0xfffff000U);
+    break;
+  case 0x6f: // jal
+  {
+    uint32_t imm = ((insn >> 31) << 20) | (((insn >> 12) & 0xff) << 12) |
+                   (((insn >> 20) & 1) << 11) | (((insn >> 21) & 0x3ff) << 1);
+    if (imm == 0)
+      return 0; // j . ends the program
+    result = next;
+    next = pc + sign_extend(imm, 21);
+    cost += 2;
+    break;
+  }
+  case 0x67: // jalr
+    result = next;
+    next = (a + sign_extend(insn >> 20, 12)) & ~1U;
+    cost += 2;
+    break;
+  case 0x63: // branches
+  {
+    uint32_t imm = ((insn >> 31) << 12) | (((insn >> 7) & 1) << 11) |
+                   (((insn >> 25) & 0x3f) << 5) | (((insn >> 8) & 0xf) << 1);
+    int taken;
+    switch (funct3)
+    {
+    case 0:
+      taken = a == b;
+      break;
+    case 1:
+      taken = a != b;
+      break;
+    case 4:
+      taken = (int32_t)a < (int32_t)b;
+      break;
+    case 5:
+      taken = (int32_t)a >= (int32_t)b;
+      break;
+    case 6:
+      taken = a < b;
+      break;
+    case 7:
+      taken = a >= b;
+      break;
+    default:
+      goto illegal;
+    }
+    if (taken)
+    {
+      next = pc + sign_extend(imm, 13);
+      cost += 2;
+    }
+    writes_rd = 0;
+    break;
+  }
+  case 0x03: // loads
+  {
+    uint32_t address = a + sign_extend(insn >> 20, 12);
+    switch (funct3)
+    {
+    case 0:
+      result = sign_extend(load(address, 1) & 0xff, 8);
+      break;
+    case 1:
+      result = sign_extend(load(address, 2) & 0xffff, 16);
+      break;
+    case 2:
+      result = load(address, 4);
+      break;
+    case 4:
+      result = load(address, 1) & 0xff;
+      break;
+    case 5:
+      result = load(address, 2) & 0xffff;
+      break;
+    default:
+      goto illegal;
+    }
+    cost += 1;
+    break;
+  }
+  case 0x23: // stores
+    if (funct3 > 2)
+      goto illegal;
+    store(a + sign_extend(((insn >> 25) << 5) | ((insn >> 7) & 31), 12), b, 1U << funct3);
+    writes_rd = 0;
+    break;
+  case 0x13: // register-immediate operations
+  {
+    int32_t imm = sign_extend(insn >> 20, 12);
+    switch (funct3)
+    {
+    case 0:
+      result = a + imm;
+      break;
+    case 1:
+      result = a << rs2;
+      break;
+    case 2:
+      result = (int32_t)a < imm;
+      break;
+    case 3:
+      result = a < (uint32_t)imm;
+      break;
+    case 4:
+      result = a ^ imm;
+      break;
+    case 5:
+      result = (funct7 & 0x20) ? (uint32_t)((int32_t)a >> rs2) : a >> rs2;
+      break;
+    case 6:
+      result = a | imm;
+      break;
+    case 7:
+      result = a & imm;
+      break;
+    }
+    break;
+  }
+  case 0x33: // register-register operations (no M extension)
+    if (funct7 & ~0x20U)
+      goto illegal;
+    switch (funct3)
+    {
+    case 0:
+      result = (funct7 & 0x20) ? a - b : a + b;
+      break;
+    case 1:
+      result = a << (b & 31);
+      break;
+    case 2:
+      result = (int32_t)a < (int32_t)b;
+      break;
+    case 3:
+      result = a < b;
+      break;
+    case 4:
+      result = a ^ b;
+      break;
+    case 5:
+      result = (funct7 & 0x20) ? (uint32_t)((int32_t)a >> (b & 31)) : a >> (b & 31);
+      break;
+    case 6:
+      result = a | b;
+      break;
+    case 7:
+      result = a & b;
+      break;
+    }
+    break;
+  case 0x0f: // fence
+    writes_rd = 0;
+    break;
+  case 0x73: // system
+    if (funct3 == 0)
+    {
+      writes_rd = 0;
+      if (insn == 0x00000073 || insn == 0x00100073) // ecall, ebreak
+      {
+        advance(1);
+        instret++;
+        trap(insn == 0x00000073 ? 11 : 3);
+        return 1;
+      }
+      if (insn == 0x30200073) // mret
+      {
+        next = mepc;
+        mstatus = (mstatus & ~MSTATUS_MIE) | ((mstatus >> 4) & MSTATUS_MIE) | MSTATUS_MPIE;
+        cost += 2;
+      }
+      else if (insn == 0x10500073) // wfi
+      {
+        update_mip();
+        while ((mip & mie) == 0)
+        {
+          if (!(mtimer_cr & 1) || (mie & MIP_MTIP) == 0 || cycles > MAX_CYCLES)
+            fail("wfi without wake-up source");
+          advance(mtimecmp > mtime ? mtimecmp - mtime : 1);
+          update_mip();
+        }
+      }
+      else
+        goto illegal;
+    }
+    else
+    {
+      uint32_t number = insn >> 20;
+      uint32_t source = (funct3 & 4) ? rs1 : a;
+      result = csr_read(number);
+      switch (funct3 & 3)
+      {
+      case 1:
+        csr_write(number, source);
+        break;
+      case 2:
+        if (rs1 != 0)
+          csr_write(number, result | source);
+        break;
+      case 3:
+        if (rs1 != 0)
+          csr_write(number, result & ~source);
+        break;
+      }
+    }
+    break;
+  default:
+  illegal:
+    fail("illegal instruction");
+  }
+  if (writes_rd && rd != 0)
+    x[rd] = result;
+  pc = next;
+  instret++;
+  advance(cost);
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: steel_sim program.elf\n");
+    return 2;
+  }
+  load_elf(argv[1]);
+  while (step())
+    if (cycles > MAX_CYCLES)
+      fail("cycle limit reached");
+  fflush(stdout);
+  fprintf(stderr, "steel_sim: exit status %u after %llu cycles, %llu instructions\n", x[10],
+          (unsigned long long)cycles, (unsigned long long)instret);
+  return (int)x[10];
+}